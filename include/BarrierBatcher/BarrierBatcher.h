@@ -0,0 +1,324 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+
+/* A structure for the counters of a barrier batcher */
+typedef struct {
+	u64 Requested;	/* Barriers added */
+	u64 Merged;		/* Barriers folded into one that was already pending */
+	u64 Emitted;	/* Barrier structures handed to the driver */
+	u64 Flushes;	/* Pipeline barrier commands recorded, each one can drain the pipeline */
+} BarrierBatcherStats;
+
+/* A structure for collecting the barriers recorded between two commands so they go to the driver as one pipeline
+   barrier, right before the command that needs them. Barriers on the same buffer range or image subresources are
+   merged into one. Like a command buffer, a batcher may only be used by one thread at a time */
+typedef struct {
+	bool Synchronization2;		/* If vkCmdPipelineBarrier2KHR is used, otherwise the barriers go through vkCmdPipelineBarrier */
+	PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2;	/* An extension command, from vkGetDeviceProcAddr */
+	VkMemoryBarrier2KHR Memory;	/* The global barrier, all of them are merged into this one */
+	bool HasMemory;				/* If Memory is pending */
+	Vec Buffers;				/* A Vector of pending VkBufferMemoryBarrier2KHR */
+	Vec Images;					/* A Vector of pending VkImageMemoryBarrier2KHR */
+	Vec LegacyBuffers;			/* A Vector of VkBufferMemoryBarrier, reused by every flush without synchronization2 */
+	Vec LegacyImages;			/* A Vector of VkImageMemoryBarrier, reused by every flush without synchronization2 */
+	BarrierBatcherStats Stats;	/* The counters */
+} BarrierBatcher;
+
+/* A function to create a barrier batcher */
+/* @param A Pointer to a logical device */
+/* @param If the device was created with synchronization2, DeviceFeatureChain.Synchronization2Features.synchronization2 */
+/* @param A Pointer to the BarrierBatcher to be filled */
+bool CreateBarrierBatcher(VkDevice* logicalDevice, bool synchronization2, BarrierBatcher* batcher)
+{
+	memset(batcher, 0, sizeof(BarrierBatcher));
+	batcher->Buffers = vec_reserve(VkBufferMemoryBarrier2KHR, 16);
+	batcher->Images = vec_reserve(VkImageMemoryBarrier2KHR, 16);
+	batcher->LegacyBuffers = vec_create(VkBufferMemoryBarrier);
+	batcher->LegacyImages = vec_create(VkImageMemoryBarrier);
+
+	if (synchronization2)
+	{
+		batcher->CmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(*logicalDevice, "vkCmdPipelineBarrier2KHR");
+		batcher->Synchronization2 = batcher->CmdPipelineBarrier2 != nullptr;
+		if (!batcher->Synchronization2)
+			printf("WARNING: Could not load vkCmdPipelineBarrier2KHR, barriers go through vkCmdPipelineBarrier instead!\n");
+	}
+
+	return true;
+}
+
+/* A function to check if two subresource ranges share any subresource */
+/* @param A Pointer to the first range */
+/* @param A Pointer to the second range */
+bool DoSubresourceRangesOverlap(const VkImageSubresourceRange* a, const VkImageSubresourceRange* b)
+{
+	u32 aLevels = a->levelCount == VK_REMAINING_MIP_LEVELS ? ~0u - a->baseMipLevel : a->levelCount;
+	u32 bLevels = b->levelCount == VK_REMAINING_MIP_LEVELS ? ~0u - b->baseMipLevel : b->levelCount;
+	u32 aLayers = a->layerCount == VK_REMAINING_ARRAY_LAYERS ? ~0u - a->baseArrayLayer : a->layerCount;
+	u32 bLayers = b->layerCount == VK_REMAINING_ARRAY_LAYERS ? ~0u - b->baseArrayLayer : b->layerCount;
+
+	return (a->aspectMask & b->aspectMask) &&
+		(a->baseMipLevel < b->baseMipLevel + bLevels) && (b->baseMipLevel < a->baseMipLevel + aLevels) &&
+		(a->baseArrayLayer < b->baseArrayLayer + bLayers) && (b->baseArrayLayer < a->baseArrayLayer + aLayers);
+}
+
+/* A function to fold a barrier into a pending one for the same memory. Nothing is recorded between the two, so the
+   union of both scopes covers everything either one had to wait for, and a layout transition followed by another
+   becomes a single transition from the first old layout to the second new one */
+/* @param A Pointer to the src stages of the pending barrier */
+/* @param A Pointer to the src access of the pending barrier */
+/* @param A Pointer to the dst stages of the pending barrier */
+/* @param A Pointer to the dst access of the pending barrier */
+/* @param The src stages of the new barrier */
+/* @param The src access of the new barrier */
+/* @param The dst stages of the new barrier */
+/* @param The dst access of the new barrier */
+void MergeBarrierScopes(VkPipelineStageFlags2KHR* srcStages, VkAccessFlags2KHR* srcAccess, VkPipelineStageFlags2KHR* dstStages, VkAccessFlags2KHR* dstAccess,
+	VkPipelineStageFlags2KHR newSrcStages, VkAccessFlags2KHR newSrcAccess, VkPipelineStageFlags2KHR newDstStages, VkAccessFlags2KHR newDstAccess)
+{
+	*srcStages |= newSrcStages;
+	*srcAccess |= newSrcAccess;
+	*dstStages |= newDstStages;
+	*dstAccess |= newDstAccess;
+}
+
+/* A function to add a global memory barrier */
+/* @param A Pointer to the batcher */
+/* @param The stages that have to finish */
+/* @param The writes that have to be made available */
+/* @param The stages that wait */
+/* @param The accesses that have to see the writes */
+void AddMemoryBarrier(BarrierBatcher* batcher, VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+{
+	++batcher->Stats.Requested;
+	if (batcher->HasMemory)
+	{
+		++batcher->Stats.Merged;
+		MergeBarrierScopes(&batcher->Memory.srcStageMask, &batcher->Memory.srcAccessMask, &batcher->Memory.dstStageMask, &batcher->Memory.dstAccessMask,
+			srcStages, srcAccess, dstStages, dstAccess);
+		return;
+	}
+
+	VkMemoryBarrier2KHR barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR, nullptr, srcStages, srcAccess, dstStages, dstAccess };
+	batcher->Memory = barrier;
+	batcher->HasMemory = true;
+}
+
+void FlushBarriers(BarrierBatcher* batcher, VkCommandBuffer commandBuffer);
+
+/* A function to add a barrier on a range of a buffer */
+/* @param A Pointer to the batcher */
+/* @param The command buffer, pending barriers are flushed to it first if they cannot be merged with this one */
+/* @param The buffer */
+/* @param The start of the range */
+/* @param The size of the range, or VK_WHOLE_SIZE */
+/* @param The stages that have to finish */
+/* @param The writes that have to be made available */
+/* @param The stages that wait */
+/* @param The accesses that have to see the writes */
+void AddBufferBarrier(BarrierBatcher* batcher, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+	VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+{
+	++batcher->Stats.Requested;
+	for (u64 i = 0; i < vec_length(batcher->Buffers); ++i)
+	{
+		VkBufferMemoryBarrier2KHR* pending = &((VkBufferMemoryBarrier2KHR*)batcher->Buffers)[i];
+		if (pending->buffer != buffer)
+			continue;
+
+		if ((pending->offset == offset) && (pending->size == size))
+		{
+			++batcher->Stats.Merged;
+			MergeBarrierScopes(&pending->srcStageMask, &pending->srcAccessMask, &pending->dstStageMask, &pending->dstAccessMask,
+				srcStages, srcAccess, dstStages, dstAccess);
+			return;
+		}
+
+		/* Barriers in one command are not ordered, so one that overlaps another part of a pending range has to wait */
+		VkDeviceSize pendingEnd = pending->size == VK_WHOLE_SIZE ? ~0ull : pending->offset + pending->size;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? ~0ull : offset + size;
+		if ((offset < pendingEnd) && (pending->offset < end))
+		{
+			FlushBarriers(batcher, commandBuffer);
+			break;
+		}
+	}
+
+	VkBufferMemoryBarrier2KHR barrier =
+	{
+		VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR, nullptr, srcStages, srcAccess, dstStages, dstAccess,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, buffer, offset, size
+	};
+	vec_pushback(batcher->Buffers, barrier, VkBufferMemoryBarrier2KHR);
+}
+
+/* A function to add a barrier on subresources of an image, with a layout transition if the layouts differ */
+/* @param A Pointer to the batcher */
+/* @param The command buffer, pending barriers are flushed to it first if they cannot be merged with this one */
+/* @param The image */
+/* @param The subresources */
+/* @param The layout before, VK_IMAGE_LAYOUT_UNDEFINED to throw the contents away */
+/* @param The layout after */
+/* @param The stages that have to finish */
+/* @param The writes that have to be made available */
+/* @param The stages that wait */
+/* @param The accesses that have to see the writes */
+void AddImageBarrier(BarrierBatcher* batcher, VkCommandBuffer commandBuffer, VkImage image, VkImageSubresourceRange range, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+{
+	++batcher->Stats.Requested;
+	for (u64 i = 0; i < vec_length(batcher->Images); ++i)
+	{
+		VkImageMemoryBarrier2KHR* pending = &((VkImageMemoryBarrier2KHR*)batcher->Images)[i];
+		if ((pending->image != image) || !DoSubresourceRangesOverlap(&pending->subresourceRange, &range))
+			continue;
+
+		/* The second barrier has to start from the layout the first one leaves, or throw the contents away */
+		bool sameRange = memcmp(&pending->subresourceRange, &range, sizeof(VkImageSubresourceRange)) == 0;
+		if (sameRange && ((oldLayout == pending->newLayout) || (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)))
+		{
+			++batcher->Stats.Merged;
+			MergeBarrierScopes(&pending->srcStageMask, &pending->srcAccessMask, &pending->dstStageMask, &pending->dstAccessMask,
+				srcStages, srcAccess, dstStages, dstAccess);
+			pending->newLayout = newLayout;
+			return;
+		}
+
+		FlushBarriers(batcher, commandBuffer);
+		break;
+	}
+
+	VkImageMemoryBarrier2KHR barrier =
+	{
+		VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR, nullptr, srcStages, srcAccess, dstStages, dstAccess,
+		oldLayout, newLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range
+	};
+	vec_pushback(batcher->Images, barrier, VkImageMemoryBarrier2KHR);
+}
+
+/* A function to turn synchronization2 stages into the ones vkCmdPipelineBarrier knows */
+/* @param The stages */
+/* @param The stage to use if there are none */
+VkPipelineStageFlags GetLegacyPipelineStages(VkPipelineStageFlags2KHR stages, VkPipelineStageFlags none)
+{
+	VkPipelineStageFlags legacy = (VkPipelineStageFlags)(stages & 0xFFFFFFFFull);
+	if (stages & (VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_RESOLVE_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR))
+		legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+	if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR))
+		legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	if (stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT_KHR)
+		legacy |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+			VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+	return legacy ? legacy : none;
+}
+
+/* A function to turn synchronization2 accesses into the ones vkCmdPipelineBarrier knows */
+/* @param The accesses */
+VkAccessFlags GetLegacyAccess(VkAccessFlags2KHR access)
+{
+	VkAccessFlags legacy = (VkAccessFlags)(access & 0xFFFFFFFFull);
+	if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR))
+		legacy |= VK_ACCESS_SHADER_READ_BIT;
+	if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR)
+		legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+	return legacy;
+}
+
+/* A function to record the pending barriers as one pipeline barrier, call it right before the command that depends
+   on them. Does nothing if none are pending */
+/* @param A Pointer to the batcher */
+/* @param The command buffer being recorded */
+void FlushBarriers(BarrierBatcher* batcher, VkCommandBuffer commandBuffer)
+{
+	u32 bufferCount = (u32)vec_length(batcher->Buffers);
+	u32 imageCount = (u32)vec_length(batcher->Images);
+	u32 memoryCount = batcher->HasMemory ? 1 : 0;
+	if (bufferCount + imageCount + memoryCount == 0)
+		return;
+
+	if (batcher->Synchronization2)
+	{
+		VkDependencyInfoKHR dependencyInfo =
+		{
+			VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR, nullptr, 0, memoryCount, &batcher->Memory,
+			bufferCount, (const VkBufferMemoryBarrier2KHR*)batcher->Buffers, imageCount, (const VkImageMemoryBarrier2KHR*)batcher->Images
+		};
+		batcher->CmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+	}
+	else
+	{
+		/* vkCmdPipelineBarrier only has one pair of stage masks, so every barrier shares the union of them */
+		VkPipelineStageFlags2KHR srcStages = batcher->HasMemory ? batcher->Memory.srcStageMask : 0;
+		VkPipelineStageFlags2KHR dstStages = batcher->HasMemory ? batcher->Memory.dstStageMask : 0;
+		VkMemoryBarrier memoryBarrier =
+		{
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, GetLegacyAccess(batcher->Memory.srcAccessMask), GetLegacyAccess(batcher->Memory.dstAccessMask)
+		};
+
+		vec_clear(batcher->LegacyBuffers);
+		for (u32 i = 0; i < bufferCount; ++i)
+		{
+			VkBufferMemoryBarrier2KHR* barrier = &((VkBufferMemoryBarrier2KHR*)batcher->Buffers)[i];
+			srcStages |= barrier->srcStageMask;
+			dstStages |= barrier->dstStageMask;
+			VkBufferMemoryBarrier legacy =
+			{
+				VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr, GetLegacyAccess(barrier->srcAccessMask), GetLegacyAccess(barrier->dstAccessMask),
+				barrier->srcQueueFamilyIndex, barrier->dstQueueFamilyIndex, barrier->buffer, barrier->offset, barrier->size
+			};
+			vec_pushback(batcher->LegacyBuffers, legacy, VkBufferMemoryBarrier);
+		}
+
+		vec_clear(batcher->LegacyImages);
+		for (u32 i = 0; i < imageCount; ++i)
+		{
+			VkImageMemoryBarrier2KHR* barrier = &((VkImageMemoryBarrier2KHR*)batcher->Images)[i];
+			srcStages |= barrier->srcStageMask;
+			dstStages |= barrier->dstStageMask;
+			VkImageMemoryBarrier legacy =
+			{
+				VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr, GetLegacyAccess(barrier->srcAccessMask), GetLegacyAccess(barrier->dstAccessMask),
+				barrier->oldLayout, barrier->newLayout, barrier->srcQueueFamilyIndex, barrier->dstQueueFamilyIndex, barrier->image, barrier->subresourceRange
+			};
+			vec_pushback(batcher->LegacyImages, legacy, VkImageMemoryBarrier);
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, GetLegacyPipelineStages(srcStages, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+			GetLegacyPipelineStages(dstStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT), 0, memoryCount, &memoryBarrier,
+			bufferCount, (const VkBufferMemoryBarrier*)batcher->LegacyBuffers, imageCount, (const VkImageMemoryBarrier*)batcher->LegacyImages);
+	}
+
+	batcher->Stats.Emitted += bufferCount + imageCount + memoryCount;
+	++batcher->Stats.Flushes;
+	vec_clear(batcher->Buffers);
+	vec_clear(batcher->Images);
+	batcher->HasMemory = false;
+}
+
+/* A function for getting the counters of a batcher */
+/* @param A Pointer to the batcher */
+/* @param A Pointer to the BarrierBatcherStats to be filled */
+void GetBarrierBatcherStats(BarrierBatcher* batcher, BarrierBatcherStats* stats)
+{
+	*stats = batcher->Stats;
+}
+
+/* A function to print the counters of a batcher */
+/* @param A Pointer to the batcher */
+void PrintBarrierBatcherStats(BarrierBatcher* batcher)
+{
+	printf("INFO: %llu barriers requested, %llu emitted in %llu pipeline barriers with %s, %llu merged\n",
+		(unsigned long long)batcher->Stats.Requested, (unsigned long long)batcher->Stats.Emitted, (unsigned long long)batcher->Stats.Flushes,
+		batcher->Synchronization2 ? "vkCmdPipelineBarrier2KHR" : "vkCmdPipelineBarrier", (unsigned long long)batcher->Stats.Merged);
+}
+
+/* A function to free a batcher, pending barriers are dropped */
+/* @param A pointer to the batcher */
+void DestroyBarrierBatcher(BarrierBatcher* batcher)
+{
+	vec_destroy(batcher->Buffers);
+	vec_destroy(batcher->Images);
+	vec_destroy(batcher->LegacyBuffers);
+	vec_destroy(batcher->LegacyImages);
+	memset(batcher, 0, sizeof(BarrierBatcher));
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+
+#define COMMAND_RECYCLER_MAX_FRAMES 3
+#define COMMAND_RECYCLER_GROWTH 4	/* The fewest buffers allocated at once when a frame runs out */
+
+/* A structure for the command buffers of one frame in flight */
+typedef struct {
+	VkCommandPool Pool;		/* The pool, reset as a whole when the frame comes around again */
+	Vec Buffers[2];			/* A Vector of VkCommandBuffer for primary and secondary buffers, they only ever grow */
+	u32 Used[2];			/* How many of each were handed out this frame */
+} CommandRecyclerFrame;
+
+/* A structure for the counters of a recycler */
+typedef struct {
+	u64 AllocationCalls;	/* Calls to vkAllocateCommandBuffers, flat once the frames are warm */
+	u64 Buffers;			/* Command buffers owned by the recycler */
+	u64 Acquired;			/* Command buffers handed out */
+	u64 PoolResets;			/* Calls to vkResetCommandPool */
+} CommandRecyclerStats;
+
+/* A structure for handing out command buffers that are reused frame after frame instead of allocated. Like the
+   pools in it, a recycler may only be used by one thread at a time */
+typedef struct {
+	VkDevice* LogicalDevice;	/* The logical device */
+	u32 FrameCount;				/* The number of frames in flight */
+	u32 Frame;					/* The frame being recorded */
+	CommandRecyclerFrame Frames[COMMAND_RECYCLER_MAX_FRAMES];	/* The buffers of each frame */
+	CommandRecyclerStats Stats;	/* The counters */
+} CommandBufferRecycler;
+
+/* A function to create a command buffer recycler */
+/* @param A Pointer to a logical device */
+/* @param The queue family the command buffers are submitted to */
+/* @param The number of frames in flight */
+/* @param A Pointer to the CommandBufferRecycler to be filled */
+bool CreateCommandBufferRecycler(VkDevice* logicalDevice, u32 queueFamily, u32 frameCount, CommandBufferRecycler* recycler)
+{
+	memset(recycler, 0, sizeof(CommandBufferRecycler));
+	if ((frameCount == 0) || (frameCount > COMMAND_RECYCLER_MAX_FRAMES))
+	{
+		printf("ERROR: A command buffer recycler needs between 1 and %d frames in flight!\n", COMMAND_RECYCLER_MAX_FRAMES);
+		return false;
+	}
+
+	recycler->LogicalDevice = logicalDevice;
+	recycler->FrameCount = frameCount;
+	for (u32 i = 0; i < frameCount; ++i)
+	{
+		recycler->Frames[i].Buffers[0] = vec_create(VkCommandBuffer);
+		recycler->Frames[i].Buffers[1] = vec_create(VkCommandBuffer);
+		if (!CreateCommandPool(logicalDevice, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queueFamily, &recycler->Frames[i].Pool))
+			return false;
+	}
+
+	return true;
+}
+
+/* A function to start a frame, every buffer handed out the last time this frame was recorded is reset at once */
+/* @param A Pointer to the recycler */
+/* @param The frame in flight, from 0 to FrameCount - 1 */
+/* @param A Pointer to the fence of the last submit of this frame, it is waited on first, null if it already signaled */
+bool BeginCommandBufferRecyclerFrame(CommandBufferRecycler* recycler, u32 frame, VkFence* fence)
+{
+	if (fence && (vkWaitForFences(*recycler->LogicalDevice, 1, fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS))
+	{
+		printf("ERROR: Could not wait for the fence of a frame!\n");
+		return false;
+	}
+
+	CommandRecyclerFrame* current = &recycler->Frames[frame];
+	recycler->Frame = frame;
+	current->Used[0] = 0;
+	current->Used[1] = 0;
+	++recycler->Stats.PoolResets;
+	return ResetCommandPool(recycler->LogicalDevice, &current->Pool, false);
+}
+
+/* A function to get a command buffer for the current frame, it is reset and ready to begin */
+/* @param A Pointer to the recycler */
+/* @param Primary or secondary */
+/* @param A Pointer to the VkCommandBuffer to be filled */
+bool AcquireCommandBuffer(CommandBufferRecycler* recycler, VkCommandBufferLevel level, VkCommandBuffer* commandBuffer)
+{
+	CommandRecyclerFrame* current = &recycler->Frames[recycler->Frame];
+	u32 index = level == VK_COMMAND_BUFFER_LEVEL_SECONDARY ? 1 : 0;
+	u32 count = (u32)vec_length(current->Buffers[index]);
+
+	/* Only a frame that needs more buffers than ever before allocates, and then several at once */
+	if (current->Used[index] == count)
+	{
+		u32 growth = count > COMMAND_RECYCLER_GROWTH ? count : COMMAND_RECYCLER_GROWTH;
+		Vec allocated = AllocateCommandBuffers(recycler->LogicalDevice, &current->Pool, level, growth);
+		if (allocated == nullptr)
+			return false;
+
+		for (u32 i = 0; i < growth; ++i)
+			vec_pushback(current->Buffers[index], ((VkCommandBuffer*)allocated)[i], VkCommandBuffer);
+		vec_destroy(allocated);
+
+		++recycler->Stats.AllocationCalls;
+		recycler->Stats.Buffers += growth;
+	}
+
+	*commandBuffer = ((VkCommandBuffer*)current->Buffers[index])[current->Used[index]++];
+	++recycler->Stats.Acquired;
+	return true;
+}
+
+/* A function for getting the counters of a recycler */
+/* @param A Pointer to the recycler */
+/* @param A Pointer to the CommandRecyclerStats to be filled */
+void GetCommandBufferRecyclerStats(CommandBufferRecycler* recycler, CommandRecyclerStats* stats)
+{
+	*stats = recycler->Stats;
+}
+
+/* A function to clean up created vulkan resources, the GPU must be done with every frame */
+/* @param A pointer to the resource to cleanup */
+void DestroyCommandBufferRecycler(CommandBufferRecycler* recycler)
+{
+	/* Destroying the pools frees their buffers */
+	for (u32 i = 0; i < recycler->FrameCount; ++i)
+	{
+		if (recycler->Frames[i].Pool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(*recycler->LogicalDevice, recycler->Frames[i].Pool, nullptr);
+		vec_destroy(recycler->Frames[i].Buffers[0]);
+		vec_destroy(recycler->Frames[i].Buffers[1]);
+	}
+
+	memset(recycler, 0, sizeof(CommandBufferRecycler));
+}
@@ -0,0 +1,445 @@
+#pragma once
+#include <stdlib.h>
+#include <VkHelper/VkHelper.h>
+#include <Hash/Hash.h>
+#include <PipelineState/PipelineState.h>
+#include <PipelineBuilder/PipelineBuilder.h>
+
+#define RENDER_TARGET_MAX_COLORS PIPELINE_STATE_MAX_ATTACHMENTS
+#define RENDER_TARGET_TABLE_INITIAL_CAPACITY 64
+
+/* A structure for one attachment rendered to. The image must already be in Layout, nothing is transitioned, the same
+   as with vkCmdBeginRenderingKHR */
+typedef struct {
+	VkImageView View;				/* The view rendered to */
+	VkFormat Format;				/* The format of the view */
+	VkImageLayout Layout;			/* The layout of the image while rendering */
+	VkAttachmentLoadOp LoadOp;		/* What happens to the contents at the start */
+	VkAttachmentStoreOp StoreOp;	/* What happens to the contents at the end */
+	VkClearValue Clear;				/* The clear value when LoadOp is VK_ATTACHMENT_LOAD_OP_CLEAR */
+} RenderTargetAttachment;
+
+/* A structure for everything rendered to between BeginRendering and EndRendering, single sampled */
+typedef struct {
+	VkExtent2D Extent;				/* The size of the attachments, the whole of it is rendered to */
+	u32 ColorCount;					/* The number of color attachments */
+	RenderTargetAttachment Colors[RENDER_TARGET_MAX_COLORS];	/* The color attachments */
+	RenderTargetAttachment Depth;	/* The depth and stencil attachment, View is VK_NULL_HANDLE when there is none */
+} RenderTargetDescription;
+
+/* A structure for the part of an attachment a render pass is made from */
+typedef struct {
+	VkFormat Format;
+	VkImageLayout Layout;
+	VkAttachmentLoadOp LoadOp;
+	VkAttachmentStoreOp StoreOp;
+} RenderTargetAttachmentKey;
+
+/* A structure for the key of a compatibility render pass, only 32 bit fields so it has no padding */
+typedef struct {
+	u32 ColorCount;
+	u32 HasDepth;
+	RenderTargetAttachmentKey Attachments[RENDER_TARGET_MAX_COLORS + 1];	/* The colors, then the depth */
+} RenderTargetPassKey;
+
+/* A structure for the key of a compatibility framebuffer, the views are handles so it is only good until they are destroyed */
+typedef struct {
+	VkRenderPass RenderPass;
+	u32 Width;
+	u32 Height;
+	u32 ViewCount;
+	u32 Reserved;
+	VkImageView Views[RENDER_TARGET_MAX_COLORS + 1];	/* The colors, then the depth */
+} RenderTargetFramebufferKey;
+
+/* A structure for an entry of a render target table */
+typedef struct {
+	u64 Hash;		/* The hash of the key, 0 marks an empty slot */
+	u64 Value;		/* The VkRenderPass or VkFramebuffer */
+	union {
+		RenderTargetPassKey Pass;
+		RenderTargetFramebufferKey Framebuffer;
+	} Key;			/* The key, two keys with the same hash are told apart with it */
+} RenderTargetEntry;
+
+/* A structure for an open addressed table of render passes or framebuffers */
+typedef struct {
+	RenderTargetEntry* Entries;	/* The slots, the capacity is a power of 2 */
+	u32 Capacity;				/* The number of slots */
+	u32 Count;					/* The number of filled slots */
+	u32 KeySize;				/* The size of the keys of this table */
+} RenderTargetTable;
+
+/* A structure for the counters of a render target cache */
+typedef struct {
+	u64 Begins;					/* Calls to BeginRendering */
+	u64 RenderPassesCreated;	/* Render passes created on the compatibility path */
+	u64 FramebuffersCreated;	/* Framebuffers created on the compatibility path */
+	u64 FramebuffersDestroyed;	/* Framebuffers destroyed because a view they used went away */
+} RenderTargetStats;
+
+/* A structure for beginning and ending rendering. With dynamic rendering nothing is created at all, without it the
+   render passes and framebuffers are made once per combination of attachments and looked up after that, so neither
+   path creates objects in a warm frame. It may only be used by one thread at a time */
+typedef struct {
+	VkDevice* LogicalDevice;					/* The logical device */
+	bool Dynamic;								/* If vkCmdBeginRenderingKHR is used */
+	PFN_vkCmdBeginRenderingKHR CmdBeginRendering;	/* Extension commands, from vkGetDeviceProcAddr */
+	PFN_vkCmdEndRenderingKHR CmdEndRendering;
+	RenderTargetTable RenderPasses;				/* The compatibility render passes by RenderTargetPassKey */
+	RenderTargetTable Framebuffers;				/* The compatibility framebuffers by RenderTargetFramebufferKey */
+	RenderTargetStats Stats;					/* The counters */
+} RenderTargetCache;
+
+/* A function to create an empty render target table */
+/* @param The size of the keys */
+/* @param A Pointer to the RenderTargetTable to be filled */
+void CreateRenderTargetTable(u32 keySize, RenderTargetTable* table)
+{
+	table->Capacity = RENDER_TARGET_TABLE_INITIAL_CAPACITY;
+	table->Count = 0;
+	table->KeySize = keySize;
+	table->Entries = (RenderTargetEntry*)calloc(table->Capacity, sizeof(RenderTargetEntry));
+}
+
+/* A function for finding the slot of a key, or the empty slot it would go in */
+/* @param A Pointer to the table */
+/* @param A Pointer to the key */
+/* @param The hash of the key */
+RenderTargetEntry* FindRenderTargetSlot(RenderTargetTable* table, const void* key, u64 hash)
+{
+	u32 mask = table->Capacity - 1;
+	for (u32 slot = (u32)hash & mask;; slot = (slot + 1) & mask)
+	{
+		RenderTargetEntry* entry = &table->Entries[slot];
+		if ((entry->Hash == 0) || ((entry->Hash == hash) && (memcmp(&entry->Key, key, table->KeySize) == 0)))
+			return entry;
+	}
+}
+
+/* A function to put an entry in a table that has no entry for its key yet, growing it when it gets full */
+/* @param A Pointer to the table */
+/* @param A Pointer to the entry */
+void InsertRenderTargetEntry(RenderTargetTable* table, const RenderTargetEntry* entry)
+{
+	*FindRenderTargetSlot(table, &entry->Key, entry->Hash) = *entry;
+
+	/* Kept under 3/4 full so probes stay short */
+	if (++table->Count * 4 > table->Capacity * 3)
+	{
+		RenderTargetEntry* entries = table->Entries;
+		u32 capacity = table->Capacity;
+
+		table->Capacity = capacity * 2;
+		table->Entries = (RenderTargetEntry*)calloc(table->Capacity, sizeof(RenderTargetEntry));
+		for (u32 i = 0; i < capacity; ++i)
+			if (entries[i].Hash != 0)
+				*FindRenderTargetSlot(table, &entries[i].Key, entries[i].Hash) = entries[i];
+		free(entries);
+	}
+}
+
+/* A function for the hash of a key, never 0 since that marks empty slots */
+/* @param A Pointer to the key */
+/* @param The size of the key */
+u64 GetRenderTargetHash(const void* key, u32 keySize)
+{
+	u64 hash = HashWords(key, keySize, HASH_SEED);
+	return hash ? hash : 1;
+}
+
+/* A function to create a render target cache */
+/* @param A Pointer to a logical device */
+/* @param If the device was created with dynamic rendering, DeviceFeatureChain.DynamicRenderingFeatures.dynamicRendering */
+/* @param A Pointer to the RenderTargetCache to be filled */
+bool CreateRenderTargetCache(VkDevice* logicalDevice, bool dynamicRendering, RenderTargetCache* cache)
+{
+	memset(cache, 0, sizeof(RenderTargetCache));
+	cache->LogicalDevice = logicalDevice;
+	CreateRenderTargetTable(sizeof(RenderTargetPassKey), &cache->RenderPasses);
+	CreateRenderTargetTable(sizeof(RenderTargetFramebufferKey), &cache->Framebuffers);
+
+	if (dynamicRendering)
+	{
+		cache->CmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(*logicalDevice, "vkCmdBeginRenderingKHR");
+		cache->CmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(*logicalDevice, "vkCmdEndRenderingKHR");
+		cache->Dynamic = (cache->CmdBeginRendering != nullptr) && (cache->CmdEndRendering != nullptr);
+		if (!cache->Dynamic)
+			printf("WARNING: Could not load the dynamic rendering commands, render passes are used instead!\n");
+	}
+
+	return true;
+}
+
+/* A function to fill the attachment formats of a pipeline state from what it will render to */
+/* @param A Pointer to the description of the attachments */
+/* @param A Pointer to the pipeline state */
+void SetPipelineStateRenderTargets(const RenderTargetDescription* description, PipelineState* state)
+{
+	state->ColorCount = description->ColorCount;
+	for (u32 i = 0; i < RENDER_TARGET_MAX_COLORS; ++i)
+		state->ColorFormats[i] = i < description->ColorCount ? description->Colors[i].Format : VK_FORMAT_UNDEFINED;
+	state->DepthFormat = description->Depth.View != VK_NULL_HANDLE ? description->Depth.Format : VK_FORMAT_UNDEFINED;
+}
+
+/* A function for getting the compatibility render pass of some attachments, creating it on a miss. Pipelines made
+   for it work with any render pass of the same formats, so it can also be registered with the pipeline manager */
+/* @param A Pointer to the render target cache */
+/* @param A Pointer to the description of the attachments */
+/* @param A Pointer to the VkRenderPass to be filled */
+bool GetRenderTargetRenderPass(RenderTargetCache* cache, const RenderTargetDescription* description, VkRenderPass* renderPass)
+{
+	RenderTargetEntry entry;
+	memset(&entry, 0, sizeof(RenderTargetEntry));
+	RenderTargetPassKey* key = &entry.Key.Pass;
+	key->ColorCount = description->ColorCount;
+	key->HasDepth = description->Depth.View != VK_NULL_HANDLE;
+	for (u32 i = 0; i < key->ColorCount + key->HasDepth; ++i)
+	{
+		const RenderTargetAttachment* attachment = i < key->ColorCount ? &description->Colors[i] : &description->Depth;
+		RenderTargetAttachmentKey attachmentKey = { attachment->Format, attachment->Layout, attachment->LoadOp, attachment->StoreOp };
+		key->Attachments[i] = attachmentKey;
+	}
+
+	entry.Hash = GetRenderTargetHash(key, sizeof(RenderTargetPassKey));
+	RenderTargetEntry* found = FindRenderTargetSlot(&cache->RenderPasses, key, entry.Hash);
+	if (found->Hash != 0)
+	{
+		*renderPass = (VkRenderPass)found->Value;
+		return true;
+	}
+
+	VkAttachmentDescription attachments[RENDER_TARGET_MAX_COLORS + 1];
+	VkAttachmentReference references[RENDER_TARGET_MAX_COLORS + 1];
+	for (u32 i = 0; i < key->ColorCount + key->HasDepth; ++i)
+	{
+		const RenderTargetAttachmentKey* attachmentKey = &key->Attachments[i];
+		bool stencil = (i == key->ColorCount) && IsStencilFormat(attachmentKey->Format);
+
+		/* The layout stays the same from start to end, barriers outside the render pass do the transitions */
+		VkAttachmentDescription attachment =
+		{
+			0, attachmentKey->Format, VK_SAMPLE_COUNT_1_BIT, attachmentKey->LoadOp, attachmentKey->StoreOp,
+			stencil ? attachmentKey->LoadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE, stencil ? attachmentKey->StoreOp : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			attachmentKey->Layout, attachmentKey->Layout
+		};
+		VkAttachmentReference reference = { i, attachmentKey->Layout };
+		attachments[i] = attachment;
+		references[i] = reference;
+	}
+
+	VkSubpassDescription subpass =
+	{
+		0, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, nullptr, key->ColorCount, references, nullptr,
+		key->HasDepth ? &references[key->ColorCount] : nullptr, 0, nullptr
+	};
+
+	VkRenderPassCreateInfo renderPassCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO, nullptr, 0, key->ColorCount + key->HasDepth, attachments, 1, &subpass, 0, nullptr
+	};
+
+	if (vkCreateRenderPass(*cache->LogicalDevice, &renderPassCreateInfo, nullptr, renderPass) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a compatibility render pass!\n");
+		return false;
+	}
+
+	entry.Value = (u64)*renderPass;
+	InsertRenderTargetEntry(&cache->RenderPasses, &entry);
+	++cache->Stats.RenderPassesCreated;
+	return true;
+}
+
+/* A function for getting the compatibility framebuffer of some attachments, creating it on a miss */
+/* @param A Pointer to the render target cache */
+/* @param The render pass of the attachments */
+/* @param A Pointer to the description of the attachments */
+/* @param A Pointer to the VkFramebuffer to be filled */
+bool GetRenderTargetFramebuffer(RenderTargetCache* cache, VkRenderPass renderPass, const RenderTargetDescription* description, VkFramebuffer* framebuffer)
+{
+	RenderTargetEntry entry;
+	memset(&entry, 0, sizeof(RenderTargetEntry));
+	RenderTargetFramebufferKey* key = &entry.Key.Framebuffer;
+	key->RenderPass = renderPass;
+	key->Width = description->Extent.width;
+	key->Height = description->Extent.height;
+	for (u32 i = 0; i < description->ColorCount; ++i)
+		key->Views[key->ViewCount++] = description->Colors[i].View;
+	if (description->Depth.View != VK_NULL_HANDLE)
+		key->Views[key->ViewCount++] = description->Depth.View;
+
+	entry.Hash = GetRenderTargetHash(key, sizeof(RenderTargetFramebufferKey));
+	RenderTargetEntry* found = FindRenderTargetSlot(&cache->Framebuffers, key, entry.Hash);
+	if (found->Hash != 0)
+	{
+		*framebuffer = (VkFramebuffer)found->Value;
+		return true;
+	}
+
+	VkFramebufferCreateInfo framebufferCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO, nullptr, 0, renderPass, key->ViewCount, key->Views, key->Width, key->Height, 1
+	};
+
+	if (vkCreateFramebuffer(*cache->LogicalDevice, &framebufferCreateInfo, nullptr, framebuffer) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a compatibility framebuffer!\n");
+		return false;
+	}
+
+	entry.Value = (u64)*framebuffer;
+	InsertRenderTargetEntry(&cache->Framebuffers, &entry);
+	++cache->Stats.FramebuffersCreated;
+	return true;
+}
+
+/* A function to begin rendering to some attachments, with vkCmdBeginRenderingKHR or a cached render pass */
+/* @param A Pointer to the render target cache */
+/* @param The command buffer being recorded */
+/* @param A Pointer to the description of the attachments */
+bool BeginRendering(RenderTargetCache* cache, VkCommandBuffer commandBuffer, const RenderTargetDescription* description)
+{
+	VkRect2D renderArea = { { 0, 0 }, description->Extent };
+	++cache->Stats.Begins;
+
+	if (cache->Dynamic)
+	{
+		VkRenderingAttachmentInfoKHR colors[RENDER_TARGET_MAX_COLORS];
+		for (u32 i = 0; i < description->ColorCount; ++i)
+		{
+			const RenderTargetAttachment* color = &description->Colors[i];
+			VkRenderingAttachmentInfoKHR attachment =
+			{
+				VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR, nullptr, color->View, color->Layout,
+				VK_RESOLVE_MODE_NONE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED, color->LoadOp, color->StoreOp, color->Clear
+			};
+			colors[i] = attachment;
+		}
+
+		const RenderTargetAttachment* depth = &description->Depth;
+		VkRenderingAttachmentInfoKHR depthAttachment =
+		{
+			VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR, nullptr, depth->View, depth->Layout,
+			VK_RESOLVE_MODE_NONE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED, depth->LoadOp, depth->StoreOp, depth->Clear
+		};
+		bool hasDepth = (depth->View != VK_NULL_HANDLE) && (depth->Format != VK_FORMAT_S8_UINT);
+		bool hasStencil = (depth->View != VK_NULL_HANDLE) && IsStencilFormat(depth->Format);
+
+		VkRenderingInfoKHR renderingInfo =
+		{
+			VK_STRUCTURE_TYPE_RENDERING_INFO_KHR, nullptr, 0, renderArea, 1, 0, description->ColorCount, colors,
+			hasDepth ? &depthAttachment : nullptr, hasStencil ? &depthAttachment : nullptr
+		};
+		cache->CmdBeginRendering(commandBuffer, &renderingInfo);
+		return true;
+	}
+
+	VkRenderPass renderPass;
+	VkFramebuffer framebuffer;
+	if (!GetRenderTargetRenderPass(cache, description, &renderPass) || !GetRenderTargetFramebuffer(cache, renderPass, description, &framebuffer))
+		return false;
+
+	VkClearValue clearValues[RENDER_TARGET_MAX_COLORS + 1];
+	u32 clearCount = 0;
+	for (u32 i = 0; i < description->ColorCount; ++i)
+		clearValues[clearCount++] = description->Colors[i].Clear;
+	if (description->Depth.View != VK_NULL_HANDLE)
+		clearValues[clearCount++] = description->Depth.Clear;
+
+	VkRenderPassBeginInfo renderPassBeginInfo =
+	{
+		VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO, nullptr, renderPass, framebuffer, renderArea, clearCount, clearValues
+	};
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	return true;
+}
+
+/* A function to end rendering begun with BeginRendering */
+/* @param A Pointer to the render target cache */
+/* @param The command buffer being recorded */
+void EndRendering(RenderTargetCache* cache, VkCommandBuffer commandBuffer)
+{
+	if (cache->Dynamic)
+		cache->CmdEndRendering(commandBuffer);
+	else
+		vkCmdEndRenderPass(commandBuffer);
+}
+
+/* A function to destroy the framebuffers that use some image views, call it before destroying the views, for example
+   the ones of an old swapchain. The GPU must be done with the framebuffers. Does nothing with dynamic rendering */
+/* @param A Pointer to the render target cache */
+/* @param An array of the image views */
+/* @param The number of image views */
+void ForgetRenderTargetViews(RenderTargetCache* cache, const VkImageView* views, u32 viewCount)
+{
+	RenderTargetTable* table = &cache->Framebuffers;
+	RenderTargetEntry* entries = table->Entries;
+	u32 capacity = table->Capacity;
+	bool removed = false;
+
+	for (u32 i = 0; i < capacity; ++i)
+	{
+		RenderTargetFramebufferKey* key = &entries[i].Key.Framebuffer;
+		bool uses = false;
+		for (u32 j = 0; (entries[i].Hash != 0) && !uses && (j < key->ViewCount); ++j)
+			for (u32 k = 0; !uses && (k < viewCount); ++k)
+				uses = key->Views[j] == views[k];
+
+		if (uses)
+		{
+			vkDestroyFramebuffer(*cache->LogicalDevice, (VkFramebuffer)entries[i].Value, nullptr);
+			entries[i].Hash = 0;
+			++cache->Stats.FramebuffersDestroyed;
+			removed = true;
+		}
+	}
+
+	if (!removed)
+		return;
+
+	/* Emptied slots would break the probe chains through them, so the ones left are put in again */
+	table->Entries = (RenderTargetEntry*)calloc(capacity, sizeof(RenderTargetEntry));
+	table->Count = 0;
+	for (u32 i = 0; i < capacity; ++i)
+		if (entries[i].Hash != 0)
+		{
+			*FindRenderTargetSlot(table, &entries[i].Key, entries[i].Hash) = entries[i];
+			++table->Count;
+		}
+	free(entries);
+}
+
+/* A function for getting the counters of a render target cache */
+/* @param A Pointer to the render target cache */
+/* @param A Pointer to the RenderTargetStats to be filled */
+void GetRenderTargetStats(RenderTargetCache* cache, RenderTargetStats* stats)
+{
+	*stats = cache->Stats;
+}
+
+/* A function to print the counters of a render target cache */
+/* @param A Pointer to the render target cache */
+void PrintRenderTargetStats(RenderTargetCache* cache)
+{
+	printf("INFO: Rendering with %s, %llu begins, %llu render passes and %llu framebuffers created, %llu framebuffers destroyed\n",
+		cache->Dynamic ? "dynamic rendering" : "render passes", (unsigned long long)cache->Stats.Begins,
+		(unsigned long long)cache->Stats.RenderPassesCreated, (unsigned long long)cache->Stats.FramebuffersCreated,
+		(unsigned long long)cache->Stats.FramebuffersDestroyed);
+}
+
+/* A function to clean up created vulkan resources, the GPU must be done with them */
+/* @param A pointer to the resource to cleanup */
+void DestroyRenderTargetCache(RenderTargetCache* cache)
+{
+	for (u32 i = 0; i < cache->Framebuffers.Capacity; ++i)
+		if (cache->Framebuffers.Entries[i].Hash != 0)
+			vkDestroyFramebuffer(*cache->LogicalDevice, (VkFramebuffer)cache->Framebuffers.Entries[i].Value, nullptr);
+	for (u32 i = 0; i < cache->RenderPasses.Capacity; ++i)
+		if (cache->RenderPasses.Entries[i].Hash != 0)
+			vkDestroyRenderPass(*cache->LogicalDevice, (VkRenderPass)cache->RenderPasses.Entries[i].Value, nullptr);
+
+	free(cache->Framebuffers.Entries);
+	free(cache->RenderPasses.Entries);
+	memset(cache, 0, sizeof(RenderTargetCache));
+}
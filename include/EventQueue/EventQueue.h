@@ -0,0 +1,64 @@
+#pragma once
+#include <defines.h>
+#include <Threading/Threading.h>
+
+#define EVENT_QUEUE_CAPACITY 256	/* A power of 2 */
+
+/* The kinds of events the platform thread sends to the render thread */
+typedef enum {
+	PLATFORM_EVENT_RESIZE,		/* The client area changed size, 0 by 0 when minimized */
+	PLATFORM_EVENT_KEY_DOWN,	/* A key was pressed */
+	PLATFORM_EVENT_KEY_UP,		/* A key was released */
+	PLATFORM_EVENT_FOCUS,		/* The window gained or lost focus */
+	PLATFORM_EVENT_QUIT			/* The window was closed */
+} PlatformEventType;
+
+/* A structure for one event */
+typedef struct {
+	PlatformEventType Type;	/* The kind of event */
+	u32 Width;				/* The new width for a resize */
+	u32 Height;				/* The new height for a resize */
+	u32 Key;				/* The virtual key for key events, 1 or 0 for focus */
+} PlatformEvent;
+
+/* A structure for a queue with exactly one thread pushing and one thread popping, neither ever waits on the other.
+   Head and Tail live on their own cache lines so the two threads do not fight over one */
+typedef struct {
+	volatile i32 Head;		/* The next event to pop, only written by the consumer */
+	u8 HeadPadding[60];
+	volatile i32 Tail;		/* The next free slot, only written by the producer */
+	u8 TailPadding[60];
+	volatile i32 Dropped;	/* Events pushed while the queue was full */
+	PlatformEvent Events[EVENT_QUEUE_CAPACITY];	/* The ring of events */
+} EventQueue;
+
+/* A function to push an event, only the producer thread calls it. Returns false and drops the event if the queue is full */
+/* @param A Pointer to the queue */
+/* @param A Pointer to the event */
+bool PushEvent(EventQueue* queue, const PlatformEvent* event)
+{
+	i32 tail = AtomicLoad32(&queue->Tail);
+	if (tail - AtomicLoad32(&queue->Head) >= EVENT_QUEUE_CAPACITY)
+	{
+		AtomicAdd32(&queue->Dropped, 1);
+		return false;
+	}
+
+	queue->Events[tail & (EVENT_QUEUE_CAPACITY - 1)] = *event;
+	AtomicStore32(&queue->Tail, tail + 1);
+	return true;
+}
+
+/* A function to pop the oldest event, only the consumer thread calls it. Returns false if the queue is empty */
+/* @param A Pointer to the queue */
+/* @param A Pointer to the PlatformEvent to be filled */
+bool PopEvent(EventQueue* queue, PlatformEvent* event)
+{
+	i32 head = AtomicLoad32(&queue->Head);
+	if (head == AtomicLoad32(&queue->Tail))
+		return false;
+
+	*event = queue->Events[head & (EVENT_QUEUE_CAPACITY - 1)];
+	AtomicStore32(&queue->Head, head + 1);
+	return true;
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <defines.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define FILE_PATH_LENGTH 260
+
+/* A function to read a whole file into memory, the data is null terminated so text files can be used as strings */
+/* @param The path of the file */
+/* @param A Pointer to the size of the file to be filled, can be null */
+/* @param A Pointer to the data to be filled, it must be freed with free() */
+bool ReadWholeFile(const char* path, u64* size, char** data)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr)
+	{
+		printf("ERROR: Could not open the file %s!\n", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length < 0)
+	{
+		printf("ERROR: Could not get the size of the file %s!\n", path);
+		fclose(file);
+		return false;
+	}
+
+	*data = (char*)malloc((size_t)length + 1);
+	if (fread(*data, 1, (size_t)length, file) != (size_t)length)
+	{
+		printf("ERROR: Could not read the file %s!\n", path);
+		free(*data);
+		*data = nullptr;
+		fclose(file);
+		return false;
+	}
+	(*data)[length] = '\0';
+	fclose(file);
+
+	if (size)
+		*size = (u64)length;
+	return true;
+}
+
+/* A function for getting the last modification time of a file, returns 0 if the file does not exist */
+/* @param The path of the file */
+i64 GetFileModificationTime(const char* path)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(path, &info) != 0)
+		return 0;
+#else
+	struct stat info;
+	if (stat(path, &info) != 0)
+		return 0;
+#endif
+	return (i64)info.st_mtime;
+}
+
+/* A function to get the directory part of a path, including the last separator */
+/* @param The path */
+/* @param A Pointer to a buffer of FILE_PATH_LENGTH characters to be filled */
+void GetPathDirectory(const char* path, char* directory)
+{
+	u64 end = 0;
+	for (u64 i = 0; path[i] != '\0'; ++i)
+		if ((path[i] == '/') || (path[i] == '\\'))
+			end = i + 1;
+
+	if (end >= FILE_PATH_LENGTH)
+		end = FILE_PATH_LENGTH - 1;
+	memcpy(directory, path, end);
+	directory[end] = '\0';
+}
+
+/* A function to join a directory and a file name */
+/* @param The directory, can end with a separator or not */
+/* @param The file name */
+/* @param A Pointer to a buffer of FILE_PATH_LENGTH characters to be filled */
+void JoinPath(const char* directory, const char* name, char* path)
+{
+	u64 length = strlen(directory);
+	if ((length == 0) || (directory[length - 1] == '/') || (directory[length - 1] == '\\'))
+		snprintf(path, FILE_PATH_LENGTH, "%s%s", directory, name);
+	else
+		snprintf(path, FILE_PATH_LENGTH, "%s/%s", directory, name);
+}
+
+/* A function to create a directory if it does not exist yet, the parent has to exist */
+/* @param The path of the directory */
+bool CreateDirectoryIfMissing(const char* path)
+{
+#ifdef _WIN32
+	if (CreateDirectoryA(path, nullptr) || (GetLastError() == ERROR_ALREADY_EXISTS))
+		return true;
+#else
+	if ((mkdir(path, 0755) == 0) || (errno == EEXIST))
+		return true;
+#endif
+
+	printf("ERROR: Could not create the directory %s!\n", path);
+	return false;
+}
+
+/* A structure for a read only memory mapped file */
+typedef struct {
+	const void* Data;	/* The mapped content */
+	u64 Size;			/* The size of the file in bytes */
+#ifdef _WIN32
+	HANDLE File;		/* The opened file */
+	HANDLE Mapping;		/* The file mapping object */
+#endif
+} MappedFile;
+
+/* A function to map a whole file into memory for reading, pages are only read from disk when they are touched */
+/* @param The path of the file */
+/* @param A Pointer to the MappedFile to be filled */
+bool MapFile(const char* path, MappedFile* mappedFile)
+{
+	memset(mappedFile, 0, sizeof(MappedFile));
+
+#ifdef _WIN32
+	mappedFile->File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mappedFile->File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mappedFile->File, &size) || (size.QuadPart == 0))
+	{
+		CloseHandle(mappedFile->File);
+		return false;
+	}
+	mappedFile->Size = (u64)size.QuadPart;
+
+	mappedFile->Mapping = CreateFileMappingA(mappedFile->File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappedFile->Mapping != nullptr)
+		mappedFile->Data = MapViewOfFile(mappedFile->Mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (mappedFile->Data == nullptr)
+	{
+		printf("ERROR: Could not map the file %s!\n", path);
+		if (mappedFile->Mapping != nullptr)
+			CloseHandle(mappedFile->Mapping);
+		CloseHandle(mappedFile->File);
+		return false;
+	}
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if ((fstat(file, &info) != 0) || (info.st_size == 0))
+	{
+		close(file);
+		return false;
+	}
+	mappedFile->Size = (u64)info.st_size;
+
+	/* The mapping keeps the file alive, so the descriptor is not needed anymore */
+	void* data = mmap(nullptr, (size_t)mappedFile->Size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		printf("ERROR: Could not map the file %s!\n", path);
+		return false;
+	}
+	mappedFile->Data = data;
+#endif
+
+	return true;
+}
+
+/* A function to clean up a mapped file */
+/* @param A pointer to the mapped file to cleanup */
+void UnmapFile(MappedFile* mappedFile)
+{
+	if (mappedFile->Data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mappedFile->Data);
+	CloseHandle(mappedFile->Mapping);
+	CloseHandle(mappedFile->File);
+#else
+	munmap((void*)mappedFile->Data, (size_t)mappedFile->Size);
+#endif
+	memset(mappedFile, 0, sizeof(MappedFile));
+}
+
+/* A function to write a whole file so readers see either the old or the new content, never half of it */
+/* @param The path of the file */
+/* @param A Pointer to the data */
+/* @param The size of the data in bytes */
+bool WriteWholeFileAtomic(const char* path, const void* data, u64 size)
+{
+	/* The data goes to a temporary file next to the real one, which is then renamed over it */
+	char temporaryPath[FILE_PATH_LENGTH + 16];
+	snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+
+	FILE* file = fopen(temporaryPath, "wb");
+	if (file == nullptr)
+	{
+		printf("ERROR: Could not open the file %s for writing!\n", temporaryPath);
+		return false;
+	}
+
+	bool written = fwrite(data, 1, (size_t)size, file) == (size_t)size;
+	written = (fflush(file) == 0) && written;
+	fclose(file);
+
+	if (!written)
+	{
+		printf("ERROR: Could not write the file %s!\n", temporaryPath);
+		remove(temporaryPath);
+		return false;
+	}
+
+#ifdef _WIN32
+	if (!MoveFileExA(temporaryPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+#else
+	if (rename(temporaryPath, path) != 0)
+#endif
+	{
+		printf("ERROR: Could not replace the file %s!\n", path);
+		remove(temporaryPath);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,353 @@
+#pragma once
+#include <defines.h>
+#include <VkHelper/VkHelper.h>
+#include <PipelineCache/PipelineCache.h>
+#include <BarrierBatcher/BarrierBatcher.h>
+
+/* The number of instances one workgroup of shaders/cull.comp tests, its local_size_x */
+#define GPU_CULLING_GROUP_SIZE 64
+
+/* The largest number of bytes vkCmdUpdateBuffer can write at once */
+#define GPU_CULLING_UPDATE_SIZE 65536
+
+/* A structure for one instance the culling pass tests, matches Instance in shaders/cull.comp */
+typedef struct {
+	float Center[3];		/* The world space center of the bounding sphere */
+	float Radius;			/* The radius of the bounding sphere */
+	u32 IndexCount;			/* The indices of the mesh */
+	u32 FirstIndex;			/* The first index of the mesh in the index buffer */
+	i32 VertexOffset;		/* Added to each index */
+	u32 FirstInstance;		/* Becomes gl_InstanceIndex, the vertex shader finds the per instance data with it */
+} GpuCullInstance;
+
+/* A structure of the push constants of the culling pass, matches the push_constant block in shaders/cull.comp */
+typedef struct {
+	float ViewProjection[16];		/* The column major matrix the frustum planes are taken from, depth goes from 0 to 1 */
+	VkDeviceAddress Instances;		/* The address of the GpuCullInstances */
+	VkDeviceAddress Draws;			/* The address of the VkDrawIndexedIndirectCommands to be written */
+	VkDeviceAddress DrawCount;		/* The address of the number of draws written */
+	u32 InstanceCount;				/* The number of instances to test */
+	u32 Occlusion;					/* If the depth pyramid is tested against */
+	float PyramidWidth;				/* The size of mip 0 of the depth pyramid */
+	float PyramidHeight;
+} GpuCullPushConstants;
+
+/* A structure for the counters of the culling pass */
+typedef struct {
+	u64 Culls;				/* Culling passes recorded */
+	u64 InstancesTested;	/* Instances handed to those passes */
+	u64 Draws;				/* Indirect draws recorded, each one covers every instance that was left */
+} GpuCullingStats;
+
+/* A structure for GPU driven rendering. A compute pass tests every instance against the frustum and the depth of the
+   last frame, and writes an indexed indirect draw for each one left. The draws and their count never go back to the
+   CPU, so recording a frame costs the same few commands however many instances there are */
+typedef struct {
+	VkDevice* LogicalDevice;			/* The logical device */
+	u32 MaxInstances;					/* The number of instances the buffers have room for */
+	u32 InstanceCount;					/* The number of instances that get tested */
+	AddressableBuffer Instances;		/* The GpuCullInstances, filled with transfers */
+	AddressableBuffer Draws;			/* A VkDrawIndexedIndirectCommand for every instance that was left */
+	AddressableBuffer DrawCount;		/* The number of draws written */
+	VkDescriptorSetLayout SetLayout;	/* The depth pyramid, partially bound so culling works without one */
+	VkDescriptorPool DescriptorPool;	/* The pool of the one descriptor set */
+	VkDescriptorSet DescriptorSet;		/* The set with the depth pyramid */
+	VkPipelineLayout PipelineLayout;	/* The set and the push constants */
+	VkPipeline Pipeline;				/* The culling pass */
+	bool Occlusion;						/* If a depth pyramid is set */
+	float PyramidWidth;					/* The size of mip 0 of the depth pyramid */
+	float PyramidHeight;
+	GpuCullingStats Stats;				/* The counters */
+} GpuCulling;
+
+void DestroyGpuCulling(GpuCulling* culling);
+
+/* A function to create the buffers and the pipeline of the culling pass, the device needs IsGpuDrivenRenderingSupported
+   and its features enabled */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the pipeline cache */
+/* @param The shader module of shaders/cull.comp */
+/* @param The number of instances the buffers have room for */
+/* @param A Pointer to the GpuCulling to be filled */
+bool CreateGpuCulling(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, PipelineCache* pipelineCache, VkShaderModule cullShader, u32 maxInstances,
+	GpuCulling* culling)
+{
+	memset(culling, 0, sizeof(GpuCulling));
+	culling->LogicalDevice = logicalDevice;
+	culling->MaxInstances = maxInstances;
+
+	if (!CreateAddressableBuffer(physicalDevice, logicalDevice, (VkDeviceSize)maxInstances * sizeof(GpuCullInstance),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &culling->Instances) ||
+		!CreateAddressableBuffer(physicalDevice, logicalDevice, (VkDeviceSize)maxInstances * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &culling->Draws) ||
+		!CreateAddressableBuffer(physicalDevice, logicalDevice, sizeof(u32),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &culling->DrawCount))
+	{
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	/* Without a pyramid the shader never reads the binding, partially bound lets it stay unwritten */
+	VkDescriptorSetLayoutBinding binding = { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+	VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+		nullptr,
+		1,
+		&bindingFlags
+	};
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		&bindingFlagsCreateInfo,
+		0,
+		1,
+		&binding
+	};
+
+	if (vkCreateDescriptorSetLayout(*logicalDevice, &setLayoutCreateInfo, nullptr, &culling->SetLayout) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the descriptor set layout of the culling pass!\n");
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
+	VkDescriptorPoolCreateInfo poolCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		nullptr,
+		0,
+		1,
+		1,
+		&poolSize
+	};
+
+	if (vkCreateDescriptorPool(*logicalDevice, &poolCreateInfo, nullptr, &culling->DescriptorPool) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the descriptor pool of the culling pass!\n");
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo setAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		nullptr,
+		culling->DescriptorPool,
+		1,
+		&culling->SetLayout
+	};
+
+	if (vkAllocateDescriptorSets(*logicalDevice, &setAllocateInfo, &culling->DescriptorSet) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate the descriptor set of the culling pass!\n");
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GpuCullPushConstants) };
+	if (!CreatePipelineLayout(logicalDevice, &culling->SetLayout, 1, &pushConstantRange, 1, &culling->PipelineLayout))
+	{
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipelineCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		nullptr,
+		0,
+		{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_COMPUTE_BIT, cullShader, "main", nullptr },
+		culling->PipelineLayout,
+		VK_NULL_HANDLE,
+		-1
+	};
+
+	if (!CreateComputePipelineWithCache(pipelineCache, pipelineCache->Cache, &pipelineCreateInfo, "gpu culling", &culling->Pipeline))
+	{
+		DestroyGpuCulling(culling);
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to record an update of a range of the instances, for instances that move. Whole scenes are better
+   copied into culling->Instances.Buffer from a staging buffer. Must be recorded outside of a render pass */
+/* @param A Pointer to the culling */
+/* @param The command buffer being recorded */
+/* @param A Pointer to the instances */
+/* @param The index of the first instance to update */
+/* @param The number of instances to update */
+bool RecordGpuCullInstanceUpdate(GpuCulling* culling, VkCommandBuffer commandBuffer, const GpuCullInstance* instances, u32 first, u32 count)
+{
+	if ((u64)first + count > culling->MaxInstances)
+	{
+		printf("ERROR: The culling pass only has room for %u instances!\n", culling->MaxInstances);
+		return false;
+	}
+
+	/* Updates go into the command buffer itself, so they are split into the largest pieces it takes */
+	const u8* data = (const u8*)instances;
+	VkDeviceSize offset = (VkDeviceSize)first * sizeof(GpuCullInstance);
+	VkDeviceSize size = (VkDeviceSize)count * sizeof(GpuCullInstance);
+	while (size > 0)
+	{
+		VkDeviceSize pieceSize = size < GPU_CULLING_UPDATE_SIZE ? size : GPU_CULLING_UPDATE_SIZE;
+		vkCmdUpdateBuffer(commandBuffer, culling->Instances.Buffer, offset, pieceSize, data);
+		data += pieceSize;
+		offset += pieceSize;
+		size -= pieceSize;
+	}
+
+	return true;
+}
+
+/* A function to set the number of instances that get tested, the first ones of culling->Instances */
+/* @param A Pointer to the culling */
+/* @param The number of instances */
+bool SetGpuCullInstanceCount(GpuCulling* culling, u32 count)
+{
+	if (count > culling->MaxInstances)
+	{
+		printf("ERROR: The culling pass only has room for %u instances!\n", culling->MaxInstances);
+		return false;
+	}
+
+	culling->InstanceCount = count;
+	return true;
+}
+
+/* A function to set the depth pyramid instances are tested against, the GPU must be done with the culling pass */
+/* The pyramid holds the farthest depth of the last frame, with each mip covering 2 by 2 texels of the one above */
+/* @param A Pointer to the culling */
+/* @param The view of every mip of the pyramid in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE to only cull against the frustum */
+/* @param A nearest sampler that clamps to the edge */
+/* @param The width of mip 0 */
+/* @param The height of mip 0 */
+void SetGpuCullingDepthPyramid(GpuCulling* culling, VkImageView pyramid, VkSampler sampler, u32 width, u32 height)
+{
+	culling->Occlusion = pyramid != VK_NULL_HANDLE;
+	culling->PyramidWidth = (float)width;
+	culling->PyramidHeight = (float)height;
+	if (!culling->Occlusion)
+		return;
+
+	VkDescriptorImageInfo imageInfo = { sampler, pyramid, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkWriteDescriptorSet write =
+	{
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		nullptr,
+		culling->DescriptorSet,
+		0,
+		0,
+		1,
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		&imageInfo,
+		nullptr,
+		nullptr
+	};
+	vkUpdateDescriptorSets(*culling->LogicalDevice, 1, &write, 0, nullptr);
+}
+
+/* A function to record the culling pass, it has to be recorded outside of a render pass before the draws that use it.
+   Its barriers are flushed at the end so the draws can be recorded right away */
+/* @param A Pointer to the culling */
+/* @param A Pointer to the barrier batcher of the command buffer */
+/* @param The command buffer being recorded */
+/* @param The column major view projection matrix, depth going from 0 to 1 */
+void RecordGpuCulling(GpuCulling* culling, BarrierBatcher* batcher, VkCommandBuffer commandBuffer, const float* viewProjection)
+{
+	/* The draws of the last frame have to be read before they get written again, and the instance updates seen */
+	AddBufferBarrier(batcher, commandBuffer, culling->DrawCount.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, 0, VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR);
+	AddBufferBarrier(batcher, commandBuffer, culling->Draws.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, 0, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR);
+	AddBufferBarrier(batcher, commandBuffer, culling->Instances.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR);
+	FlushBarriers(batcher, commandBuffer);
+	vkCmdFillBuffer(commandBuffer, culling->DrawCount.Buffer, 0, sizeof(u32), 0);
+
+	AddBufferBarrier(batcher, commandBuffer, culling->DrawCount.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR);
+	FlushBarriers(batcher, commandBuffer);
+
+	GpuCullPushConstants pushConstants = { 0 };
+	memcpy(pushConstants.ViewProjection, viewProjection, sizeof(pushConstants.ViewProjection));
+	pushConstants.Instances = culling->Instances.Address;
+	pushConstants.Draws = culling->Draws.Address;
+	pushConstants.DrawCount = culling->DrawCount.Address;
+	pushConstants.InstanceCount = culling->InstanceCount;
+	pushConstants.Occlusion = culling->Occlusion ? 1 : 0;
+	pushConstants.PyramidWidth = culling->PyramidWidth;
+	pushConstants.PyramidHeight = culling->PyramidHeight;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->Pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->PipelineLayout, 0, 1, &culling->DescriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, culling->PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GpuCullPushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (culling->InstanceCount + GPU_CULLING_GROUP_SIZE - 1) / GPU_CULLING_GROUP_SIZE, 1, 1);
+
+	AddBufferBarrier(batcher, commandBuffer, culling->Draws.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR);
+	AddBufferBarrier(batcher, commandBuffer, culling->DrawCount.Buffer, 0, VK_WHOLE_SIZE,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR);
+	FlushBarriers(batcher, commandBuffer);
+
+	++culling->Stats.Culls;
+	culling->Stats.InstancesTested += culling->InstanceCount;
+}
+
+/* A function to draw every instance the last culling pass left, with one command. The graphics pipeline, the index
+   buffer and everything the vertex shader reads have to be bound already */
+/* @param A Pointer to the culling */
+/* @param The command buffer being recorded, inside a render pass */
+void DrawGpuCulledInstances(GpuCulling* culling, VkCommandBuffer commandBuffer)
+{
+	vkCmdDrawIndexedIndirectCount(commandBuffer, culling->Draws.Buffer, 0, culling->DrawCount.Buffer, 0, culling->InstanceCount,
+		sizeof(VkDrawIndexedIndirectCommand));
+	++culling->Stats.Draws;
+}
+
+/* A function for getting the culling statistics */
+/* @param A Pointer to the culling */
+/* @param A Pointer to the GpuCullingStats to be filled */
+void GetGpuCullingStats(GpuCulling* culling, GpuCullingStats* stats)
+{
+	*stats = culling->Stats;
+}
+
+/* A function for printing the culling statistics */
+/* @param A Pointer to the culling */
+void PrintGpuCullingStats(GpuCulling* culling)
+{
+	printf("INFO: GPU culling, %llu passes tested %llu instances, %llu indirect draws recorded, occlusion %s\n",
+		(unsigned long long)culling->Stats.Culls, (unsigned long long)culling->Stats.InstancesTested,
+		(unsigned long long)culling->Stats.Draws, culling->Occlusion ? "on" : "off");
+}
+
+/* A function to clean up created vulkan resources, the GPU must be done with them */
+/* @param A pointer to the resource to cleanup */
+void DestroyGpuCulling(GpuCulling* culling)
+{
+	if (culling->LogicalDevice == nullptr)
+		return;
+
+	VkDevice* logicalDevice = culling->LogicalDevice;
+	if (culling->Pipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(*logicalDevice, culling->Pipeline, nullptr);
+	if (culling->PipelineLayout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(*logicalDevice, culling->PipelineLayout, nullptr);
+	if (culling->DescriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(*logicalDevice, culling->DescriptorPool, nullptr);
+	if (culling->SetLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(*logicalDevice, culling->SetLayout, nullptr);
+	DestroyAddressableBuffer(logicalDevice, &culling->DrawCount);
+	DestroyAddressableBuffer(logicalDevice, &culling->Draws);
+	DestroyAddressableBuffer(logicalDevice, &culling->Instances);
+	memset(culling, 0, sizeof(GpuCulling));
+}
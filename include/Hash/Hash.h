@@ -0,0 +1,72 @@
+#pragma once
+#include <string.h>
+#include <defines.h>
+
+/* 64 bit FNV-1a, good enough for cache keys and hash maps, not for anything that has to be secure */
+#define HASH_SEED 14695981039346656037ULL
+#define HASH_PRIME 1099511628211ULL
+
+/* A function to hash a block of memory */
+/* @param A Pointer to the memory */
+/* @param The size of the memory in bytes */
+/* @param The hash to continue from, HASH_SEED to start a new one */
+u64 HashBytes(const void* data, u64 size, u64 hash)
+{
+	const u8* bytes = (const u8*)data;
+	for (u64 i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= HASH_PRIME;
+	}
+	return hash;
+}
+
+/* A function to hash a null terminated string, the terminator is hashed too so "ab" + "c" differs from "a" + "bc" */
+/* @param The string */
+/* @param The hash to continue from, HASH_SEED to start a new one */
+u64 HashString(const char* string, u64 hash)
+{
+	return HashBytes(string, strlen(string) + 1, hash);
+}
+
+/* A function to hash a single 64 bit value */
+/* @param The value */
+/* @param The hash to continue from, HASH_SEED to start a new one */
+u64 HashU64(u64 value, u64 hash)
+{
+	return HashBytes(&value, sizeof(u64), hash);
+}
+
+/* A function to hash a block of memory 8 bytes at a time, much faster than HashBytes on large keys like pipeline
+   states. It gives different values than HashBytes, so one kind of key must always use the same one */
+/* @param A Pointer to the memory */
+/* @param The size of the memory in bytes */
+/* @param The hash to continue from, HASH_SEED to start a new one */
+u64 HashWords(const void* data, u64 size, u64 hash)
+{
+	const u8* bytes = (const u8*)data;
+	u64 i = 0;
+	for (; i + sizeof(u64) <= size; i += sizeof(u64))
+	{
+		u64 word;
+		memcpy(&word, bytes + i, sizeof(u64));
+		hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+		hash ^= hash >> 32;
+	}
+
+	if (i < size)
+	{
+		u64 word = 0;
+		memcpy(&word, bytes + i, (size_t)(size - i));
+		hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	/* The murmur3 finalizer, so every input bit reaches every output bit */
+	hash ^= size;
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB93FE1A85EC9ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
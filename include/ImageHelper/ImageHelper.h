@@ -0,0 +1,386 @@
+#pragma once
+#include <defines.h>
+#include <vector/vector.h>
+#include <VkHelper/VkHelper.h>
+
+/* The ways an image can be used, every usage maps to the narrowest stage, access and layout for it */
+typedef enum {
+	IMAGE_USAGE_UNDEFINED = 0,			/* Contents don't matter, used to discard an image */
+	IMAGE_USAGE_TRANSFER_SOURCE,		/* Copied or blitted from */
+	IMAGE_USAGE_TRANSFER_DESTINATION,	/* Copied, blitted or cleared into */
+	IMAGE_USAGE_COLOR_ATTACHMENT,		/* Written as a color attachment */
+	IMAGE_USAGE_DEPTH_ATTACHMENT,		/* Written as a depth / stencil attachment */
+	IMAGE_USAGE_DEPTH_READ_ONLY,		/* Depth tested but not written */
+	IMAGE_USAGE_SAMPLED_VERTEX,			/* Sampled in a vertex shader */
+	IMAGE_USAGE_SAMPLED_FRAGMENT,		/* Sampled in a fragment shader */
+	IMAGE_USAGE_SAMPLED_COMPUTE,		/* Sampled in a compute shader */
+	IMAGE_USAGE_STORAGE_READ_COMPUTE,	/* Read as a storage image in a compute shader */
+	IMAGE_USAGE_STORAGE_WRITE_COMPUTE,	/* Written as a storage image in a compute shader */
+	IMAGE_USAGE_PRESENT,				/* Handed to the presentation engine */
+	IMAGE_USAGE_COUNT
+} ImageUsage;
+
+/* A structure for what the GPU needs to know about one usage */
+typedef struct {
+	VkPipelineStageFlags Stage;	/* The only stage that touches the image for this usage */
+	VkAccessFlags Access;		/* The only access the usage does */
+	VkImageLayout Layout;		/* The layout the image has to be in */
+	bool Write;					/* True if the usage writes to the image */
+} ImageUsageInfo;
+
+/* A function for getting the stage, access and layout of a usage */
+/* @param The usage */
+ImageUsageInfo GetImageUsageInfo(ImageUsage usage)
+{
+	static const ImageUsageInfo usageInfos[IMAGE_USAGE_COUNT] =
+	{
+		{ VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, false },
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false },
+		{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true },
+		{ VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false }
+	};
+
+	return usageInfos[usage < IMAGE_USAGE_COUNT ? usage : IMAGE_USAGE_UNDEFINED];
+}
+
+/* A structure for the state of one subresource (mip level and array layer) of an image */
+typedef struct {
+	VkImageLayout Layout;			/* The current layout */
+	VkPipelineStageFlags WriteStage;	/* The stage of the last write or layout transition, 0 if there was none */
+	VkAccessFlags WriteAccess;		/* The access of the last write, 0 if nothing has to be made visible */
+	VkPipelineStageFlags ReadStages;	/* The stages that read since the last write */
+	VkAccessFlags ReadAccess;		/* The accesses that read since the last write */
+} ImageSubresourceState;
+
+/* A structure for the statistics of the layout tracker */
+typedef struct {
+	u64 TransitionsRequested;	/* The number of subresource transitions asked for */
+	u64 TransitionsSkipped;		/* The number of subresource transitions that needed no barrier */
+	u64 BarriersEmitted;		/* The number of VkImageMemoryBarriers that got emitted after merging */
+} ImageTrackerStats;
+
+/* A structure for an image with its memory, view and the state of all its subresources */
+typedef struct {
+	VkImage Image;			/* The image */
+	VkDeviceMemory Memory;	/* The memory of the image, VK_NULL_HANDLE if the image is not owned (swapchain images) */
+	VkImageView View;		/* A view that sees all of the image */
+	VkFormat Format;		/* The format of the image */
+	VkExtent3D Extent;		/* The size of the image */
+	VkImageAspectFlags Aspect;	/* The aspect of the image */
+	u32 MipLevels;			/* The number of mip levels */
+	u32 ArrayLayers;		/* The number of array layers */
+	Vec States;				/* A Vector of ImageSubresourceState, indexed by mip * ArrayLayers + layer */
+} TrackedImage;
+
+/* The statistics of all the tracked images */
+static ImageTrackerStats ImageTrackerStatistics = { 0 };
+
+/* A function for getting the aspect of a format */
+/* @param The format */
+VkImageAspectFlags GetFormatAspect(VkFormat format)
+{
+	switch (format)
+	{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+/* A function for setting up the subresource states of a tracked image, all subresources start out undefined */
+/* @param A Pointer to the tracked image */
+void InitializeTrackedImageStates(TrackedImage* image)
+{
+	u32 count = image->MipLevels * image->ArrayLayers;
+	image->States = nullptr;
+	vec_resize(image->States, count, ImageSubresourceState);
+	memset(image->States, 0, count * sizeof(ImageSubresourceState));
+}
+
+/* A function to create an image, bind memory to it and create a view of it */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param The format of the image */
+/* @param The size of the image */
+/* @param The number of mip levels */
+/* @param The number of array layers */
+/* @param The usage flags of the image */
+/* @param The memory properties wanted */
+/* @param A Pointer to a TrackedImage to be filled */
+bool CreateTrackedImage(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkFormat format, VkExtent3D size, u32 mipLevels, u32 arrayLayers,
+	VkImageUsageFlags usage, VkMemoryPropertyFlags memoryProperties, TrackedImage* image)
+{
+	memset(image, 0, sizeof(TrackedImage));
+	image->Format = format;
+	image->Extent = size;
+	image->MipLevels = mipLevels;
+	image->ArrayLayers = arrayLayers;
+	image->Aspect = GetFormatAspect(format);
+
+	VkImageType type = size.depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+	if (!CreateImage(logicalDevice, type, format, size, mipLevels, arrayLayers, VK_SAMPLE_COUNT_1_BIT, usage, false, &image->Image))
+		return false;
+
+	if (!AllocateAndBindMemoryObjectToImage(physicalDevice, logicalDevice, &image->Image, memoryProperties, &image->Memory))
+	{
+		vkDestroyImage(*logicalDevice, image->Image, nullptr);
+		image->Image = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkImageViewType viewType = type == VK_IMAGE_TYPE_3D ? VK_IMAGE_VIEW_TYPE_3D : (arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D);
+	if (!CreateImageView(logicalDevice, &image->Image, viewType, format, image->Aspect, &image->View))
+	{
+		vkDestroyImage(*logicalDevice, image->Image, nullptr);
+		vkFreeMemory(*logicalDevice, image->Memory, nullptr);
+		image->Image = VK_NULL_HANDLE;
+		image->Memory = VK_NULL_HANDLE;
+		return false;
+	}
+
+	InitializeTrackedImageStates(image);
+	return true;
+}
+
+void DestroyTrackedImage(VkDevice* logicalDevice, TrackedImage* image);
+
+/* A function for tracking the images of a swapchain, the images are not owned and only get views */
+/* @param A Pointer to a logical device */
+/* @param A Vector (MUST BE VALID) of VkImages from GetSwapchainImageHandles */
+/* @param The format of the swapchain images */
+/* @param The size of the swapchain images */
+Vec CreateTrackedSwapchainImages(VkDevice* logicalDevice, Vec swapchainImages, VkFormat format, VkExtent2D size)
+{
+	Vec trackedImages = vec_reserve(TrackedImage, vec_length(swapchainImages));
+
+	for (u32 i = 0; i < vec_length(swapchainImages); ++i)
+	{
+		TrackedImage image = { 0 };
+		image.Image = *(VkImage*)vec_get_at(swapchainImages, i);
+		image.Format = format;
+		image.Extent.width = size.width;
+		image.Extent.height = size.height;
+		image.Extent.depth = 1;
+		image.MipLevels = 1;
+		image.ArrayLayers = 1;
+		image.Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+		if (!CreateImageView(logicalDevice, &image.Image, VK_IMAGE_VIEW_TYPE_2D, format, image.Aspect, &image.View))
+		{
+			/* The views and states of the images already tracked are freed, the images stay with the swapchain */
+			for (u32 j = 0; j < vec_length(trackedImages); ++j)
+				DestroyTrackedImage(logicalDevice, (TrackedImage*)vec_get_at(trackedImages, j));
+			vec_destroy(trackedImages);
+			return nullptr;
+		}
+
+		InitializeTrackedImageStates(&image);
+		vec_pushback(trackedImages, image, TrackedImage);
+	}
+
+	return trackedImages;
+}
+
+/* A function for working out the barrier one subresource needs for a new usage, returns false if none is needed */
+/* The state of the subresource is updated to the new usage */
+/* @param A Pointer to the subresource state */
+/* @param The new usage */
+/* @param A Pointer to a VkImageMemoryBarrier to fill in the access masks and layouts */
+/* @param A Pointer to the source stages for output */
+/* @param A Pointer to the destination stages for output */
+bool TransitionImageSubresourceState(ImageSubresourceState* state, ImageUsage usage, VkImageMemoryBarrier* barrier, VkPipelineStageFlags* sourceStages,
+	VkPipelineStageFlags* destinationStages)
+{
+	ImageUsageInfo info = GetImageUsageInfo(usage);
+	bool layoutChange = (state->Layout != info.Layout) && (usage != IMAGE_USAGE_UNDEFINED);
+
+	/* Reads in the same layout only wait on the last write, and only once per stage */
+	if (!info.Write && !layoutChange)
+	{
+		bool alreadyVisible = ((state->ReadStages & info.Stage) == info.Stage) && ((state->ReadAccess & info.Access) == info.Access);
+		if ((state->WriteStage == 0) || alreadyVisible)
+		{
+			state->ReadStages |= info.Stage;
+			state->ReadAccess |= info.Access;
+			return false;
+		}
+	}
+
+	/* Writes and layout changes wait on everything since the last write, reads only need execution ordering */
+	*sourceStages = state->WriteStage | state->ReadStages;
+	if (*sourceStages == 0)
+		*sourceStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	*destinationStages = info.Stage;
+
+	barrier->srcAccessMask = state->WriteAccess;
+	barrier->dstAccessMask = info.Access;
+	barrier->oldLayout = usage == IMAGE_USAGE_UNDEFINED ? VK_IMAGE_LAYOUT_UNDEFINED : state->Layout;
+	barrier->newLayout = layoutChange ? info.Layout : state->Layout;
+
+	/* A read after a write or layout transition stays ordered behind it for the next readers */
+	if (info.Write || layoutChange)
+	{
+		state->WriteStage = info.Stage;
+		state->WriteAccess = info.Write ? info.Access : 0;
+		state->ReadStages = info.Write ? 0 : info.Stage;
+		state->ReadAccess = info.Write ? 0 : info.Access;
+	}
+	else
+	{
+		state->ReadStages |= info.Stage;
+		state->ReadAccess |= info.Access;
+	}
+	state->Layout = barrier->newLayout;
+	return true;
+}
+
+/* A function for checking if two image barriers do the same thing and can cover one range */
+/* @param A Pointer to the first barrier */
+/* @param A Pointer to the second barrier */
+bool IsSameImageBarrier(VkImageMemoryBarrier* first, VkImageMemoryBarrier* second)
+{
+	return (first->srcAccessMask == second->srcAccessMask) && (first->dstAccessMask == second->dstAccessMask) &&
+		(first->oldLayout == second->oldLayout) && (first->newLayout == second->newLayout);
+}
+
+/* A function for getting the barriers that move a range of subresources to a new usage */
+/* Subresources that need the same barrier are merged into one VkImageMemoryBarrier */
+/* @param A Pointer to the tracked image */
+/* @param The first mip level */
+/* @param The number of mip levels */
+/* @param The first array layer */
+/* @param The number of array layers */
+/* @param The new usage */
+/* @param A Vector (MUST BE VALID) of VkImageMemoryBarriers the barriers get pushed into */
+/* @param A Pointer to the source stages, the needed stages get OR'd in */
+/* @param A Pointer to the destination stages, the needed stages get OR'd in */
+void GetTrackedImageTransitionBarriers(TrackedImage* image, u32 baseMipLevel, u32 mipLevelCount, u32 baseArrayLayer, u32 arrayLayerCount, ImageUsage usage,
+	Vec* barriers, VkPipelineStageFlags* sourceStages, VkPipelineStageFlags* destinationStages)
+{
+	u32 firstNewBarrier = (u32)vec_length(*barriers);
+
+	for (u32 mip = baseMipLevel; mip < baseMipLevel + mipLevelCount && mip < image->MipLevels; ++mip)
+	{
+		u32 firstMipBarrier = (u32)vec_length(*barriers);
+
+		for (u32 layer = baseArrayLayer; layer < baseArrayLayer + arrayLayerCount && layer < image->ArrayLayers; ++layer)
+		{
+			ImageSubresourceState* state = &((ImageSubresourceState*)image->States)[mip * image->ArrayLayers + layer];
+			++ImageTrackerStatistics.TransitionsRequested;
+
+			VkImageMemoryBarrier barrier = { 0 };
+			VkPipelineStageFlags sourceStage = 0;
+			VkPipelineStageFlags destinationStage = 0;
+			if (!TransitionImageSubresourceState(state, usage, &barrier, &sourceStage, &destinationStage))
+			{
+				++ImageTrackerStatistics.TransitionsSkipped;
+				continue;
+			}
+
+			*sourceStages |= sourceStage;
+			*destinationStages |= destinationStage;
+
+			/* Grow the last barrier of this mip when the subresource is the next layer and needs the same barrier */
+			if ((u32)vec_length(*barriers) > firstMipBarrier)
+			{
+				VkImageMemoryBarrier* last = (VkImageMemoryBarrier*)vec_get_at(*barriers, vec_length(*barriers) - 1);
+				if (IsSameImageBarrier(last, &barrier) && (last->subresourceRange.baseArrayLayer + last->subresourceRange.layerCount == layer))
+				{
+					++last->subresourceRange.layerCount;
+					continue;
+				}
+			}
+
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image->Image;
+			barrier.subresourceRange.aspectMask = image->Aspect;
+			barrier.subresourceRange.baseMipLevel = mip;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = layer;
+			barrier.subresourceRange.layerCount = 1;
+			vec_pushback(*barriers, barrier, VkImageMemoryBarrier);
+		}
+
+		/* Fold a mip into the previous one when both came out as one barrier over the same layers */
+		if (((u32)vec_length(*barriers) == firstMipBarrier + 1) && (firstMipBarrier > firstNewBarrier))
+		{
+			VkImageMemoryBarrier* previous = (VkImageMemoryBarrier*)vec_get_at(*barriers, firstMipBarrier - 1);
+			VkImageMemoryBarrier* current = (VkImageMemoryBarrier*)vec_get_at(*barriers, firstMipBarrier);
+			if (IsSameImageBarrier(previous, current) &&
+				(previous->subresourceRange.baseArrayLayer == current->subresourceRange.baseArrayLayer) &&
+				(previous->subresourceRange.layerCount == current->subresourceRange.layerCount) &&
+				(previous->subresourceRange.baseMipLevel + previous->subresourceRange.levelCount == mip))
+			{
+				++previous->subresourceRange.levelCount;
+				vec_length_set(*barriers, firstMipBarrier);
+			}
+		}
+	}
+
+	ImageTrackerStatistics.BarriersEmitted += vec_length(*barriers) - firstNewBarrier;
+}
+
+/* A function for recording the barrier that moves a whole tracked image to a new usage, nothing is recorded if none is needed */
+/* @param A Pointer to a command buffer that is recording */
+/* @param A Pointer to the tracked image */
+/* @param The new usage */
+void TransitionTrackedImage(VkCommandBuffer* commandBuffer, TrackedImage* image, ImageUsage usage)
+{
+	Vec barriers = vec_create(VkImageMemoryBarrier);
+	VkPipelineStageFlags sourceStages = 0;
+	VkPipelineStageFlags destinationStages = 0;
+
+	GetTrackedImageTransitionBarriers(image, 0, image->MipLevels, 0, image->ArrayLayers, usage, &barriers, &sourceStages, &destinationStages);
+
+	if (vec_length(barriers) > 0)
+	{
+		vkCmdPipelineBarrier(*commandBuffer, sourceStages, destinationStages, 0, 0, nullptr, 0, nullptr,
+			(u32)vec_length(barriers), (const VkImageMemoryBarrier*)barriers);
+	}
+
+	vec_destroy(barriers);
+}
+
+/* A function for getting the statistics of the layout tracker */
+ImageTrackerStats GetImageTrackerStats()
+{
+	return ImageTrackerStatistics;
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A Pointer to a logical device */
+/* @param A pointer to the resource to cleanup */
+void DestroyTrackedImage(VkDevice* logicalDevice, TrackedImage* image)
+{
+	if (image->View != VK_NULL_HANDLE)
+		vkDestroyImageView(*logicalDevice, image->View, nullptr);
+
+	/* Swapchain images are owned by the swapchain and have no memory here */
+	if (image->Memory != VK_NULL_HANDLE)
+	{
+		vkDestroyImage(*logicalDevice, image->Image, nullptr);
+		vkFreeMemory(*logicalDevice, image->Memory, nullptr);
+	}
+
+	vec_destroy(image->States);
+	memset(image, 0, sizeof(TrackedImage));
+}
@@ -0,0 +1,606 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <defines.h>
+#include <Timer/Timer.h>
+#include <Threading/Threading.h>
+
+#define JOB_SYSTEM_MAX_WORKERS 64
+#define JOB_DEQUE_CAPACITY 4096	/* Per worker, a power of 2. A worker with a full deque runs the job it pushes right away */
+#define JOB_IDLE_SPINS 64		/* Failed rounds of stealing before a worker goes to sleep */
+#define JOB_MAX_WAIT_DEPTH 16	/* Waits nested deeper than this only yield, a waiting thread runs other jobs on its own stack */
+
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL _Thread_local
+#endif
+
+/* A function a job runs */
+typedef void (*JobFunction)(void* argument);
+
+/* A structure for a counter jobs count down when they finish, to wait on them or to run more jobs after them */
+typedef struct {
+	volatile i32 Value;			/* The jobs still running */
+	volatile i32 Lock;			/* A spin lock for the continuations */
+	volatile i32 Decrementing;	/* Jobs still touching the counter after counting it down, it can not be destroyed before it is 0 */
+	bool Done;					/* Set when the value reached 0 and the continuations were started */
+	Vec Continuations;			/* A Vector of Job to start when the value reaches 0 */
+} JobCounter;
+
+/* A structure for a job */
+typedef struct {
+	JobFunction Function;	/* The function */
+	void* Argument;			/* Passed to the function */
+	JobCounter* Counter;	/* Counted down when the job is done, can be null */
+} Job;
+
+/* A structure for the deque of a worker. Only the worker pushes and pops at the bottom, others steal at the top.
+   This is the Chase-Lev deque, with a fixed capacity so there is never a buffer to swap */
+typedef struct {
+	volatile i64 Top;		/* The next job to steal */
+	volatile i64 Bottom;	/* The next free slot */
+	Job Entries[JOB_DEQUE_CAPACITY];	/* A slot is only written by the owner while no thief can have it, a torn read fails the steal */
+} JobDeque;
+
+/* A structure for the counters of a worker */
+typedef struct {
+	volatile i64 Executed;		/* Jobs run */
+	volatile i64 Steals;		/* Jobs taken from another worker */
+	volatile i64 StealAttempts;	/* Tries to take a job from another worker */
+} JobWorkerStats;
+
+struct JobSystem;
+
+/* A structure for a worker thread */
+typedef struct {
+	struct JobSystem* System;	/* The job system */
+	u32 Index;					/* The index of the worker */
+	u32 Random;					/* The state of the victim picker */
+	Thread Thread;				/* The thread */
+	JobDeque Deque;				/* The jobs of this worker */
+	JobWorkerStats Stats;		/* The counters */
+} JobWorker;
+
+/* A structure for the job system */
+typedef struct JobSystem {
+	JobWorker* Workers;			/* The workers, one per core */
+	u32 WorkerCount;			/* The number of workers */
+	Mutex Lock;					/* Guards the injected jobs and sleeping */
+	Vec Injected;				/* A Vector of Job pushed by threads that are not workers */
+	u64 InjectedHead;			/* The next injected job to run */
+	volatile i32 InjectedCount;	/* The injected jobs not yet taken, read without the lock */
+	ConditionVariable Wake;		/* Signaled when there are jobs for sleeping workers */
+	volatile i32 Queued;		/* The jobs pushed and not yet taken */
+	volatile i32 Sleeping;		/* The workers waiting on Wake */
+	volatile i32 Stop;			/* Set to stop the workers */
+} JobSystem;
+
+/* A structure for the counters of the whole job system */
+typedef struct {
+	u64 Executed;		/* Jobs run */
+	u64 Steals;			/* Jobs taken from another worker */
+	u64 StealAttempts;	/* Tries to take a job from another worker */
+	double StealRate;	/* Steals divided by jobs run */
+	double JobsPerSecond;	/* Filled by MeasureJobSystem */
+} JobSystemStats;
+
+/* The worker the current thread is, null on threads that are not workers */
+static JOB_THREAD_LOCAL JobWorker* CurrentJobWorker = nullptr;
+
+/* How many waits the current thread is inside of */
+static JOB_THREAD_LOCAL u32 JobWaitDepth = 0;
+
+/* A function to set up a counter before jobs use it */
+/* @param A Pointer to the counter */
+/* @param The number of jobs that will count it down */
+void InitializeJobCounter(JobCounter* counter, i32 value)
+{
+	counter->Value = value;
+	counter->Lock = 0;
+	counter->Decrementing = 0;
+	counter->Done = false;
+	if (counter->Continuations == nullptr)
+		counter->Continuations = vec_create(Job);
+	vec_clear(counter->Continuations);
+}
+
+/* A function to free the memory of a counter */
+/* @param A pointer to the counter to cleanup */
+void DestroyJobCounter(JobCounter* counter)
+{
+	vec_destroy(counter->Continuations);
+	counter->Continuations = nullptr;
+}
+
+/* A function to push a job onto the bottom of a deque, only the owner calls it. Returns false if the deque is full */
+/* @param A Pointer to the deque */
+/* @param A Pointer to the job */
+bool PushJobDeque(JobDeque* deque, const Job* job)
+{
+	i64 bottom = AtomicLoad64(&deque->Bottom);
+	i64 top = AtomicLoad64(&deque->Top);
+	if (bottom - top >= JOB_DEQUE_CAPACITY)
+		return false;
+
+	deque->Entries[bottom & (JOB_DEQUE_CAPACITY - 1)] = *job;
+	AtomicStore64(&deque->Bottom, bottom + 1);
+	return true;
+}
+
+/* A function to pop the newest job from the bottom of a deque, only the owner calls it */
+/* @param A Pointer to the deque */
+/* @param A Pointer to the Job to be filled */
+bool PopJobDeque(JobDeque* deque, Job* job)
+{
+	i64 bottom = AtomicLoad64(&deque->Bottom) - 1;
+	AtomicStore64(&deque->Bottom, bottom);
+	i64 top = AtomicLoad64(&deque->Top);
+
+	if (top > bottom)
+	{
+		AtomicStore64(&deque->Bottom, bottom + 1);
+		return false;
+	}
+
+	*job = deque->Entries[bottom & (JOB_DEQUE_CAPACITY - 1)];
+	if (top != bottom)
+		return true;
+
+	/* The last job, a thief may be taking it at the same time and only one of us gets it */
+	bool won = AtomicCompareExchange64(&deque->Top, top, top + 1);
+	AtomicStore64(&deque->Bottom, bottom + 1);
+	return won;
+}
+
+/* A function to steal the oldest job from the top of a deque, any thread can call it */
+/* @param A Pointer to the deque */
+/* @param A Pointer to the Job to be filled */
+bool StealJobDeque(JobDeque* deque, Job* job)
+{
+	i64 top = AtomicLoad64(&deque->Top);
+	i64 bottom = AtomicLoad64(&deque->Bottom);
+	if (top >= bottom)
+		return false;
+
+	*job = deque->Entries[top & (JOB_DEQUE_CAPACITY - 1)];
+	return AtomicCompareExchange64(&deque->Top, top, top + 1);
+}
+
+/* A function to wake a sleeping worker if there is one */
+/* @param A Pointer to the job system */
+void WakeJobWorkers(JobSystem* system)
+{
+	if (AtomicLoad32(&system->Sleeping) > 0)
+	{
+		LockMutex(&system->Lock);
+		BroadcastConditionVariable(&system->Wake);
+		UnlockMutex(&system->Lock);
+	}
+}
+
+void RunJob(JobSystem* system, Job* job);
+
+/* A function to queue jobs, from workers they go to the worker's own deque and from other threads to a shared queue */
+/* @param A Pointer to the job system */
+/* @param An array of jobs */
+/* @param The number of jobs */
+void PushJobs(JobSystem* system, const Job* jobs, u32 count)
+{
+	JobWorker* worker = CurrentJobWorker;
+	if (worker && (worker->System == system))
+	{
+		for (u32 i = 0; i < count; ++i)
+		{
+			AtomicAdd32(&system->Queued, 1);
+			if (!PushJobDeque(&worker->Deque, &jobs[i]))
+			{
+				/* Full, so the job runs here, which also throttles a worker that spawns faster than others steal */
+				AtomicAdd32(&system->Queued, -1);
+				Job job = jobs[i];
+				RunJob(system, &job);
+			}
+		}
+	}
+	else
+	{
+		LockMutex(&system->Lock);
+		for (u32 i = 0; i < count; ++i)
+			vec_pushback(system->Injected, jobs[i], Job);
+		AtomicAdd32(&system->InjectedCount, (i32)count);
+		AtomicAdd32(&system->Queued, (i32)count);
+		UnlockMutex(&system->Lock);
+	}
+
+	WakeJobWorkers(system);
+}
+
+/* A function to count a counter down, starting its continuations when it reaches 0 */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the counter */
+void DecrementJobCounter(JobSystem* system, JobCounter* counter)
+{
+	AtomicAdd32(&counter->Decrementing, 1);
+	if (AtomicAdd32(&counter->Value, -1) != 0)
+	{
+		AtomicAdd32(&counter->Decrementing, -1);
+		return;
+	}
+
+	while (!AtomicCompareExchange32(&counter->Lock, 0, 1))
+		YieldThread();
+	counter->Done = true;
+	u32 count = (u32)vec_length(counter->Continuations);
+	Vec continuations = counter->Continuations;
+	counter->Continuations = vec_create(Job);
+	AtomicStore32(&counter->Lock, 0);
+
+	if (count > 0)
+		PushJobs(system, (Job*)continuations, count);
+	vec_destroy(continuations);
+	AtomicAdd32(&counter->Decrementing, -1);
+}
+
+/* A function to run a job and count down its counter */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the job */
+void RunJob(JobSystem* system, Job* job)
+{
+	job->Function(job->Argument);
+	if (CurrentJobWorker && (CurrentJobWorker->System == system))
+		AtomicAdd64(&CurrentJobWorker->Stats.Executed, 1);
+	if (job->Counter)
+		DecrementJobCounter(system, job->Counter);
+}
+
+/* A function to find a job for a thread, its own deque first, then the shared queue, then other workers */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the worker, null for threads that are not workers */
+/* @param A Pointer to the Job to be filled */
+bool FindJob(JobSystem* system, JobWorker* worker, Job* job)
+{
+	if (worker && PopJobDeque(&worker->Deque, job))
+	{
+		AtomicAdd32(&system->Queued, -1);
+		return true;
+	}
+
+	if (AtomicLoad32(&system->InjectedCount) > 0)
+	{
+		bool found = false;
+		LockMutex(&system->Lock);
+		if (system->InjectedHead < vec_length(system->Injected))
+		{
+			*job = ((Job*)system->Injected)[system->InjectedHead++];
+			AtomicAdd32(&system->InjectedCount, -1);
+			if (system->InjectedHead == vec_length(system->Injected))
+			{
+				vec_clear(system->Injected);
+				system->InjectedHead = 0;
+			}
+			found = true;
+		}
+		UnlockMutex(&system->Lock);
+
+		if (found)
+		{
+			AtomicAdd32(&system->Queued, -1);
+			return true;
+		}
+	}
+
+	/* Victims are picked at random so thieves spread out instead of all hitting the same worker */
+	u32 random = worker ? worker->Random : (u32)(uintptr_t)job;
+	for (u32 i = 0; i < system->WorkerCount; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		JobWorker* victim = &system->Workers[(random >> 16) % system->WorkerCount];
+		if (victim == worker)
+			continue;
+
+		if (worker)
+			AtomicAdd64(&worker->Stats.StealAttempts, 1);
+		if (StealJobDeque(&victim->Deque, job))
+		{
+			if (worker)
+			{
+				worker->Random = random;
+				AtomicAdd64(&worker->Stats.Steals, 1);
+			}
+			AtomicAdd32(&system->Queued, -1);
+			return true;
+		}
+	}
+
+	if (worker)
+		worker->Random = random;
+	return false;
+}
+
+/* The function a worker thread runs */
+/* @param A Pointer to the JobWorker */
+void JobWorkerMain(void* argument)
+{
+	JobWorker* worker = (JobWorker*)argument;
+	JobSystem* system = worker->System;
+	CurrentJobWorker = worker;
+
+	u32 idle = 0;
+	while (!AtomicLoad32(&system->Stop))
+	{
+		Job job;
+		if (FindJob(system, worker, &job))
+		{
+			RunJob(system, &job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < JOB_IDLE_SPINS)
+		{
+			YieldThread();
+			continue;
+		}
+
+		/* Sleeping is counted before Queued is checked, and pushers bump Queued before checking Sleeping, so one of the two always sees the other */
+		LockMutex(&system->Lock);
+		AtomicAdd32(&system->Sleeping, 1);
+		while ((AtomicLoad32(&system->Queued) == 0) && !AtomicLoad32(&system->Stop))
+			WaitConditionVariable(&system->Wake, &system->Lock);
+		AtomicAdd32(&system->Sleeping, -1);
+		UnlockMutex(&system->Lock);
+		idle = 0;
+	}
+
+	CurrentJobWorker = nullptr;
+}
+
+/* A function to create the job system */
+/* @param The number of worker threads, 0 uses one per processor */
+/* @param A Pointer to the JobSystem to be filled */
+bool CreateJobSystem(u32 workerCount, JobSystem* system)
+{
+	memset(system, 0, sizeof(JobSystem));
+	if (workerCount == 0)
+		workerCount = GetProcessorCount();
+	if (workerCount > JOB_SYSTEM_MAX_WORKERS)
+		workerCount = JOB_SYSTEM_MAX_WORKERS;
+
+	system->WorkerCount = workerCount;
+	system->Workers = (JobWorker*)calloc(workerCount, sizeof(JobWorker));
+	system->Injected = vec_create(Job);
+	InitializeMutex(&system->Lock);
+	InitializeConditionVariable_(&system->Wake);
+
+	for (u32 i = 0; i < workerCount; ++i)
+	{
+		system->Workers[i].System = system;
+		system->Workers[i].Index = i;
+		system->Workers[i].Random = 2654435761u * (i + 1);
+	}
+
+	/* Every worker exists before any thread can try to steal from it */
+	for (u32 i = 0; i < workerCount; ++i)
+		if (!StartThread(JobWorkerMain, &system->Workers[i], &system->Workers[i].Thread))
+		{
+			printf("ERROR: Could not start job worker %u!\n", i);
+			return false;
+		}
+
+	return true;
+}
+
+/* A function to run jobs and count them on a counter */
+/* @param A Pointer to the job system */
+/* @param The function of every job */
+/* @param An array of the arguments, job i gets arguments + i * argumentSize */
+/* @param The size of one argument in bytes, 0 to pass the same pointer to every job */
+/* @param The number of jobs */
+/* @param A Pointer to an initialized counter, it goes up by the number of jobs, can be null */
+void RunJobs(JobSystem* system, JobFunction function, void* arguments, u64 argumentSize, u32 count, JobCounter* counter)
+{
+	/* Counted before any job is pushed, so the first ones to finish can not take it to 0 early */
+	if (counter)
+		AtomicAdd32(&counter->Value, (i32)count);
+
+	Job jobs[64];
+	for (u32 first = 0; first < count; first += 64)
+	{
+		u32 batch = (count - first) < 64 ? (count - first) : 64;
+		for (u32 i = 0; i < batch; ++i)
+		{
+			jobs[i].Function = function;
+			jobs[i].Argument = (u8*)arguments + (first + i) * argumentSize;
+			jobs[i].Counter = counter;
+		}
+		PushJobs(system, jobs, batch);
+	}
+}
+
+/* A function to run a job once a counter reaches 0, without a thread waiting for it */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the counter to wait for */
+/* @param The function of the job */
+/* @param The argument of the job */
+/* @param A Pointer to a counter the job counts down when it is done, can be null */
+void RunJobAfter(JobSystem* system, JobCounter* after, JobFunction function, void* argument, JobCounter* counter)
+{
+	Job job = { function, argument, counter };
+
+	while (!AtomicCompareExchange32(&after->Lock, 0, 1))
+		YieldThread();
+	bool ready = after->Done || (AtomicLoad32(&after->Value) == 0);
+	if (!ready)
+		vec_pushback(after->Continuations, job, Job);
+	AtomicStore32(&after->Lock, 0);
+
+	if (ready)
+		PushJobs(system, &job, 1);
+}
+
+/* A function to wait for a counter to reach 0, the waiting thread runs jobs in the meantime so a job can wait on
+   jobs it spawned without blocking a worker */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the counter */
+void WaitForJobCounter(JobSystem* system, JobCounter* counter)
+{
+	JobWorker* worker = (CurrentJobWorker && (CurrentJobWorker->System == system)) ? CurrentJobWorker : nullptr;
+	++JobWaitDepth;
+	while (AtomicLoad32(&counter->Value) > 0)
+	{
+		Job job;
+		if ((JobWaitDepth <= JOB_MAX_WAIT_DEPTH) && FindJob(system, worker, &job))
+			RunJob(system, &job);
+		else
+			YieldThread();
+	}
+	--JobWaitDepth;
+
+	while (AtomicLoad32(&counter->Decrementing) > 0)
+		YieldThread();
+}
+
+/* A structure for one batch of a parallel for */
+typedef struct {
+	void (*Function)(u32 first, u32 count, void* userData);	/* The function for a range */
+	void* UserData;	/* Passed to the function */
+	u32 First;		/* The first index of the batch */
+	u32 Count;		/* The number of indices */
+} ParallelForBatch;
+
+/* The job running a batch of a parallel for */
+void ParallelForJob(void* argument)
+{
+	ParallelForBatch* batch = (ParallelForBatch*)argument;
+	batch->Function(batch->First, batch->Count, batch->UserData);
+}
+
+/* A function to run a function over a range of indices in batches on the job system and wait for it, for culling,
+   command recording, uploads and decoding */
+/* @param A Pointer to the job system */
+/* @param The number of indices */
+/* @param The number of indices per job */
+/* @param The function for a range */
+/* @param A Pointer passed to the function */
+void ParallelFor(JobSystem* system, u32 count, u32 batchSize, void (*function)(u32 first, u32 count, void* userData), void* userData)
+{
+	if (batchSize == 0)
+		batchSize = 1;
+
+	u32 batchCount = (count + batchSize - 1) / batchSize;
+	ParallelForBatch* batches = (ParallelForBatch*)malloc(batchCount * sizeof(ParallelForBatch));
+	for (u32 i = 0; i < batchCount; ++i)
+	{
+		batches[i].Function = function;
+		batches[i].UserData = userData;
+		batches[i].First = i * batchSize;
+		batches[i].Count = (count - batches[i].First) < batchSize ? (count - batches[i].First) : batchSize;
+	}
+
+	JobCounter counter = { 0 };
+	InitializeJobCounter(&counter, 0);
+	RunJobs(system, ParallelForJob, batches, sizeof(ParallelForBatch), batchCount, &counter);
+	WaitForJobCounter(system, &counter);
+	DestroyJobCounter(&counter);
+	free(batches);
+}
+
+/* A function for the counters of the job system */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the JobSystemStats to be filled */
+void GetJobSystemStats(JobSystem* system, JobSystemStats* stats)
+{
+	memset(stats, 0, sizeof(JobSystemStats));
+	for (u32 i = 0; i < system->WorkerCount; ++i)
+	{
+		stats->Executed += (u64)AtomicLoad64(&system->Workers[i].Stats.Executed);
+		stats->Steals += (u64)AtomicLoad64(&system->Workers[i].Stats.Steals);
+		stats->StealAttempts += (u64)AtomicLoad64(&system->Workers[i].Stats.StealAttempts);
+	}
+	stats->StealRate = stats->Executed ? (double)stats->Steals / (double)stats->Executed : 0.0;
+}
+
+/* A function to clean up the job system, the queued jobs are dropped so wait for them first */
+/* @param A pointer to the job system to cleanup */
+void DestroyJobSystem(JobSystem* system)
+{
+	AtomicStore32(&system->Stop, 1);
+	LockMutex(&system->Lock);
+	BroadcastConditionVariable(&system->Wake);
+	UnlockMutex(&system->Lock);
+
+	for (u32 i = 0; i < system->WorkerCount; ++i)
+		JoinThread(&system->Workers[i].Thread);
+
+	free(system->Workers);
+	vec_destroy(system->Injected);
+	DestroyConditionVariable(&system->Wake);
+	DestroyMutex(&system->Lock);
+	memset(system, 0, sizeof(JobSystem));
+}
+
+/* A structure for a level of the measurement's job tree */
+typedef struct {
+	JobSystem* System;		/* The job system */
+	u32 Depth;				/* The levels left below this one */
+	JobCounter* Counter;	/* Counts every job of the tree */
+	volatile i64* Sum;		/* Every leaf adds to it, so the work can not be optimized away */
+	void* Children;			/* The level below */
+} JobBenchmarkLevel;
+
+/* A job of the measurement, it spawns two jobs of the level below until the depth runs out, like a recursive
+   culling or sorting pass. The children count on the same counter so no job waits and every job is scheduling */
+void JobBenchmarkTree(void* argument)
+{
+	JobBenchmarkLevel* level = (JobBenchmarkLevel*)argument;
+	if (level->Depth == 0)
+		AtomicAdd64(level->Sum, 1);
+	else
+		RunJobs(level->System, JobBenchmarkTree, level->Children, 0, 2, level->Counter);
+}
+
+/* A function to measure how many jobs per second the job system runs and how often workers steal, with a binary
+   tree of tiny jobs started from one job, so every other worker has to steal to get work */
+/* @param The number of worker threads, 0 uses one per processor */
+/* @param The depth of the tree, it has 2^(depth + 1) - 1 jobs, at most 30 */
+/* @param A Pointer to the JobSystemStats to be filled */
+bool MeasureJobSystem(u32 workerCount, u32 depth, JobSystemStats* stats)
+{
+	if (depth > 30)
+		depth = 30;
+
+	JobSystem system;
+	if (!CreateJobSystem(workerCount, &system))
+		return false;
+
+	volatile i64 sum = 0;
+	JobCounter counter = { 0 };
+	InitializeJobCounter(&counter, 0);
+	JobBenchmarkLevel levels[31];
+	for (u32 i = 0; i <= depth; ++i)
+	{
+		levels[i].System = &system;
+		levels[i].Depth = i;
+		levels[i].Counter = &counter;
+		levels[i].Sum = &sum;
+		levels[i].Children = i > 0 ? &levels[i - 1] : nullptr;
+	}
+
+	double startTime = GetTimeInSeconds();
+	RunJobs(&system, JobBenchmarkTree, &levels[depth], 0, 1, &counter);
+	WaitForJobCounter(&system, &counter);
+	double seconds = GetTimeInSeconds() - startTime;
+
+	/* The waiting thread may run some of the jobs itself, those are not in the worker counters */
+	u64 jobCount = (2ull << depth) - 1;
+	GetJobSystemStats(&system, stats);
+	stats->JobsPerSecond = seconds > 0.0 ? (double)jobCount / seconds : 0.0;
+	bool result = sum == (1ll << depth);
+	printf("INFO: %llu jobs on %u workers in %.2f ms, %.2f million jobs per second, %.1f%% stolen%s\n",
+		(unsigned long long)jobCount, system.WorkerCount, seconds * 1000.0, stats->JobsPerSecond / 1000000.0,
+		stats->StealRate * 100.0, result ? "" : ", WRONG RESULT");
+
+	DestroyJobCounter(&counter);
+	DestroyJobSystem(&system);
+	return result;
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <stdlib.h>
+#include <VkHelper/VkHelper.h>
+#include <JobSystem/JobSystem.h>
+#include <CommandRecycler/CommandRecycler.h>
+
+#define PARALLEL_RECORDER_MAX_WORKERS 64
+
+/* A function that records a range of items, for example draws, into a secondary command buffer */
+typedef void (*RecordItemsFunction)(VkCommandBuffer commandBuffer, u32 first, u32 count, void* userData);
+
+/* A structure for what one range records into, a command pool per frame in flight so a frame's pool can be
+   reset while the GPU still runs the buffers of the other frames. Whichever thread runs the job of a range is the
+   only one using its pools for that recording */
+typedef struct {
+	CommandBufferRecycler Recycler;	/* Only this worker records from its pools */
+} RecorderWorker;
+
+/* A structure for the range of items one worker records */
+typedef struct {
+	struct ParallelRecorder* Recorder;			/* The recorder */
+	u32 Worker;									/* The range, picks the command pool */
+	u32 First;									/* The first item */
+	u32 Count;									/* The number of items */
+	VkCommandBufferInheritanceInfo* Inheritance;	/* The render pass the secondary buffer continues */
+	RecordItemsFunction Record;					/* The function recording the items */
+	void* UserData;								/* Passed to the function */
+	VkCommandBuffer CommandBuffer;				/* The recorded secondary buffer, VK_NULL_HANDLE if it failed */
+} ParallelRecordTask;
+
+/* A structure for recording secondary command buffers on many threads */
+typedef struct ParallelRecorder {
+	VkDevice* LogicalDevice;	/* The logical device */
+	JobSystem* Jobs;			/* The job system the ranges are recorded on */
+	u32 WorkerCount;			/* The number of ranges the items are split into, each has its own command pools */
+	u32 FrameCount;				/* The number of frames in flight */
+	u32 Frame;					/* The frame being recorded */
+	RecorderWorker* Workers;	/* The command pools of each worker */
+	ParallelRecordTask* Tasks;	/* The task of each worker for the current recording */
+} ParallelRecorder;
+
+/* A structure for how long recording took on a number of threads */
+typedef struct {
+	u32 ThreadCount;	/* The threads that recorded */
+	double Seconds;		/* The time from the first secondary buffer begun to the last one ended */
+	double Speedup;		/* The time on one thread divided by this time */
+} ParallelRecordingTiming;
+
+/* A function to create a parallel recorder */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the job system that records the ranges */
+/* @param The queue family the command buffers are submitted to */
+/* @param The number of ranges, 0 uses one per job worker and one for the thread that waits */
+/* @param The number of frames in flight */
+/* @param A Pointer to the ParallelRecorder to be filled */
+bool CreateParallelRecorder(VkDevice* logicalDevice, JobSystem* jobs, u32 queueFamily, u32 workerCount, u32 frameCount, ParallelRecorder* recorder)
+{
+	memset(recorder, 0, sizeof(ParallelRecorder));
+	if (workerCount == 0)
+		workerCount = jobs->WorkerCount + 1;
+	if (workerCount > PARALLEL_RECORDER_MAX_WORKERS)
+		workerCount = PARALLEL_RECORDER_MAX_WORKERS;
+
+	recorder->LogicalDevice = logicalDevice;
+	recorder->Jobs = jobs;
+	recorder->WorkerCount = workerCount;
+	recorder->FrameCount = frameCount;
+	recorder->Workers = (RecorderWorker*)calloc(workerCount, sizeof(RecorderWorker));
+	recorder->Tasks = (ParallelRecordTask*)calloc(workerCount, sizeof(ParallelRecordTask));
+
+	for (u32 i = 0; i < workerCount; ++i)
+		if (!CreateCommandBufferRecycler(logicalDevice, queueFamily, frameCount, &recorder->Workers[i].Recycler))
+			return false;
+
+	return true;
+}
+
+/* A function to start recording a frame, the command buffers of the last time this frame was recorded are reused */
+/* @param A Pointer to the parallel recorder */
+/* @param The frame in flight, from 0 to FrameCount - 1 */
+/* @param A Pointer to the fence of the last submit of this frame, it is waited on first, null if it already signaled */
+bool BeginParallelRecorderFrame(ParallelRecorder* recorder, u32 frame, VkFence* fence)
+{
+	if (fence && (vkWaitForFences(*recorder->LogicalDevice, 1, fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS))
+	{
+		printf("ERROR: Could not wait for the fence of a frame!\n");
+		return false;
+	}
+
+	recorder->Frame = frame;
+	for (u32 i = 0; i < recorder->WorkerCount; ++i)
+		if (!BeginCommandBufferRecyclerFrame(&recorder->Workers[i].Recycler, frame, nullptr))
+			return false;
+
+	return true;
+}
+
+/* A function for the counters of every worker together, AllocationCalls stays flat once every frame is warm */
+/* @param A Pointer to the parallel recorder */
+/* @param A Pointer to the CommandRecyclerStats to be filled */
+void GetParallelRecorderStats(ParallelRecorder* recorder, CommandRecyclerStats* stats)
+{
+	memset(stats, 0, sizeof(CommandRecyclerStats));
+	for (u32 i = 0; i < recorder->WorkerCount; ++i)
+	{
+		CommandRecyclerStats worker;
+		GetCommandBufferRecyclerStats(&recorder->Workers[i].Recycler, &worker);
+		stats->AllocationCalls += worker.AllocationCalls;
+		stats->Buffers += worker.Buffers;
+		stats->Acquired += worker.Acquired;
+		stats->PoolResets += worker.PoolResets;
+	}
+}
+
+/* The job recording one range */
+/* @param A Pointer to the ParallelRecordTask */
+void ParallelRecordWorker(void* argument)
+{
+	ParallelRecordTask* task = (ParallelRecordTask*)argument;
+	ParallelRecorder* recorder = task->Recorder;
+	RecorderWorker* worker = &recorder->Workers[task->Worker];
+	task->CommandBuffer = VK_NULL_HANDLE;
+
+	VkCommandBuffer commandBuffer;
+	if (!AcquireCommandBuffer(&worker->Recycler, VK_COMMAND_BUFFER_LEVEL_SECONDARY, &commandBuffer))
+		return;
+
+	if (!BeginCommandBufferRecordingOperation(&commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, task->Inheritance))
+		return;
+
+	task->Record(commandBuffer, task->First, task->Count, task->UserData);
+
+	if (EndCommandBufferRecordingOperation(&commandBuffer))
+		task->CommandBuffer = commandBuffer;
+}
+
+/* A function to record items as jobs into secondary command buffers and execute them from a primary one.
+   The primary buffer must be inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and
+   only one thread may call this at a time */
+/* @param A Pointer to the parallel recorder */
+/* @param The primary command buffer */
+/* @param A Pointer to the inheritance info with the render pass, subpass and framebuffer */
+/* @param The number of items */
+/* @param The function recording a range of items, it is called from many threads at once */
+/* @param A Pointer passed to the function */
+bool RecordInParallel(ParallelRecorder* recorder, VkCommandBuffer primary, VkCommandBufferInheritanceInfo* inheritance, u32 itemCount, RecordItemsFunction record, void* userData)
+{
+	/* Equal ranges, the items are assumed to cost about the same, in order so the draws keep their order */
+	u32 perWorker = (itemCount + recorder->WorkerCount - 1) / recorder->WorkerCount;
+	u32 taskCount = 0;
+	for (u32 first = 0; first < itemCount; first += perWorker)
+	{
+		ParallelRecordTask* task = &recorder->Tasks[taskCount];
+		task->Recorder = recorder;
+		task->Worker = taskCount++;
+		task->First = first;
+		task->Count = (itemCount - first) < perWorker ? (itemCount - first) : perWorker;
+		task->Inheritance = inheritance;
+		task->Record = record;
+		task->UserData = userData;
+	}
+
+	/* The calling thread runs ranges too while it waits */
+	JobCounter counter = { 0 };
+	InitializeJobCounter(&counter, 0);
+	RunJobs(recorder->Jobs, ParallelRecordWorker, recorder->Tasks, sizeof(ParallelRecordTask), taskCount, &counter);
+	WaitForJobCounter(recorder->Jobs, &counter);
+	DestroyJobCounter(&counter);
+
+	VkCommandBuffer secondaries[PARALLEL_RECORDER_MAX_WORKERS];
+	for (u32 i = 0; i < taskCount; ++i)
+	{
+		if (recorder->Tasks[i].CommandBuffer == VK_NULL_HANDLE)
+		{
+			printf("ERROR: Could not record a secondary command buffer!\n");
+			return false;
+		}
+		secondaries[i] = recorder->Tasks[i].CommandBuffer;
+	}
+
+	if (taskCount > 0)
+		vkCmdExecuteCommands(primary, taskCount, secondaries);
+	return true;
+}
+
+/* A function to clean up created vulkan resources, the GPU must be done with every frame */
+/* @param A pointer to the resource to cleanup */
+void DestroyParallelRecorder(ParallelRecorder* recorder)
+{
+	for (u32 i = 0; i < recorder->WorkerCount; ++i)
+		DestroyCommandBufferRecycler(&recorder->Workers[i].Recycler);
+
+	free(recorder->Workers);
+	free(recorder->Tasks);
+	memset(recorder, 0, sizeof(ParallelRecorder));
+}
+
+/* A structure for what the measurement records for each draw */
+typedef struct {
+	VkPipeline Pipeline;	/* The pipeline the draws use */
+	VkExtent2D Extent;		/* The size of the framebuffer */
+} ParallelDrawBenchmark;
+
+/* The function recording the draws of the measurement */
+void RecordBenchmarkDraws(VkCommandBuffer commandBuffer, u32 first, u32 count, void* userData)
+{
+	ParallelDrawBenchmark* benchmark = (ParallelDrawBenchmark*)userData;
+	VkViewport viewport = { 0.0f, 0.0f, (float)benchmark->Extent.width, (float)benchmark->Extent.height, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, benchmark->Extent };
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, benchmark->Pipeline);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	for (u32 i = 0; i < count; ++i)
+		vkCmdDraw(commandBuffer, 3, 1, 0, first + i);
+}
+
+/* A function to measure recording the same draws on job systems of 1, 2, 4, 8 and 16 workers, split into as many ranges.
+   The command buffers are never submitted */
+/* @param A Pointer to a logical device */
+/* @param The queue family of the command buffers */
+/* @param The render pass the draws are in */
+/* @param A framebuffer of the render pass */
+/* @param The size of the framebuffer */
+/* @param A pipeline with dynamic viewport and scissor, compatible with the render pass */
+/* @param The number of draws, 100000 for the usual numbers */
+/* @param An array of 5 ParallelRecordingTiming to be filled */
+bool MeasureParallelRecording(VkDevice* logicalDevice, u32 queueFamily, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent,
+	VkPipeline pipeline, u32 drawCount, ParallelRecordingTiming* timings)
+{
+	ParallelDrawBenchmark benchmark = { pipeline, extent };
+	VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO, nullptr, renderPass, 0, framebuffer, VK_FALSE, 0, 0 };
+	VkClearValue clearValue = { 0 };
+	VkRenderPassBeginInfo renderPassBegin = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO, nullptr, renderPass, framebuffer, { { 0, 0 }, extent }, 1, &clearValue };
+
+	VkCommandPool primaryPool;
+	if (!CreateCommandPool(logicalDevice, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queueFamily, &primaryPool))
+		return false;
+	Vec primaries = AllocateCommandBuffers(logicalDevice, &primaryPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+	if (primaries == nullptr)
+	{
+		vkDestroyCommandPool(*logicalDevice, primaryPool, nullptr);
+		return false;
+	}
+	VkCommandBuffer primary = ((VkCommandBuffer*)primaries)[0];
+
+	bool result = true;
+	for (u32 i = 0; result && (i < 5); ++i)
+	{
+		JobSystem jobs;
+		ParallelRecorder recorder;
+		timings[i].ThreadCount = 1u << i;
+		if (!CreateJobSystem(timings[i].ThreadCount, &jobs))
+		{
+			result = false;
+			break;
+		}
+		if (!CreateParallelRecorder(logicalDevice, &jobs, queueFamily, timings[i].ThreadCount, 1, &recorder))
+		{
+			DestroyJobSystem(&jobs);
+			result = false;
+			break;
+		}
+
+		/* A warm up frame first, so pool growth in the driver is not measured */
+		for (u32 run = 0; result && (run < 2); ++run)
+		{
+			result = BeginParallelRecorderFrame(&recorder, 0, nullptr);
+			if (!result)
+				break;
+
+			ResetCommandBuffer(&primary, false);
+			BeginCommandBufferRecordingOperation(&primary, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
+			vkCmdBeginRenderPass(primary, &renderPassBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			double startTime = GetTimeInSeconds();
+			result = RecordInParallel(&recorder, primary, &inheritance, drawCount, RecordBenchmarkDraws, &benchmark);
+			timings[i].Seconds = GetTimeInSeconds() - startTime;
+
+			vkCmdEndRenderPass(primary);
+			EndCommandBufferRecordingOperation(&primary);
+		}
+
+		timings[i].Speedup = timings[i].Seconds > 0.0 ? timings[0].Seconds / timings[i].Seconds : 0.0;
+		if (result)
+			printf("INFO: %u draws recorded on %u threads in %.2f ms, %.2fx the speed of one thread\n", drawCount, timings[i].ThreadCount,
+				timings[i].Seconds * 1000.0, timings[i].Speedup);
+		DestroyParallelRecorder(&recorder);
+		DestroyJobSystem(&jobs);
+	}
+
+	vec_destroy(primaries);
+	vkDestroyCommandPool(*logicalDevice, primaryPool, nullptr);
+	return result;
+}
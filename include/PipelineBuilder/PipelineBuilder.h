@@ -0,0 +1,168 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <PipelineState/PipelineState.h>
+
+#define PIPELINE_SHADER_ENTRY_POINT_LENGTH 64
+
+/* A structure for a shader the pipeline states can use */
+typedef struct {
+	u64 Id;								/* The id the states use */
+	VkShaderStageFlagBits Stage;		/* The stage */
+	VkShaderModule Module;				/* The module */
+	char EntryPoint[PIPELINE_SHADER_ENTRY_POINT_LENGTH];	/* The entry point */
+} PipelineShader;
+
+/* A structure holding every structure a VkGraphicsPipelineCreateInfo points to, so a create info can be built in
+   one place and changed before use. It points into itself, so it must not be copied after it is built */
+typedef struct {
+	VkPipelineShaderStageCreateInfo Stages[PIPELINE_STATE_MAX_STAGES];
+	VkSpecializationMapEntry SpecializationEntries[PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS];
+	VkSpecializationInfo Specialization;
+	VkPipelineVertexInputStateCreateInfo VertexInput;
+	VkPipelineInputAssemblyStateCreateInfo InputAssembly;
+	VkPipelineViewportStateCreateInfo Viewport;
+	VkPipelineRasterizationStateCreateInfo Rasterization;
+	VkPipelineMultisampleStateCreateInfo Multisample;
+	VkPipelineDepthStencilStateCreateInfo DepthStencil;
+	VkPipelineColorBlendStateCreateInfo ColorBlend;
+	VkDynamicState DynamicStates[2];
+	VkPipelineDynamicStateCreateInfo Dynamic;
+	VkPipelineRenderingCreateInfoKHR Rendering;	/* The attachment formats, only used without a render pass */
+	VkGraphicsPipelineCreateInfo CreateInfo;	/* The create info, pNext is null or the rendering info, callers chain theirs in front */
+} GraphicsPipelineBuilder;
+
+/* A function to check if a depth format has a stencil part */
+/* @param The format */
+bool IsStencilFormat(VkFormat format)
+{
+	return (format == VK_FORMAT_S8_UINT) || (format == VK_FORMAT_D16_UNORM_S8_UINT) ||
+		(format == VK_FORMAT_D24_UNORM_S8_UINT) || (format == VK_FORMAT_D32_SFLOAT_S8_UINT);
+}
+
+/* A function to build the create info of a graphics pipeline from a state */
+/* @param A Pointer to the pipeline state */
+/* @param An array of the shaders of the state, in the order of its ShaderIds */
+/* @param The pipeline layout */
+/* @param The render pass, VK_NULL_HANDLE for dynamic rendering with the formats of the state, the device must have it enabled */
+/* @param A Pointer to the GraphicsPipelineBuilder to be filled */
+void BuildGraphicsPipeline(const PipelineState* state, const PipelineShader* shaders, VkPipelineLayout layout, VkRenderPass renderPass, GraphicsPipelineBuilder* builder)
+{
+	memset(builder, 0, sizeof(GraphicsPipelineBuilder));
+
+	/* Every stage gets every constant, the ones a stage does not declare are ignored */
+	for (u32 i = 0; i < state->SpecializationCount; ++i)
+	{
+		VkSpecializationMapEntry entry = { state->SpecializationIds[i], i * (u32)sizeof(u32), sizeof(u32) };
+		builder->SpecializationEntries[i] = entry;
+	}
+
+	VkSpecializationInfo specializationInfo =
+	{
+		state->SpecializationCount, builder->SpecializationEntries, state->SpecializationCount * sizeof(u32), state->SpecializationValues
+	};
+	builder->Specialization = specializationInfo;
+
+	for (u32 i = 0; i < state->ShaderCount; ++i)
+	{
+		VkPipelineShaderStageCreateInfo stage =
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, shaders[i].Stage, shaders[i].Module, shaders[i].EntryPoint,
+			state->SpecializationCount ? &builder->Specialization : nullptr
+		};
+		builder->Stages[i] = stage;
+	}
+
+	VkPipelineVertexInputStateCreateInfo vertexInputState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO, nullptr, 0,
+		state->VertexBindingCount, state->VertexBindings,
+		state->VertexAttributeCount, state->VertexAttributes
+	};
+	builder->VertexInput = vertexInputState;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0, state->Topology, VK_FALSE
+	};
+	builder->InputAssembly = inputAssemblyState;
+
+	/* Viewport and scissor are dynamic, so one pipeline works for every window size */
+	VkPipelineViewportStateCreateInfo viewportState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, nullptr, 0, 1, nullptr, 1, nullptr
+	};
+	builder->Viewport = viewportState;
+
+	VkPipelineRasterizationStateCreateInfo rasterizationState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, nullptr, 0,
+		VK_FALSE, VK_FALSE, state->PolygonMode, state->CullMode, state->FrontFace, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
+	};
+	builder->Rasterization = rasterizationState;
+
+	VkPipelineMultisampleStateCreateInfo multisampleState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, nullptr, 0,
+		state->Samples ? state->Samples : VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 1.0f, nullptr, VK_FALSE, VK_FALSE
+	};
+	builder->Multisample = multisampleState;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencilState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO, nullptr, 0,
+		state->DepthTest, state->DepthWrite, state->DepthCompare, VK_FALSE, VK_FALSE, { 0 }, { 0 }, 0.0f, 1.0f
+	};
+	builder->DepthStencil = depthStencilState;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, nullptr, 0,
+		VK_FALSE, VK_LOGIC_OP_COPY, state->ColorCount, state->Blend, { 0.0f, 0.0f, 0.0f, 0.0f }
+	};
+	builder->ColorBlend = colorBlendState;
+
+	builder->DynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+	builder->DynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+	VkPipelineDynamicStateCreateInfo dynamicState =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO, nullptr, 0, 2, builder->DynamicStates
+	};
+	builder->Dynamic = dynamicState;
+
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+		nullptr,
+		0,
+		state->ShaderCount,
+		builder->Stages,
+		&builder->VertexInput,
+		&builder->InputAssembly,
+		nullptr,
+		&builder->Viewport,
+		&builder->Rasterization,
+		&builder->Multisample,
+		&builder->DepthStencil,
+		&builder->ColorBlend,
+		&builder->Dynamic,
+		layout,
+		renderPass,
+		state->Subpass,
+		VK_NULL_HANDLE,
+		-1
+	};
+	builder->CreateInfo = pipelineCreateInfo;
+
+	/* Without a render pass the driver gets the formats of the attachments it will render to instead */
+	if (renderPass == VK_NULL_HANDLE)
+	{
+		VkPipelineRenderingCreateInfoKHR renderingCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR, nullptr, 0, state->ColorCount, state->ColorFormats,
+			state->DepthFormat == VK_FORMAT_S8_UINT ? VK_FORMAT_UNDEFINED : state->DepthFormat,
+			IsStencilFormat(state->DepthFormat) ? state->DepthFormat : VK_FORMAT_UNDEFINED
+		};
+		builder->Rendering = renderingCreateInfo;
+		builder->CreateInfo.pNext = &builder->Rendering;
+	}
+}
@@ -0,0 +1,360 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <FileHelper/FileHelper.h>
+
+#define PIPELINE_NAME_LENGTH 64
+#define PIPELINE_MAX_STAGES 8
+
+/* How a pipeline creation used the cache */
+typedef enum {
+	PIPELINE_CACHE_UNKNOWN,		/* The driver did not say, VK_EXT_pipeline_creation_feedback is missing */
+	PIPELINE_CACHE_HIT,			/* The whole pipeline came out of the cache */
+	PIPELINE_CACHE_MISS			/* The driver had to compile */
+} PipelineCacheResult;
+
+/* A structure for the creation of one pipeline */
+typedef struct {
+	char Name[PIPELINE_NAME_LENGTH];	/* The name given at creation */
+	PipelineCacheResult Result;			/* Hit, miss or unknown */
+	double Seconds;						/* The CPU time of the create call */
+	double DriverSeconds;				/* The time the driver reports, 0 if unknown */
+} PipelineCreationTiming;
+
+/* A structure for the cache statistics */
+typedef struct {
+	u32 Hits;				/* Pipelines that came out of the cache */
+	u32 Misses;				/* Pipelines that had to be compiled */
+	u32 Unknown;			/* Pipelines without creation feedback */
+	double HitSeconds;		/* The time spent on hits */
+	double MissSeconds;		/* The time spent on misses */
+	double UnknownSeconds;	/* The time spent on pipelines without feedback */
+	u64 LoadedSize;			/* The size of the cache data read at startup, 0 if it was not valid */
+} PipelineCacheStats;
+
+/* A structure for a VkPipelineCache that lives on disk between runs */
+typedef struct {
+	VkDevice* LogicalDevice;			/* The logical device */
+	VkPhysicalDeviceProperties Properties;	/* The device the data has to come from */
+	char Path[FILE_PATH_LENGTH];		/* Where the data is stored */
+	VkPipelineCache Cache;				/* The cache everything is merged into */
+	Vec WorkerCaches;					/* A Vector of VkPipelineCache, one per worker thread so they do not fight over one cache */
+	bool FeedbackSupported;				/* VK_EXT_pipeline_creation_feedback is enabled */
+	Mutex Lock;							/* Guards the vectors and the statistics */
+	Vec Timings;						/* A Vector of PipelineCreationTiming */
+	PipelineCacheStats Stats;			/* The statistics */
+} PipelineCache;
+
+/* A function to check if pipeline cache data was written by this driver and device */
+/* @param A Pointer to the data */
+/* @param The size of the data in bytes */
+/* @param A Pointer to the properties of the physical device */
+bool ValidatePipelineCacheHeader(const void* data, u64 size, VkPhysicalDeviceProperties* properties)
+{
+	const VkPipelineCacheHeaderVersionOne* header = (const VkPipelineCacheHeaderVersionOne*)data;
+
+	if (size < sizeof(VkPipelineCacheHeaderVersionOne))
+	{
+		printf("WARNING: The pipeline cache data is too small\n");
+		return false;
+	}
+
+	if ((header->headerSize < sizeof(VkPipelineCacheHeaderVersionOne)) || (header->headerSize > size) ||
+		(header->headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE))
+	{
+		printf("WARNING: The pipeline cache data has an unknown header\n");
+		return false;
+	}
+
+	/* A driver update changes the UUID, and other GPUs can not use the data at all */
+	if ((header->vendorID != properties->vendorID) || (header->deviceID != properties->deviceID) ||
+		(memcmp(header->pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) != 0))
+	{
+		printf("INFO: The pipeline cache data is from another device or driver, starting with an empty cache\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create a pipeline cache object */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the initial data, can be null */
+/* @param The size of the initial data in bytes */
+/* @param A Pointer to a VkPipelineCache to be filled */
+bool CreateVkPipelineCache(VkDevice* logicalDevice, const void* data, u64 size, VkPipelineCache* pipelineCache)
+{
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		nullptr,
+		0,
+		(size_t)size,
+		data
+	};
+
+	VkResult result = vkCreatePipelineCache(*logicalDevice, &pipelineCacheCreateInfo, nullptr, pipelineCache);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a pipeline cache!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create a pipeline cache and fill it with the data from the last run */
+/* @param A Pointer to the physical device */
+/* @param A Pointer to a logical device */
+/* @param Where the data is stored */
+/* @param True if VK_EXT_pipeline_creation_feedback is enabled on the device */
+/* @param A Pointer to the PipelineCache to be filled */
+bool CreatePersistentPipelineCache(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, const char* path, bool feedbackSupported, PipelineCache* cache)
+{
+	memset(cache, 0, sizeof(PipelineCache));
+	cache->LogicalDevice = logicalDevice;
+	cache->FeedbackSupported = feedbackSupported;
+	cache->WorkerCaches = vec_create(VkPipelineCache);
+	cache->Timings = vec_create(PipelineCreationTiming);
+	snprintf(cache->Path, FILE_PATH_LENGTH, "%s", path);
+	InitializeMutex(&cache->Lock);
+	vkGetPhysicalDeviceProperties(*physicalDevice, &cache->Properties);
+
+	char* data = nullptr;
+	u64 size = 0;
+	if ((GetFileModificationTime(path) != 0) && ReadWholeFile(path, &size, &data) && ValidatePipelineCacheHeader(data, size, &cache->Properties))
+	{
+		/* Drivers check the data too, but a bad blob from somewhere else should never get that far */
+		if (CreateVkPipelineCache(logicalDevice, data, size, &cache->Cache))
+		{
+			cache->Stats.LoadedSize = size;
+			printf("INFO: Loaded %llu bytes of pipeline cache data\n", (unsigned long long)size);
+		}
+	}
+	free(data);
+
+	if ((cache->Cache == VK_NULL_HANDLE) && !CreateVkPipelineCache(logicalDevice, nullptr, 0, &cache->Cache))
+		return false;
+
+	return true;
+}
+
+/* A function to create a pipeline cache for a worker thread, it is merged into the main one when saving */
+/* @param A Pointer to the pipeline cache */
+/* @param A Pointer to a VkPipelineCache to be filled */
+bool CreateWorkerPipelineCache(PipelineCache* cache, VkPipelineCache* workerCache)
+{
+	/* Seeded from the main cache, so the worker still hits on pipelines from the last run */
+	size_t size = 0;
+	void* data = nullptr;
+	LockMutex(&cache->Lock);
+	if ((vkGetPipelineCacheData(*cache->LogicalDevice, cache->Cache, &size, nullptr) == VK_SUCCESS) && (size > 0))
+	{
+		data = malloc(size);
+		if (vkGetPipelineCacheData(*cache->LogicalDevice, cache->Cache, &size, data) != VK_SUCCESS)
+			size = 0;
+	}
+	UnlockMutex(&cache->Lock);
+
+	bool result = CreateVkPipelineCache(cache->LogicalDevice, data, size, workerCache);
+	free(data);
+	if (!result)
+		return false;
+
+	LockMutex(&cache->Lock);
+	vec_pushback(cache->WorkerCaches, *workerCache, VkPipelineCache);
+	UnlockMutex(&cache->Lock);
+	return true;
+}
+
+/* A function to record how a pipeline creation went */
+/* @param A Pointer to the pipeline cache */
+/* @param The name of the pipeline */
+/* @param The CPU time of the create call */
+/* @param A Pointer to the creation feedback, null if there is none */
+void RecordPipelineCreation(PipelineCache* cache, const char* name, double seconds, const VkPipelineCreationFeedback* feedback)
+{
+	PipelineCreationTiming timing = { 0 };
+	snprintf(timing.Name, PIPELINE_NAME_LENGTH, "%s", name ? name : "unnamed");
+	timing.Seconds = seconds;
+	timing.Result = PIPELINE_CACHE_UNKNOWN;
+
+	if (feedback && (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+	{
+		timing.Result = (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) ? PIPELINE_CACHE_HIT : PIPELINE_CACHE_MISS;
+		timing.DriverSeconds = (double)feedback->duration / 1000000000.0;
+	}
+
+	LockMutex(&cache->Lock);
+	vec_pushback(cache->Timings, timing, PipelineCreationTiming);
+	switch (timing.Result)
+	{
+	case PIPELINE_CACHE_HIT:	++cache->Stats.Hits; cache->Stats.HitSeconds += seconds; break;
+	case PIPELINE_CACHE_MISS:	++cache->Stats.Misses; cache->Stats.MissSeconds += seconds; break;
+	default:					++cache->Stats.Unknown; cache->Stats.UnknownSeconds += seconds; break;
+	}
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function to create a graphics pipeline through the cache and record if it was a hit */
+/* @param A Pointer to the pipeline cache */
+/* @param The VkPipelineCache to use, the main one or a worker one */
+/* @param A Pointer to the create info, its pNext chain is left as it was */
+/* @param The name of the pipeline for the timings */
+/* @param A Pointer to a VkPipeline to be filled */
+bool CreateGraphicsPipelineWithCache(PipelineCache* cache, VkPipelineCache pipelineCache, VkGraphicsPipelineCreateInfo* createInfo, const char* name, VkPipeline* pipeline)
+{
+	VkPipelineCreationFeedback pipelineFeedback = { 0 };
+	VkPipelineCreationFeedback stageFeedbacks[PIPELINE_MAX_STAGES] = { 0 };
+	VkPipelineCreationFeedbackCreateInfo feedbackCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+		createInfo->pNext,
+		&pipelineFeedback,
+		createInfo->stageCount <= PIPELINE_MAX_STAGES ? createInfo->stageCount : 0,
+		stageFeedbacks
+	};
+
+	const void* next = createInfo->pNext;
+	if (cache->FeedbackSupported)
+		createInfo->pNext = &feedbackCreateInfo;
+
+	double startTime = GetTimeInSeconds();
+	VkResult result = vkCreateGraphicsPipelines(*cache->LogicalDevice, pipelineCache, 1, createInfo, nullptr, pipeline);
+	double seconds = GetTimeInSeconds() - startTime;
+	createInfo->pNext = next;
+
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the graphics pipeline %s!\n", name ? name : "unnamed");
+		return false;
+	}
+
+	RecordPipelineCreation(cache, name, seconds, cache->FeedbackSupported ? &pipelineFeedback : nullptr);
+	return true;
+}
+
+/* A function to create a compute pipeline through the cache and record if it was a hit */
+/* @param A Pointer to the pipeline cache */
+/* @param The VkPipelineCache to use, the main one or a worker one */
+/* @param A Pointer to the create info, its pNext chain is left as it was */
+/* @param The name of the pipeline for the timings */
+/* @param A Pointer to a VkPipeline to be filled */
+bool CreateComputePipelineWithCache(PipelineCache* cache, VkPipelineCache pipelineCache, VkComputePipelineCreateInfo* createInfo, const char* name, VkPipeline* pipeline)
+{
+	VkPipelineCreationFeedback pipelineFeedback = { 0 };
+	VkPipelineCreationFeedback stageFeedback = { 0 };
+	VkPipelineCreationFeedbackCreateInfo feedbackCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+		createInfo->pNext,
+		&pipelineFeedback,
+		1,
+		&stageFeedback
+	};
+
+	const void* next = createInfo->pNext;
+	if (cache->FeedbackSupported)
+		createInfo->pNext = &feedbackCreateInfo;
+
+	double startTime = GetTimeInSeconds();
+	VkResult result = vkCreateComputePipelines(*cache->LogicalDevice, pipelineCache, 1, createInfo, nullptr, pipeline);
+	double seconds = GetTimeInSeconds() - startTime;
+	createInfo->pNext = next;
+
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the compute pipeline %s!\n", name ? name : "unnamed");
+		return false;
+	}
+
+	RecordPipelineCreation(cache, name, seconds, cache->FeedbackSupported ? &pipelineFeedback : nullptr);
+	return true;
+}
+
+/* A function for getting the cache statistics */
+/* @param A Pointer to the pipeline cache */
+/* @param A Pointer to the PipelineCacheStats to be filled */
+void GetPipelineCacheStats(PipelineCache* cache, PipelineCacheStats* stats)
+{
+	LockMutex(&cache->Lock);
+	*stats = cache->Stats;
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function to print the timing of every pipeline created so far */
+/* @param A Pointer to the pipeline cache */
+void PrintPipelineCreationTimings(PipelineCache* cache)
+{
+	static const char* results[] = { "unknown", "hit", "miss" };
+
+	LockMutex(&cache->Lock);
+	for (u64 i = 0; i < vec_length(cache->Timings); ++i)
+	{
+		PipelineCreationTiming* timing = &((PipelineCreationTiming*)cache->Timings)[i];
+		printf("INFO: Pipeline %s: %s in %.3f ms (driver %.3f ms)\n", timing->Name, results[timing->Result], timing->Seconds * 1000.0, timing->DriverSeconds * 1000.0);
+	}
+	printf("INFO: Pipeline cache: %u hits in %.3f ms, %u misses in %.3f ms, %u unknown in %.3f ms\n", cache->Stats.Hits, cache->Stats.HitSeconds * 1000.0,
+		cache->Stats.Misses, cache->Stats.MissSeconds * 1000.0, cache->Stats.Unknown, cache->Stats.UnknownSeconds * 1000.0);
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function to merge every worker cache into the main one */
+/* @param A Pointer to the pipeline cache */
+bool MergeWorkerPipelineCaches(PipelineCache* cache)
+{
+	LockMutex(&cache->Lock);
+	VkResult result = VK_SUCCESS;
+	if (vec_length(cache->WorkerCaches) > 0)
+		result = vkMergePipelineCaches(*cache->LogicalDevice, cache->Cache, (u32)vec_length(cache->WorkerCaches), (VkPipelineCache*)cache->WorkerCaches);
+	UnlockMutex(&cache->Lock);
+
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not merge the worker pipeline caches!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to merge the worker caches and write the data to disk, readers never see a half written file */
+/* @param A Pointer to the pipeline cache */
+bool SavePipelineCache(PipelineCache* cache)
+{
+	if (!MergeWorkerPipelineCaches(cache))
+		return false;
+
+	size_t size = 0;
+	if ((vkGetPipelineCacheData(*cache->LogicalDevice, cache->Cache, &size, nullptr) != VK_SUCCESS) || (size == 0))
+	{
+		printf("ERROR: Could not get the size of the pipeline cache data!\n");
+		return false;
+	}
+
+	void* data = malloc(size);
+	bool result = vkGetPipelineCacheData(*cache->LogicalDevice, cache->Cache, &size, data) == VK_SUCCESS;
+	if (!result)
+		printf("ERROR: Could not get the pipeline cache data!\n");
+	else
+		result = WriteWholeFileAtomic(cache->Path, data, size);
+
+	free(data);
+	return result;
+}
+
+/* A function to clean up created vulkan resources, the data is saved first */
+/* @param A pointer to the resource to cleanup */
+void DestroyPersistentPipelineCache(PipelineCache* cache)
+{
+	SavePipelineCache(cache);
+
+	for (u64 i = 0; i < vec_length(cache->WorkerCaches); ++i)
+		vkDestroyPipelineCache(*cache->LogicalDevice, ((VkPipelineCache*)cache->WorkerCaches)[i], nullptr);
+	vkDestroyPipelineCache(*cache->LogicalDevice, cache->Cache, nullptr);
+
+	vec_destroy(cache->WorkerCaches);
+	vec_destroy(cache->Timings);
+	DestroyMutex(&cache->Lock);
+	memset(cache, 0, sizeof(PipelineCache));
+}
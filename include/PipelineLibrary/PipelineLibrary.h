@@ -0,0 +1,281 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <PipelineBuilder/PipelineBuilder.h>
+#include <PipelineMap/PipelineMap.h>
+#include <PipelineCache/PipelineCache.h>
+
+/* The parts VK_EXT_graphics_pipeline_library splits a graphics pipeline into */
+typedef enum {
+	PIPELINE_LIBRARY_VERTEX_INPUT,			/* Vertex buffers and topology */
+	PIPELINE_LIBRARY_PRE_RASTERIZATION,		/* Every shader before the fragment shader and the rasterizer */
+	PIPELINE_LIBRARY_FRAGMENT_SHADER,		/* The fragment shader and the depth test */
+	PIPELINE_LIBRARY_FRAGMENT_OUTPUT,		/* The attachments and blending */
+	PIPELINE_LIBRARY_PART_COUNT
+} PipelineLibraryPart;
+
+/* A structure for the counters of the pipeline library cache */
+typedef struct {
+	u64 LibraryCount;				/* Libraries compiled */
+	double LibrarySeconds;			/* Time spent compiling libraries */
+	u64 FastLinkCount;				/* Pipelines linked without link time optimization */
+	double FastLinkSeconds;			/* Time spent on those links */
+	double SlowestFastLinkSeconds;	/* The longest of those links */
+	u64 OptimizedLinkCount;			/* Pipelines linked with link time optimization */
+	double OptimizedLinkSeconds;	/* Time spent on those links */
+} PipelineLibraryStats;
+
+/* A structure for the pipeline libraries, the parts are shared by every pipeline that has the same state for them */
+typedef struct {
+	VkDevice* LogicalDevice;		/* The logical device */
+	PipelineCache* Cache;			/* The pipeline cache for the timings */
+	bool Supported;					/* False when the device has no graphics pipeline library, pipelines are then built whole */
+	PipelineMap Parts[PIPELINE_LIBRARY_PART_COUNT];	/* Maps the part of a state that matters for a library to the library */
+	Mutex Lock;						/* Guards the counters */
+	PipelineLibraryStats Stats;		/* The counters */
+} PipelineLibraryCache;
+
+/* A structure for what creating a library on a miss of a part map needs */
+typedef struct {
+	PipelineLibraryCache* Libraries;	/* The library cache */
+	VkPipelineCache PipelineCache;		/* The VkPipelineCache to compile into */
+	const PipelineShader* Shaders;		/* The shaders of the part */
+	VkPipelineLayout Layout;			/* The pipeline layout */
+	VkRenderPass RenderPass;			/* The render pass */
+	PipelineLibraryPart Part;			/* The part */
+} PipelineLibraryRequest;
+
+/* A function to check if a physical device can build pipelines from libraries */
+/* @param The physical device to be screened */
+bool IsGraphicsPipelineLibrarySupported(VkPhysicalDevice* physicalDevice)
+{
+	if (!IsDeviceExtensionSupported(physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) ||
+		!IsDeviceExtensionSupported(physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &libraryFeatures };
+	vkGetPhysicalDeviceFeatures2(*physicalDevice, &features);
+	return libraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+}
+
+/* A function to create the pipeline library cache */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the pipeline cache */
+/* @param If the device was created with VK_EXT_graphics_pipeline_library and its feature enabled */
+/* @param A Pointer to the PipelineLibraryCache to be filled */
+void CreatePipelineLibraryCache(VkDevice* logicalDevice, PipelineCache* cache, bool supported, PipelineLibraryCache* libraries)
+{
+	memset(libraries, 0, sizeof(PipelineLibraryCache));
+	libraries->LogicalDevice = logicalDevice;
+	libraries->Cache = cache;
+	libraries->Supported = supported;
+	InitializeMutex(&libraries->Lock);
+	for (u32 i = 0; i < PIPELINE_LIBRARY_PART_COUNT; ++i)
+		CreatePipelineMap(&libraries->Parts[i]);
+
+	printf("INFO: Graphics pipelines are %s\n", supported ? "linked from libraries" : "built whole, there is no graphics pipeline library");
+}
+
+/* A function to strip a state down to what one library part is built from, so states that only differ elsewhere
+   share the library. The shaders of the part are picked out too */
+/* @param A Pointer to the pipeline state */
+/* @param An array of the shaders of the state, in the order of its ShaderIds */
+/* @param The part */
+/* @param A Pointer to the PipelineState to be filled with the key of the part */
+/* @param An array of PIPELINE_STATE_MAX_STAGES shaders to be filled with the shaders of the part */
+void GetPipelineLibraryKey(const PipelineState* state, const PipelineShader* shaders, PipelineLibraryPart part, PipelineState* key, PipelineShader* partShaders)
+{
+	memset(key, 0, sizeof(PipelineState));
+
+	if ((part == PIPELINE_LIBRARY_PRE_RASTERIZATION) || (part == PIPELINE_LIBRARY_FRAGMENT_SHADER))
+	{
+		for (u32 i = 0; i < state->ShaderCount; ++i)
+			if ((shaders[i].Stage == VK_SHADER_STAGE_FRAGMENT_BIT) == (part == PIPELINE_LIBRARY_FRAGMENT_SHADER))
+			{
+				partShaders[key->ShaderCount] = shaders[i];
+				key->ShaderIds[key->ShaderCount++] = state->ShaderIds[i];
+			}
+
+		key->LayoutId = state->LayoutId;
+		key->SpecializationCount = state->SpecializationCount;
+		memcpy(key->SpecializationIds, state->SpecializationIds, sizeof(state->SpecializationIds));
+		memcpy(key->SpecializationValues, state->SpecializationValues, sizeof(state->SpecializationValues));
+	}
+
+	if (part != PIPELINE_LIBRARY_VERTEX_INPUT)
+	{
+		key->RenderPassId = state->RenderPassId;
+		key->Subpass = state->Subpass;
+	}
+
+	switch (part)
+	{
+	case PIPELINE_LIBRARY_VERTEX_INPUT:
+		key->VertexBindingCount = state->VertexBindingCount;
+		key->VertexAttributeCount = state->VertexAttributeCount;
+		memcpy(key->VertexBindings, state->VertexBindings, sizeof(state->VertexBindings));
+		memcpy(key->VertexAttributes, state->VertexAttributes, sizeof(state->VertexAttributes));
+		key->Topology = state->Topology;
+		break;
+	case PIPELINE_LIBRARY_PRE_RASTERIZATION:
+		key->PolygonMode = state->PolygonMode;
+		key->CullMode = state->CullMode;
+		key->FrontFace = state->FrontFace;
+		break;
+	case PIPELINE_LIBRARY_FRAGMENT_SHADER:
+		key->Samples = state->Samples;
+		key->DepthTest = state->DepthTest;
+		key->DepthWrite = state->DepthWrite;
+		key->DepthCompare = state->DepthCompare;
+		break;
+	default:
+		key->ColorCount = state->ColorCount;
+		memcpy(key->ColorFormats, state->ColorFormats, sizeof(state->ColorFormats));
+		key->DepthFormat = state->DepthFormat;
+		key->Samples = state->Samples;
+		memcpy(key->Blend, state->Blend, sizeof(state->Blend));
+		break;
+	}
+}
+
+/* A function to add a link or compile to the counters */
+/* @param A Pointer to the pipeline library cache */
+/* @param The part that was compiled, or PIPELINE_LIBRARY_PART_COUNT for a link */
+/* @param If the link was optimized */
+/* @param The time it took */
+void RecordPipelineLibraryTime(PipelineLibraryCache* libraries, PipelineLibraryPart part, bool optimized, double seconds)
+{
+	LockMutex(&libraries->Lock);
+	if (part != PIPELINE_LIBRARY_PART_COUNT)
+	{
+		++libraries->Stats.LibraryCount;
+		libraries->Stats.LibrarySeconds += seconds;
+	}
+	else if (optimized)
+	{
+		++libraries->Stats.OptimizedLinkCount;
+		libraries->Stats.OptimizedLinkSeconds += seconds;
+	}
+	else
+	{
+		++libraries->Stats.FastLinkCount;
+		libraries->Stats.FastLinkSeconds += seconds;
+		if (seconds > libraries->Stats.SlowestFastLinkSeconds)
+			libraries->Stats.SlowestFastLinkSeconds = seconds;
+	}
+	UnlockMutex(&libraries->Lock);
+}
+
+/* The function the part maps call to compile a library on a miss */
+/* @param A Pointer to the key of the part */
+/* @param A Pointer to the PipelineLibraryRequest */
+/* @param A Pointer to the VkPipeline to be filled */
+bool CreatePipelineLibrary(const PipelineState* key, void* userData, VkPipeline* pipeline)
+{
+	PipelineLibraryRequest* request = (PipelineLibraryRequest*)userData;
+	static const VkGraphicsPipelineLibraryFlagsEXT partFlags[PIPELINE_LIBRARY_PART_COUNT] =
+	{
+		VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+		VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+		VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+		VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+	};
+
+	/* The state a part does not use is zero in the key and ignored by the driver */
+	GraphicsPipelineBuilder builder;
+	BuildGraphicsPipeline(key, request->Shaders, request->Layout, request->RenderPass, &builder);
+
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT, builder.CreateInfo.pNext, partFlags[request->Part] };
+	builder.CreateInfo.pNext = &libraryCreateInfo;
+	builder.CreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+	char name[PIPELINE_NAME_LENGTH];
+	snprintf(name, PIPELINE_NAME_LENGTH, "library %u %016llx", request->Part, (unsigned long long)HashPipelineState(key));
+
+	double startTime = GetTimeInSeconds();
+	if (!CreateGraphicsPipelineWithCache(request->Libraries->Cache, request->PipelineCache, &builder.CreateInfo, name, pipeline))
+		return false;
+
+	RecordPipelineLibraryTime(request->Libraries, request->Part, false, GetTimeInSeconds() - startTime);
+	return true;
+}
+
+/* A function to link a graphics pipeline from its libraries, compiling the libraries that are not there yet. A fast
+   link takes a fraction of a millisecond and can be done at draw time, an optimized one gives the same code as a
+   whole pipeline and belongs on a background thread */
+/* @param A Pointer to the pipeline library cache */
+/* @param The VkPipelineCache to use */
+/* @param A Pointer to the pipeline state */
+/* @param An array of the shaders of the state, in the order of its ShaderIds */
+/* @param The pipeline layout */
+/* @param The render pass */
+/* @param If the link should be optimized */
+/* @param A Pointer to the VkPipeline to be filled */
+bool LinkPipelineLibraries(PipelineLibraryCache* libraries, VkPipelineCache pipelineCache, const PipelineState* state, const PipelineShader* shaders,
+	VkPipelineLayout layout, VkRenderPass renderPass, bool optimized, VkPipeline* pipeline)
+{
+	VkPipeline parts[PIPELINE_LIBRARY_PART_COUNT];
+	for (u32 i = 0; i < PIPELINE_LIBRARY_PART_COUNT; ++i)
+	{
+		PipelineState key;
+		PipelineShader partShaders[PIPELINE_STATE_MAX_STAGES];
+		GetPipelineLibraryKey(state, shaders, (PipelineLibraryPart)i, &key, partShaders);
+
+		PipelineLibraryRequest request = { libraries, pipelineCache, partShaders, layout, renderPass, (PipelineLibraryPart)i };
+		if (!GetOrCreatePipeline(&libraries->Parts[i], libraries->LogicalDevice, &key, CreatePipelineLibrary, &request, &parts[i]))
+			return false;
+	}
+
+	VkPipelineLibraryCreateInfoKHR linkCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR, nullptr, PIPELINE_LIBRARY_PART_COUNT, parts };
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	pipelineCreateInfo.pNext = &linkCreateInfo;
+	pipelineCreateInfo.flags = optimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+	pipelineCreateInfo.layout = layout;
+	pipelineCreateInfo.basePipelineIndex = -1;
+
+	char name[PIPELINE_NAME_LENGTH];
+	snprintf(name, PIPELINE_NAME_LENGTH, "%s link %016llx", optimized ? "optimized" : "fast", (unsigned long long)HashPipelineState(state));
+
+	double startTime = GetTimeInSeconds();
+	if (!CreateGraphicsPipelineWithCache(libraries->Cache, pipelineCache, &pipelineCreateInfo, name, pipeline))
+		return false;
+
+	RecordPipelineLibraryTime(libraries, PIPELINE_LIBRARY_PART_COUNT, optimized, GetTimeInSeconds() - startTime);
+	return true;
+}
+
+/* A function for getting the counters of the pipeline library cache */
+/* @param A Pointer to the pipeline library cache */
+/* @param A Pointer to the PipelineLibraryStats to be filled */
+void GetPipelineLibraryStats(PipelineLibraryCache* libraries, PipelineLibraryStats* stats)
+{
+	LockMutex(&libraries->Lock);
+	*stats = libraries->Stats;
+	UnlockMutex(&libraries->Lock);
+}
+
+/* A function to print the link times */
+/* @param A Pointer to the pipeline library cache */
+void PrintPipelineLibraryStats(PipelineLibraryCache* libraries)
+{
+	if (!libraries->Supported)
+		return;
+
+	PipelineLibraryStats stats;
+	GetPipelineLibraryStats(libraries, &stats);
+	printf("INFO: %llu pipeline libraries in %.2f ms, %llu fast links averaging %.3f ms (slowest %.3f ms), %llu optimized links averaging %.2f ms\n",
+		(unsigned long long)stats.LibraryCount, stats.LibrarySeconds * 1000.0,
+		(unsigned long long)stats.FastLinkCount, stats.FastLinkCount ? stats.FastLinkSeconds * 1000.0 / stats.FastLinkCount : 0.0, stats.SlowestFastLinkSeconds * 1000.0,
+		(unsigned long long)stats.OptimizedLinkCount, stats.OptimizedLinkCount ? stats.OptimizedLinkSeconds * 1000.0 / stats.OptimizedLinkCount : 0.0);
+}
+
+/* A function to clean up created vulkan resources, the linked pipelines must be destroyed first */
+/* @param A pointer to the resource to cleanup */
+void DestroyPipelineLibraryCache(PipelineLibraryCache* libraries)
+{
+	for (u32 i = 0; i < PIPELINE_LIBRARY_PART_COUNT; ++i)
+		DestroyPipelineMap(&libraries->Parts[i], libraries->LogicalDevice);
+	DestroyMutex(&libraries->Lock);
+	memset(libraries, 0, sizeof(PipelineLibraryCache));
+}
@@ -0,0 +1,516 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <PipelineState/PipelineState.h>
+#include <PipelineMap/PipelineMap.h>
+#include <PipelineCache/PipelineCache.h>
+#include <PipelineBuilder/PipelineBuilder.h>
+#include <PipelineLibrary/PipelineLibrary.h>
+
+#define PIPELINE_MANAGER_MAX_PIPELINES 4096
+#define PIPELINE_NO_FALLBACK ((PipelineHandle)-1)
+
+/* The states of a managed pipeline */
+typedef enum {
+	PIPELINE_STATUS_PENDING,	/* Queued or compiling, the fallback is used */
+	PIPELINE_STATUS_READY,		/* The pipeline can be bound */
+	PIPELINE_STATUS_FAILED		/* The compile failed, the fallback stays in use */
+} PipelineStatus;
+
+/* A handle to a pipeline of the manager */
+typedef u32 PipelineHandle;
+
+/* A structure for a pipeline of the manager */
+typedef struct {
+	PipelineState State;		/* What the pipeline is built from */
+	volatile i32 Status;		/* A PipelineStatus, set after Pipeline so a reader that sees READY also sees the pipeline */
+	VkPipeline Pipeline;		/* The pipeline once it is ready, fast linked when there are pipeline libraries */
+	volatile i32 Optimized;		/* Set after OptimizedPipeline, when the optimized link replaces the fast linked pipeline */
+	VkPipeline OptimizedPipeline;	/* The link time optimized pipeline, the fast linked one is kept until shutdown since frames in flight can still use it */
+	PipelineHandle Fallback;	/* The pipeline to use until this one is ready, PIPELINE_NO_FALLBACK for none */
+} ManagedPipeline;
+
+/* A structure for a handle the pipeline states refer to by id */
+typedef struct {
+	u64 Id;			/* The id the states use */
+	u64 Handle;		/* The VkPipelineLayout or VkRenderPass */
+} PipelineObject;
+
+/* A structure for the pipeline manager */
+typedef struct {
+	VkDevice* LogicalDevice;		/* The logical device */
+	PipelineCache* Cache;			/* The pipeline cache the workers use */
+	ThreadPool Pool;				/* The threads compiling the pipelines */
+	ManagedPipeline** Pipelines;	/* PIPELINE_MANAGER_MAX_PIPELINES slots, filled slots never move so the render thread reads them without locking */
+	volatile i32 PipelineCount;		/* The number of filled slots */
+	PipelineMap Handles;			/* Maps states to their PipelineHandle, so a state requested from many places is compiled once */
+	PipelineLibraryCache Libraries;	/* The pipeline libraries, unused when the device has none */
+	bool DynamicRendering;			/* The device was created with dynamic rendering, so states can leave out the render pass */
+	Mutex Lock;						/* Guards everything below and adding pipelines */
+	Vec Shaders;					/* A Vector of PipelineShader */
+	Vec Layouts;					/* A Vector of PipelineObject with VkPipelineLayouts */
+	Vec RenderPasses;				/* A Vector of PipelineObject with VkRenderPasses */
+	Vec FreeCaches;					/* A Vector of VkPipelineCache a worker can take */
+	Vec Recorded;					/* A Vector of PipelineState requested this run, for prewarming the next one */
+	char RecordingPath[FILE_PATH_LENGTH];	/* Where the requested states are written, empty to not record */
+} PipelineManager;
+
+/* A structure handed to a worker to compile one pipeline */
+typedef struct {
+	PipelineManager* Manager;	/* The manager */
+	PipelineHandle Handle;		/* The pipeline to compile */
+	bool Optimize;				/* Do the optimized link of a pipeline that is already fast linked */
+} PipelineCompileTask;
+
+/* A function to create the pipeline manager */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the pipeline cache */
+/* @param The number of compile threads, 0 uses one per processor */
+/* @param Where the requested pipeline states are recorded for prewarming, can be null */
+/* @param If the device was created with VK_EXT_graphics_pipeline_library, pipelines are then fast linked first */
+/* @param If the device was created with dynamic rendering, states with render pass id 0 are rejected without it */
+/* @param A Pointer to the PipelineManager to be filled */
+bool CreatePipelineManager(VkDevice* logicalDevice, PipelineCache* cache, u32 threadCount, const char* recordingPath, bool pipelineLibraries, bool dynamicRendering,
+	PipelineManager* manager)
+{
+	memset(manager, 0, sizeof(PipelineManager));
+	manager->LogicalDevice = logicalDevice;
+	manager->DynamicRendering = dynamicRendering;
+	manager->Cache = cache;
+	manager->Pipelines = (ManagedPipeline**)calloc(PIPELINE_MANAGER_MAX_PIPELINES, sizeof(ManagedPipeline*));
+	manager->Shaders = vec_create(PipelineShader);
+	manager->Layouts = vec_create(PipelineObject);
+	manager->RenderPasses = vec_create(PipelineObject);
+	manager->FreeCaches = vec_create(VkPipelineCache);
+	manager->Recorded = vec_create(PipelineState);
+	if (recordingPath)
+		snprintf(manager->RecordingPath, FILE_PATH_LENGTH, "%s", recordingPath);
+	InitializeMutex(&manager->Lock);
+	CreatePipelineMap(&manager->Handles);
+	CreatePipelineLibraryCache(logicalDevice, cache, pipelineLibraries, &manager->Libraries);
+
+	if (!CreateThreadPool(threadCount, &manager->Pool))
+	{
+		printf("ERROR: Could not create the pipeline compile threads!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to register a shader module the pipeline states can use by id */
+/* @param A Pointer to the pipeline manager */
+/* @param The id, for example the SPIR-V cache key of the shader */
+/* @param The stage of the shader */
+/* @param The shader module */
+/* @param The entry point */
+void RegisterPipelineShader(PipelineManager* manager, u64 id, VkShaderStageFlagBits stage, VkShaderModule module, const char* entryPoint)
+{
+	PipelineShader shader = { id, stage, module };
+	snprintf(shader.EntryPoint, PIPELINE_SHADER_ENTRY_POINT_LENGTH, "%s", entryPoint ? entryPoint : "main");
+
+	LockMutex(&manager->Lock);
+	for (u64 i = 0; i < vec_length(manager->Shaders); ++i)
+		if (((PipelineShader*)manager->Shaders)[i].Id == id)
+		{
+			((PipelineShader*)manager->Shaders)[i] = shader;
+			UnlockMutex(&manager->Lock);
+			return;
+		}
+	vec_pushback(manager->Shaders, shader, PipelineShader);
+	UnlockMutex(&manager->Lock);
+}
+
+/* A function to register a handle by id, the lock must not be held */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the Vector of PipelineObject */
+/* @param The id */
+/* @param The handle */
+void RegisterPipelineObject(PipelineManager* manager, Vec* objects, u64 id, u64 handle)
+{
+	PipelineObject object = { id, handle };
+
+	LockMutex(&manager->Lock);
+	for (u64 i = 0; i < vec_length(*objects); ++i)
+		if (((PipelineObject*)*objects)[i].Id == id)
+		{
+			((PipelineObject*)*objects)[i] = object;
+			UnlockMutex(&manager->Lock);
+			return;
+		}
+	vec_pushback(*objects, object, PipelineObject);
+	UnlockMutex(&manager->Lock);
+}
+
+/* A function to register a pipeline layout the pipeline states can use by id */
+/* @param A Pointer to the pipeline manager */
+/* @param The id */
+/* @param The pipeline layout */
+void RegisterPipelineLayout(PipelineManager* manager, u64 id, VkPipelineLayout layout)
+{
+	RegisterPipelineObject(manager, &manager->Layouts, id, (u64)layout);
+}
+
+/* A function to register a render pass the pipeline states can use by id */
+/* @param A Pointer to the pipeline manager */
+/* @param The id, states with id 0 render without a render pass if none is registered with it and the device has dynamic rendering */
+/* @param The render pass */
+void RegisterPipelineRenderPass(PipelineManager* manager, u64 id, VkRenderPass renderPass)
+{
+	RegisterPipelineObject(manager, &manager->RenderPasses, id, (u64)renderPass);
+}
+
+/* A function for finding a registered handle, returns false if the id is not registered, the lock must be held */
+/* @param The Vector of PipelineObject */
+/* @param The id */
+/* @param A Pointer to the handle to be filled */
+bool FindPipelineObject(Vec objects, u64 id, u64* handle)
+{
+	for (u64 i = 0; i < vec_length(objects); ++i)
+		if (((PipelineObject*)objects)[i].Id == id)
+		{
+			*handle = ((PipelineObject*)objects)[i].Handle;
+			return true;
+		}
+	return false;
+}
+
+/* A function to check if everything a pipeline state refers to is registered, the lock must be held */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the pipeline state */
+bool IsPipelineStateResolvable(PipelineManager* manager, const PipelineState* state)
+{
+	u64 handle;
+	/* Render pass id 0 is dynamic rendering unless a render pass is registered with it, a device without dynamic
+	   rendering needs one registered */
+	if (!FindPipelineObject(manager->Layouts, state->LayoutId, &handle) ||
+		(!FindPipelineObject(manager->RenderPasses, state->RenderPassId, &handle) && ((state->RenderPassId != 0) || !manager->DynamicRendering)))
+		return false;
+
+	for (u32 i = 0; i < state->ShaderCount; ++i)
+	{
+		bool found = false;
+		for (u64 j = 0; !found && (j < vec_length(manager->Shaders)); ++j)
+			found = ((PipelineShader*)manager->Shaders)[j].Id == state->ShaderIds[i];
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+/* A function to build a graphics pipeline from a state. With pipeline libraries it is linked from them, and the
+   optimized link is only done when asked for */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the pipeline state */
+/* @param The VkPipelineCache to use */
+/* @param If the link should be optimized, ignored without pipeline libraries */
+/* @param A Pointer to a VkPipeline to be filled */
+bool CreateGraphicsPipelineFromState(PipelineManager* manager, const PipelineState* state, VkPipelineCache pipelineCache, bool optimized, VkPipeline* pipeline)
+{
+	PipelineShader shaders[PIPELINE_STATE_MAX_STAGES];
+	u64 layout = 0, renderPass = 0;
+
+	/* The registered handles are copied out, so the lock is not held while the driver compiles */
+	LockMutex(&manager->Lock);
+	bool resolved = IsPipelineStateResolvable(manager, state);
+	if (resolved)
+	{
+		FindPipelineObject(manager->Layouts, state->LayoutId, &layout);
+		FindPipelineObject(manager->RenderPasses, state->RenderPassId, &renderPass);
+		for (u32 i = 0; i < state->ShaderCount; ++i)
+			for (u64 j = 0; j < vec_length(manager->Shaders); ++j)
+				if (((PipelineShader*)manager->Shaders)[j].Id == state->ShaderIds[i])
+					shaders[i] = ((PipelineShader*)manager->Shaders)[j];
+	}
+	UnlockMutex(&manager->Lock);
+
+	if (!resolved)
+	{
+		printf("ERROR: A pipeline state refers to a shader, layout or render pass that is not registered, render pass id 0 needs dynamic rendering!\n");
+		return false;
+	}
+
+	if (manager->Libraries.Supported)
+		return LinkPipelineLibraries(&manager->Libraries, pipelineCache, state, shaders, (VkPipelineLayout)layout, (VkRenderPass)renderPass, optimized, pipeline);
+
+	GraphicsPipelineBuilder builder;
+	BuildGraphicsPipeline(state, shaders, (VkPipelineLayout)layout, (VkRenderPass)renderPass, &builder);
+
+	char name[PIPELINE_NAME_LENGTH];
+	snprintf(name, PIPELINE_NAME_LENGTH, "%016llx", (unsigned long long)HashPipelineState(state));
+	return CreateGraphicsPipelineWithCache(manager->Cache, pipelineCache, &builder.CreateInfo, name, pipeline);
+}
+
+/* A function to take a worker pipeline cache, or create one if none is free */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to a VkPipelineCache to be filled */
+bool AcquireWorkerPipelineCache(PipelineManager* manager, VkPipelineCache* pipelineCache)
+{
+	LockMutex(&manager->Lock);
+	u64 count = vec_length(manager->FreeCaches);
+	if (count > 0)
+	{
+		*pipelineCache = ((VkPipelineCache*)manager->FreeCaches)[count - 1];
+		vec_length_set(manager->FreeCaches, count - 1);
+	}
+	UnlockMutex(&manager->Lock);
+
+	return (count > 0) || CreateWorkerPipelineCache(manager->Cache, pipelineCache);
+}
+
+void PipelineCompileWorker(void* argument);
+
+/* A function to hand a pipeline to the compile threads */
+/* @param A Pointer to the pipeline manager */
+/* @param The handle of the pipeline */
+/* @param If this is the optimized link of a pipeline that is already fast linked */
+void QueuePipelineCompile(PipelineManager* manager, PipelineHandle handle, bool optimize)
+{
+	PipelineCompileTask* task = (PipelineCompileTask*)malloc(sizeof(PipelineCompileTask));
+	task->Manager = manager;
+	task->Handle = handle;
+	task->Optimize = optimize;
+	SubmitThreadPoolTask(&manager->Pool, PipelineCompileWorker, task);
+}
+
+/* The function a worker runs for a compile task */
+/* @param A Pointer to the PipelineCompileTask */
+void PipelineCompileWorker(void* argument)
+{
+	PipelineCompileTask* task = (PipelineCompileTask*)argument;
+	PipelineManager* manager = task->Manager;
+	PipelineHandle handle = task->Handle;
+	bool optimize = task->Optimize;
+	ManagedPipeline* pipeline = manager->Pipelines[handle];
+	free(task);
+
+	/* Each worker compiles into a cache nobody else uses at the same time, they are merged when the cache is saved */
+	VkPipelineCache pipelineCache;
+	if (!AcquireWorkerPipelineCache(manager, &pipelineCache))
+	{
+		if (!optimize)
+			AtomicStore32(&pipeline->Status, PIPELINE_STATUS_FAILED);
+		return;
+	}
+
+	if (optimize)
+	{
+		if (CreateGraphicsPipelineFromState(manager, &pipeline->State, pipelineCache, true, &pipeline->OptimizedPipeline))
+			AtomicStore32(&pipeline->Optimized, 1);
+	}
+	else
+	{
+		bool result = CreateGraphicsPipelineFromState(manager, &pipeline->State, pipelineCache, false, &pipeline->Pipeline);
+		AtomicStore32(&pipeline->Status, result ? PIPELINE_STATUS_READY : PIPELINE_STATUS_FAILED);
+
+		/* The optimized link goes to the back of the queue, so every waiting pipeline gets its fast link first */
+		if (result && manager->Libraries.Supported)
+			QueuePipelineCompile(manager, handle, true);
+	}
+
+	LockMutex(&manager->Lock);
+	vec_pushback(manager->FreeCaches, pipelineCache, VkPipelineCache);
+	UnlockMutex(&manager->Lock);
+}
+
+/* A function to add a pipeline to the manager, the lock must be held. Callers look the state up first, this only
+   finds it again if another thread added it in between */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the pipeline state */
+/* @param The pipeline to use until this one is ready, PIPELINE_NO_FALLBACK for none */
+/* @param A Pointer to the PipelineHandle to be filled */
+/* @param A Pointer to a bool that is set if the pipeline was already there */
+bool AddManagedPipeline(PipelineManager* manager, const PipelineState* state, PipelineHandle fallback, PipelineHandle* handle, bool* existing)
+{
+	i32 count = AtomicLoad32(&manager->PipelineCount);
+	if (count == PIPELINE_MANAGER_MAX_PIPELINES)
+	{
+		printf("ERROR: The pipeline manager can not have more than %d pipelines!\n", PIPELINE_MANAGER_MAX_PIPELINES);
+		return false;
+	}
+
+	/* The slot is filled before the map can hand out its handle to threads that do not take the lock */
+	ManagedPipeline* pipeline = (ManagedPipeline*)calloc(1, sizeof(ManagedPipeline));
+	pipeline->State = *state;
+	pipeline->Status = PIPELINE_STATUS_PENDING;
+	pipeline->Fallback = fallback;
+	manager->Pipelines[count] = pipeline;
+
+	u64 value;
+	if (!InsertIntoPipelineMap(&manager->Handles, state, (u64)count, &value))
+	{
+		manager->Pipelines[count] = nullptr;
+		free(pipeline);
+		*handle = (PipelineHandle)value;
+		*existing = true;
+		return true;
+	}
+	AtomicStore32(&manager->PipelineCount, count + 1);
+
+	if (manager->RecordingPath[0] != '\0')
+		vec_pushback(manager->Recorded, *state, PipelineState);
+
+	*handle = (PipelineHandle)count;
+	*existing = false;
+	return true;
+}
+
+/* A function to request a pipeline, it returns right away and the pipeline is compiled on a worker */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the pipeline state */
+/* @param The pipeline to draw with until this one is ready, PIPELINE_NO_FALLBACK to skip those draws */
+/* @param A Pointer to the PipelineHandle to be filled */
+bool RequestPipeline(PipelineManager* manager, const PipelineState* state, PipelineHandle fallback, PipelineHandle* handle)
+{
+	/* Requests for a known state, the common case every frame, only take a stripe lock of the map */
+	u64 value;
+	if (FindInPipelineMap(&manager->Handles, state, &value))
+	{
+		*handle = (PipelineHandle)value;
+		return true;
+	}
+
+	bool existing = false;
+	LockMutex(&manager->Lock);
+	bool result = AddManagedPipeline(manager, state, fallback, handle, &existing);
+	UnlockMutex(&manager->Lock);
+
+	if (!result || existing)
+		return result;
+
+	QueuePipelineCompile(manager, *handle, false);
+	return true;
+}
+
+/* A function to create a pipeline on the calling thread, for the fallbacks at load time */
+/* @param A Pointer to the pipeline manager */
+/* @param A Pointer to the pipeline state */
+/* @param A Pointer to the PipelineHandle to be filled */
+bool CreatePipelineNow(PipelineManager* manager, const PipelineState* state, PipelineHandle* handle)
+{
+	u64 value;
+	bool existing = FindInPipelineMap(&manager->Handles, state, &value);
+	bool result = true;
+	if (existing)
+		*handle = (PipelineHandle)value;
+	else
+	{
+		LockMutex(&manager->Lock);
+		result = AddManagedPipeline(manager, state, PIPELINE_NO_FALLBACK, handle, &existing);
+		UnlockMutex(&manager->Lock);
+	}
+
+	if (!result)
+		return false;
+
+	ManagedPipeline* pipeline = manager->Pipelines[*handle];
+	if (existing)
+	{
+		/* Someone already queued it, wait for that compile instead of starting another one */
+		while (AtomicLoad32(&pipeline->Status) == PIPELINE_STATUS_PENDING)
+			YieldThread();
+		return AtomicLoad32(&pipeline->Status) == PIPELINE_STATUS_READY;
+	}
+
+	result = CreateGraphicsPipelineFromState(manager, state, manager->Cache->Cache, false, &pipeline->Pipeline);
+	AtomicStore32(&pipeline->Status, result ? PIPELINE_STATUS_READY : PIPELINE_STATUS_FAILED);
+	if (result && manager->Libraries.Supported)
+		QueuePipelineCompile(manager, *handle, true);
+	return result;
+}
+
+/* A function for getting the pipeline to bind for a handle, it never waits. It is the real pipeline once it is ready,
+   the fallback before that, or VK_NULL_HANDLE if neither is ready and the draw should be skipped */
+/* @param A Pointer to the pipeline manager */
+/* @param The handle of the pipeline */
+VkPipeline GetPipeline(PipelineManager* manager, PipelineHandle handle)
+{
+	/* Fallbacks can have fallbacks, the loop stops at a ready one or the end of the chain */
+	for (u32 depth = 0; (handle != PIPELINE_NO_FALLBACK) && (depth < 4); ++depth)
+	{
+		ManagedPipeline* pipeline = manager->Pipelines[handle];
+		if (AtomicLoad32(&pipeline->Status) == PIPELINE_STATUS_READY)
+			return AtomicLoad32(&pipeline->Optimized) ? pipeline->OptimizedPipeline : pipeline->Pipeline;
+		handle = pipeline->Fallback;
+	}
+
+	return VK_NULL_HANDLE;
+}
+
+/* A function for getting the status of a pipeline */
+/* @param A Pointer to the pipeline manager */
+/* @param The handle of the pipeline */
+PipelineStatus GetPipelineStatus(PipelineManager* manager, PipelineHandle handle)
+{
+	return (PipelineStatus)AtomicLoad32(&manager->Pipelines[handle]->Status);
+}
+
+/* A function to queue every pipeline state recorded by an earlier run, states that refer to unregistered shaders,
+   layouts or render passes are skipped. Returns the number of queued pipelines */
+/* @param A Pointer to the pipeline manager */
+/* @param The path of the recording */
+u32 PrewarmPipelines(PipelineManager* manager, const char* path)
+{
+	Vec states = vec_create(PipelineState);
+	LoadPipelineStateRecording(path, &states);
+
+	u32 queued = 0;
+	for (u64 i = 0; i < vec_length(states); ++i)
+	{
+		PipelineState* state = &((PipelineState*)states)[i];
+
+		LockMutex(&manager->Lock);
+		bool resolvable = IsPipelineStateResolvable(manager, state);
+		UnlockMutex(&manager->Lock);
+
+		PipelineHandle handle;
+		if (resolvable && RequestPipeline(manager, state, PIPELINE_NO_FALLBACK, &handle))
+			++queued;
+	}
+
+	printf("INFO: Prewarming %u of %llu recorded pipelines\n", queued, (unsigned long long)vec_length(states));
+	vec_destroy(states);
+	return queued;
+}
+
+/* A function to wait until every queued pipeline is compiled, for loading screens */
+/* @param A Pointer to the pipeline manager */
+void WaitForPipelineManager(PipelineManager* manager)
+{
+	WaitForThreadPool(&manager->Pool);
+}
+
+/* A function to clean up created vulkan resources, the requested states are recorded for the next run */
+/* @param A pointer to the resource to cleanup */
+void DestroyPipelineManager(PipelineManager* manager)
+{
+	DestroyThreadPool(&manager->Pool);
+
+	if (manager->RecordingPath[0] != '\0')
+		SavePipelineStateRecording(manager->RecordingPath, manager->Recorded);
+
+	for (i32 i = 0; i < manager->PipelineCount; ++i)
+	{
+		if (manager->Pipelines[i]->Pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(*manager->LogicalDevice, manager->Pipelines[i]->Pipeline, nullptr);
+		if (manager->Pipelines[i]->OptimizedPipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(*manager->LogicalDevice, manager->Pipelines[i]->OptimizedPipeline, nullptr);
+		free(manager->Pipelines[i]);
+	}
+
+	/* The libraries go after the pipelines linked from them */
+	PrintPipelineLibraryStats(&manager->Libraries);
+	DestroyPipelineLibraryCache(&manager->Libraries);
+
+	/* The worker caches belong to the PipelineCache, it merges and destroys them */
+	free(manager->Pipelines);
+	vec_destroy(manager->Shaders);
+	vec_destroy(manager->Layouts);
+	vec_destroy(manager->RenderPasses);
+	vec_destroy(manager->FreeCaches);
+	vec_destroy(manager->Recorded);
+	DestroyPipelineMap(&manager->Handles, nullptr);
+	DestroyMutex(&manager->Lock);
+	memset(manager, 0, sizeof(PipelineManager));
+}
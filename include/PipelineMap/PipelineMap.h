@@ -0,0 +1,230 @@
+#pragma once
+#include <stdlib.h>
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <PipelineState/PipelineState.h>
+
+#define PIPELINE_MAP_STRIPES 16
+#define PIPELINE_MAP_INITIAL_CAPACITY 64
+
+/* A structure for an entry of the pipeline map */
+typedef struct {
+	u64 Hash;				/* The hash of the state, 0 marks an empty slot */
+	u64 Value;				/* The VkPipeline, or whatever 64 bit value the map is used with */
+	PipelineState* State;	/* A copy of the state, two states with the same hash are told apart with it */
+} PipelineMapEntry;
+
+/* A structure for one stripe of the pipeline map, with its own lock so threads on other stripes never wait */
+typedef struct {
+	Mutex Lock;					/* Guards the entries */
+	PipelineMapEntry* Entries;	/* An open addressed table, the capacity is a power of 2 */
+	u32 Capacity;				/* The number of slots */
+	u32 Count;					/* The number of filled slots */
+} PipelineMapStripe;
+
+/* A structure for a concurrent map from pipeline states to pipelines */
+typedef struct {
+	PipelineMapStripe Stripes[PIPELINE_MAP_STRIPES];	/* The stripes, picked by the low bits of the hash */
+	volatile i64 Hits;		/* Lookups that found a pipeline */
+	volatile i64 Misses;	/* Lookups that did not */
+	volatile i64 Unique;	/* Pipelines added */
+	volatile i64 Races;		/* Pipelines created twice at the same time, where the second one was thrown away */
+} PipelineMap;
+
+/* A structure for the counters of the pipeline map */
+typedef struct {
+	u64 Unique;		/* The number of different pipelines */
+	u64 Hits;		/* Lookups that found a pipeline */
+	u64 Misses;		/* Lookups that did not */
+	u64 Races;		/* Pipelines created twice at the same time */
+	double HitRate;	/* Hits / (Hits + Misses), 0 before the first lookup */
+} PipelineMapStats;
+
+/* A function that creates the pipeline for a state on a miss of GetOrCreatePipeline */
+typedef bool (*CreatePipelineFunction)(const PipelineState* state, void* userData, VkPipeline* pipeline);
+
+/* A function to create the pipeline map */
+/* @param A Pointer to the PipelineMap to be filled */
+void CreatePipelineMap(PipelineMap* map)
+{
+	memset(map, 0, sizeof(PipelineMap));
+	for (u32 i = 0; i < PIPELINE_MAP_STRIPES; ++i)
+	{
+		InitializeMutex(&map->Stripes[i].Lock);
+		map->Stripes[i].Capacity = PIPELINE_MAP_INITIAL_CAPACITY;
+		map->Stripes[i].Entries = (PipelineMapEntry*)calloc(PIPELINE_MAP_INITIAL_CAPACITY, sizeof(PipelineMapEntry));
+	}
+}
+
+/* A function for the hash the map uses for a state, never 0 since that marks empty slots */
+/* @param A Pointer to the pipeline state */
+u64 GetPipelineMapHash(const PipelineState* state)
+{
+	u64 hash = HashPipelineState(state);
+	return hash ? hash : 1;
+}
+
+/* A function for finding the slot of a state in a stripe, or the empty slot it would go in, the lock must be held */
+/* @param A Pointer to the stripe */
+/* @param A Pointer to the pipeline state */
+/* @param The hash of the state */
+PipelineMapEntry* FindPipelineMapSlot(PipelineMapStripe* stripe, const PipelineState* state, u64 hash)
+{
+	/* The low bits picked the stripe, so the slot starts from the high bits */
+	u32 mask = stripe->Capacity - 1;
+	for (u32 slot = (u32)(hash >> 32) & mask;; slot = (slot + 1) & mask)
+	{
+		PipelineMapEntry* entry = &stripe->Entries[slot];
+		if ((entry->Hash == 0) || ((entry->Hash == hash) && IsSamePipelineState(entry->State, state)))
+			return entry;
+	}
+}
+
+/* A function to double the slots of a stripe, the lock must be held */
+/* @param A Pointer to the stripe */
+void GrowPipelineMapStripe(PipelineMapStripe* stripe)
+{
+	PipelineMapEntry* entries = stripe->Entries;
+	u32 capacity = stripe->Capacity;
+
+	stripe->Capacity = capacity * 2;
+	stripe->Entries = (PipelineMapEntry*)calloc(stripe->Capacity, sizeof(PipelineMapEntry));
+	for (u32 i = 0; i < capacity; ++i)
+		if (entries[i].Hash != 0)
+			*FindPipelineMapSlot(stripe, entries[i].State, entries[i].Hash) = entries[i];
+
+	free(entries);
+}
+
+/* A function for finding the value stored for a state */
+/* @param A Pointer to the pipeline map */
+/* @param A Pointer to the pipeline state */
+/* @param A Pointer to the value to be filled */
+bool FindInPipelineMap(PipelineMap* map, const PipelineState* state, u64* value)
+{
+	u64 hash = GetPipelineMapHash(state);
+	PipelineMapStripe* stripe = &map->Stripes[hash % PIPELINE_MAP_STRIPES];
+
+	LockMutex(&stripe->Lock);
+	PipelineMapEntry* entry = FindPipelineMapSlot(stripe, state, hash);
+	bool found = entry->Hash != 0;
+	if (found)
+		*value = entry->Value;
+	UnlockMutex(&stripe->Lock);
+
+	AtomicAdd64(found ? &map->Hits : &map->Misses, 1);
+	return found;
+}
+
+/* A function to store a value for a state if the state has none yet. Returns true if it was stored, if another
+   thread stored one first it returns false and fills in that value */
+/* @param A Pointer to the pipeline map */
+/* @param A Pointer to the pipeline state */
+/* @param The value to store */
+/* @param A Pointer to the value already stored to be filled */
+bool InsertIntoPipelineMap(PipelineMap* map, const PipelineState* state, u64 value, u64* existing)
+{
+	u64 hash = GetPipelineMapHash(state);
+	PipelineMapStripe* stripe = &map->Stripes[hash % PIPELINE_MAP_STRIPES];
+
+	LockMutex(&stripe->Lock);
+	PipelineMapEntry* entry = FindPipelineMapSlot(stripe, state, hash);
+	if (entry->Hash != 0)
+	{
+		*existing = entry->Value;
+		UnlockMutex(&stripe->Lock);
+		return false;
+	}
+
+	entry->Hash = hash;
+	entry->Value = value;
+	entry->State = (PipelineState*)malloc(sizeof(PipelineState));
+	memcpy(entry->State, state, sizeof(PipelineState));
+
+	/* Kept under 3/4 full so probes stay short */
+	if (++stripe->Count * 4 > stripe->Capacity * 3)
+		GrowPipelineMapStripe(stripe);
+	UnlockMutex(&stripe->Lock);
+
+	AtomicAdd64(&map->Unique, 1);
+	return true;
+}
+
+/* A function for getting the pipeline of a state, creating it on a miss. Identical states from any thread get the
+   same VkPipeline, the lock is not held while creating so other lookups never wait on the driver */
+/* @param A Pointer to the pipeline map */
+/* @param A Pointer to a logical device, to destroy the pipeline if another thread created the same one first */
+/* @param A Pointer to the pipeline state */
+/* @param The function that creates the pipeline */
+/* @param A Pointer passed to the function */
+/* @param A Pointer to the VkPipeline to be filled */
+bool GetOrCreatePipeline(PipelineMap* map, VkDevice* logicalDevice, const PipelineState* state, CreatePipelineFunction create, void* userData, VkPipeline* pipeline)
+{
+	u64 value;
+	if (FindInPipelineMap(map, state, &value))
+	{
+		*pipeline = (VkPipeline)value;
+		return true;
+	}
+
+	VkPipeline created = VK_NULL_HANDLE;
+	if (!create(state, userData, &created))
+		return false;
+
+	if (!InsertIntoPipelineMap(map, state, (u64)created, &value))
+	{
+		vkDestroyPipeline(*logicalDevice, created, nullptr);
+		AtomicAdd64(&map->Races, 1);
+		*pipeline = (VkPipeline)value;
+		return true;
+	}
+
+	*pipeline = created;
+	return true;
+}
+
+/* A function for getting the counters of the pipeline map */
+/* @param A Pointer to the pipeline map */
+/* @param A Pointer to the PipelineMapStats to be filled */
+void GetPipelineMapStats(PipelineMap* map, PipelineMapStats* stats)
+{
+	stats->Unique = (u64)AtomicLoad64(&map->Unique);
+	stats->Hits = (u64)AtomicLoad64(&map->Hits);
+	stats->Misses = (u64)AtomicLoad64(&map->Misses);
+	stats->Races = (u64)AtomicLoad64(&map->Races);
+	stats->HitRate = (stats->Hits + stats->Misses) ? (double)stats->Hits / (double)(stats->Hits + stats->Misses) : 0.0;
+}
+
+/* A function to print the counters of the pipeline map */
+/* @param A Pointer to the pipeline map */
+void PrintPipelineMapStats(PipelineMap* map)
+{
+	PipelineMapStats stats;
+	GetPipelineMapStats(map, &stats);
+	printf("INFO: %llu unique pipelines, %llu hits, %llu misses, %.1f%% hit rate, %llu duplicate creations\n",
+		(unsigned long long)stats.Unique, (unsigned long long)stats.Hits, (unsigned long long)stats.Misses,
+		stats.HitRate * 100.0, (unsigned long long)stats.Races);
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A pointer to the resource to cleanup */
+/* @param A Pointer to a logical device to destroy the stored pipelines with, null if the values are not pipelines */
+void DestroyPipelineMap(PipelineMap* map, VkDevice* logicalDevice)
+{
+	for (u32 i = 0; i < PIPELINE_MAP_STRIPES; ++i)
+	{
+		PipelineMapStripe* stripe = &map->Stripes[i];
+		for (u32 j = 0; j < stripe->Capacity; ++j)
+			if (stripe->Entries[j].Hash != 0)
+			{
+				if (logicalDevice && stripe->Entries[j].Value)
+					vkDestroyPipeline(*logicalDevice, (VkPipeline)stripe->Entries[j].Value, nullptr);
+				free(stripe->Entries[j].State);
+			}
+
+		free(stripe->Entries);
+		DestroyMutex(&stripe->Lock);
+	}
+
+	memset(map, 0, sizeof(PipelineMap));
+}
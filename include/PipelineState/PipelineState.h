@@ -0,0 +1,182 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <FileHelper/FileHelper.h>
+#include <Hash/Hash.h>
+
+#define PIPELINE_STATE_MAX_STAGES 5
+#define PIPELINE_STATE_MAX_ATTACHMENTS 8
+#define PIPELINE_STATE_MAX_VERTEX_BINDINGS 4
+#define PIPELINE_STATE_MAX_VERTEX_ATTRIBUTES 16
+#define PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS 16
+#define PIPELINE_STATE_RECORDING_MAGIC 0x5350504E	/* "NPPS" */
+
+/* A structure for everything a graphics pipeline is built from. It has no pointers or handles, shaders, layouts and
+   render passes are ids the application registers, so states can be hashed, compared and written to disk as they are.
+   Always start from InitializePipelineState so the padding is zero */
+typedef struct {
+	u64 ShaderIds[PIPELINE_STATE_MAX_STAGES];	/* The ids of the shaders, one per stage */
+	u64 LayoutId;								/* The id of the pipeline layout */
+	u64 RenderPassId;							/* The id of the render pass */
+	u32 ShaderCount;							/* The number of shaders */
+	u32 Subpass;								/* The subpass of the render pass */
+	VkFormat ColorFormats[PIPELINE_STATE_MAX_ATTACHMENTS];	/* The formats of the color attachments */
+	u32 ColorCount;								/* The number of color attachments */
+	VkFormat DepthFormat;						/* The format of the depth attachment, VK_FORMAT_UNDEFINED if there is none */
+	VkSampleCountFlagBits Samples;				/* The sample count */
+	VkVertexInputBindingDescription VertexBindings[PIPELINE_STATE_MAX_VERTEX_BINDINGS];	/* The vertex buffers */
+	u32 VertexBindingCount;						/* The number of vertex buffers */
+	VkVertexInputAttributeDescription VertexAttributes[PIPELINE_STATE_MAX_VERTEX_ATTRIBUTES];	/* The vertex inputs */
+	u32 VertexAttributeCount;					/* The number of vertex inputs */
+	VkPrimitiveTopology Topology;				/* The primitive topology */
+	VkPolygonMode PolygonMode;					/* Fill, line or point */
+	VkCullModeFlags CullMode;					/* The faces to cull */
+	VkFrontFace FrontFace;						/* The winding of front faces */
+	VkBool32 DepthTest;							/* Test against the depth buffer */
+	VkBool32 DepthWrite;						/* Write to the depth buffer */
+	VkCompareOp DepthCompare;					/* The depth test */
+	VkPipelineColorBlendAttachmentState Blend[PIPELINE_STATE_MAX_ATTACHMENTS];	/* The blending of each color attachment */
+	u32 SpecializationIds[PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS];		/* The constant_id of each specialization constant */
+	u32 SpecializationValues[PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS];	/* The 32 bit value of each specialization constant */
+	u32 SpecializationCount;					/* The number of specialization constants, they apply to every stage that declares them */
+	u32 Reserved;								/* Zero, keeps the size a multiple of 8 without hidden padding */
+} PipelineState;
+
+/* A structure for the header of a file with recorded pipeline states */
+typedef struct {
+	u32 Magic;		/* PIPELINE_STATE_RECORDING_MAGIC */
+	u32 StateSize;	/* sizeof(PipelineState), a changed layout makes old files invalid */
+	u64 Count;		/* The number of states after the header */
+} PipelineStateRecordingHeader;
+
+/* A function to fill a pipeline state with opaque triangles, back face culling and a less-or-equal depth test */
+/* @param A Pointer to the PipelineState to be filled */
+void InitializePipelineState(PipelineState* state)
+{
+	memset(state, 0, sizeof(PipelineState));
+	state->Samples = VK_SAMPLE_COUNT_1_BIT;
+	state->Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	state->PolygonMode = VK_POLYGON_MODE_FILL;
+	state->CullMode = VK_CULL_MODE_BACK_BIT;
+	state->FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	state->DepthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	for (u32 i = 0; i < PIPELINE_STATE_MAX_ATTACHMENTS; ++i)
+	{
+		state->Blend[i].srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		state->Blend[i].dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+		state->Blend[i].colorBlendOp = VK_BLEND_OP_ADD;
+		state->Blend[i].srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		state->Blend[i].dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		state->Blend[i].alphaBlendOp = VK_BLEND_OP_ADD;
+		state->Blend[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	}
+}
+
+/* A function to add a shader to a pipeline state */
+/* @param A Pointer to the pipeline state */
+/* @param The id the shader was registered with */
+bool AddPipelineStateShader(PipelineState* state, u64 shaderId)
+{
+	if (state->ShaderCount == PIPELINE_STATE_MAX_STAGES)
+	{
+		printf("ERROR: A pipeline can not have more than %d shaders!\n", PIPELINE_STATE_MAX_STAGES);
+		return false;
+	}
+
+	state->ShaderIds[state->ShaderCount++] = shaderId;
+	return true;
+}
+
+/* A function to set a specialization constant of a pipeline state, it replaces the value if the id is already set */
+/* @param A Pointer to the pipeline state */
+/* @param The constant_id in the shaders */
+/* @param The value, floats and bools are passed as their 32 bit pattern */
+bool SetPipelineStateSpecialization(PipelineState* state, u32 constantId, u32 value)
+{
+	for (u32 i = 0; i < state->SpecializationCount; ++i)
+		if (state->SpecializationIds[i] == constantId)
+		{
+			state->SpecializationValues[i] = value;
+			return true;
+		}
+
+	if (state->SpecializationCount == PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS)
+	{
+		printf("ERROR: A pipeline can not have more than %d specialization constants!\n", PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS);
+		return false;
+	}
+
+	/* Kept sorted by id, so setting the same constants in another order gives the same state */
+	u32 index = state->SpecializationCount++;
+	for (; (index > 0) && (state->SpecializationIds[index - 1] > constantId); --index)
+	{
+		state->SpecializationIds[index] = state->SpecializationIds[index - 1];
+		state->SpecializationValues[index] = state->SpecializationValues[index - 1];
+	}
+	state->SpecializationIds[index] = constantId;
+	state->SpecializationValues[index] = value;
+	return true;
+}
+
+/* A function to hash a pipeline state, everything in it is part of the hash */
+/* @param A Pointer to the pipeline state */
+u64 HashPipelineState(const PipelineState* state)
+{
+	return HashWords(state, sizeof(PipelineState), HASH_SEED);
+}
+
+/* A function to check if two pipeline states are the same */
+/* @param A Pointer to the first pipeline state */
+/* @param A Pointer to the second pipeline state */
+bool IsSamePipelineState(const PipelineState* a, const PipelineState* b)
+{
+	return memcmp(a, b, sizeof(PipelineState)) == 0;
+}
+
+/* A function to write pipeline states to disk, so the next run can compile them before they are needed */
+/* @param The path of the file */
+/* @param A Vector of PipelineState */
+bool SavePipelineStateRecording(const char* path, Vec states)
+{
+	u64 count = vec_length(states);
+	u64 size = sizeof(PipelineStateRecordingHeader) + count * sizeof(PipelineState);
+	PipelineStateRecordingHeader* header = (PipelineStateRecordingHeader*)malloc(size);
+	header->Magic = PIPELINE_STATE_RECORDING_MAGIC;
+	header->StateSize = sizeof(PipelineState);
+	header->Count = count;
+	memcpy(header + 1, states, count * sizeof(PipelineState));
+
+	bool result = WriteWholeFileAtomic(path, header, size);
+	free(header);
+	return result;
+}
+
+/* A function to read pipeline states written by an earlier run */
+/* @param The path of the file */
+/* @param A Pointer to a Vector of PipelineState the states are added to */
+bool LoadPipelineStateRecording(const char* path, Vec* states)
+{
+	if (GetFileModificationTime(path) == 0)
+		return false;
+
+	char* data = nullptr;
+	u64 size = 0;
+	if (!ReadWholeFile(path, &size, &data))
+		return false;
+
+	PipelineStateRecordingHeader* header = (PipelineStateRecordingHeader*)data;
+	if ((size < sizeof(PipelineStateRecordingHeader)) || (header->Magic != PIPELINE_STATE_RECORDING_MAGIC) ||
+		(header->StateSize != sizeof(PipelineState)) || (size != sizeof(PipelineStateRecordingHeader) + header->Count * sizeof(PipelineState)))
+	{
+		printf("WARNING: The pipeline state recording %s is not valid\n", path);
+		free(data);
+		return false;
+	}
+
+	PipelineState* recorded = (PipelineState*)(header + 1);
+	for (u64 i = 0; i < header->Count; ++i)
+		vec_pushback(*states, recorded[i], PipelineState);
+
+	free(data);
+	return true;
+}
@@ -0,0 +1,1971 @@
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <VkHelper/VkHelper.h>
+#include <Timer/Timer.h>
+#include <CommandRecycler/CommandRecycler.h>
+#include <BarrierBatcher/BarrierBatcher.h>
+
+#define RENDER_GRAPH_NAME_LENGTH 32
+#define RENDER_GRAPH_NONE 0xFFFFFFFFu
+#define RENDER_GRAPH_ASYNC_COMPUTE_STAGES (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | \
+	VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT)
+#define RENDER_GRAPH_ATTACHMENT_USAGE (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)
+
+/* The queues a pass can run on */
+typedef enum {
+	RENDER_GRAPH_QUEUE_GRAPHICS,
+	RENDER_GRAPH_QUEUE_COMPUTE,
+	RENDER_GRAPH_QUEUE_TRANSFER,
+	RENDER_GRAPH_QUEUE_COUNT
+} RenderGraphQueue;
+
+/* The kinds of resources a graph tracks */
+typedef enum {
+	RENDER_GRAPH_IMAGE,
+	RENDER_GRAPH_BUFFER
+} RenderGraphResourceType;
+
+struct RenderGraph;
+
+/* A function that records a pass */
+typedef void (*RenderGraphPassFunction)(VkCommandBuffer commandBuffer, struct RenderGraph* graph, void* userData);
+
+/* A structure for a resource as the passes of one frame see it */
+typedef struct {
+	RenderGraphResourceType Type;	/* An image or a buffer */
+	bool Imported;					/* Owned outside the graph, like a swapchain image, it is never aliased */
+	bool Concurrent;				/* An imported resource created VK_SHARING_MODE_CONCURRENT over the queue families of the graph */
+	bool Output;					/* Read after the graph, passes writing it are never culled */
+	VkFormat Format;				/* The format of an image */
+	VkExtent3D Extent;				/* The size of an image */
+	VkImageAspectFlags Aspect;		/* The aspect of an image */
+	VkDeviceSize Size;				/* The size of a buffer */
+	VkImageUsageFlags ImageUsage;	/* Gathered from the uses */
+	VkBufferUsageFlags BufferUsage;	/* Gathered from the uses */
+	VkImage Image;					/* The handle of an imported image */
+	VkBuffer Buffer;				/* The handle of an imported buffer */
+	VkImageLayout InitialLayout;	/* The layout an imported image is in before the graph */
+	VkPipelineStageFlags WaitStages;	/* The stages of its first use that wait on the semaphore given to ExecuteRenderGraph, 0 if it is ready */
+	VkImageLayout FinalLayout;		/* The layout an imported image is left in, VK_IMAGE_LAYOUT_UNDEFINED to leave it as the last pass did */
+	u32 FirstPass;					/* The first position in the pass order using it */
+	u32 LastPass;					/* The last position in the pass order using it */
+	u32 QueueMask;					/* The queues using it */
+	u32 Slot;						/* The physical resource behind it */
+} RenderGraphResource;
+
+/* A structure for a pass reading or writing a resource */
+typedef struct {
+	u32 Pass;						/* The pass */
+	u32 Resource;					/* The resource */
+	VkPipelineStageFlags Stages;	/* The stages touching the resource */
+	VkAccessFlags Access;			/* How they touch it */
+	VkImageLayout Layout;			/* The layout an image has to be in */
+	bool Write;						/* If the pass writes it */
+} RenderGraphUse;
+
+/* A structure for a pass */
+typedef struct {
+	char Name[RENDER_GRAPH_NAME_LENGTH];	/* For debugging */
+	RenderGraphQueue Queue;					/* The queue it runs on */
+	RenderGraphQueue DeclaredQueue;			/* The queue it was declared on, the compile may move it */
+	bool AsyncCompute;						/* It may run on the compute queue when that is a family of its own */
+	RenderGraphPassFunction Execute;		/* Records the pass */
+	void* UserData;							/* Passed to Execute */
+	u32 FirstUse;							/* The first of its uses once compiled */
+	u32 UseCount;							/* The number of its uses */
+	bool Culled;							/* Nothing it writes is ever read */
+	u32 FirstBarrier;						/* The first barrier recorded before it */
+	u32 BarrierCount;						/* The number of barriers recorded before it */
+	u32 Batch;								/* The submit it is in */
+} RenderGraphPass;
+
+/* A structure for a physical resource, transient resources whose lifetimes do not overlap share one */
+typedef struct {
+	RenderGraphResourceType Type;	/* An image or a buffer */
+	bool Imported;					/* Stands for an imported resource this frame */
+	VkFormat Format;				/* The format of an image */
+	VkExtent3D Extent;				/* The size of an image */
+	VkImageAspectFlags Aspect;		/* The aspect of an image */
+	VkDeviceSize Size;				/* The size of a buffer */
+	VkImageUsageFlags ImageUsage;	/* The usage of every resource placed in it */
+	VkBufferUsageFlags BufferUsage;	/* The usage of every resource placed in it */
+	u32 QueueMask;					/* The queues of every resource placed in it */
+	bool Output;					/* A resource placed in it is read after the graph, so its contents are kept */
+	VkImage Image;					/* The image */
+	VkBuffer Buffer;				/* The buffer */
+	VkDeviceMemory Memory;			/* The memory of a buffer or lazily allocated image, images in a heap have none of their own */
+	VkMemoryRequirements Requirements;	/* What the image or buffer needs */
+	bool Lazy;						/* The image lives in lazily allocated memory */
+	bool Bound;						/* The image or buffer has memory */
+	u32 Heap;						/* The heap an image is placed in, RENDER_GRAPH_NONE if it has its own memory */
+	VkDeviceSize Offset;			/* Where in the heap */
+	VkImageUsageFlags CreatedImageUsage;	/* The usage the image was created with */
+	VkBufferUsageFlags CreatedBufferUsage;	/* The usage the buffer was created with */
+	u32 CreatedQueueMask;			/* The queues the resource was created for */
+	u32 FirstPass;					/* The first position in the pass order using it this frame */
+	RenderGraphQueue FirstQueue;	/* The queue of that pass */
+	u32 FirstBarrier;				/* The barrier before its first use this frame, RENDER_GRAPH_NONE if there is none */
+	u32 LastPass;					/* The last position in the pass order using it this frame, RENDER_GRAPH_NONE if unused */
+	RenderGraphQueue LastQueue;		/* The queue of that pass */
+	VkImageLayout Layout;			/* The layout while compiling */
+	VkPipelineStageFlags WriteStages;	/* The stages of the last write, or of the semaphore wait that replaced it */
+	VkAccessFlags WriteAccess;		/* The access of the last write, 0 once it was made visible by a semaphore */
+	VkPipelineStageFlags ReadStages;	/* The stages that read since the last write */
+	VkPipelineStageFlags VisibleStages;	/* The stages the last write was made visible to */
+	VkAccessFlags VisibleAccess;	/* The access the last write was made visible to */
+	u32 WriteBatch;					/* The submit of the last write */
+	u32 ReadBatch[RENDER_GRAPH_QUEUE_COUNT];	/* The last submit on each queue that read since the last write */
+	u32 LastBatch;					/* The last submit using it */
+} RenderGraphSlot;
+
+/* A structure for a barrier the compiler placed */
+typedef struct {
+	u32 Slot;							/* The physical resource */
+	u32 Batch;							/* The submit it is recorded in, for barriers after the last pass */
+	VkPipelineStageFlags SrcStages;		/* The stages to wait for */
+	VkPipelineStageFlags DstStages;		/* The stages that wait */
+	VkAccessFlags SrcAccess;			/* The writes to make available */
+	VkAccessFlags DstAccess;			/* The access they are made visible to */
+	VkImageLayout OldLayout;			/* The layout of an image before */
+	VkImageLayout NewLayout;			/* The layout of an image after */
+} RenderGraphBarrier;
+
+/* A structure for a submit waiting on a semaphore another submit signals */
+typedef struct {
+	u32 Semaphore;					/* The semaphore */
+	u32 Producer;					/* The submit signaling it */
+	u32 Consumer;					/* The submit waiting on it */
+	VkPipelineStageFlags Stages;	/* The stages that wait */
+} RenderGraphWait;
+
+/* A structure for a run of passes on one queue, submitted together */
+typedef struct {
+	RenderGraphQueue Queue;	/* The queue */
+	u32 FirstPass;			/* The first position in the pass order */
+	u32 PassCount;			/* The number of passes */
+	u32 FirstWait;			/* The first of its waits */
+	u32 WaitCount;			/* The number of its waits */
+	u32 WaitIndex[RENDER_GRAPH_QUEUE_COUNT];	/* The wait on the latest submit of each queue, RENDER_GRAPH_NONE if none */
+} RenderGraphBatch;
+
+/* A structure for a block of memory transient images are placed in, images whose lifetimes do not overlap share
+   the same bytes */
+typedef struct {
+	VkDeviceMemory Memory;	/* The memory */
+	VkDeviceSize Size;		/* The size of the memory */
+	VkDeviceSize Needed;	/* The size the last placement needed */
+	u32 MemoryTypeBits;		/* The memory types of the images placed in it */
+} RenderGraphHeap;
+
+/* A structure for the memory of the transient images in the last frame */
+typedef struct {
+	VkDeviceSize UnaliasedBytes;	/* The memory the transient images would need if each had its own */
+	VkDeviceSize HeapBytes;			/* The memory their heaps need */
+	VkDeviceSize LazyBytes;			/* The memory of images in lazily allocated memory, tile based GPUs never commit it */
+	VkDeviceSize SavedBytes;		/* The peak memory saved in a frame */
+	u32 AliasedImages;				/* Images sharing bytes with an image used earlier in the frame */
+	u32 LazyImages;					/* Images in lazily allocated memory */
+} RenderGraphMemoryStats;
+
+/* A structure for what the last compile produced */
+typedef struct {
+	u32 Passes;			/* Passes declared */
+	u32 CulledPasses;	/* Passes dropped because nothing reads what they write */
+	u32 Resources;		/* Resources declared */
+	u32 Slots;			/* Physical resources used, fewer than resources when transient ones are aliased */
+	u32 Barriers;		/* Barriers placed, final layout transitions included */
+	u32 BarrierBatches;	/* Pipeline barriers needed, at most one before each pass and one at the end of each submit */
+	u32 Batches;		/* Submits */
+	u32 Semaphores;		/* Semaphores between submits */
+	u32 AsyncPasses;	/* Passes moved to the compute queue */
+} RenderGraphStats;
+
+/* A structure for how long a pass took on the GPU the last time its timestamps were read */
+typedef struct {
+	char Name[RENDER_GRAPH_NAME_LENGTH];	/* The name of the pass */
+	RenderGraphQueue Queue;		/* The queue it ran on */
+	bool Async;					/* It was moved to the compute queue */
+	double Start;				/* When it started in milliseconds, from the start of the first pass */
+	double End;					/* When it ended in milliseconds */
+	double Overlap;				/* The milliseconds it ran while a pass on another queue ran */
+} RenderGraphPassTiming;
+
+/* A structure for the GPU time of a frame */
+typedef struct {
+	double FrameMilliseconds;	/* From the start of the first pass to the end of the last */
+	double GraphicsMilliseconds;	/* The time of the passes on the graphics queue */
+	double ComputeMilliseconds;	/* The time of the passes on the compute queue */
+	double OverlapMilliseconds;	/* The time compute passes ran at the same time as graphics passes */
+} RenderGraphTimingStats;
+
+/* A structure for the render graph of a frame. Transient resources, semaphores and timestamps are reused every time
+   the graph runs, so a run waits for the one before it. Frames that should overlap on the GPU need a graph each */
+typedef struct RenderGraph {
+	VkPhysicalDevice* PhysicalDevice;	/* The physical device, null for a graph that is only compiled */
+	VkDevice* LogicalDevice;			/* The logical device, null for a graph that is only compiled */
+	u32 QueueFamilies[RENDER_GRAPH_QUEUE_COUNT];	/* The family of each queue, resources used on more than one are shared */
+	Vec Passes;			/* A Vector of RenderGraphPass */
+	Vec Resources;		/* A Vector of RenderGraphResource */
+	Vec Uses;			/* A Vector of RenderGraphUse in the order they were declared */
+	Vec SortedUses;		/* A Vector of RenderGraphUse grouped by pass */
+	Vec Order;			/* A Vector of u32, the passes that run in the order they run */
+	Vec Barriers;		/* A Vector of RenderGraphBarrier recorded before passes */
+	Vec FinalBarriers;	/* A Vector of RenderGraphBarrier recorded at the end of a submit */
+	Vec Batches;		/* A Vector of RenderGraphBatch */
+	Vec Waits;			/* A Vector of RenderGraphWait */
+	Vec Slots;			/* A Vector of RenderGraphSlot, the transient ones are kept from frame to frame */
+	u32 TransientSlotCount;	/* The slots before the imported ones */
+	Vec Heaps;			/* A Vector of RenderGraphHeap, kept from frame to frame */
+	bool LazyMemory;	/* The device has lazily allocated memory */
+	RenderGraphMemoryStats Memory;	/* The memory of the last frame */
+	Vec Semaphores;		/* A Vector of VkSemaphore, kept from frame to frame */
+	VkFence RunFence;	/* Signaled when the last run is done with the resources of the graph */
+	u32 SemaphoreCount;	/* The semaphores the last compile used */
+	bool Compiled;		/* Set by CompileRenderGraph, cleared by ResetRenderGraph */
+	BarrierBatcher* Batcher;	/* The batcher of the running ExecuteRenderGraph, passes can add their own barriers to it */
+	bool DedicatedCompute;		/* The compute queue is of another family than the graphics queue, async passes go on it */
+	VkQueryPool Timestamps;		/* Two timestamps per pass, VK_NULL_HANDLE if they are not measured */
+	u32 TimestampCapacity;		/* The passes the pool has room for */
+	double TimestampPeriod;		/* Nanoseconds per timestamp tick */
+	bool TimestampsWritten;		/* The last run wrote timestamps that were not read yet */
+	Vec Timings;				/* A Vector of RenderGraphPassTiming, one for each pass of the last run that was read */
+	RenderGraphTimingStats Timing;	/* The GPU time of the last run that was read */
+	u32 ExternalWaitBatch;	/* The submit that waits on the semaphore given to ExecuteRenderGraph, RENDER_GRAPH_NONE if there is none */
+	VkPipelineStageFlags ExternalWaitStages;	/* The stages of that submit that wait on it */
+	RenderGraphStats Stats;	/* What the last compile produced */
+} RenderGraph;
+
+/* A function to create a render graph */
+/* @param A Pointer to a physical device, null for a graph that is only compiled */
+/* @param A Pointer to a logical device, null for a graph that is only compiled */
+/* @param The queue family of the graphics, compute and transfer queues */
+/* @param A Pointer to the RenderGraph to be filled */
+bool CreateRenderGraph(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, const u32 queueFamilies[RENDER_GRAPH_QUEUE_COUNT], RenderGraph* graph)
+{
+	memset(graph, 0, sizeof(RenderGraph));
+	graph->PhysicalDevice = physicalDevice;
+	graph->LogicalDevice = logicalDevice;
+	for (u32 i = 0; i < RENDER_GRAPH_QUEUE_COUNT; ++i)
+		graph->QueueFamilies[i] = queueFamilies ? queueFamilies[i] : 0;
+	graph->DedicatedCompute = graph->QueueFamilies[RENDER_GRAPH_QUEUE_COMPUTE] != graph->QueueFamilies[RENDER_GRAPH_QUEUE_GRAPHICS];
+
+	graph->Passes = vec_create(RenderGraphPass);
+	graph->Resources = vec_create(RenderGraphResource);
+	graph->Uses = vec_create(RenderGraphUse);
+	graph->SortedUses = vec_create(RenderGraphUse);
+	graph->Order = vec_create(u32);
+	graph->Barriers = vec_create(RenderGraphBarrier);
+	graph->FinalBarriers = vec_create(RenderGraphBarrier);
+	graph->Batches = vec_create(RenderGraphBatch);
+	graph->Waits = vec_create(RenderGraphWait);
+	graph->Slots = vec_create(RenderGraphSlot);
+	graph->Heaps = vec_create(RenderGraphHeap);
+	graph->Semaphores = vec_create(VkSemaphore);
+	graph->Timings = vec_create(RenderGraphPassTiming);
+
+	if (logicalDevice && !CreateFence(logicalDevice, true, &graph->RunFence))
+		return false;
+
+	/* Tile based GPUs can keep attachments that never leave a render pass in tile memory, with nothing behind them */
+	if (physicalDevice)
+	{
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(*physicalDevice, &memoryProperties);
+		for (u32 i = 0; i < memoryProperties.memoryTypeCount; ++i)
+			graph->LazyMemory |= (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+	}
+	return true;
+}
+
+/* A function to clear the passes and resources of a graph so the next frame can declare its own, the physical
+   resources and semaphores stay */
+/* @param A Pointer to the graph */
+void ResetRenderGraph(RenderGraph* graph)
+{
+	vec_clear(graph->Passes);
+	vec_clear(graph->Resources);
+	vec_clear(graph->Uses);
+	vec_length_set(graph->Slots, graph->TransientSlotCount);
+	graph->Compiled = false;
+}
+
+/* A function to declare a pass */
+/* @param A Pointer to the graph */
+/* @param The name of the pass */
+/* @param The queue it runs on */
+/* @param The function recording it */
+/* @param A Pointer passed to the function */
+u32 AddRenderGraphPass(RenderGraph* graph, const char* name, RenderGraphQueue queue, RenderGraphPassFunction execute, void* userData)
+{
+	RenderGraphPass pass = { 0 };
+	strncpy(pass.Name, name, RENDER_GRAPH_NAME_LENGTH - 1);
+	pass.Queue = queue;
+	pass.DeclaredQueue = queue;
+	pass.Execute = execute;
+	pass.UserData = userData;
+	vec_pushback(graph->Passes, pass, RenderGraphPass);
+	return (u32)vec_length(graph->Passes) - 1;
+}
+
+/* A function to let a pass run on the compute queue, for passes like particles, culling, post processing or light
+   binning that only dispatch and copy. When the compute queue has a family of its own the compile moves the pass
+   there and as early as its inputs allow, so it overlaps the graphics work around it */
+/* @param A Pointer to the graph */
+/* @param The pass, declared on the graphics queue */
+void MarkRenderGraphAsyncCompute(RenderGraph* graph, u32 pass)
+{
+	((RenderGraphPass*)graph->Passes)[pass].AsyncCompute = true;
+}
+
+/* A function to declare an image the graph creates and may alias with others */
+/* @param A Pointer to the graph */
+/* @param The format */
+/* @param The size */
+/* @param The aspect */
+u32 CreateRenderGraphImage(RenderGraph* graph, VkFormat format, VkExtent3D extent, VkImageAspectFlags aspect)
+{
+	RenderGraphResource resource = { 0 };
+	resource.Type = RENDER_GRAPH_IMAGE;
+	resource.Format = format;
+	resource.Extent = extent;
+	resource.Aspect = aspect;
+	vec_pushback(graph->Resources, resource, RenderGraphResource);
+	return (u32)vec_length(graph->Resources) - 1;
+}
+
+/* A function to declare a buffer the graph creates and may alias with others */
+/* @param A Pointer to the graph */
+/* @param The size in bytes */
+u32 CreateRenderGraphBuffer(RenderGraph* graph, VkDeviceSize size)
+{
+	RenderGraphResource resource = { 0 };
+	resource.Type = RENDER_GRAPH_BUFFER;
+	resource.Size = size;
+	vec_pushback(graph->Resources, resource, RenderGraphResource);
+	return (u32)vec_length(graph->Resources) - 1;
+}
+
+/* A function to declare an image owned outside the graph */
+/* @param A Pointer to the graph */
+/* @param The image */
+/* @param The format */
+/* @param The size */
+/* @param The aspect */
+/* @param The layout it is in before the graph */
+/* @param The layout to leave it in, VK_IMAGE_LAYOUT_UNDEFINED to leave it as the last pass did */
+/* @param The sharing mode it was created with, an exclusive one is only used on the family of the graphics queue */
+/* @param The stages of its first use, when it has to wait on the semaphore given to ExecuteRenderGraph like a swapchain
+   image being acquired, 0 if it is ready */
+u32 ImportRenderGraphImage(RenderGraph* graph, VkImage image, VkFormat format, VkExtent3D extent, VkImageAspectFlags aspect,
+	VkImageLayout initialLayout, VkImageLayout finalLayout, VkSharingMode sharingMode, VkPipelineStageFlags waitStages)
+{
+	u32 index = CreateRenderGraphImage(graph, format, extent, aspect);
+	RenderGraphResource* resource = &((RenderGraphResource*)graph->Resources)[index];
+	resource->Imported = true;
+	resource->Output = true;
+	resource->Image = image;
+	resource->InitialLayout = initialLayout;
+	resource->FinalLayout = finalLayout;
+	resource->Concurrent = sharingMode == VK_SHARING_MODE_CONCURRENT;
+	resource->WaitStages = waitStages;
+	return index;
+}
+
+/* A function to declare a buffer owned outside the graph */
+/* @param A Pointer to the graph */
+/* @param The buffer */
+/* @param The size in bytes */
+/* @param The sharing mode it was created with, an exclusive one is only used on the family of the graphics queue */
+/* @param The stages of its first use, when it has to wait on the semaphore given to ExecuteRenderGraph, 0 if it is ready */
+u32 ImportRenderGraphBuffer(RenderGraph* graph, VkBuffer buffer, VkDeviceSize size, VkSharingMode sharingMode, VkPipelineStageFlags waitStages)
+{
+	u32 index = CreateRenderGraphBuffer(graph, size);
+	RenderGraphResource* resource = &((RenderGraphResource*)graph->Resources)[index];
+	resource->Imported = true;
+	resource->Output = true;
+	resource->Buffer = buffer;
+	resource->Concurrent = sharingMode == VK_SHARING_MODE_CONCURRENT;
+	resource->WaitStages = waitStages;
+	return index;
+}
+
+/* A function to declare that a pass reads or writes a resource */
+/* @param A Pointer to the graph */
+/* @param The pass */
+/* @param The resource */
+/* @param The stages touching it */
+/* @param How they touch it */
+/* @param The layout an image has to be in, ignored for buffers */
+/* @param If the pass writes it */
+void UseRenderGraphResource(RenderGraph* graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout, bool write)
+{
+	RenderGraphUse use = { pass, resource, stages, access, layout, write };
+	vec_pushback(graph->Uses, use, RenderGraphUse);
+}
+
+/* A function to declare that a pass writes an image as a color attachment */
+/* @param A Pointer to the graph */
+/* @param The pass */
+/* @param The image */
+void WriteRenderGraphColorAttachment(RenderGraph* graph, u32 pass, u32 resource)
+{
+	UseRenderGraphResource(graph, pass, resource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true);
+}
+
+/* A function to declare that a pass writes an image as a depth attachment */
+/* @param A Pointer to the graph */
+/* @param The pass */
+/* @param The image */
+void WriteRenderGraphDepthAttachment(RenderGraph* graph, u32 pass, u32 resource)
+{
+	UseRenderGraphResource(graph, pass, resource, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true);
+}
+
+/* A function to declare that a pass samples an image */
+/* @param A Pointer to the graph */
+/* @param The pass */
+/* @param The image */
+/* @param The shader stages sampling it */
+void ReadRenderGraphTexture(RenderGraph* graph, u32 pass, u32 resource, VkPipelineStageFlags stages)
+{
+	UseRenderGraphResource(graph, pass, resource, stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false);
+}
+
+/* A function to declare that a pass writes a storage image or buffer from compute */
+/* @param A Pointer to the graph */
+/* @param The pass */
+/* @param The resource */
+void WriteRenderGraphStorage(RenderGraph* graph, u32 pass, u32 resource)
+{
+	UseRenderGraphResource(graph, pass, resource, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true);
+}
+
+/* A function to mark a resource as read after the graph, so passes writing it are kept */
+/* @param A Pointer to the graph */
+/* @param The resource */
+void MarkRenderGraphOutput(RenderGraph* graph, u32 resource)
+{
+	((RenderGraphResource*)graph->Resources)[resource].Output = true;
+}
+
+/* A function to get the usage an image needs for a layout */
+/* @param The layout */
+VkImageUsageFlags GetRenderGraphImageUsage(VkImageLayout layout)
+{
+	switch (layout)
+	{
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+		return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+		return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		return VK_IMAGE_USAGE_SAMPLED_BIT;
+	case VK_IMAGE_LAYOUT_GENERAL:
+		return VK_IMAGE_USAGE_STORAGE_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	default:
+		return 0;
+	}
+}
+
+/* A function to get the usage a buffer needs for an access */
+/* @param The access */
+VkBufferUsageFlags GetRenderGraphBufferUsage(VkAccessFlags access)
+{
+	VkBufferUsageFlags usage = 0;
+	if (access & (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT))
+		usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	if (access & VK_ACCESS_UNIFORM_READ_BIT)
+		usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	if (access & VK_ACCESS_INDIRECT_COMMAND_READ_BIT)
+		usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+	if (access & VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT)
+		usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	if (access & VK_ACCESS_INDEX_READ_BIT)
+		usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	if (access & VK_ACCESS_TRANSFER_READ_BIT)
+		usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	if (access & VK_ACCESS_TRANSFER_WRITE_BIT)
+		usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	return usage;
+}
+
+/* A function to make a submit wait for another one on a different queue, reusing a wait it already has when that
+   covers it */
+/* @param A Pointer to the graph */
+/* @param The waiting submit */
+/* @param The submit to wait for */
+/* @param The stages that wait */
+void AddRenderGraphWait(RenderGraph* graph, u32 consumer, u32 producer, VkPipelineStageFlags stages)
+{
+	RenderGraphBatch* batches = (RenderGraphBatch*)graph->Batches;
+	RenderGraphQueue queue = batches[producer].Queue;
+	u32 index = batches[consumer].WaitIndex[queue];
+
+	/* Waiting for a later submit on the same queue covers every submit before it */
+	if (index != RENDER_GRAPH_NONE)
+	{
+		RenderGraphWait* wait = &((RenderGraphWait*)graph->Waits)[index];
+		if (wait->Producer >= producer)
+		{
+			wait->Stages |= stages;
+			return;
+		}
+	}
+
+	RenderGraphWait wait = { graph->SemaphoreCount++, producer, consumer, stages };
+	vec_pushback(graph->Waits, wait, RenderGraphWait);
+	batches[consumer].WaitIndex[queue] = (u32)vec_length(graph->Waits) - 1;
+	++batches[consumer].WaitCount;
+}
+
+/* A function to find the submits on other queues a use has to wait for */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the slot */
+/* @param The queue of the pass */
+/* @param If the pass writes the slot */
+/* @param An array of RENDER_GRAPH_QUEUE_COUNT submits to be filled, RENDER_GRAPH_NONE for none */
+void GetRenderGraphProducers(RenderGraph* graph, RenderGraphSlot* slot, RenderGraphQueue queue, bool write, u32 producers[RENDER_GRAPH_QUEUE_COUNT])
+{
+	RenderGraphBatch* batches = (RenderGraphBatch*)graph->Batches;
+	for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+		producers[q] = RENDER_GRAPH_NONE;
+
+	if ((slot->WriteBatch != RENDER_GRAPH_NONE) && (batches[slot->WriteBatch].Queue != queue))
+		producers[batches[slot->WriteBatch].Queue] = slot->WriteBatch;
+
+	/* A write also has to wait for the reads before it */
+	if (write)
+		for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+			if ((q != queue) && (slot->ReadBatch[q] != RENDER_GRAPH_NONE) &&
+				((producers[q] == RENDER_GRAPH_NONE) || (slot->ReadBatch[q] > producers[q])))
+				producers[q] = slot->ReadBatch[q];
+}
+
+/* A function to place the barrier a use needs, if any, and update what the slot has seen. Returns true if the image
+   changed layout, which later passes on other queues have to wait for like a write */
+/* @param A Pointer to the graph */
+/* @param The slot */
+/* @param A Pointer to the use */
+/* @param The stages a semaphore wait just blocked for this use, a layout change is chained to them, 0 for none */
+bool PlaceRenderGraphBarrier(RenderGraph* graph, u32 slotIndex, RenderGraphUse* use, VkPipelineStageFlags chainStages)
+{
+	RenderGraphSlot* slot = &((RenderGraphSlot*)graph->Slots)[slotIndex];
+	bool image = slot->Type == RENDER_GRAPH_IMAGE;
+	bool transition = image && (slot->Layout != use->Layout);
+
+	RenderGraphBarrier barrier = { slotIndex, RENDER_GRAPH_NONE, 0, use->Stages, 0, use->Access, slot->Layout, image ? use->Layout : VK_IMAGE_LAYOUT_UNDEFINED };
+	bool needed = false;
+
+	if (use->Write || transition)
+	{
+		/* A write or a layout change has to wait for everything before it, and make earlier writes available */
+		barrier.SrcStages = slot->WriteStages | slot->ReadStages;
+		barrier.SrcAccess = slot->WriteAccess;
+		needed = transition || (barrier.SrcStages != 0);
+		if (!use->Write)
+		{
+			/* A transition is a write too, the reads after it only need to see it */
+			slot->WriteStages = use->Stages;
+			slot->WriteAccess = 0;
+			slot->ReadStages = use->Stages;
+			slot->VisibleStages = use->Stages;
+			slot->VisibleAccess = use->Access;
+		}
+		else
+		{
+			slot->WriteStages = use->Stages;
+			slot->WriteAccess = use->Access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+			slot->ReadStages = 0;
+			slot->VisibleStages = 0;
+			slot->VisibleAccess = 0;
+		}
+	}
+	else if ((slot->WriteAccess != 0) && (((slot->VisibleStages & use->Stages) != use->Stages) || ((slot->VisibleAccess & use->Access) != use->Access)))
+	{
+		/* A read after a write, later reads in stages that already see the write need nothing */
+		barrier.SrcStages = slot->WriteStages;
+		barrier.SrcAccess = slot->WriteAccess;
+		slot->VisibleStages |= use->Stages;
+		slot->VisibleAccess |= use->Access;
+		slot->ReadStages |= use->Stages;
+		needed = true;
+	}
+	else
+		slot->ReadStages |= use->Stages;
+
+	slot->Layout = image ? use->Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	if (!needed)
+		return false;
+
+	if (barrier.SrcStages == 0)
+		barrier.SrcStages = chainStages ? chainStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	vec_pushback(graph->Barriers, barrier, RenderGraphBarrier);
+	return transition;
+}
+
+/* A function to move a pass that may run async to the compute queue, if it only dispatches and copies, the compute
+   queue is of its own family and every imported resource it uses is shared with that family */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the pass, its uses sorted */
+bool MoveRenderGraphPassToComputeQueue(RenderGraph* graph, RenderGraphPass* pass)
+{
+	if (!pass->AsyncCompute || !graph->DedicatedCompute || (pass->DeclaredQueue != RENDER_GRAPH_QUEUE_GRAPHICS))
+		return false;
+
+	RenderGraphUse* uses = &((RenderGraphUse*)graph->SortedUses)[pass->FirstUse];
+	RenderGraphResource* resources = (RenderGraphResource*)graph->Resources;
+	for (u32 u = 0; u < pass->UseCount; ++u)
+		if ((uses[u].Stages & ~RENDER_GRAPH_ASYNC_COMPUTE_STAGES) || (resources[uses[u].Resource].Imported && !resources[uses[u].Resource].Concurrent))
+			return false;
+
+	pass->Queue = RENDER_GRAPH_QUEUE_COMPUTE;
+	return true;
+}
+
+/* A function to check if two passes have to stay in order, when they share a resource and one of them writes it */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the first pass, its uses sorted */
+/* @param A Pointer to the second pass, its uses sorted */
+bool DoRenderGraphPassesConflict(RenderGraph* graph, RenderGraphPass* a, RenderGraphPass* b)
+{
+	RenderGraphUse* aUses = &((RenderGraphUse*)graph->SortedUses)[a->FirstUse];
+	RenderGraphUse* bUses = &((RenderGraphUse*)graph->SortedUses)[b->FirstUse];
+	for (u32 i = 0; i < a->UseCount; ++i)
+		for (u32 j = 0; j < b->UseCount; ++j)
+			if ((aUses[i].Resource == bUses[j].Resource) && (aUses[i].Write || bUses[j].Write))
+				return true;
+	return false;
+}
+
+/* A function to compile the declared passes into the order they run in, the barriers before each of them, the
+   physical resources behind the transient ones and the submits with the semaphores between them. It does not touch
+   the device, so it can be timed on its own */
+/* @param A Pointer to the graph */
+bool CompileRenderGraph(RenderGraph* graph)
+{
+	u32 passCount = (u32)vec_length(graph->Passes);
+	u32 resourceCount = (u32)vec_length(graph->Resources);
+	u32 useCount = (u32)vec_length(graph->Uses);
+	RenderGraphPass* passes = (RenderGraphPass*)graph->Passes;
+	RenderGraphResource* resources = (RenderGraphResource*)graph->Resources;
+	RenderGraphUse* uses = (RenderGraphUse*)graph->Uses;
+
+	memset(&graph->Stats, 0, sizeof(RenderGraphStats));
+	vec_clear(graph->Order);
+	vec_clear(graph->Barriers);
+	vec_clear(graph->FinalBarriers);
+	vec_clear(graph->Batches);
+	vec_clear(graph->Waits);
+	vec_length_set(graph->Slots, graph->TransientSlotCount);
+	graph->SemaphoreCount = 0;
+	graph->ExternalWaitBatch = RENDER_GRAPH_NONE;
+	graph->ExternalWaitStages = 0;
+
+	/* Group the uses by pass, a counting sort keeps the declared order within each pass */
+	for (u32 i = 0; i < passCount; ++i)
+	{
+		passes[i].UseCount = 0;
+		passes[i].Queue = passes[i].DeclaredQueue;
+		passes[i].Culled = true;
+		passes[i].BarrierCount = 0;
+		passes[i].Batch = RENDER_GRAPH_NONE;
+	}
+	for (u32 i = 0; i < useCount; ++i)
+	{
+		if ((uses[i].Pass >= passCount) || (uses[i].Resource >= resourceCount))
+		{
+			printf("ERROR: A render graph use names a pass or resource that does not exist!\n");
+			return false;
+		}
+		++passes[uses[i].Pass].UseCount;
+	}
+	for (u32 i = 0, first = 0; i < passCount; first += passes[i].UseCount, ++i)
+	{
+		passes[i].FirstUse = first;
+		passes[i].BarrierCount = 0;
+	}
+	if (vec_capacity(graph->SortedUses) < useCount)
+	{
+		vec_destroy(graph->SortedUses);
+		graph->SortedUses = vec_reserve(RenderGraphUse, useCount);
+	}
+	vec_length_set(graph->SortedUses, useCount);
+	RenderGraphUse* sorted = (RenderGraphUse*)graph->SortedUses;
+	for (u32 i = 0; i < useCount; ++i)
+	{
+		RenderGraphPass* pass = &passes[uses[i].Pass];
+		sorted[pass->FirstUse + pass->BarrierCount++] = uses[i];
+	}
+
+	/* Walk back from the outputs, a pass is kept if something after it reads what it writes */
+	bool* needed = (bool*)calloc(resourceCount ? resourceCount : 1, sizeof(bool));
+	for (u32 i = 0; i < resourceCount; ++i)
+	{
+		needed[i] = resources[i].Output;
+		resources[i].FirstPass = RENDER_GRAPH_NONE;
+		resources[i].LastPass = RENDER_GRAPH_NONE;
+		resources[i].QueueMask = 0;
+		resources[i].Slot = RENDER_GRAPH_NONE;
+		resources[i].ImageUsage = 0;
+		resources[i].BufferUsage = 0;
+	}
+	for (u32 i = passCount; i-- > 0;)
+	{
+		RenderGraphPass* pass = &passes[i];
+		for (u32 u = 0; u < pass->UseCount; ++u)
+			if (sorted[pass->FirstUse + u].Write && needed[sorted[pass->FirstUse + u].Resource])
+				pass->Culled = false;
+
+		if (pass->Culled)
+		{
+			++graph->Stats.CulledPasses;
+			continue;
+		}
+
+		for (u32 u = 0; u < pass->UseCount; ++u)
+			if (!sorted[pass->FirstUse + u].Write)
+				needed[sorted[pass->FirstUse + u].Resource] = true;
+	}
+	free(needed);
+
+	/* Passes can only read what earlier passes wrote, so the declared order of the kept passes is a valid one. A pass
+	   moved to the compute queue goes right after the last pass it depends on instead, so it starts as early as it can */
+	for (u32 i = 0; i < passCount; ++i)
+	{
+		if (passes[i].Culled)
+			continue;
+
+		u32 position = (u32)vec_length(graph->Order);
+		vec_pushback(graph->Order, i, u32);
+		if (MoveRenderGraphPassToComputeQueue(graph, &passes[i]))
+		{
+			u32* order = (u32*)graph->Order;
+			for (; (position > 0) && !DoRenderGraphPassesConflict(graph, &passes[order[position - 1]], &passes[i]); --position)
+				order[position] = order[position - 1];
+			order[position] = i;
+			++graph->Stats.AsyncPasses;
+		}
+	}
+	u32* order = (u32*)graph->Order;
+	u32 orderCount = (u32)vec_length(graph->Order);
+
+	for (u32 position = 0; position < orderCount; ++position)
+	{
+		u32 i = order[position];
+		for (u32 u = 0; u < passes[i].UseCount; ++u)
+		{
+			RenderGraphUse* use = &sorted[passes[i].FirstUse + u];
+			RenderGraphResource* resource = &resources[use->Resource];
+			if (resource->FirstPass == RENDER_GRAPH_NONE)
+				resource->FirstPass = position;
+			resource->LastPass = position;
+			resource->QueueMask |= 1u << passes[i].Queue;
+			if (resource->Type == RENDER_GRAPH_IMAGE)
+				resource->ImageUsage |= GetRenderGraphImageUsage(use->Layout);
+			else
+				resource->BufferUsage |= GetRenderGraphBufferUsage(use->Access);
+		}
+	}
+
+	/* Place every transient resource in a slot whose last user ran before its first one, on the same queue so the
+	   barriers of that queue order the two. Going by first use makes this the greedy interval colouring */
+	RenderGraphSlot* slots = (RenderGraphSlot*)graph->Slots;
+	for (u32 i = 0; i < graph->TransientSlotCount; ++i)
+	{
+		slots[i].LastPass = RENDER_GRAPH_NONE;
+		slots[i].QueueMask = 0;
+		slots[i].Output = false;
+	}
+	for (u32 position = 0; position < orderCount; ++position)
+	{
+		RenderGraphPass* pass = &passes[order[position]];
+		for (u32 u = 0; u < pass->UseCount; ++u)
+		{
+			RenderGraphResource* resource = &resources[sorted[pass->FirstUse + u].Resource];
+			if (resource->Imported || (resource->Slot != RENDER_GRAPH_NONE))
+				continue;
+
+			u32 slotIndex = RENDER_GRAPH_NONE;
+			for (u32 s = 0; s < graph->TransientSlotCount; ++s)
+			{
+				RenderGraphSlot* slot = &((RenderGraphSlot*)graph->Slots)[s];
+				if ((slot->Type != resource->Type) || ((slot->LastPass != RENDER_GRAPH_NONE) && ((slot->LastPass >= position) || (slot->LastQueue != pass->Queue) || slot->Output)))
+					continue;
+				if ((resource->Type == RENDER_GRAPH_IMAGE) && ((slot->Format != resource->Format) || (slot->Aspect != resource->Aspect) ||
+					(slot->Extent.width != resource->Extent.width) || (slot->Extent.height != resource->Extent.height) || (slot->Extent.depth != resource->Extent.depth)))
+					continue;
+				if ((resource->Type == RENDER_GRAPH_BUFFER) && (slot->Size != resource->Size))
+					continue;
+
+				slotIndex = s;
+				break;
+			}
+
+			if (slotIndex == RENDER_GRAPH_NONE)
+			{
+				RenderGraphSlot slot = { 0 };
+				slot.Type = resource->Type;
+				slot.Format = resource->Format;
+				slot.Extent = resource->Extent;
+				slot.Aspect = resource->Aspect;
+				slot.Size = resource->Size;
+				slot.LastPass = RENDER_GRAPH_NONE;
+				slot.Heap = RENDER_GRAPH_NONE;
+				vec_pushback(graph->Slots, slot, RenderGraphSlot);
+				slotIndex = graph->TransientSlotCount++;
+			}
+
+			RenderGraphSlot* slot = &((RenderGraphSlot*)graph->Slots)[slotIndex];
+			if (slot->LastPass == RENDER_GRAPH_NONE)
+			{
+				slot->FirstPass = position;
+				slot->FirstQueue = pass->Queue;
+			}
+			slot->LastPass = resource->LastPass;
+			slot->LastQueue = passes[order[resource->LastPass]].Queue;
+			slot->ImageUsage |= resource->ImageUsage;
+			slot->BufferUsage |= resource->BufferUsage;
+			slot->QueueMask |= resource->QueueMask;
+			slot->Output |= resource->Output;
+			resource->Slot = slotIndex;
+		}
+	}
+
+	/* Imported resources get a slot each, after the transient ones. The graph does no ownership transfers, so an
+	   exclusive one has to stay on one queue family */
+	for (u32 i = 0; i < resourceCount; ++i)
+	{
+		if (!resources[i].Imported || (resources[i].FirstPass == RENDER_GRAPH_NONE))
+			continue;
+
+		for (u32 q = 0; !resources[i].Concurrent && (q < RENDER_GRAPH_QUEUE_COUNT); ++q)
+			if ((resources[i].QueueMask & (1u << q)) && (graph->QueueFamilies[q] != graph->QueueFamilies[RENDER_GRAPH_QUEUE_GRAPHICS]))
+			{
+				printf("ERROR: An exclusive imported render graph resource is used on another queue family than the graphics queue!\n");
+				return false;
+			}
+
+		RenderGraphSlot slot = { 0 };
+		slot.Type = resources[i].Type;
+		slot.Imported = true;
+		slot.Format = resources[i].Format;
+		slot.Extent = resources[i].Extent;
+		slot.Aspect = resources[i].Aspect;
+		slot.Size = resources[i].Size;
+		slot.Image = resources[i].Image;
+		slot.Buffer = resources[i].Buffer;
+		slot.QueueMask = resources[i].QueueMask;
+		vec_pushback(graph->Slots, slot, RenderGraphSlot);
+		resources[i].Slot = (u32)vec_length(graph->Slots) - 1;
+	}
+
+	slots = (RenderGraphSlot*)graph->Slots;
+	u32 slotCount = (u32)vec_length(graph->Slots);
+	for (u32 i = 0; i < slotCount; ++i)
+	{
+		RenderGraphSlot* slot = &slots[i];
+		slot->Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		slot->WriteStages = 0;
+		slot->WriteAccess = 0;
+		slot->ReadStages = 0;
+		slot->VisibleStages = 0;
+		slot->VisibleAccess = 0;
+		slot->WriteBatch = RENDER_GRAPH_NONE;
+		slot->LastBatch = RENDER_GRAPH_NONE;
+		slot->FirstBarrier = RENDER_GRAPH_NONE;
+		for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+			slot->ReadBatch[q] = RENDER_GRAPH_NONE;
+		if (i < graph->TransientSlotCount)
+			graph->Stats.Slots += slot->LastPass != RENDER_GRAPH_NONE;
+		else
+			++graph->Stats.Slots;
+	}
+	/* An imported resource that waits on the external semaphore starts out as if those stages wrote it, so its first
+	   barrier is chained to the wait */
+	for (u32 i = 0; i < resourceCount; ++i)
+		if (resources[i].Imported && (resources[i].Slot != RENDER_GRAPH_NONE))
+		{
+			slots[resources[i].Slot].Layout = resources[i].InitialLayout;
+			slots[resources[i].Slot].WriteStages = resources[i].WaitStages;
+		}
+
+	/* Walk the passes in order, placing barriers and splitting submits where a queue changes or a pass needs a
+	   semaphore its submit does not wait for yet */
+	u32 current = RENDER_GRAPH_NONE;
+	for (u32 position = 0; position < orderCount; ++position)
+	{
+		RenderGraphPass* pass = &passes[order[position]];
+		RenderGraphBatch* batch = current != RENDER_GRAPH_NONE ? &((RenderGraphBatch*)graph->Batches)[current] : nullptr;
+		bool split = (batch == nullptr) || (batch->Queue != pass->Queue);
+
+		for (u32 u = 0; !split && (u < pass->UseCount); ++u)
+		{
+			RenderGraphUse* use = &sorted[pass->FirstUse + u];
+			u32 producers[RENDER_GRAPH_QUEUE_COUNT];
+			GetRenderGraphProducers(graph, &slots[resources[use->Resource].Slot], pass->Queue, use->Write, producers);
+			for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+				if ((producers[q] != RENDER_GRAPH_NONE) && ((batch->WaitIndex[q] == RENDER_GRAPH_NONE) ||
+					(((RenderGraphWait*)graph->Waits)[batch->WaitIndex[q]].Producer < producers[q])))
+					split = true;
+		}
+
+		if (split)
+		{
+			RenderGraphBatch newBatch = { pass->Queue, position, 0, (u32)vec_length(graph->Waits), 0 };
+			for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+				newBatch.WaitIndex[q] = RENDER_GRAPH_NONE;
+			vec_pushback(graph->Batches, newBatch, RenderGraphBatch);
+			current = (u32)vec_length(graph->Batches) - 1;
+		}
+
+		pass->Batch = current;
+		pass->FirstBarrier = (u32)vec_length(graph->Barriers);
+		for (u32 u = 0; u < pass->UseCount; ++u)
+		{
+			RenderGraphUse* use = &sorted[pass->FirstUse + u];
+			RenderGraphResource* resource = &resources[use->Resource];
+			RenderGraphSlot* slot = &slots[resource->Slot];
+
+			u32 producers[RENDER_GRAPH_QUEUE_COUNT];
+			GetRenderGraphProducers(graph, slot, pass->Queue, use->Write, producers);
+			VkPipelineStageFlags chainStages = 0;
+			for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+				if (producers[q] != RENDER_GRAPH_NONE)
+				{
+					AddRenderGraphWait(graph, current, producers[q], use->Stages);
+					chainStages = use->Stages;
+				}
+
+			/* The external semaphore is waited on by the submit of the first use of a resource that needs it, later
+			   first uses on other queues wait for that submit */
+			if (resource->WaitStages && (resource->FirstPass == position) && (slot->LastBatch == RENDER_GRAPH_NONE))
+			{
+				if (graph->ExternalWaitBatch == RENDER_GRAPH_NONE)
+					graph->ExternalWaitBatch = current;
+				if (((RenderGraphBatch*)graph->Batches)[graph->ExternalWaitBatch].Queue == pass->Queue)
+					graph->ExternalWaitStages |= resource->WaitStages;
+				else
+				{
+					AddRenderGraphWait(graph, current, graph->ExternalWaitBatch, use->Stages);
+					chainStages = use->Stages;
+				}
+			}
+
+			/* The semaphore made the other queue's work visible, a barrier is only left for a layout change, chained
+			   to the stages that waited */
+			if (chainStages)
+			{
+				slot->WriteStages = 0;
+				slot->WriteAccess = 0;
+				slot->ReadStages = 0;
+			}
+
+			/* The contents of the resource that had the slot before are not kept */
+			if (!resource->Imported && (resource->FirstPass == position))
+				slot->Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			/* The barrier before the first use of a transient image is where RealizeRenderGraph adds waiting for
+			   images that had its memory earlier in the frame */
+			u32 barrierCount = (u32)vec_length(graph->Barriers);
+			bool firstUse = (slot->LastBatch == RENDER_GRAPH_NONE) && !resource->Imported;
+			bool transition = PlaceRenderGraphBarrier(graph, resource->Slot, use, chainStages);
+			if (firstUse && (vec_length(graph->Barriers) > barrierCount))
+				slot->FirstBarrier = barrierCount;
+
+			if (use->Write || transition)
+			{
+				slot->WriteBatch = current;
+				for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+					slot->ReadBatch[q] = RENDER_GRAPH_NONE;
+			}
+			if (!use->Write)
+				slot->ReadBatch[pass->Queue] = current;
+			slot->LastBatch = current;
+		}
+		pass->BarrierCount = (u32)vec_length(graph->Barriers) - pass->FirstBarrier;
+		graph->Stats.BarrierBatches += pass->BarrierCount > 0;
+		++((RenderGraphBatch*)graph->Batches)[current].PassCount;
+	}
+
+	/* Imported images are left in the layout asked for, at the end of the last submit using them */
+	for (u32 i = 0; i < resourceCount; ++i)
+	{
+		RenderGraphResource* resource = &resources[i];
+		if (!resource->Imported || (resource->Slot == RENDER_GRAPH_NONE) || (resource->Type != RENDER_GRAPH_IMAGE) ||
+			(resource->FinalLayout == VK_IMAGE_LAYOUT_UNDEFINED) || (resource->FinalLayout == slots[resource->Slot].Layout))
+			continue;
+
+		RenderGraphSlot* slot = &slots[resource->Slot];
+		RenderGraphBarrier barrier = { resource->Slot, slot->LastBatch, slot->WriteStages | slot->ReadStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			slot->WriteAccess, 0, slot->Layout, resource->FinalLayout };
+		if (barrier.SrcStages == 0)
+			barrier.SrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		vec_pushback(graph->FinalBarriers, barrier, RenderGraphBarrier);
+	}
+
+	/* Without a resource waiting on it, the external semaphore is waited on by the first graphics submit, or the first
+	   one, for everything since the stages it guards are not known */
+	u32 batchCount = (u32)vec_length(graph->Batches);
+	if ((graph->ExternalWaitBatch == RENDER_GRAPH_NONE) && (batchCount > 0))
+	{
+		graph->ExternalWaitBatch = 0;
+		for (u32 b = batchCount; b-- > 0;)
+			if (((RenderGraphBatch*)graph->Batches)[b].Queue == RENDER_GRAPH_QUEUE_GRAPHICS)
+				graph->ExternalWaitBatch = b;
+		graph->ExternalWaitStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	}
+
+	/* The last submit waits for the last one of every other queue, so its fence covers the whole frame */
+	if (batchCount > 1)
+	{
+		u32 last = batchCount - 1;
+		for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+		{
+			if (q == ((RenderGraphBatch*)graph->Batches)[last].Queue)
+				continue;
+
+			for (u32 b = last; b-- > 0;)
+				if (((RenderGraphBatch*)graph->Batches)[b].Queue == q)
+				{
+					AddRenderGraphWait(graph, last, b, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+					break;
+				}
+		}
+	}
+
+	graph->Stats.Passes = passCount;
+	graph->Stats.Resources = resourceCount;
+	graph->Stats.Barriers = (u32)(vec_length(graph->Barriers) + vec_length(graph->FinalBarriers));
+	graph->Stats.BarrierBatches += (u32)vec_length(graph->FinalBarriers) > 0;
+	graph->Stats.Batches = batchCount;
+	graph->Stats.Semaphores = graph->SemaphoreCount;
+	graph->Compiled = true;
+	return true;
+}
+
+/* A function to get the image behind a resource, valid once the graph ran RealizeRenderGraph */
+/* @param A Pointer to the graph */
+/* @param The resource */
+VkImage GetRenderGraphImage(RenderGraph* graph, u32 resource)
+{
+	u32 slot = ((RenderGraphResource*)graph->Resources)[resource].Slot;
+	return slot != RENDER_GRAPH_NONE ? ((RenderGraphSlot*)graph->Slots)[slot].Image : VK_NULL_HANDLE;
+}
+
+/* A function to get the buffer behind a resource, valid once the graph ran RealizeRenderGraph */
+/* @param A Pointer to the graph */
+/* @param The resource */
+VkBuffer GetRenderGraphBuffer(RenderGraph* graph, u32 resource)
+{
+	u32 slot = ((RenderGraphResource*)graph->Resources)[resource].Slot;
+	return slot != RENDER_GRAPH_NONE ? ((RenderGraphSlot*)graph->Slots)[slot].Buffer : VK_NULL_HANDLE;
+}
+
+/* A function to destroy the resource of a transient slot */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the slot */
+void DestroyRenderGraphSlot(RenderGraph* graph, RenderGraphSlot* slot)
+{
+	if (slot->Image != VK_NULL_HANDLE)
+		vkDestroyImage(*graph->LogicalDevice, slot->Image, nullptr);
+	if (slot->Buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(*graph->LogicalDevice, slot->Buffer, nullptr);
+	if (slot->Memory != VK_NULL_HANDLE)
+		vkFreeMemory(*graph->LogicalDevice, slot->Memory, nullptr);
+	slot->Image = VK_NULL_HANDLE;
+	slot->Buffer = VK_NULL_HANDLE;
+	slot->Memory = VK_NULL_HANDLE;
+	slot->Bound = false;
+	slot->Heap = RENDER_GRAPH_NONE;
+}
+
+/* A function to find a memory type without printing an error when there is none */
+/* @param A Pointer to the graph */
+/* @param The memory types allowed */
+/* @param The properties wanted */
+/* @param A Pointer to the u32 to be filled */
+bool FindRenderGraphMemoryType(RenderGraph* graph, u32 memoryTypeBits, VkMemoryPropertyFlags properties, u32* memoryTypeIndex)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(*graph->PhysicalDevice, &memoryProperties);
+	for (u32 i = 0; i < memoryProperties.memoryTypeCount; ++i)
+		if ((memoryTypeBits & (1u << i)) && ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties))
+		{
+			*memoryTypeIndex = i;
+			return true;
+		}
+
+	return false;
+}
+
+/* A function to create the image or buffer of a transient slot without memory */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the slot */
+/* @param If the image should be able to live in lazily allocated memory */
+bool CreateRenderGraphSlot(RenderGraph* graph, RenderGraphSlot* slot, bool lazy)
+{
+	/* Resources used on more than one queue family are shared, so no ownership transfers are needed */
+	u32 families[RENDER_GRAPH_QUEUE_COUNT];
+	u32 familyCount = 0;
+	for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+	{
+		if (!(slot->QueueMask & (1u << q)))
+			continue;
+		bool seen = false;
+		for (u32 f = 0; f < familyCount; ++f)
+			seen |= families[f] == graph->QueueFamilies[q];
+		if (!seen)
+			families[familyCount++] = graph->QueueFamilies[q];
+	}
+	VkSharingMode sharing = familyCount > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+
+	if (slot->Type == RENDER_GRAPH_IMAGE)
+	{
+		VkImageCreateInfo imageCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			nullptr,
+			0,
+			slot->Extent.depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D,
+			slot->Format,
+			slot->Extent,
+			1,
+			1,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_IMAGE_TILING_OPTIMAL,
+			slot->ImageUsage | (lazy ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0),
+			sharing,
+			familyCount > 1 ? familyCount : 0,
+			familyCount > 1 ? families : nullptr,
+			VK_IMAGE_LAYOUT_UNDEFINED
+		};
+
+		if (vkCreateImage(*graph->LogicalDevice, &imageCreateInfo, nullptr, &slot->Image) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not create a render graph image!\n");
+			return false;
+		}
+		vkGetImageMemoryRequirements(*graph->LogicalDevice, slot->Image, &slot->Requirements);
+	}
+	else
+	{
+		VkBufferCreateInfo bufferCreateInfo =
+		{
+			VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			nullptr,
+			0,
+			slot->Size,
+			slot->BufferUsage,
+			sharing,
+			familyCount > 1 ? familyCount : 0,
+			familyCount > 1 ? families : nullptr
+		};
+
+		if (vkCreateBuffer(*graph->LogicalDevice, &bufferCreateInfo, nullptr, &slot->Buffer) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not create a render graph buffer!\n");
+			return false;
+		}
+		vkGetBufferMemoryRequirements(*graph->LogicalDevice, slot->Buffer, &slot->Requirements);
+	}
+
+	slot->Lazy = lazy;
+	slot->Bound = false;
+	slot->Heap = RENDER_GRAPH_NONE;
+	slot->CreatedImageUsage = slot->ImageUsage;
+	slot->CreatedBufferUsage = slot->BufferUsage;
+	slot->CreatedQueueMask = slot->QueueMask;
+	return true;
+}
+
+/* A function to check if two transient slots may share memory, one has to be done before the other starts on the
+   same queue, so the barrier before the later one can wait for the earlier one, and not be read after the graph */
+/* @param A Pointer to a slot */
+/* @param A Pointer to another slot */
+bool CanAliasRenderGraphSlots(RenderGraphSlot* a, RenderGraphSlot* b)
+{
+	return (!a->Output && (a->LastPass < b->FirstPass) && (a->LastQueue == b->FirstQueue)) ||
+		(!b->Output && (b->LastPass < a->FirstPass) && (b->LastQueue == a->FirstQueue));
+}
+
+/* A function to place the transient images of the last compile in shared heaps. The largest go first, each at the
+   lowest offset where it does not share bytes with an image it can not alias */
+/* @param A Pointer to the graph */
+/* @param A Vector of u32, the slots to place */
+/* @param An array of VkDeviceSize for the offset of each slot, filled */
+/* @param An array of u32 for the heap of each slot, filled */
+void PlaceRenderGraphImages(RenderGraph* graph, Vec placed, VkDeviceSize* offsets, u32* heaps)
+{
+	RenderGraphSlot* slots = (RenderGraphSlot*)graph->Slots;
+	u32* order = (u32*)placed;
+	u32 count = (u32)vec_length(placed);
+
+	for (u32 i = 1; i < count; ++i)
+		for (u32 j = i; (j > 0) && (slots[order[j - 1]].Requirements.size < slots[order[j]].Requirements.size); --j)
+		{
+			u32 temp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = temp;
+		}
+
+	for (u32 h = 0; h < vec_length(graph->Heaps); ++h)
+		((RenderGraphHeap*)graph->Heaps)[h].Needed = 0;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		RenderGraphSlot* slot = &slots[order[i]];
+
+		/* Images that can use the same memory types share a heap */
+		u32 heap = RENDER_GRAPH_NONE;
+		for (u32 h = 0; h < vec_length(graph->Heaps); ++h)
+			if (((RenderGraphHeap*)graph->Heaps)[h].MemoryTypeBits == slot->Requirements.memoryTypeBits)
+				heap = h;
+		if (heap == RENDER_GRAPH_NONE)
+		{
+			RenderGraphHeap newHeap = { VK_NULL_HANDLE, 0, 0, slot->Requirements.memoryTypeBits };
+			vec_pushback(graph->Heaps, newHeap, RenderGraphHeap);
+			heap = (u32)vec_length(graph->Heaps) - 1;
+		}
+
+		/* The candidates are the start of the heap and the end of every image already placed in it */
+		VkDeviceSize alignment = slot->Requirements.alignment ? slot->Requirements.alignment : 1;
+		VkDeviceSize best = ~(VkDeviceSize)0;
+		for (u32 c = 0; c <= i; ++c)
+		{
+			VkDeviceSize candidate = 0;
+			if (c < i)
+			{
+				if (heaps[order[c]] != heap)
+					continue;
+				candidate = offsets[order[c]] + slots[order[c]].Requirements.size;
+			}
+			candidate = (candidate + alignment - 1) / alignment * alignment;
+			if (candidate >= best)
+				continue;
+
+			bool fits = true;
+			for (u32 o = 0; fits && (o < i); ++o)
+			{
+				RenderGraphSlot* other = &slots[order[o]];
+				if ((heaps[order[o]] != heap) || CanAliasRenderGraphSlots(slot, other))
+					continue;
+				fits = (candidate + slot->Requirements.size <= offsets[order[o]]) || (offsets[order[o]] + other->Requirements.size <= candidate);
+			}
+			if (fits)
+				best = candidate;
+		}
+
+		offsets[order[i]] = best;
+		heaps[order[i]] = heap;
+		RenderGraphHeap* target = &((RenderGraphHeap*)graph->Heaps)[heap];
+		if (best + slot->Requirements.size > target->Needed)
+			target->Needed = best + slot->Requirements.size;
+	}
+}
+
+/* A function to create the transient resources the last compile needs. Buffers and images that only live inside one
+   render pass get their own memory, lazily allocated for the images where the device has it. The other images are
+   placed in heaps, sharing bytes with images whose lifetimes do not overlap. An image is only recreated when it has
+   to be used in a new way or moves in its heap, which destroys resources the last run used, so the GPU has to be done
+   with it. ExecuteRenderGraph waits for that first */
+/* @param A Pointer to the graph */
+bool RealizeRenderGraph(RenderGraph* graph)
+{
+	memset(&graph->Memory, 0, sizeof(RenderGraphMemoryStats));
+	Vec placed = vec_create(u32);
+
+	for (u32 i = 0; i < graph->TransientSlotCount; ++i)
+	{
+		RenderGraphSlot* slot = &((RenderGraphSlot*)graph->Slots)[i];
+		if (slot->LastPass == RENDER_GRAPH_NONE)
+			continue;
+
+		/* Attachments written and read inside a single pass, like MSAA color or a depth buffer nothing samples, never
+		   need their contents in memory, unless they are read after the graph */
+		bool lazy = graph->LazyMemory && (slot->Type == RENDER_GRAPH_IMAGE) && (slot->FirstPass == slot->LastPass) &&
+			((slot->ImageUsage & ~RENDER_GRAPH_ATTACHMENT_USAGE) == 0) && !slot->Output;
+
+		bool exists = (slot->Image != VK_NULL_HANDLE) || (slot->Buffer != VK_NULL_HANDLE);
+		bool changed = ((slot->ImageUsage & ~slot->CreatedImageUsage) != 0) || ((slot->BufferUsage & ~slot->CreatedBufferUsage) != 0) ||
+			((slot->QueueMask & ~slot->CreatedQueueMask) != 0) || (slot->Lazy != lazy);
+		if (exists && changed)
+			DestroyRenderGraphSlot(graph, slot);
+		if ((!exists || changed) && !CreateRenderGraphSlot(graph, slot, lazy))
+		{
+			vec_destroy(placed);
+			return false;
+		}
+
+		if (slot->Type == RENDER_GRAPH_BUFFER)
+		{
+			if (!slot->Bound && !AllocateAndBindMemoryObjectToBuffer(graph->PhysicalDevice, graph->LogicalDevice, &slot->Buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &slot->Memory))
+			{
+				vec_destroy(placed);
+				return false;
+			}
+			slot->Bound = true;
+			continue;
+		}
+
+		/* A lazy image whose memory types have no lazily allocated one went into a heap, and is placed again each frame */
+		u32 memoryTypeIndex = 0;
+		if (slot->Lazy && (slot->Bound ? (slot->Heap == RENDER_GRAPH_NONE) :
+			FindRenderGraphMemoryType(graph, slot->Requirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, &memoryTypeIndex)))
+		{
+			if (!slot->Bound)
+			{
+				VkMemoryAllocateInfo memoryAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, slot->Requirements.size, memoryTypeIndex };
+				if ((vkAllocateMemory(*graph->LogicalDevice, &memoryAllocateInfo, nullptr, &slot->Memory) != VK_SUCCESS) ||
+					(vkBindImageMemory(*graph->LogicalDevice, slot->Image, slot->Memory, 0) != VK_SUCCESS))
+				{
+					printf("ERROR: Could not allocate lazily allocated memory for a render graph image!\n");
+					vec_destroy(placed);
+					return false;
+				}
+				slot->Bound = true;
+			}
+
+			graph->Memory.LazyBytes += slot->Requirements.size;
+			++graph->Memory.LazyImages;
+			continue;
+		}
+
+		vec_pushback(placed, i, u32);
+	}
+
+	u32 placedCount = (u32)vec_length(placed);
+	VkDeviceSize* offsets = (VkDeviceSize*)calloc(graph->TransientSlotCount ? graph->TransientSlotCount : 1, sizeof(VkDeviceSize));
+	u32* heaps = (u32*)calloc(graph->TransientSlotCount ? graph->TransientSlotCount : 1, sizeof(u32));
+	PlaceRenderGraphImages(graph, placed, offsets, heaps);
+
+	RenderGraphSlot* slots = (RenderGraphSlot*)graph->Slots;
+	bool result = true;
+	for (u32 h = 0; result && (h < vec_length(graph->Heaps)); ++h)
+	{
+		RenderGraphHeap* heap = &((RenderGraphHeap*)graph->Heaps)[h];
+		graph->Memory.HeapBytes += heap->Needed;
+		if (heap->Needed <= heap->Size)
+			continue;
+
+		/* The heap grows, so every image in it moves */
+		for (u32 i = 0; i < graph->TransientSlotCount; ++i)
+			if (slots[i].Bound && (slots[i].Heap == h))
+			{
+				vkDestroyImage(*graph->LogicalDevice, slots[i].Image, nullptr);
+				slots[i].Image = VK_NULL_HANDLE;
+				slots[i].Bound = false;
+				slots[i].Heap = RENDER_GRAPH_NONE;
+				result = result && CreateRenderGraphSlot(graph, &slots[i], slots[i].Lazy);
+			}
+		if (heap->Memory != VK_NULL_HANDLE)
+			vkFreeMemory(*graph->LogicalDevice, heap->Memory, nullptr);
+		heap->Memory = VK_NULL_HANDLE;
+		heap->Size = 0;
+
+		u32 memoryTypeIndex = 0;
+		if (!result || !SelectMemoryTypeIndex(graph->PhysicalDevice, heap->MemoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memoryTypeIndex))
+		{
+			result = false;
+			break;
+		}
+
+		VkMemoryAllocateInfo memoryAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, heap->Needed, memoryTypeIndex };
+		if (vkAllocateMemory(*graph->LogicalDevice, &memoryAllocateInfo, nullptr, &heap->Memory) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not allocate a render graph heap!\n");
+			result = false;
+			break;
+		}
+		heap->Size = heap->Needed;
+	}
+
+	for (u32 p = 0; result && (p < placedCount); ++p)
+	{
+		u32 index = ((u32*)placed)[p];
+		RenderGraphSlot* slot = &slots[index];
+		if (slot->Bound && (slot->Heap == heaps[index]) && (slot->Offset == offsets[index]))
+			continue;
+
+		/* An image can not be bound again, one that moved is made anew */
+		if (slot->Bound)
+		{
+			vkDestroyImage(*graph->LogicalDevice, slot->Image, nullptr);
+			slot->Image = VK_NULL_HANDLE;
+			if (!CreateRenderGraphSlot(graph, slot, slot->Lazy))
+			{
+				result = false;
+				break;
+			}
+		}
+
+		if (vkBindImageMemory(*graph->LogicalDevice, slot->Image, ((RenderGraphHeap*)graph->Heaps)[heaps[index]].Memory, offsets[index]) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not bind a render graph image to its heap!\n");
+			result = false;
+			break;
+		}
+		slot->Bound = true;
+		slot->Heap = heaps[index];
+		slot->Offset = offsets[index];
+	}
+
+	/* The first barrier of an image waits for the images that had its bytes before it, the compile only knew about
+	   uses of the image itself */
+	for (u32 p = 0; result && (p < placedCount); ++p)
+	{
+		RenderGraphSlot* slot = &slots[((u32*)placed)[p]];
+		bool aliased = false;
+		for (u32 o = 0; o < placedCount; ++o)
+		{
+			RenderGraphSlot* other = &slots[((u32*)placed)[o]];
+			if ((other == slot) || (other->Heap != slot->Heap) || (other->LastPass >= slot->FirstPass) ||
+				(other->Offset >= slot->Offset + slot->Requirements.size) || (slot->Offset >= other->Offset + other->Requirements.size))
+				continue;
+
+			aliased = true;
+			if (slot->FirstBarrier != RENDER_GRAPH_NONE)
+			{
+				RenderGraphBarrier* barrier = &((RenderGraphBarrier*)graph->Barriers)[slot->FirstBarrier];
+				barrier->SrcStages |= other->WriteStages | other->ReadStages;
+				barrier->SrcAccess |= other->WriteAccess;
+			}
+		}
+		graph->Memory.AliasedImages += aliased;
+	}
+
+	/* Every image declared this frame would have had memory of its own */
+	RenderGraphResource* resources = (RenderGraphResource*)graph->Resources;
+	for (u32 i = 0; i < vec_length(graph->Resources); ++i)
+		if (!resources[i].Imported && (resources[i].Type == RENDER_GRAPH_IMAGE) && (resources[i].Slot != RENDER_GRAPH_NONE))
+			graph->Memory.UnaliasedBytes += slots[resources[i].Slot].Requirements.size;
+	graph->Memory.SavedBytes = graph->Memory.UnaliasedBytes > graph->Memory.HeapBytes ? graph->Memory.UnaliasedBytes - graph->Memory.HeapBytes : 0;
+
+	free(offsets);
+	free(heaps);
+	vec_destroy(placed);
+	return result;
+}
+
+/* A function to print the memory of the transient images in the last frame */
+/* @param A Pointer to the graph */
+void PrintRenderGraphMemoryStats(RenderGraph* graph)
+{
+	RenderGraphMemoryStats* memory = &graph->Memory;
+	printf("INFO: Render graph memory: %.2f MB without aliasing, %.2f MB in heaps, %.2f MB lazily allocated, %.2f MB saved (%u images aliased, %u lazy)\n",
+		memory->UnaliasedBytes / (1024.0 * 1024.0), memory->HeapBytes / (1024.0 * 1024.0), memory->LazyBytes / (1024.0 * 1024.0),
+		memory->SavedBytes / (1024.0 * 1024.0), memory->AliasedImages, memory->LazyImages);
+}
+
+/* A function to measure how long each pass takes on the GPU with timestamps, the compute and graphics queue families
+   both need timestamp support */
+/* @param A Pointer to the graph */
+/* @param The most passes a frame runs, the passes after them are not measured */
+bool EnableRenderGraphTimestamps(RenderGraph* graph, u32 maxPasses)
+{
+	Vec queueFamilies = CheckAvailableQueueFamiliesAndTheirProperties(graph->PhysicalDevice);
+	if (queueFamilies == nullptr)
+		return false;
+
+	bool supported = true;
+	for (u32 q = 0; q < RENDER_GRAPH_QUEUE_COUNT; ++q)
+		supported &= ((VkQueueFamilyProperties*)queueFamilies)[graph->QueueFamilies[q]].timestampValidBits > 0;
+	vec_destroy(queueFamilies);
+	if (!supported)
+	{
+		printf("WARNING: The queues of a render graph have no timestamps, its passes are not measured!\n");
+		return false;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(*graph->PhysicalDevice, &properties);
+	graph->TimestampPeriod = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, nullptr, 0, VK_QUERY_TYPE_TIMESTAMP, maxPasses * 2, 0 };
+	if (vkCreateQueryPool(*graph->LogicalDevice, &queryPoolCreateInfo, nullptr, &graph->Timestamps) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the timestamp query pool of a render graph!\n");
+		return false;
+	}
+
+	graph->TimestampCapacity = maxPasses;
+	return true;
+}
+
+/* A function to read the timestamps the last run of the graph wrote, the GPU must be done with it */
+/* @param A Pointer to the graph */
+void ReadRenderGraphTimestamps(RenderGraph* graph)
+{
+	u32 count = (u32)vec_length(graph->Timings);
+	if (!graph->TimestampsWritten || (count == 0))
+		return;
+	graph->TimestampsWritten = false;
+
+	u64* ticks = (u64*)malloc(count * 2 * sizeof(u64));
+	if (vkGetQueryPoolResults(*graph->LogicalDevice, graph->Timestamps, 0, count * 2, count * 2 * sizeof(u64), ticks, sizeof(u64), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+	{
+		free(ticks);
+		return;
+	}
+
+	u64 first = UINT64_MAX, last = 0;
+	for (u32 i = 0; i < count * 2; ++i)
+	{
+		first = ticks[i] < first ? ticks[i] : first;
+		last = ticks[i] > last ? ticks[i] : last;
+	}
+
+	RenderGraphPassTiming* timings = (RenderGraphPassTiming*)graph->Timings;
+	RenderGraphTimingStats* stats = &graph->Timing;
+	memset(stats, 0, sizeof(RenderGraphTimingStats));
+	stats->FrameMilliseconds = (double)(last - first) * graph->TimestampPeriod / 1000000.0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		timings[i].Start = (double)(ticks[i * 2] - first) * graph->TimestampPeriod / 1000000.0;
+		timings[i].End = (double)(ticks[i * 2 + 1] - first) * graph->TimestampPeriod / 1000000.0;
+		timings[i].Overlap = 0.0;
+		if (timings[i].Queue == RENDER_GRAPH_QUEUE_COMPUTE)
+			stats->ComputeMilliseconds += timings[i].End - timings[i].Start;
+		else
+			stats->GraphicsMilliseconds += timings[i].End - timings[i].Start;
+	}
+	free(ticks);
+
+	/* Passes on one queue run one after the other, so the overlap with the passes of another queue just adds up */
+	for (u32 i = 0; i < count; ++i)
+	{
+		for (u32 j = 0; j < count; ++j)
+		{
+			if (timings[i].Queue == timings[j].Queue)
+				continue;
+			double start = timings[i].Start > timings[j].Start ? timings[i].Start : timings[j].Start;
+			double end = timings[i].End < timings[j].End ? timings[i].End : timings[j].End;
+			if (end > start)
+				timings[i].Overlap += end - start;
+		}
+		if (timings[i].Overlap > timings[i].End - timings[i].Start)
+			timings[i].Overlap = timings[i].End - timings[i].Start;
+		if (timings[i].Queue == RENDER_GRAPH_QUEUE_COMPUTE)
+			stats->OverlapMilliseconds += timings[i].Overlap;
+	}
+}
+
+/* A function to print how long the passes of the last measured run took on the GPU and how much of the time of the
+   async ones was hidden behind other queues, a pass that barely overlaps gains nothing from running async */
+/* @param A Pointer to the graph */
+void PrintRenderGraphTimings(RenderGraph* graph)
+{
+	RenderGraphTimingStats* stats = &graph->Timing;
+	printf("INFO: Render graph GPU time: %.3f ms frame, %.3f ms graphics, %.3f ms compute, %.3f ms of compute overlapped\n",
+		stats->FrameMilliseconds, stats->GraphicsMilliseconds, stats->ComputeMilliseconds, stats->OverlapMilliseconds);
+
+	RenderGraphPassTiming* timings = (RenderGraphPassTiming*)graph->Timings;
+	for (u32 i = 0; i < vec_length(graph->Timings); ++i)
+	{
+		double duration = timings[i].End - timings[i].Start;
+		printf("INFO:   %-32s %-8s %8.3f ms, %5.1f%% overlapped%s\n", timings[i].Name,
+			timings[i].Queue == RENDER_GRAPH_QUEUE_GRAPHICS ? "graphics" : (timings[i].Queue == RENDER_GRAPH_QUEUE_COMPUTE ? "compute" : "transfer"),
+			duration, duration > 0.0 ? timings[i].Overlap * 100.0 / duration : 0.0, timings[i].Async ? " (async)" : "");
+	}
+}
+
+/* A function to hand barriers to a batcher, they are recorded when it is flushed */
+/* @param A Pointer to the graph */
+/* @param A Pointer to the barrier batcher */
+/* @param The command buffer */
+/* @param An array of barriers */
+/* @param The number of barriers */
+/* @param The submit the barriers belong to, RENDER_GRAPH_NONE to record all of them */
+void RecordRenderGraphBarriers(RenderGraph* graph, BarrierBatcher* batcher, VkCommandBuffer commandBuffer, RenderGraphBarrier* barriers, u32 count, u32 batch)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		RenderGraphBarrier* barrier = &barriers[i];
+		if ((batch != RENDER_GRAPH_NONE) && (barrier->Batch != batch))
+			continue;
+
+		RenderGraphSlot* slot = &((RenderGraphSlot*)graph->Slots)[barrier->Slot];
+		if (slot->Type == RENDER_GRAPH_IMAGE)
+		{
+			VkImageSubresourceRange range = { slot->Aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			AddImageBarrier(batcher, commandBuffer, slot->Image, range, barrier->OldLayout, barrier->NewLayout,
+				barrier->SrcStages, barrier->SrcAccess, barrier->DstStages, barrier->DstAccess);
+		}
+		else
+			AddBufferBarrier(batcher, commandBuffer, slot->Buffer, 0, VK_WHOLE_SIZE, barrier->SrcStages, barrier->SrcAccess, barrier->DstStages, barrier->DstAccess);
+	}
+}
+
+/* A function to wait until the GPU is done with the last run of a graph */
+/* @param A Pointer to the graph */
+bool WaitForRenderGraph(RenderGraph* graph)
+{
+	if (graph->RunFence == VK_NULL_HANDLE)
+		return true;
+
+	if (vkWaitForFences(*graph->LogicalDevice, 1, &graph->RunFence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not wait for the last run of a render graph!\n");
+		return false;
+	}
+	return true;
+}
+
+/* A function to record and submit a compiled graph, one command buffer per submit. It first waits for the last run of
+   the graph, whose transient resources, semaphores and timestamps this run reuses */
+/* @param A Pointer to the graph */
+/* @param The graphics, compute and transfer queues, the same queue may be given more than once */
+/* @param A recycler for each queue, its frame has to be begun already */
+/* @param A Pointer to the barrier batcher the barriers are recorded with */
+/* @param A semaphore the imported resources declared with wait stages wait on, like the swapchain image being acquired,
+   VK_NULL_HANDLE for none */
+/* @param A semaphore the last submit signals, like the image being ready to present, VK_NULL_HANDLE for none */
+/* @param A Pointer to a fence signaled once the run is done, null for none */
+bool ExecuteRenderGraph(RenderGraph* graph, VkQueue queues[RENDER_GRAPH_QUEUE_COUNT], CommandBufferRecycler* recyclers[RENDER_GRAPH_QUEUE_COUNT], BarrierBatcher* batcher,
+	VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, VkFence* fence)
+{
+	if (!graph->Compiled)
+	{
+		printf("ERROR: A render graph has to be compiled before it runs!\n");
+		return false;
+	}
+
+	/* The barriers before the first uses start from nothing, so the last run has to be done with every slot, and
+	   with every semaphore it waits on, before they are reused */
+	if (!WaitForRenderGraph(graph) || !RealizeRenderGraph(graph))
+		return false;
+
+	graph->Batcher = batcher;
+	ReadRenderGraphTimestamps(graph);
+	u32 timedPasses = graph->Timestamps != VK_NULL_HANDLE ? (u32)vec_length(graph->Order) : 0;
+	timedPasses = timedPasses < graph->TimestampCapacity ? timedPasses : graph->TimestampCapacity;
+	vec_clear(graph->Timings);
+	while (vec_length(graph->Semaphores) < graph->SemaphoreCount)
+	{
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		if (!CreateVkSemaphore(graph->LogicalDevice, &semaphore))
+			return false;
+		vec_pushback(graph->Semaphores, semaphore, VkSemaphore);
+	}
+
+	RenderGraphPass* passes = (RenderGraphPass*)graph->Passes;
+	RenderGraphWait* waits = (RenderGraphWait*)graph->Waits;
+	VkSemaphore* semaphores = (VkSemaphore*)graph->Semaphores;
+	u32* order = (u32*)graph->Order;
+	u32 batchCount = (u32)vec_length(graph->Batches);
+	u32 waitCount = (u32)vec_length(graph->Waits);
+
+	bool result = true;
+	Vec waitInfos = vec_create(WaitSemaphoreInfo);
+	Vec commandBuffers = vec_create(VkCommandBuffer);
+	Vec signalSemaphores = vec_create(VkSemaphore);
+	for (u32 b = 0; result && (b < batchCount); ++b)
+	{
+		RenderGraphBatch* batch = &((RenderGraphBatch*)graph->Batches)[b];
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (!AcquireCommandBuffer(recyclers[batch->Queue], VK_COMMAND_BUFFER_LEVEL_PRIMARY, &commandBuffer) ||
+			!BeginCommandBufferRecordingOperation(&commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr))
+		{
+			result = false;
+			break;
+		}
+
+		for (u32 p = batch->FirstPass; p < batch->FirstPass + batch->PassCount; ++p)
+		{
+			/* Barriers a pass leaves in the batcher go out together with the ones of the next pass */
+			RenderGraphPass* pass = &passes[order[p]];
+			RecordRenderGraphBarriers(graph, batcher, commandBuffer, &((RenderGraphBarrier*)graph->Barriers)[pass->FirstBarrier], pass->BarrierCount, RENDER_GRAPH_NONE);
+			FlushBarriers(batcher, commandBuffer);
+
+			/* The pair of timestamps is reset in the same command buffer, so no other queue has to be ordered with it */
+			bool timed = p < timedPasses;
+			if (timed)
+			{
+				RenderGraphPassTiming timing = { 0 };
+				memcpy(timing.Name, pass->Name, RENDER_GRAPH_NAME_LENGTH);
+				timing.Queue = pass->Queue;
+				timing.Async = pass->Queue != pass->DeclaredQueue;
+				vec_pushback(graph->Timings, timing, RenderGraphPassTiming);
+				vkCmdResetQueryPool(commandBuffer, graph->Timestamps, p * 2, 2);
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, graph->Timestamps, p * 2);
+			}
+			if (pass->Execute)
+				pass->Execute(commandBuffer, graph, pass->UserData);
+			if (timed)
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, graph->Timestamps, p * 2 + 1);
+		}
+		RecordRenderGraphBarriers(graph, batcher, commandBuffer, (RenderGraphBarrier*)graph->FinalBarriers, (u32)vec_length(graph->FinalBarriers), b);
+		FlushBarriers(batcher, commandBuffer);
+
+		if (!EndCommandBufferRecordingOperation(&commandBuffer))
+		{
+			result = false;
+			break;
+		}
+
+		vec_clear(waitInfos);
+		vec_clear(commandBuffers);
+		vec_clear(signalSemaphores);
+		vec_pushback(commandBuffers, commandBuffer, VkCommandBuffer);
+		for (u32 w = 0; w < waitCount; ++w)
+		{
+			if (waits[w].Consumer == b)
+			{
+				WaitSemaphoreInfo info = { semaphores[waits[w].Semaphore], waits[w].Stages };
+				vec_pushback(waitInfos, info, WaitSemaphoreInfo);
+			}
+			if (waits[w].Producer == b)
+				vec_pushback(signalSemaphores, semaphores[waits[w].Semaphore], VkSemaphore);
+		}
+		if ((b == graph->ExternalWaitBatch) && (waitSemaphore != VK_NULL_HANDLE))
+		{
+			WaitSemaphoreInfo info = { waitSemaphore, graph->ExternalWaitStages };
+			vec_pushback(waitInfos, info, WaitSemaphoreInfo);
+		}
+
+		/* The last submit waits for every other queue, so its fence covers the whole run */
+		VkFence batchFence = VK_NULL_HANDLE;
+		if (b == batchCount - 1)
+		{
+			if (signalSemaphore != VK_NULL_HANDLE)
+				vec_pushback(signalSemaphores, signalSemaphore, VkSemaphore);
+			batchFence = graph->RunFence;
+			if (vkResetFences(*graph->LogicalDevice, 1, &batchFence) != VK_SUCCESS)
+			{
+				printf("ERROR: Could not reset the fence of a render graph!\n");
+				result = false;
+				break;
+			}
+		}
+
+		result = SubmitCommandBuffersToQueue(&queues[batch->Queue], waitInfos, commandBuffers, signalSemaphores, &batchFence);
+
+		/* The fence of the caller goes on an empty submit after it, the queue signals it once the run is done */
+		if (result && (b == batchCount - 1) && fence)
+		{
+			vec_clear(waitInfos);
+			vec_clear(commandBuffers);
+			vec_clear(signalSemaphores);
+			result = SubmitCommandBuffersToQueue(&queues[batch->Queue], waitInfos, commandBuffers, signalSemaphores, fence);
+		}
+	}
+
+	/* With every pass culled nothing ran, an empty submit still waits on and signals the semaphores and fence of the
+	   caller so a frame loop waiting on them goes on. The fence of the graph stays signaled */
+	if (result && (batchCount == 0) && ((waitSemaphore != VK_NULL_HANDLE) || (signalSemaphore != VK_NULL_HANDLE) || fence))
+	{
+		vec_clear(waitInfos);
+		vec_clear(commandBuffers);
+		vec_clear(signalSemaphores);
+		if (waitSemaphore != VK_NULL_HANDLE)
+		{
+			WaitSemaphoreInfo info = { waitSemaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+			vec_pushback(waitInfos, info, WaitSemaphoreInfo);
+		}
+		if (signalSemaphore != VK_NULL_HANDLE)
+			vec_pushback(signalSemaphores, signalSemaphore, VkSemaphore);
+
+		VkFence emptyFence = fence ? *fence : VK_NULL_HANDLE;
+		result = SubmitCommandBuffersToQueue(&queues[RENDER_GRAPH_QUEUE_GRAPHICS], waitInfos, commandBuffers, signalSemaphores, &emptyFence);
+	}
+
+	vec_destroy(waitInfos);
+	vec_destroy(commandBuffers);
+	vec_destroy(signalSemaphores);
+	graph->TimestampsWritten = result && (timedPasses > 0);
+	return result;
+}
+
+/* A function to print what the last compile produced */
+/* @param A Pointer to the graph */
+void PrintRenderGraphStats(RenderGraph* graph)
+{
+	RenderGraphStats* stats = &graph->Stats;
+	printf("INFO: Render graph: %u passes (%u culled, %u async), %u resources in %u slots, %u barriers in %u batches, %u submits, %u semaphores\n",
+		stats->Passes, stats->CulledPasses, stats->AsyncPasses, stats->Resources, stats->Slots, stats->Barriers, stats->BarrierBatches, stats->Batches, stats->Semaphores);
+}
+
+/* A function to clean up created vulkan resources, the GPU must be done with every frame the graph ran */
+/* @param A pointer to the resource to cleanup */
+void DestroyRenderGraph(RenderGraph* graph)
+{
+	if (graph->LogicalDevice)
+	{
+		for (u32 i = 0; i < graph->TransientSlotCount; ++i)
+			DestroyRenderGraphSlot(graph, &((RenderGraphSlot*)graph->Slots)[i]);
+		for (u32 i = 0; i < vec_length(graph->Heaps); ++i)
+			if (((RenderGraphHeap*)graph->Heaps)[i].Memory != VK_NULL_HANDLE)
+				vkFreeMemory(*graph->LogicalDevice, ((RenderGraphHeap*)graph->Heaps)[i].Memory, nullptr);
+		for (u32 i = 0; i < vec_length(graph->Semaphores); ++i)
+			vkDestroySemaphore(*graph->LogicalDevice, ((VkSemaphore*)graph->Semaphores)[i], nullptr);
+		if (graph->Timestamps != VK_NULL_HANDLE)
+			vkDestroyQueryPool(*graph->LogicalDevice, graph->Timestamps, nullptr);
+		if (graph->RunFence != VK_NULL_HANDLE)
+			vkDestroyFence(*graph->LogicalDevice, graph->RunFence, nullptr);
+	}
+
+	vec_destroy(graph->Passes);
+	vec_destroy(graph->Resources);
+	vec_destroy(graph->Uses);
+	vec_destroy(graph->SortedUses);
+	vec_destroy(graph->Order);
+	vec_destroy(graph->Barriers);
+	vec_destroy(graph->FinalBarriers);
+	vec_destroy(graph->Batches);
+	vec_destroy(graph->Waits);
+	vec_destroy(graph->Slots);
+	vec_destroy(graph->Heaps);
+	vec_destroy(graph->Semaphores);
+	vec_destroy(graph->Timings);
+	memset(graph, 0, sizeof(RenderGraph));
+}
+
+/* A structure for how long compiling a graph of some size took */
+typedef struct {
+	u32 PassCount;			/* The passes declared */
+	double DeclareSeconds;	/* The average time to declare the passes and resources */
+	double CompileSeconds;	/* The average time to compile them */
+	RenderGraphStats Stats;	/* What the compile produced */
+} RenderGraphCompileTiming;
+
+/* A function to declare a frame like graph for the measurement, a chain of passes that mostly render but sometimes
+   run compute or copies, each writing a new target and sampling a few recent ones, with some passes nothing reads */
+/* @param A Pointer to the graph */
+/* @param The number of passes */
+void DeclareRenderGraphBenchmark(RenderGraph* graph, u32 passCount)
+{
+	VkExtent3D full = { 1920, 1080, 1 };
+	VkExtent3D half = { 960, 540, 1 };
+	VkFormat formats[3] = { VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R32_SFLOAT };
+	u32* targets = (u32*)malloc(passCount * sizeof(u32));
+	u32 random = 12345;
+
+	u32 backbuffer = ImportRenderGraphImage(graph, VK_NULL_HANDLE, VK_FORMAT_B8G8R8A8_UNORM, full, VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_SHARING_MODE_EXCLUSIVE, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+	for (u32 i = 0; i < passCount; ++i)
+	{
+		bool last = i == passCount - 1;
+		RenderGraphQueue queue = (i % 5 == 4) ? RENDER_GRAPH_QUEUE_COMPUTE : (i % 25 == 12) ? RENDER_GRAPH_QUEUE_TRANSFER : RENDER_GRAPH_QUEUE_GRAPHICS;
+		u32 pass = AddRenderGraphPass(graph, "Benchmark", last ? RENDER_GRAPH_QUEUE_GRAPHICS : queue, nullptr, nullptr);
+		targets[i] = last ? backbuffer : CreateRenderGraphImage(graph, formats[i % 3], (i % 2) ? half : full, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		u32 reads = i < 3 ? i : 3;
+		for (u32 r = 0; r < reads; ++r)
+		{
+			random = random * 1664525u + 1013904223u;
+			u32 source = i - 1 - ((random >> 16) % (i < 8 ? i : 8));
+			if ((queue == RENDER_GRAPH_QUEUE_TRANSFER) && !last)
+				UseRenderGraphResource(graph, pass, targets[source], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false);
+			else
+				ReadRenderGraphTexture(graph, pass, targets[source], (queue == RENDER_GRAPH_QUEUE_COMPUTE) && !last ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		}
+
+		if ((queue == RENDER_GRAPH_QUEUE_COMPUTE) && !last)
+			WriteRenderGraphStorage(graph, pass, targets[i]);
+		else if ((queue == RENDER_GRAPH_QUEUE_TRANSFER) && !last)
+			UseRenderGraphResource(graph, pass, targets[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+		else
+			WriteRenderGraphColorAttachment(graph, pass, targets[i]);
+	}
+
+	free(targets);
+}
+
+/* A function to measure how long declaring and compiling graphs of 50, 100, 250 and 500 passes takes on the CPU */
+/* @param The number of times each graph is declared and compiled */
+/* @param An array of 4 RenderGraphCompileTiming to be filled */
+bool MeasureRenderGraphCompile(u32 iterations, RenderGraphCompileTiming timings[4])
+{
+	const u32 passCounts[4] = { 50, 100, 250, 500 };
+	if (iterations == 0)
+		iterations = 1;
+
+	for (u32 i = 0; i < 4; ++i)
+	{
+		RenderGraph graph;
+		CreateRenderGraph(nullptr, nullptr, nullptr, &graph);
+
+		double declareSeconds = 0.0;
+		double compileSeconds = 0.0;
+		for (u32 n = 0; n < iterations; ++n)
+		{
+			double startTime = GetTimeInSeconds();
+			ResetRenderGraph(&graph);
+			DeclareRenderGraphBenchmark(&graph, passCounts[i]);
+			double declaredTime = GetTimeInSeconds();
+			if (!CompileRenderGraph(&graph))
+			{
+				DestroyRenderGraph(&graph);
+				return false;
+			}
+			compileSeconds += GetTimeInSeconds() - declaredTime;
+			declareSeconds += declaredTime - startTime;
+		}
+
+		timings[i].PassCount = passCounts[i];
+		timings[i].DeclareSeconds = declareSeconds / iterations;
+		timings[i].CompileSeconds = compileSeconds / iterations;
+		timings[i].Stats = graph.Stats;
+		printf("INFO: %u passes: declared in %.1f us, compiled in %.1f us\n", passCounts[i], timings[i].DeclareSeconds * 1000000.0, timings[i].CompileSeconds * 1000000.0);
+		PrintRenderGraphStats(&graph);
+		DestroyRenderGraph(&graph);
+	}
+
+	return true;
+}
+
+/* A function to check without a device that the external semaphore is waited on by the queue of the imported image
+   it guards, when a pass declared before it is hoisted to a compute queue of its own family. The graph renders a
+   gbuffer, runs particles async and composites both into the backbuffer */
+bool CheckRenderGraphExternalWait()
+{
+	const u32 queueFamilies[RENDER_GRAPH_QUEUE_COUNT] = { 0, 1, 2 };
+	RenderGraph graph;
+	CreateRenderGraph(nullptr, nullptr, queueFamilies, &graph);
+
+	VkExtent3D extent = { 1920, 1080, 1 };
+	u32 backbuffer = ImportRenderGraphImage(&graph, VK_NULL_HANDLE, VK_FORMAT_B8G8R8A8_UNORM, extent, VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_SHARING_MODE_EXCLUSIVE, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	u32 gbuffer = CreateRenderGraphImage(&graph, VK_FORMAT_R16G16B16A16_SFLOAT, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+	u32 particles = CreateRenderGraphBuffer(&graph, 1024 * 1024);
+
+	u32 pass = AddRenderGraphPass(&graph, "GBuffer", RENDER_GRAPH_QUEUE_GRAPHICS, nullptr, nullptr);
+	WriteRenderGraphColorAttachment(&graph, pass, gbuffer);
+	pass = AddRenderGraphPass(&graph, "Particles", RENDER_GRAPH_QUEUE_GRAPHICS, nullptr, nullptr);
+	MarkRenderGraphAsyncCompute(&graph, pass);
+	WriteRenderGraphStorage(&graph, pass, particles);
+	pass = AddRenderGraphPass(&graph, "Composite", RENDER_GRAPH_QUEUE_GRAPHICS, nullptr, nullptr);
+	ReadRenderGraphTexture(&graph, pass, gbuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	UseRenderGraphResource(&graph, pass, particles, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false);
+	WriteRenderGraphColorAttachment(&graph, pass, backbuffer);
+
+	bool result = CompileRenderGraph(&graph) && (graph.Stats.AsyncPasses == 1) && (graph.ExternalWaitBatch != RENDER_GRAPH_NONE);
+	if (result)
+	{
+		/* The wait goes on the submit of the composite, and the layout change of the backbuffer is chained to it */
+		RenderGraphPass* composite = &((RenderGraphPass*)graph.Passes)[pass];
+		RenderGraphBatch* batch = &((RenderGraphBatch*)graph.Batches)[graph.ExternalWaitBatch];
+		result = (batch->Queue == RENDER_GRAPH_QUEUE_GRAPHICS) && (composite->Batch == graph.ExternalWaitBatch) &&
+			(graph.ExternalWaitStages == VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+		u32 slot = ((RenderGraphResource*)graph.Resources)[backbuffer].Slot;
+		RenderGraphBarrier* barriers = &((RenderGraphBarrier*)graph.Barriers)[composite->FirstBarrier];
+		for (u32 i = 0; i < composite->BarrierCount; ++i)
+			if (barriers[i].Slot == slot)
+				result &= barriers[i].SrcStages == VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	}
+
+	if (!result)
+		printf("ERROR: The render graph waits on the external semaphore on a queue that does not use the imported image!\n");
+	DestroyRenderGraph(&graph);
+	return result;
+}
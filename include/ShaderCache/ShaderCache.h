@@ -0,0 +1,301 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <FileHelper/FileHelper.h>
+#include <Hash/Hash.h>
+
+#define SHADER_CACHE_MAGIC 0x4353504E		/* "NPSC" */
+#define SHADER_CACHE_VERSION 2				/* Bump when the key or the file layout changes */
+#define SHADER_CACHE_INDEX_NAME "index.bin"
+#define SPIRV_MAGIC 0x07230203
+
+/* A structure for the header of the cache index file */
+typedef struct {
+	u32 Magic;		/* SHADER_CACHE_MAGIC */
+	u32 Version;	/* SHADER_CACHE_VERSION */
+	u64 Count;		/* The number of entries after the header */
+	u64 Tick;		/* The use counter, so the LRU order survives restarts */
+} ShaderCacheIndexHeader;
+
+/* A structure for a SPIR-V blob in the cache */
+typedef struct {
+	u64 Key;		/* The hash of everything the SPIR-V was built from, also the file name */
+	u64 Size;		/* The size of the SPIR-V in bytes */
+	u64 LastUse;	/* The tick of the last load or store */
+} ShaderCacheEntry;
+
+/* A structure for the cache statistics */
+typedef struct {
+	u32 Hits;				/* Shaders loaded from the cache */
+	u32 Misses;				/* Shaders that had to be compiled */
+	u32 Stores;				/* SPIR-V blobs written to the cache */
+	u32 Evictions;			/* SPIR-V blobs removed to stay under the size cap */
+	double LoadSeconds;		/* Time spent getting shaders from the cache, key included */
+	double CompileSeconds;	/* Time spent compiling the misses, key included */
+} ShaderCacheStats;
+
+/* A structure for the on disk SPIR-V cache */
+typedef struct {
+	char Directory[FILE_PATH_LENGTH];	/* Where the blobs and the index are */
+	u64 MaxSize;						/* The size cap of all blobs in bytes */
+	u64 TotalSize;						/* The size of all blobs in bytes */
+	u64 Tick;							/* The use counter */
+	Vec Entries;						/* A Vector of ShaderCacheEntry */
+	bool Dirty;							/* The index has to be written back */
+	Mutex Lock;							/* Guards everything above and the statistics */
+	ShaderCacheStats Stats;				/* The statistics */
+} ShaderCache;
+
+/* A function for getting the path of a blob in the cache */
+/* @param A Pointer to the cache */
+/* @param The key of the blob */
+/* @param A Pointer to a buffer of FILE_PATH_LENGTH characters to be filled */
+void GetShaderCachePath(ShaderCache* cache, u64 key, char* path)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)key);
+	JoinPath(cache->Directory, name, path);
+}
+
+/* A function for finding the entry of a key, returns -1 if there is none, the lock must be held */
+/* @param A Pointer to the cache */
+/* @param The key */
+i64 FindShaderCacheEntry(ShaderCache* cache, u64 key)
+{
+	for (u64 i = 0; i < vec_length(cache->Entries); ++i)
+		if (((ShaderCacheEntry*)cache->Entries)[i].Key == key)
+			return (i64)i;
+	return -1;
+}
+
+/* A function to remove an entry and its blob, the lock must be held */
+/* @param A Pointer to the cache */
+/* @param The index of the entry */
+void EvictShaderCacheEntry(ShaderCache* cache, u64 index)
+{
+	ShaderCacheEntry* entries = (ShaderCacheEntry*)cache->Entries;
+	char path[FILE_PATH_LENGTH];
+	GetShaderCachePath(cache, entries[index].Key, path);
+	remove(path);
+
+	cache->TotalSize -= entries[index].Size;
+	entries[index] = entries[vec_length(cache->Entries) - 1];
+	vec_length_set(cache->Entries, vec_length(cache->Entries) - 1);
+	cache->Dirty = true;
+}
+
+/* A function to create the SPIR-V cache and read its index */
+/* @param The directory of the cache, it is created if missing */
+/* @param The size cap of all blobs in bytes */
+/* @param A Pointer to the ShaderCache to be filled */
+bool CreateShaderCache(const char* directory, u64 maxSize, ShaderCache* cache)
+{
+	memset(cache, 0, sizeof(ShaderCache));
+	snprintf(cache->Directory, FILE_PATH_LENGTH, "%s", directory);
+	cache->MaxSize = maxSize;
+	cache->Entries = vec_create(ShaderCacheEntry);
+	InitializeMutex(&cache->Lock);
+
+	if (!CreateDirectoryIfMissing(directory))
+		return false;
+
+	char indexPath[FILE_PATH_LENGTH];
+	JoinPath(directory, SHADER_CACHE_INDEX_NAME, indexPath);
+	if (GetFileModificationTime(indexPath) == 0)
+		return true;
+
+	char* data = nullptr;
+	u64 size = 0;
+	if (!ReadWholeFile(indexPath, &size, &data))
+		return true;
+
+	/* A broken or old index just means starting with an empty cache, stale blobs get overwritten */
+	ShaderCacheIndexHeader* header = (ShaderCacheIndexHeader*)data;
+	if ((size < sizeof(ShaderCacheIndexHeader)) || (header->Magic != SHADER_CACHE_MAGIC) || (header->Version != SHADER_CACHE_VERSION) ||
+		(size != sizeof(ShaderCacheIndexHeader) + header->Count * sizeof(ShaderCacheEntry)))
+	{
+		printf("WARNING: The shader cache index %s is not valid, starting with an empty cache\n", indexPath);
+		free(data);
+		return true;
+	}
+
+	ShaderCacheEntry* entries = (ShaderCacheEntry*)(header + 1);
+	for (u64 i = 0; i < header->Count; ++i)
+	{
+		vec_pushback(cache->Entries, entries[i], ShaderCacheEntry);
+		cache->TotalSize += entries[i].Size;
+	}
+	cache->Tick = header->Tick;
+	free(data);
+
+	printf("INFO: Shader cache has %llu entries with %llu bytes\n", (unsigned long long)vec_length(cache->Entries), (unsigned long long)cache->TotalSize);
+	return true;
+}
+
+/* A function to memory map the SPIR-V of a key, returns false on a miss */
+/* @param A Pointer to the cache */
+/* @param The key */
+/* @param A Pointer to the MappedFile to be filled, it must be unmapped with UnmapFile */
+bool LoadFromShaderCache(ShaderCache* cache, u64 key, MappedFile* mappedFile)
+{
+	char path[FILE_PATH_LENGTH];
+	GetShaderCachePath(cache, key, path);
+
+	LockMutex(&cache->Lock);
+	i64 index = FindShaderCacheEntry(cache, key);
+	UnlockMutex(&cache->Lock);
+
+	bool valid = (index >= 0) && MapFile(path, mappedFile);
+	if (valid && ((mappedFile->Size % sizeof(u32) != 0) || (((const u32*)mappedFile->Data)[0] != SPIRV_MAGIC)))
+	{
+		printf("WARNING: The cached shader %s is not valid SPIR-V\n", path);
+		UnmapFile(mappedFile);
+		valid = false;
+	}
+
+	LockMutex(&cache->Lock);
+	index = FindShaderCacheEntry(cache, key);
+	if (valid && (index >= 0))
+	{
+		((ShaderCacheEntry*)cache->Entries)[index].LastUse = ++cache->Tick;
+		++cache->Stats.Hits;
+		cache->Dirty = true;
+	}
+	else
+	{
+		/* The entry can be gone since the blob is missing, broken or another thread evicted it */
+		if (index >= 0)
+			EvictShaderCacheEntry(cache, (u64)index);
+		if (valid)
+			UnmapFile(mappedFile);
+		valid = false;
+		++cache->Stats.Misses;
+	}
+	UnlockMutex(&cache->Lock);
+
+	return valid;
+}
+
+/* A function to write SPIR-V to the cache, the least recently used blobs are removed to stay under the size cap */
+/* @param A Pointer to the cache */
+/* @param The key */
+/* @param A Pointer to the SPIR-V */
+/* @param The size of the SPIR-V in bytes */
+bool StoreInShaderCache(ShaderCache* cache, u64 key, const void* spirv, u64 size)
+{
+	if (size > cache->MaxSize)
+		return false;
+
+	char path[FILE_PATH_LENGTH];
+	GetShaderCachePath(cache, key, path);
+	if (!WriteWholeFileAtomic(path, spirv, size))
+		return false;
+
+	LockMutex(&cache->Lock);
+
+	i64 index = FindShaderCacheEntry(cache, key);
+	if (index >= 0)
+	{
+		ShaderCacheEntry* entry = &((ShaderCacheEntry*)cache->Entries)[index];
+		cache->TotalSize -= entry->Size;
+		entry->Size = size;
+		entry->LastUse = ++cache->Tick;
+	}
+	else
+	{
+		ShaderCacheEntry entry = { key, size, ++cache->Tick };
+		vec_pushback(cache->Entries, entry, ShaderCacheEntry);
+	}
+	cache->TotalSize += size;
+
+	while (cache->TotalSize > cache->MaxSize)
+	{
+		ShaderCacheEntry* entries = (ShaderCacheEntry*)cache->Entries;
+		u64 oldest = 0;
+		for (u64 i = 1; i < vec_length(cache->Entries); ++i)
+			if (entries[i].LastUse < entries[oldest].LastUse)
+				oldest = i;
+		EvictShaderCacheEntry(cache, oldest);
+		++cache->Stats.Evictions;
+	}
+
+	++cache->Stats.Stores;
+	cache->Dirty = true;
+	UnlockMutex(&cache->Lock);
+	return true;
+}
+
+/* A function to remove the SPIR-V of a key from the cache */
+/* @param A Pointer to the cache */
+/* @param The key */
+void RemoveFromShaderCache(ShaderCache* cache, u64 key)
+{
+	LockMutex(&cache->Lock);
+	i64 index = FindShaderCacheEntry(cache, key);
+	if (index >= 0)
+		EvictShaderCacheEntry(cache, (u64)index);
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function to add the time a shader took to the statistics */
+/* @param A Pointer to the cache */
+/* @param True if the shader came from the cache */
+/* @param The time in seconds */
+void RecordShaderCacheTime(ShaderCache* cache, bool hit, double seconds)
+{
+	LockMutex(&cache->Lock);
+	if (hit)
+		cache->Stats.LoadSeconds += seconds;
+	else
+		cache->Stats.CompileSeconds += seconds;
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function for getting the cache statistics */
+/* @param A Pointer to the cache */
+/* @param A Pointer to the ShaderCacheStats to be filled */
+void GetShaderCacheStats(ShaderCache* cache, ShaderCacheStats* stats)
+{
+	LockMutex(&cache->Lock);
+	*stats = cache->Stats;
+	UnlockMutex(&cache->Lock);
+}
+
+/* A function to write the index of the cache if it changed */
+/* @param A Pointer to the cache */
+bool SaveShaderCacheIndex(ShaderCache* cache)
+{
+	LockMutex(&cache->Lock);
+	if (!cache->Dirty)
+	{
+		UnlockMutex(&cache->Lock);
+		return true;
+	}
+
+	u64 count = vec_length(cache->Entries);
+	u64 size = sizeof(ShaderCacheIndexHeader) + count * sizeof(ShaderCacheEntry);
+	ShaderCacheIndexHeader* header = (ShaderCacheIndexHeader*)malloc(size);
+	header->Magic = SHADER_CACHE_MAGIC;
+	header->Version = SHADER_CACHE_VERSION;
+	header->Count = count;
+	header->Tick = cache->Tick;
+	memcpy(header + 1, cache->Entries, count * sizeof(ShaderCacheEntry));
+	cache->Dirty = false;
+	UnlockMutex(&cache->Lock);
+
+	char indexPath[FILE_PATH_LENGTH];
+	JoinPath(cache->Directory, SHADER_CACHE_INDEX_NAME, indexPath);
+	bool result = WriteWholeFileAtomic(indexPath, header, size);
+	free(header);
+	return result;
+}
+
+/* A function to clean up the cache, the index is written first */
+/* @param A pointer to the cache to cleanup */
+void DestroyShaderCache(ShaderCache* cache)
+{
+	SaveShaderCacheIndex(cache);
+	vec_destroy(cache->Entries);
+	DestroyMutex(&cache->Lock);
+	memset(cache, 0, sizeof(ShaderCache));
+}
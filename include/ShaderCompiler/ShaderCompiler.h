@@ -0,0 +1,836 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <FileHelper/FileHelper.h>
+#include <ShaderCache/ShaderCache.h>
+#include <ShaderOptimizer/ShaderOptimizer.h>
+#include <shaderc/shaderc.h>
+
+#define SHADER_MAX_MACROS 16
+#define SHADER_MAX_INCLUDE_DIRECTORIES 8
+#define SHADER_NAME_LENGTH 64
+#define SHADER_HOT_RELOAD_INTERVAL 250	/* How often the watcher looks at the shader files in milliseconds */
+
+/* The source languages the compiler understands */
+typedef enum {
+	SHADER_LANGUAGE_GLSL,
+	SHADER_LANGUAGE_HLSL
+} ShaderLanguage;
+
+/* The states of a shader */
+typedef enum {
+	SHADER_STATE_COMPILING,		/* No SPIR-V yet */
+	SHADER_STATE_READY,			/* SPIR-V is there, a newer one can still be compiling */
+	SHADER_STATE_FAILED			/* The first compile failed, a change to the file retries it */
+} ShaderState;
+
+/* A structure for a macro define */
+typedef struct {
+	char Name[SHADER_NAME_LENGTH];		/* The name of the macro */
+	char Value[SHADER_NAME_LENGTH];		/* The value of the macro, empty for just defining it */
+} ShaderMacro;
+
+/* A structure describing what to compile, it has no pointers so it can be copied and hashed as is */
+typedef struct {
+	char Path[FILE_PATH_LENGTH];			/* The source file */
+	VkShaderStageFlagBits Stage;			/* The stage the shader is for */
+	ShaderLanguage Language;				/* GLSL or HLSL */
+	char EntryPoint[SHADER_NAME_LENGTH];	/* The entry point, "main" for GLSL */
+	ShaderMacro Macros[SHADER_MAX_MACROS];	/* The macro defines of this permutation */
+	u32 MacroCount;							/* The number of macro defines */
+	bool DebugInfo;							/* Keep debug info */
+	ShaderOptimizationPreset Optimization;	/* The spirv-opt passes to run after compiling */
+} ShaderDescription;
+
+/* A structure for a file a shader was built from and when it was last changed */
+typedef struct {
+	char Path[FILE_PATH_LENGTH];	/* The path of the file */
+	i64 ModifiedTime;				/* The modification time the compile saw */
+} ShaderDependency;
+
+/* A structure for a compiled shader */
+typedef struct {
+	ShaderDescription Description;	/* What the shader is compiled from */
+	volatile i32 State;				/* A ShaderState */
+	volatile i32 Pending;			/* 1 while a compile is queued or running */
+	u32* Spirv;						/* The newest SPIR-V that compiled, points into Mapping if it came from the cache */
+	MappedFile Mapping;				/* The mapped cache blob, empty if the SPIR-V was compiled */
+	u64 SpirvSize;					/* The size of the SPIR-V in bytes */
+	u32 Generation;					/* Increased every time new SPIR-V is published */
+	Vec Dependencies;				/* A Vector of ShaderDependency, the source file comes first */
+	char* Errors;					/* The messages of the last failed compile */
+	ShaderOptimizationStats Optimization;	/* What the optimizer did to the current SPIR-V */
+} Shader;
+
+/* A handle to a shader of the compiler */
+typedef u32 ShaderHandle;
+
+/* A structure for the shader compilation service */
+typedef struct {
+	shaderc_compiler_t Compiler;	/* Safe to use from many threads at once */
+	ShaderCache* Cache;				/* The SPIR-V cache, can be null */
+	char IncludeDirectories[SHADER_MAX_INCLUDE_DIRECTORIES][FILE_PATH_LENGTH];	/* Where <> includes are looked for */
+	u32 IncludeDirectoryCount;		/* The number of include directories */
+	ThreadPool Pool;				/* The threads compiling the shaders */
+	Mutex Lock;						/* Guards Shaders, Reloaded and the SPIR-V, dependencies and errors of every shader */
+	Vec Shaders;					/* A Vector of Shader*, the handle is the index */
+	Vec Reloaded;					/* A Vector of ShaderHandle which got new SPIR-V the render thread has not taken yet */
+	Thread Watcher;					/* The thread looking for changed files */
+	volatile i32 Watching;			/* 1 while the watcher runs */
+} ShaderCompiler;
+
+/* A structure handed to a worker to compile one shader */
+typedef struct {
+	ShaderCompiler* Compiler;	/* The compiler */
+	ShaderHandle Handle;		/* The shader to compile */
+} ShaderCompileTask;
+
+/* A structure handed to shaderc while resolving includes */
+typedef struct {
+	ShaderCompiler* Compiler;	/* The compiler with the include directories */
+	Vec Dependencies;			/* A Vector of ShaderDependency collecting every included file */
+} ShaderIncludeContext;
+
+/* A structure for a resolved include, the shaderc result comes first so the pointer can be cast back */
+typedef struct {
+	shaderc_include_result Result;	/* What shaderc reads */
+	char Path[FILE_PATH_LENGTH];	/* The resolved path */
+	char* Content;					/* The content of the file, or the error message */
+} ShaderInclude;
+
+/* A function to fill a shader description with the defaults */
+/* @param The source file */
+/* @param The stage the shader is for */
+/* @param GLSL or HLSL */
+/* @param A Pointer to the ShaderDescription to be filled */
+void InitializeShaderDescription(const char* path, VkShaderStageFlagBits stage, ShaderLanguage language, ShaderDescription* description)
+{
+	memset(description, 0, sizeof(ShaderDescription));
+	snprintf(description->Path, FILE_PATH_LENGTH, "%s", path);
+	snprintf(description->EntryPoint, SHADER_NAME_LENGTH, "main");
+	description->Stage = stage;
+	description->Language = language;
+	description->Optimization = SHADER_OPTIMIZATION_DEFAULT;
+}
+
+/* A function to add a macro define to a shader description */
+/* @param A Pointer to the shader description */
+/* @param The name of the macro */
+/* @param The value of the macro, can be null */
+bool AddShaderMacro(ShaderDescription* description, const char* name, const char* value)
+{
+	if (description->MacroCount == SHADER_MAX_MACROS)
+	{
+		printf("ERROR: A shader can not have more than %d macros!\n", SHADER_MAX_MACROS);
+		return false;
+	}
+
+	ShaderMacro* macro = &description->Macros[description->MacroCount++];
+	snprintf(macro->Name, SHADER_NAME_LENGTH, "%s", name);
+	snprintf(macro->Value, SHADER_NAME_LENGTH, "%s", value ? value : "");
+	return true;
+}
+
+/* A function for getting the shaderc kind of a shader stage */
+/* @param The shader stage */
+shaderc_shader_kind GetShadercShaderKind(VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT:					return shaderc_vertex_shader;
+	case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:		return shaderc_tess_control_shader;
+	case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:	return shaderc_tess_evaluation_shader;
+	case VK_SHADER_STAGE_GEOMETRY_BIT:					return shaderc_geometry_shader;
+	case VK_SHADER_STAGE_FRAGMENT_BIT:					return shaderc_fragment_shader;
+	case VK_SHADER_STAGE_COMPUTE_BIT:					return shaderc_compute_shader;
+	case VK_SHADER_STAGE_TASK_BIT_EXT:					return shaderc_task_shader;
+	case VK_SHADER_STAGE_MESH_BIT_EXT:					return shaderc_mesh_shader;
+	default:											return shaderc_glsl_infer_from_source;
+	}
+}
+
+/* A function to add a file to a list of dependencies if it is not there yet */
+/* @param A Pointer to the Vector of ShaderDependency */
+/* @param The path of the file */
+void AddShaderDependency(Vec* dependencies, const char* path)
+{
+	for (u64 i = 0; i < vec_length(*dependencies); ++i)
+		if (strcmp(((ShaderDependency*)*dependencies)[i].Path, path) == 0)
+			return;
+
+	ShaderDependency dependency;
+	snprintf(dependency.Path, FILE_PATH_LENGTH, "%s", path);
+	dependency.ModifiedTime = GetFileModificationTime(path);
+	vec_pushback(*dependencies, dependency, ShaderDependency);
+}
+
+/* A function for finding the file of an #include, "" includes look next to the including file first, then everywhere <> includes look */
+/* @param A Pointer to the compiler */
+/* @param The name in the #include */
+/* @param True for "" includes */
+/* @param The file the #include is in */
+/* @param A Pointer to a buffer of FILE_PATH_LENGTH characters to be filled */
+bool FindShaderInclude(ShaderCompiler* compiler, const char* requestedSource, bool relative, const char* requestingSource, char* path)
+{
+	if (relative)
+	{
+		char directory[FILE_PATH_LENGTH];
+		GetPathDirectory(requestingSource, directory);
+		JoinPath(directory, requestedSource, path);
+		if (GetFileModificationTime(path) != 0)
+			return true;
+	}
+
+	for (u32 i = 0; i < compiler->IncludeDirectoryCount; ++i)
+	{
+		JoinPath(compiler->IncludeDirectories[i], requestedSource, path);
+		if (GetFileModificationTime(path) != 0)
+			return true;
+	}
+
+	return false;
+}
+
+/* A function to hash a source file and every file it includes, without compiling anything */
+/* @param A Pointer to the compiler */
+/* @param The path of the file */
+/* @param How deep the include is nested */
+/* @param A Pointer to the Vector of ShaderDependency collecting the files */
+/* @param A Pointer to the hash to continue */
+bool HashShaderSourceTree(ShaderCompiler* compiler, const char* path, u32 depth, Vec* dependencies, u64* hash)
+{
+	char* source = nullptr;
+	u64 size = 0;
+	if ((depth > 32) || !ReadWholeFile(path, &size, &source))
+		return false;
+
+	AddShaderDependency(dependencies, path);
+	*hash = HashString(path, *hash);
+	*hash = HashBytes(source, size, *hash);
+
+	/* Every #include line counts, even in disabled #if blocks, that only makes the key more specific than needed */
+	for (char* line = source; line != nullptr; line = strchr(line, '\n'), line = line ? line + 1 : nullptr)
+	{
+		char* c = line;
+		while ((*c == ' ') || (*c == '\t')) ++c;
+		if (*c++ != '#') continue;
+		while ((*c == ' ') || (*c == '\t')) ++c;
+		if (strncmp(c, "include", 7) != 0) continue;
+		c += 7;
+		while ((*c == ' ') || (*c == '\t')) ++c;
+
+		char close = (*c == '"') ? '"' : (*c == '<') ? '>' : '\0';
+		char* end = close ? strchr(c + 1, close) : nullptr;
+		if ((end == nullptr) || (end - c - 1 >= FILE_PATH_LENGTH))
+			continue;
+
+		char name[FILE_PATH_LENGTH];
+		memcpy(name, c + 1, end - c - 1);
+		name[end - c - 1] = '\0';
+
+		char includePath[FILE_PATH_LENGTH];
+		bool visited = false;
+		if (FindShaderInclude(compiler, name, close == '"', path, includePath))
+		{
+			for (u64 i = 0; i < vec_length(*dependencies); ++i)
+				visited = visited || (strcmp(((ShaderDependency*)*dependencies)[i].Path, includePath) == 0);
+			if (!visited && !HashShaderSourceTree(compiler, includePath, depth + 1, dependencies, hash))
+			{
+				free(source);
+				return false;
+			}
+		}
+		else
+			*hash = HashString(name, *hash);	/* A missing include is hashed by name, the compile reports it if it matters */
+	}
+
+	free(source);
+	return true;
+}
+
+/* A function to compute the cache key of a shader from its sources, includes, macros and compiler options */
+/* @param A Pointer to the compiler */
+/* @param A Pointer to the description of the shader */
+/* @param A Pointer to the Vector of ShaderDependency collecting the files */
+/* @param A Pointer to the key to be filled */
+bool ComputeShaderCacheKey(ShaderCompiler* compiler, ShaderDescription* description, Vec* dependencies, u64* key)
+{
+	u64 hash = HashU64(SHADER_CACHE_VERSION, HASH_SEED);
+	hash = HashU64(VK_HEADER_VERSION, hash);	/* Stands in for the shaderc version, which ships with the SDK */
+	hash = HashU64(shaderc_env_version_vulkan_1_2, hash);
+	hash = HashU64(description->Stage, hash);
+	hash = HashU64(description->Language, hash);
+	hash = HashU64(description->DebugInfo, hash);
+	hash = HashU64(description->Optimization, hash);
+	hash = HashString(description->EntryPoint, hash);
+	for (u32 i = 0; i < description->MacroCount; ++i)
+	{
+		hash = HashString(description->Macros[i].Name, hash);
+		hash = HashString(description->Macros[i].Value, hash);
+	}
+	for (u32 i = 0; i < compiler->IncludeDirectoryCount; ++i)
+		hash = HashString(compiler->IncludeDirectories[i], hash);
+
+	if (!HashShaderSourceTree(compiler, description->Path, 0, dependencies, &hash))
+		return false;
+
+	*key = hash;
+	return true;
+}
+
+/* The function shaderc calls for every #include */
+/* @param A Pointer to the ShaderIncludeContext */
+/* @param The name in the #include */
+/* @param shaderc_include_type_relative for "" and shaderc_include_type_standard for <> */
+/* @param The file the #include is in */
+/* @param How deep the include is nested */
+shaderc_include_result* ResolveShaderInclude(void* userData, const char* requestedSource, int type, const char* requestingSource, size_t includeDepth)
+{
+	ShaderIncludeContext* context = (ShaderIncludeContext*)userData;
+	ShaderInclude* include = (ShaderInclude*)calloc(1, sizeof(ShaderInclude));
+	u64 size = 0;
+	bool found = FindShaderInclude(context->Compiler, requestedSource, type == shaderc_include_type_relative, requestingSource, include->Path);
+
+	if (found && ReadWholeFile(include->Path, &size, &include->Content))
+	{
+		AddShaderDependency(&context->Dependencies, include->Path);
+		include->Result.source_name = include->Path;
+		include->Result.source_name_length = strlen(include->Path);
+		include->Result.content = include->Content;
+		include->Result.content_length = (size_t)size;
+	}
+	else
+	{
+		/* shaderc wants an empty name and the error as the content */
+		include->Path[0] = '\0';
+		include->Content = (char*)malloc(FILE_PATH_LENGTH + 32);
+		snprintf(include->Content, FILE_PATH_LENGTH + 32, "Could not find the include %s", requestedSource);
+		include->Result.source_name = include->Path;
+		include->Result.source_name_length = 0;
+		include->Result.content = include->Content;
+		include->Result.content_length = strlen(include->Content);
+	}
+
+	include->Result.user_data = include;
+	return &include->Result;
+}
+
+/* The function shaderc calls when it is done with an include */
+/* @param A Pointer to the ShaderIncludeContext */
+/* @param A Pointer to the include result */
+void ReleaseShaderInclude(void* userData, shaderc_include_result* result)
+{
+	ShaderInclude* include = (ShaderInclude*)result->user_data;
+	free(include->Content);
+	free(include);
+}
+
+/* A function for getting a shader of the compiler, the lock must be held */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+Shader* GetShader(ShaderCompiler* compiler, ShaderHandle handle)
+{
+	return ((Shader**)compiler->Shaders)[handle];
+}
+
+/* A function to free the SPIR-V of a shader, the lock must be held */
+/* @param A Pointer to the shader */
+void ReleaseShaderSpirv(Shader* shader)
+{
+	if (shader->Mapping.Data != nullptr)
+		UnmapFile(&shader->Mapping);
+	else
+		free(shader->Spirv);
+	shader->Spirv = nullptr;
+	shader->SpirvSize = 0;
+}
+
+/* A function to make new SPIR-V the current one of a shader, the lock must be held */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+/* @param A Pointer to the shader */
+void PublishShaderSpirv(ShaderCompiler* compiler, ShaderHandle handle, Shader* shader)
+{
+	/* The first SPIR-V is picked up when the shader is created, only later ones are reloads */
+	if (++shader->Generation > 1)
+		vec_pushback(compiler->Reloaded, handle, ShaderHandle);
+	free(shader->Errors);
+	shader->Errors = nullptr;
+	AtomicStore32(&shader->State, SHADER_STATE_READY);
+}
+
+/* A function to compile a shader on the calling thread and publish the SPIR-V if it succeeds */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+bool CompileShaderNow(ShaderCompiler* compiler, ShaderHandle handle)
+{
+	LockMutex(&compiler->Lock);
+	Shader* shader = GetShader(compiler, handle);
+	UnlockMutex(&compiler->Lock);
+
+	/* The description never changes after the shader is added, so it can be read without the lock */
+	ShaderDescription* description = &shader->Description;
+	double startTime = GetTimeInSeconds();
+	u64 key = 0;
+	bool keyed = false;
+
+	if (compiler->Cache)
+	{
+		MappedFile mappedFile;
+		Vec dependencies = vec_create(ShaderDependency);
+		keyed = ComputeShaderCacheKey(compiler, description, &dependencies, &key);
+
+		if (keyed && LoadFromShaderCache(compiler->Cache, key, &mappedFile))
+		{
+			LockMutex(&compiler->Lock);
+			ReleaseShaderSpirv(shader);
+			shader->Mapping = mappedFile;
+			shader->Spirv = (u32*)mappedFile.Data;
+			shader->SpirvSize = mappedFile.Size;
+			memset(&shader->Optimization, 0, sizeof(ShaderOptimizationStats));
+			shader->Optimization.Preset = description->Optimization;
+			shader->Optimization.InstructionsAfter = CountSpirvInstructions(shader->Spirv, shader->SpirvSize);
+			shader->Optimization.SizeAfter = shader->SpirvSize;
+			vec_destroy(shader->Dependencies);
+			shader->Dependencies = dependencies;
+			PublishShaderSpirv(compiler, handle, shader);
+			AtomicStore32(&shader->Pending, 0);
+			UnlockMutex(&compiler->Lock);
+
+			RecordShaderCacheTime(compiler->Cache, true, GetTimeInSeconds() - startTime);
+			return true;
+		}
+		vec_destroy(dependencies);
+	}
+
+	ShaderIncludeContext context = { compiler, vec_create(ShaderDependency) };
+
+	/* The times are taken before reading, so an edit during the compile still triggers another one */
+	AddShaderDependency(&context.Dependencies, description->Path);
+
+	char* source = nullptr;
+	u64 sourceSize = 0;
+	shaderc_compilation_result_t result = nullptr;
+	bool success = false;
+
+	if (ReadWholeFile(description->Path, &sourceSize, &source))
+	{
+		shaderc_compile_options_t options = shaderc_compile_options_initialize();
+		shaderc_compile_options_set_source_language(options,
+			description->Language == SHADER_LANGUAGE_HLSL ? shaderc_source_language_hlsl : shaderc_source_language_glsl);
+		shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		shaderc_compile_options_set_include_callbacks(options, ResolveShaderInclude, ReleaseShaderInclude, &context);
+
+		/* shaderc only emits the SPIR-V, the optimization stage below runs the passes the description asks for */
+		shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_zero);
+		if (description->DebugInfo)
+			shaderc_compile_options_set_generate_debug_info(options);
+
+		for (u32 i = 0; i < description->MacroCount; ++i)
+		{
+			ShaderMacro* macro = &description->Macros[i];
+			shaderc_compile_options_add_macro_definition(options, macro->Name, strlen(macro->Name), macro->Value, strlen(macro->Value));
+		}
+
+		result = shaderc_compile_into_spv(compiler->Compiler, source, (size_t)sourceSize, GetShadercShaderKind(description->Stage),
+			description->Path, description->EntryPoint, options);
+		success = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+
+		shaderc_compile_options_release(options);
+		free(source);
+	}
+
+	u32* spirv = nullptr;
+	u64 spirvSize = 0;
+	ShaderOptimizationStats optimization = { SHADER_OPTIMIZATION_NONE };
+
+	if (success)
+	{
+		const u32* compiled = (const u32*)shaderc_result_get_bytes(result);
+		u64 compiledSize = shaderc_result_get_length(result);
+
+		if (!OptimizeSpirv(description->Optimization, compiled, compiledSize, &spirv, &spirvSize, &optimization))
+		{
+			spirvSize = compiledSize;
+			spirv = (u32*)malloc((size_t)spirvSize);
+			memcpy(spirv, compiled, (size_t)spirvSize);
+			optimization.InstructionsBefore = optimization.InstructionsAfter = CountSpirvInstructions(spirv, spirvSize);
+			optimization.SizeBefore = optimization.SizeAfter = spirvSize;
+		}
+		else
+			printf("INFO: Optimized the shader %s from %u to %u instructions\n", description->Path,
+				optimization.InstructionsBefore, optimization.InstructionsAfter);
+
+		/* Stored before publishing, once it is published a reload may free it */
+		if (keyed)
+			StoreInShaderCache(compiler->Cache, key, spirv, spirvSize);
+	}
+
+	LockMutex(&compiler->Lock);
+
+	vec_destroy(shader->Dependencies);
+	shader->Dependencies = context.Dependencies;
+
+	if (success)
+	{
+		ReleaseShaderSpirv(shader);
+		shader->Spirv = spirv;
+		shader->SpirvSize = spirvSize;
+		shader->Optimization = optimization;
+		PublishShaderSpirv(compiler, handle, shader);
+	}
+	else
+	{
+		const char* message = result ? shaderc_result_get_error_message(result) : "Could not read the source file";
+		free(shader->Errors);
+		shader->Errors = (char*)malloc(strlen(message) + 1);
+		strcpy(shader->Errors, message);
+		printf("ERROR: Could not compile the shader %s!\n%s\n", description->Path, message);
+
+		/* A failed reload keeps the old SPIR-V, so the render thread keeps drawing with it */
+		if (shader->Spirv == nullptr)
+			AtomicStore32(&shader->State, SHADER_STATE_FAILED);
+	}
+
+	AtomicStore32(&shader->Pending, 0);
+	UnlockMutex(&compiler->Lock);
+
+	if (result)
+		shaderc_result_release(result);
+
+	if (compiler->Cache)
+		RecordShaderCacheTime(compiler->Cache, false, GetTimeInSeconds() - startTime);
+	return success;
+}
+
+/* The function a worker runs for a compile task */
+/* @param A Pointer to the ShaderCompileTask */
+void ShaderCompileWorker(void* argument)
+{
+	ShaderCompileTask* task = (ShaderCompileTask*)argument;
+	CompileShaderNow(task->Compiler, task->Handle);
+	free(task);
+}
+
+/* A function to queue a compile of a shader on the thread pool, it does nothing if one is already queued */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+void QueueShaderCompile(ShaderCompiler* compiler, ShaderHandle handle)
+{
+	LockMutex(&compiler->Lock);
+	Shader* shader = GetShader(compiler, handle);
+	UnlockMutex(&compiler->Lock);
+
+	if (!AtomicCompareExchange32(&shader->Pending, 0, 1))
+		return;
+
+	ShaderCompileTask* task = (ShaderCompileTask*)malloc(sizeof(ShaderCompileTask));
+	task->Compiler = compiler;
+	task->Handle = handle;
+	SubmitThreadPoolTask(&compiler->Pool, ShaderCompileWorker, task);
+}
+
+/* A function to create the shader compilation service */
+/* @param The number of compile threads, 0 uses one per processor */
+/* @param An array of include directories, can be null */
+/* @param The number of include directories */
+/* @param A Pointer to the SPIR-V cache, can be null */
+/* @param A Pointer to the ShaderCompiler to be filled */
+bool CreateShaderCompiler(u32 threadCount, const char** includeDirectories, u32 includeDirectoryCount, ShaderCache* cache, ShaderCompiler* compiler)
+{
+	memset(compiler, 0, sizeof(ShaderCompiler));
+
+	if (includeDirectoryCount > SHADER_MAX_INCLUDE_DIRECTORIES)
+	{
+		printf("ERROR: The shader compiler can not have more than %d include directories!\n", SHADER_MAX_INCLUDE_DIRECTORIES);
+		return false;
+	}
+
+	compiler->Compiler = shaderc_compiler_initialize();
+	if (compiler->Compiler == nullptr)
+	{
+		printf("ERROR: Could not initialize shaderc!\n");
+		return false;
+	}
+
+	for (u32 i = 0; i < includeDirectoryCount; ++i)
+		snprintf(compiler->IncludeDirectories[i], FILE_PATH_LENGTH, "%s", includeDirectories[i]);
+	compiler->IncludeDirectoryCount = includeDirectoryCount;
+	compiler->Cache = cache;
+
+	compiler->Shaders = vec_create(Shader*);
+	compiler->Reloaded = vec_create(ShaderHandle);
+	InitializeMutex(&compiler->Lock);
+
+	if (!CreateThreadPool(threadCount, &compiler->Pool))
+	{
+		printf("ERROR: Could not create the shader compile threads!\n");
+		vec_destroy(compiler->Shaders);
+		vec_destroy(compiler->Reloaded);
+		DestroyMutex(&compiler->Lock);
+		shaderc_compiler_release(compiler->Compiler);
+		memset(compiler, 0, sizeof(ShaderCompiler));
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to add a shader to the compiler and queue its first compile, this never waits for the compile */
+/* @param A Pointer to the compiler */
+/* @param A Pointer to the description of the shader */
+/* @param A Pointer to the ShaderHandle to be filled */
+void AddShader(ShaderCompiler* compiler, ShaderDescription* description, ShaderHandle* handle)
+{
+	Shader* shader = (Shader*)calloc(1, sizeof(Shader));
+	shader->Description = *description;
+	shader->State = SHADER_STATE_COMPILING;
+	shader->Dependencies = vec_create(ShaderDependency);
+
+	LockMutex(&compiler->Lock);
+	*handle = (ShaderHandle)vec_length(compiler->Shaders);
+	vec_pushback(compiler->Shaders, shader, Shader*);
+	UnlockMutex(&compiler->Lock);
+
+	QueueShaderCompile(compiler, *handle);
+}
+
+/* A function for getting the state of a shader without waiting */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+ShaderState GetShaderState(ShaderCompiler* compiler, ShaderHandle handle)
+{
+	LockMutex(&compiler->Lock);
+	Shader* shader = GetShader(compiler, handle);
+	UnlockMutex(&compiler->Lock);
+
+	return (ShaderState)AtomicLoad32(&shader->State);
+}
+
+/* A function for getting what the optimizer did to the current SPIR-V of a shader */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+/* @param A Pointer to the ShaderOptimizationStats to be filled */
+void GetShaderOptimizationStats(ShaderCompiler* compiler, ShaderHandle handle, ShaderOptimizationStats* stats)
+{
+	LockMutex(&compiler->Lock);
+	*stats = GetShader(compiler, handle)->Optimization;
+	UnlockMutex(&compiler->Lock);
+}
+
+/* A function to wait until every queued compile is done, for loading screens */
+/* @param A Pointer to the compiler */
+void WaitForShaderCompiler(ShaderCompiler* compiler)
+{
+	WaitForThreadPool(&compiler->Pool);
+}
+
+/* A function to create a shader module from the newest SPIR-V of a shader */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the compiler */
+/* @param The handle of the shader */
+/* @param A Pointer to a VkShaderModule to be filled */
+bool CreateShaderModuleFromCompiler(VkDevice* logicalDevice, ShaderCompiler* compiler, ShaderHandle handle, VkShaderModule* shaderModule)
+{
+	LockMutex(&compiler->Lock);
+	Shader* shader = GetShader(compiler, handle);
+
+	if (shader->Spirv == nullptr)
+	{
+		UnlockMutex(&compiler->Lock);
+		printf("ERROR: The shader %s has no SPIR-V yet!\n", shader->Description.Path);
+		return false;
+	}
+
+	bool result = CreateShaderModule(logicalDevice, shader->Spirv, shader->SpirvSize, shaderModule);
+	UnlockMutex(&compiler->Lock);
+	return result;
+}
+
+/* A function for the render thread to take the shaders that were reloaded since the last call, it never waits */
+/* @param A Pointer to the compiler */
+/* @param A Pointer to a Vector of ShaderHandle to be filled */
+bool TakeReloadedShaders(ShaderCompiler* compiler, Vec* handles)
+{
+	vec_clear(*handles);
+
+	/* A worker or the watcher holding the lock just means the reload is picked up next frame */
+	if (!TryLockMutex(&compiler->Lock))
+		return false;
+
+	for (u64 i = 0; i < vec_length(compiler->Reloaded); ++i)
+		vec_pushback(*handles, ((ShaderHandle*)compiler->Reloaded)[i], ShaderHandle);
+	vec_clear(compiler->Reloaded);
+
+	UnlockMutex(&compiler->Lock);
+	return vec_length(*handles) > 0;
+}
+
+/* A function to queue a compile for every shader with a changed source or include */
+/* @param A Pointer to the compiler */
+void PollShaderChanges(ShaderCompiler* compiler)
+{
+	/* The paths are copied out, so the files are looked at without holding the lock */
+	typedef struct { ShaderHandle Handle; ShaderDependency Dependency; } WatchedFile;
+	Vec files = vec_create(WatchedFile);
+
+	LockMutex(&compiler->Lock);
+	for (u64 i = 0; i < vec_length(compiler->Shaders); ++i)
+	{
+		Shader* shader = GetShader(compiler, (ShaderHandle)i);
+		if (AtomicLoad32(&shader->Pending))
+			continue;
+
+		for (u64 j = 0; j < vec_length(shader->Dependencies); ++j)
+		{
+			WatchedFile file = { (ShaderHandle)i, ((ShaderDependency*)shader->Dependencies)[j] };
+			vec_pushback(files, file, WatchedFile);
+		}
+	}
+	UnlockMutex(&compiler->Lock);
+
+	ShaderHandle last = (ShaderHandle)-1;
+	for (u64 i = 0; i < vec_length(files); ++i)
+	{
+		WatchedFile* file = &((WatchedFile*)files)[i];
+		if ((file->Handle == last) || (GetFileModificationTime(file->Dependency.Path) == file->Dependency.ModifiedTime))
+			continue;
+
+		printf("INFO: Reloading the shader %s\n", file->Dependency.Path);
+		QueueShaderCompile(compiler, file->Handle);
+		last = file->Handle;
+	}
+
+	vec_destroy(files);
+}
+
+/* The loop of the hot reload watcher */
+/* @param A Pointer to the compiler */
+void ShaderWatcher(void* argument)
+{
+	ShaderCompiler* compiler = (ShaderCompiler*)argument;
+	while (AtomicLoad32(&compiler->Watching))
+	{
+		PollShaderChanges(compiler);
+		SleepMilliseconds(SHADER_HOT_RELOAD_INTERVAL);
+	}
+}
+
+/* A function to start a thread that recompiles shaders when their files change, for development builds */
+/* @param A Pointer to the compiler */
+bool StartShaderHotReload(ShaderCompiler* compiler)
+{
+	if (AtomicLoad32(&compiler->Watching))
+		return true;
+
+	AtomicStore32(&compiler->Watching, 1);
+	if (!StartThread(ShaderWatcher, compiler, &compiler->Watcher))
+	{
+		AtomicStore32(&compiler->Watching, 0);
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to stop the hot reload thread */
+/* @param A Pointer to the compiler */
+void StopShaderHotReload(ShaderCompiler* compiler)
+{
+	if (!AtomicLoad32(&compiler->Watching))
+		return;
+
+	AtomicStore32(&compiler->Watching, 0);
+	JoinThread(&compiler->Watcher);
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A pointer to the resource to cleanup */
+void DestroyShaderCompiler(ShaderCompiler* compiler)
+{
+	StopShaderHotReload(compiler);
+	DestroyThreadPool(&compiler->Pool);
+
+	for (u64 i = 0; i < vec_length(compiler->Shaders); ++i)
+	{
+		Shader* shader = GetShader(compiler, (ShaderHandle)i);
+		vec_destroy(shader->Dependencies);
+		ReleaseShaderSpirv(shader);
+		free(shader->Errors);
+		free(shader);
+	}
+
+	vec_destroy(compiler->Shaders);
+	vec_destroy(compiler->Reloaded);
+	DestroyMutex(&compiler->Lock);
+	shaderc_compiler_release(compiler->Compiler);
+	memset(compiler, 0, sizeof(ShaderCompiler));
+}
+
+/* A structure for the startup timings with and without the SPIR-V cache */
+typedef struct {
+	u32 ShaderCount;		/* The number of shaders */
+	double ColdSeconds;		/* Time to get every shader ready with nothing cached */
+	double WarmSeconds;		/* Time to get every shader ready from the cache */
+	u32 WarmHits;			/* The cache hits of the warm run */
+} ShaderStartupTimings;
+
+/* A function to measure how long it takes to get a set of shaders ready, once cold and once from the cache */
+/* @param The number of compile threads, 0 uses one per processor */
+/* @param An array of include directories, can be null */
+/* @param The number of include directories */
+/* @param A Pointer to the SPIR-V cache, the entries of these shaders are removed for the cold run */
+/* @param An array of shader descriptions */
+/* @param The number of shader descriptions */
+/* @param A Pointer to the ShaderStartupTimings to be filled */
+bool MeasureShaderCacheStartup(u32 threadCount, const char** includeDirectories, u32 includeDirectoryCount, ShaderCache* cache,
+	ShaderDescription* descriptions, u32 descriptionCount, ShaderStartupTimings* timings)
+{
+	memset(timings, 0, sizeof(ShaderStartupTimings));
+	timings->ShaderCount = descriptionCount;
+
+	for (u32 run = 0; run < 2; ++run)
+	{
+		ShaderCompiler compiler;
+		if (!CreateShaderCompiler(threadCount, includeDirectories, includeDirectoryCount, cache, &compiler))
+			return false;
+
+		/* The cold run starts from a cache without these shaders */
+		for (u32 i = 0; (run == 0) && (i < descriptionCount); ++i)
+		{
+			u64 key = 0;
+			Vec dependencies = vec_create(ShaderDependency);
+			if (ComputeShaderCacheKey(&compiler, &descriptions[i], &dependencies, &key))
+				RemoveFromShaderCache(cache, key);
+			vec_destroy(dependencies);
+		}
+
+		ShaderCacheStats before;
+		GetShaderCacheStats(cache, &before);
+
+		double startTime = GetTimeInSeconds();
+		ShaderHandle handle;
+		for (u32 i = 0; i < descriptionCount; ++i)
+			AddShader(&compiler, &descriptions[i], &handle);
+		WaitForShaderCompiler(&compiler);
+		double seconds = GetTimeInSeconds() - startTime;
+
+		ShaderCacheStats after;
+		GetShaderCacheStats(cache, &after);
+
+		if (run == 0)
+			timings->ColdSeconds = seconds;
+		else
+		{
+			timings->WarmSeconds = seconds;
+			timings->WarmHits = after.Hits - before.Hits;
+		}
+
+		DestroyShaderCompiler(&compiler);
+	}
+
+	SaveShaderCacheIndex(cache);
+	printf("INFO: %u shaders ready in %.2f ms cold and %.2f ms warm, %u of them from the cache\n", timings->ShaderCount,
+		timings->ColdSeconds * 1000.0, timings->WarmSeconds * 1000.0, timings->WarmHits);
+	return true;
+}
@@ -0,0 +1,403 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <PipelineState/PipelineState.h>
+
+/* The graphics stages shader objects are bound to, unused ones are bound to VK_NULL_HANDLE */
+#define SHADER_OBJECT_STAGE_COUNT 5
+
+/* A structure for the shader object commands, they are extension commands so they come from vkGetDeviceProcAddr */
+typedef struct {
+	PFN_vkCreateShadersEXT CreateShaders;
+	PFN_vkDestroyShaderEXT DestroyShader;
+	PFN_vkCmdBindShadersEXT CmdBindShaders;
+	PFN_vkCmdBeginRenderingKHR CmdBeginRendering;
+	PFN_vkCmdEndRenderingKHR CmdEndRendering;
+	PFN_vkCmdSetViewportWithCountEXT CmdSetViewportWithCount;
+	PFN_vkCmdSetScissorWithCountEXT CmdSetScissorWithCount;
+	PFN_vkCmdSetVertexInputEXT CmdSetVertexInput;
+	PFN_vkCmdSetPrimitiveTopologyEXT CmdSetPrimitiveTopology;
+	PFN_vkCmdSetPrimitiveRestartEnableEXT CmdSetPrimitiveRestartEnable;
+	PFN_vkCmdSetRasterizerDiscardEnableEXT CmdSetRasterizerDiscardEnable;
+	PFN_vkCmdSetPolygonModeEXT CmdSetPolygonMode;
+	PFN_vkCmdSetCullModeEXT CmdSetCullMode;
+	PFN_vkCmdSetFrontFaceEXT CmdSetFrontFace;
+	PFN_vkCmdSetDepthBiasEnableEXT CmdSetDepthBiasEnable;
+	PFN_vkCmdSetDepthTestEnableEXT CmdSetDepthTestEnable;
+	PFN_vkCmdSetDepthWriteEnableEXT CmdSetDepthWriteEnable;
+	PFN_vkCmdSetDepthCompareOpEXT CmdSetDepthCompareOp;
+	PFN_vkCmdSetDepthBoundsTestEnableEXT CmdSetDepthBoundsTestEnable;
+	PFN_vkCmdSetStencilTestEnableEXT CmdSetStencilTestEnable;
+	PFN_vkCmdSetRasterizationSamplesEXT CmdSetRasterizationSamples;
+	PFN_vkCmdSetSampleMaskEXT CmdSetSampleMask;
+	PFN_vkCmdSetAlphaToCoverageEnableEXT CmdSetAlphaToCoverageEnable;
+	PFN_vkCmdSetColorBlendEnableEXT CmdSetColorBlendEnable;
+	PFN_vkCmdSetColorBlendEquationEXT CmdSetColorBlendEquation;
+	PFN_vkCmdSetColorWriteMaskEXT CmdSetColorWriteMask;
+} ShaderObjectFunctions;
+
+/* A structure for recording draws with shader objects, it remembers the dynamic state it set so a draw only
+   records the state that differs from the draw before it */
+typedef struct {
+	ShaderObjectFunctions* Functions;		/* The shader object commands */
+	VkCommandBuffer CommandBuffer;			/* The command buffer being recorded */
+	VkShaderEXT Bound[SHADER_OBJECT_STAGE_COUNT];	/* The shaders bound to each stage */
+	PipelineState Current;					/* The state that is set */
+	bool Valid;								/* False until the first state is set, then everything is recorded */
+	u64 StateCommands;						/* The number of state commands recorded, to see what the diffing saves */
+} ShaderObjectRecorder;
+
+/* A structure for a material that can be drawn either way, used to compare the two */
+typedef struct {
+	VkShaderEXT Shaders[SHADER_OBJECT_STAGE_COUNT];	/* The shaders for the shader object path, in the order of ShaderObjectStages */
+	PipelineState State;							/* The dynamic state for the shader object path */
+	VkPipeline Pipeline;							/* The same material baked into a pipeline */
+} ShaderObjectMaterial;
+
+/* A structure for the CPU cost of recording draws */
+typedef struct {
+	u32 DrawCount;					/* The draws recorded each way */
+	u32 MaterialCount;				/* The materials the draws cycle through */
+	double PipelineSeconds;			/* Recording with vkCmdBindPipeline */
+	double ShaderObjectSeconds;		/* Recording with vkCmdBindShadersEXT and dynamic state */
+	u64 ShaderObjectStateCommands;	/* The state commands the shader object path needed */
+} ShaderObjectDrawTimings;
+
+/* The stages in the order of ShaderObjectRecorder.Bound and ShaderObjectMaterial.Shaders */
+static const VkShaderStageFlagBits ShaderObjectStages[SHADER_OBJECT_STAGE_COUNT] =
+{
+	VK_SHADER_STAGE_VERTEX_BIT,
+	VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+	VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+	VK_SHADER_STAGE_GEOMETRY_BIT,
+	VK_SHADER_STAGE_FRAGMENT_BIT
+};
+
+/* A function to check if a physical device can draw with shader objects, natively or through the emulation layer */
+/* @param The physical device to be screened */
+bool IsShaderObjectSupported(VkPhysicalDevice* physicalDevice)
+{
+	if (!IsDeviceExtensionSupported(physicalDevice, VK_EXT_SHADER_OBJECT_EXTENSION_NAME) ||
+		!IsDeviceExtensionSupported(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT };
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR, &shaderObjectFeatures };
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &dynamicRenderingFeatures };
+	vkGetPhysicalDeviceFeatures2(*physicalDevice, &features);
+	return (shaderObjectFeatures.shaderObject == VK_TRUE) && (dynamicRenderingFeatures.dynamicRendering == VK_TRUE);
+}
+
+/* A function to load the shader object commands */
+/* @param A Pointer to a logical device created with VK_EXT_shader_object enabled */
+/* @param A Pointer to the ShaderObjectFunctions to be filled */
+bool LoadShaderObjectFunctions(VkDevice* logicalDevice, ShaderObjectFunctions* functions)
+{
+	PFN_vkVoidFunction* entries = (PFN_vkVoidFunction*)functions;
+	static const char* names[] =
+	{
+		"vkCreateShadersEXT", "vkDestroyShaderEXT", "vkCmdBindShadersEXT", "vkCmdBeginRenderingKHR", "vkCmdEndRenderingKHR",
+		"vkCmdSetViewportWithCountEXT", "vkCmdSetScissorWithCountEXT", "vkCmdSetVertexInputEXT", "vkCmdSetPrimitiveTopologyEXT",
+		"vkCmdSetPrimitiveRestartEnableEXT", "vkCmdSetRasterizerDiscardEnableEXT", "vkCmdSetPolygonModeEXT", "vkCmdSetCullModeEXT",
+		"vkCmdSetFrontFaceEXT", "vkCmdSetDepthBiasEnableEXT", "vkCmdSetDepthTestEnableEXT", "vkCmdSetDepthWriteEnableEXT",
+		"vkCmdSetDepthCompareOpEXT", "vkCmdSetDepthBoundsTestEnableEXT", "vkCmdSetStencilTestEnableEXT", "vkCmdSetRasterizationSamplesEXT",
+		"vkCmdSetSampleMaskEXT", "vkCmdSetAlphaToCoverageEnableEXT", "vkCmdSetColorBlendEnableEXT", "vkCmdSetColorBlendEquationEXT",
+		"vkCmdSetColorWriteMaskEXT"
+	};
+
+	/* The structure is only function pointers, in the order of the names */
+	for (u32 i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	{
+		entries[i] = vkGetDeviceProcAddr(*logicalDevice, names[i]);
+		if (entries[i] == nullptr)
+		{
+			printf("ERROR: Could not load %s!\n", names[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* A function to create unlinked shader objects from SPIR-V with a "main" entry point, each one can be bound with any other */
+/* @param A Pointer to the shader object commands */
+/* @param A Pointer to a logical device */
+/* @param The number of shaders */
+/* @param An array of the stages */
+/* @param An array of the stages each one can be followed by, 0 for the last stage */
+/* @param An array of the SPIR-V of each one */
+/* @param An array of the sizes of the SPIR-V in bytes */
+/* @param The descriptor set layouts, the same for every shader so they can share a pipeline layout */
+/* @param The number of descriptor set layouts */
+/* @param The push constant ranges */
+/* @param The number of push constant ranges */
+/* @param An array of VkShaderEXT to be filled */
+bool CreateShaderObjects(ShaderObjectFunctions* functions, VkDevice* logicalDevice, u32 count, const VkShaderStageFlagBits* stages, const VkShaderStageFlags* nextStages,
+	const u32** spirv, const u64* spirvSizes, const VkDescriptorSetLayout* setLayouts, u32 setLayoutCount, const VkPushConstantRange* pushConstantRanges,
+	u32 pushConstantRangeCount, VkShaderEXT* shaders)
+{
+	VkShaderCreateInfoEXT createInfos[SHADER_OBJECT_STAGE_COUNT];
+	if (count > SHADER_OBJECT_STAGE_COUNT)
+	{
+		printf("ERROR: Can not create more than %d shader objects at once!\n", SHADER_OBJECT_STAGE_COUNT);
+		return false;
+	}
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		VkShaderCreateInfoEXT createInfo =
+		{
+			VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+			nullptr,
+			0,
+			stages[i],
+			nextStages[i],
+			VK_SHADER_CODE_TYPE_SPIRV_EXT,
+			(size_t)spirvSizes[i],
+			spirv[i],
+			"main",
+			setLayoutCount,
+			setLayouts,
+			pushConstantRangeCount,
+			pushConstantRanges,
+			nullptr
+		};
+		createInfos[i] = createInfo;
+	}
+
+	if (functions->CreateShaders(*logicalDevice, count, createInfos, nullptr, shaders) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the shader objects!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A Pointer to the shader object commands */
+/* @param A Pointer to a logical device */
+/* @param A pointer to the resource to cleanup */
+void DestroyShaderObject(ShaderObjectFunctions* functions, VkDevice* logicalDevice, VkShaderEXT* shader)
+{
+	if (*shader != VK_NULL_HANDLE)
+		functions->DestroyShader(*logicalDevice, *shader, nullptr);
+	*shader = VK_NULL_HANDLE;
+}
+
+/* A function to start recording shader object draws, it sets the state that never changes between draws */
+/* @param A Pointer to the ShaderObjectRecorder to be filled */
+/* @param A Pointer to the shader object commands */
+/* @param The command buffer, recording and inside vkCmdBeginRendering */
+/* @param The viewport */
+/* @param The scissor */
+void BeginShaderObjectRecording(ShaderObjectRecorder* recorder, ShaderObjectFunctions* functions, VkCommandBuffer commandBuffer, const VkViewport* viewport, const VkRect2D* scissor)
+{
+	memset(recorder, 0, sizeof(ShaderObjectRecorder));
+	recorder->Functions = functions;
+	recorder->CommandBuffer = commandBuffer;
+
+	functions->CmdSetViewportWithCount(commandBuffer, 1, viewport);
+	functions->CmdSetScissorWithCount(commandBuffer, 1, scissor);
+	functions->CmdSetPrimitiveRestartEnable(commandBuffer, VK_FALSE);
+	functions->CmdSetRasterizerDiscardEnable(commandBuffer, VK_FALSE);
+	functions->CmdSetDepthBiasEnable(commandBuffer, VK_FALSE);
+	functions->CmdSetDepthBoundsTestEnable(commandBuffer, VK_FALSE);
+	functions->CmdSetStencilTestEnable(commandBuffer, VK_FALSE);
+	functions->CmdSetAlphaToCoverageEnable(commandBuffer, VK_FALSE);
+	vkCmdSetLineWidth(commandBuffer, 1.0f);
+	recorder->StateCommands += 9;
+}
+
+/* A function to bind shaders and set the dynamic state of a draw, only what changed since the last draw is recorded */
+/* @param A Pointer to the recorder */
+/* @param An array of SHADER_OBJECT_STAGE_COUNT shaders in the order of ShaderObjectStages, VK_NULL_HANDLE for unused stages */
+/* @param A Pointer to the state, its shader, layout and render pass ids are not used */
+void BindShaderObjectState(ShaderObjectRecorder* recorder, const VkShaderEXT* shaders, const PipelineState* state)
+{
+	ShaderObjectFunctions* functions = recorder->Functions;
+	VkCommandBuffer commandBuffer = recorder->CommandBuffer;
+	PipelineState* current = &recorder->Current;
+	bool all = !recorder->Valid;
+
+	if (all || (memcmp(recorder->Bound, shaders, sizeof(recorder->Bound)) != 0))
+	{
+		functions->CmdBindShaders(commandBuffer, SHADER_OBJECT_STAGE_COUNT, ShaderObjectStages, shaders);
+		memcpy(recorder->Bound, shaders, sizeof(recorder->Bound));
+	}
+
+	if (all || (current->VertexBindingCount != state->VertexBindingCount) || (current->VertexAttributeCount != state->VertexAttributeCount) ||
+		(memcmp(current->VertexBindings, state->VertexBindings, sizeof(state->VertexBindings)) != 0) ||
+		(memcmp(current->VertexAttributes, state->VertexAttributes, sizeof(state->VertexAttributes)) != 0))
+	{
+		VkVertexInputBindingDescription2EXT bindings[PIPELINE_STATE_MAX_VERTEX_BINDINGS];
+		VkVertexInputAttributeDescription2EXT attributes[PIPELINE_STATE_MAX_VERTEX_ATTRIBUTES];
+		for (u32 i = 0; i < state->VertexBindingCount; ++i)
+		{
+			VkVertexInputBindingDescription2EXT binding =
+			{
+				VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT, nullptr,
+				state->VertexBindings[i].binding, state->VertexBindings[i].stride, state->VertexBindings[i].inputRate, 1
+			};
+			bindings[i] = binding;
+		}
+		for (u32 i = 0; i < state->VertexAttributeCount; ++i)
+		{
+			VkVertexInputAttributeDescription2EXT attribute =
+			{
+				VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT, nullptr,
+				state->VertexAttributes[i].location, state->VertexAttributes[i].binding, state->VertexAttributes[i].format, state->VertexAttributes[i].offset
+			};
+			attributes[i] = attribute;
+		}
+		functions->CmdSetVertexInput(commandBuffer, state->VertexBindingCount, bindings, state->VertexAttributeCount, attributes);
+		++recorder->StateCommands;
+	}
+
+	if (all || (current->Topology != state->Topology))
+	{
+		functions->CmdSetPrimitiveTopology(commandBuffer, state->Topology);
+		++recorder->StateCommands;
+	}
+	if (all || (current->PolygonMode != state->PolygonMode))
+	{
+		functions->CmdSetPolygonMode(commandBuffer, state->PolygonMode);
+		++recorder->StateCommands;
+	}
+	if (all || (current->CullMode != state->CullMode))
+	{
+		functions->CmdSetCullMode(commandBuffer, state->CullMode);
+		++recorder->StateCommands;
+	}
+	if (all || (current->FrontFace != state->FrontFace))
+	{
+		functions->CmdSetFrontFace(commandBuffer, state->FrontFace);
+		++recorder->StateCommands;
+	}
+	if (all || (current->DepthTest != state->DepthTest))
+	{
+		functions->CmdSetDepthTestEnable(commandBuffer, state->DepthTest);
+		++recorder->StateCommands;
+	}
+	if (all || (current->DepthWrite != state->DepthWrite))
+	{
+		functions->CmdSetDepthWriteEnable(commandBuffer, state->DepthWrite);
+		++recorder->StateCommands;
+	}
+	if (all || (current->DepthCompare != state->DepthCompare))
+	{
+		functions->CmdSetDepthCompareOp(commandBuffer, state->DepthCompare);
+		++recorder->StateCommands;
+	}
+	if (all || (current->Samples != state->Samples))
+	{
+		VkSampleMask sampleMask = 0xFFFFFFFF;
+		functions->CmdSetRasterizationSamples(commandBuffer, state->Samples);
+		functions->CmdSetSampleMask(commandBuffer, state->Samples, &sampleMask);
+		recorder->StateCommands += 2;
+	}
+
+	if (all || (current->ColorCount != state->ColorCount) || (memcmp(current->Blend, state->Blend, sizeof(state->Blend)) != 0))
+	{
+		VkBool32 enables[PIPELINE_STATE_MAX_ATTACHMENTS];
+		VkColorBlendEquationEXT equations[PIPELINE_STATE_MAX_ATTACHMENTS];
+		VkColorComponentFlags writeMasks[PIPELINE_STATE_MAX_ATTACHMENTS];
+		for (u32 i = 0; i < state->ColorCount; ++i)
+		{
+			const VkPipelineColorBlendAttachmentState* blend = &state->Blend[i];
+			VkColorBlendEquationEXT equation =
+			{
+				blend->srcColorBlendFactor, blend->dstColorBlendFactor, blend->colorBlendOp,
+				blend->srcAlphaBlendFactor, blend->dstAlphaBlendFactor, blend->alphaBlendOp
+			};
+			enables[i] = blend->blendEnable;
+			equations[i] = equation;
+			writeMasks[i] = blend->colorWriteMask;
+		}
+
+		if (state->ColorCount > 0)
+		{
+			functions->CmdSetColorBlendEnable(commandBuffer, 0, state->ColorCount, enables);
+			functions->CmdSetColorBlendEquation(commandBuffer, 0, state->ColorCount, equations);
+			functions->CmdSetColorWriteMask(commandBuffer, 0, state->ColorCount, writeMasks);
+			recorder->StateCommands += 3;
+		}
+	}
+
+	*current = *state;
+	recorder->Valid = true;
+}
+
+/* A function to measure the CPU time of recording draws with pipelines against shader objects. The command buffer
+   is recorded twice and never submitted, the draws cycle through the materials so the state changes every draw */
+/* @param A Pointer to the shader object commands */
+/* @param A Pointer to a logical device */
+/* @param A command pool to allocate the command buffer from */
+/* @param A Pointer to the begin info of a render pass the pipelines are compatible with */
+/* @param A Pointer to the rendering info the shader objects draw in */
+/* @param An array of materials */
+/* @param The number of materials */
+/* @param The number of draws to record each way */
+/* @param A Pointer to the ShaderObjectDrawTimings to be filled */
+bool MeasureShaderObjectDrawCost(ShaderObjectFunctions* functions, VkDevice* logicalDevice, VkCommandPool commandPool, const VkRenderPassBeginInfo* renderPassBegin,
+	const VkRenderingInfoKHR* renderingInfo, const ShaderObjectMaterial* materials, u32 materialCount, u32 drawCount, ShaderObjectDrawTimings* timings)
+{
+	memset(timings, 0, sizeof(ShaderObjectDrawTimings));
+	timings->DrawCount = drawCount;
+	timings->MaterialCount = materialCount;
+
+	VkCommandBuffer commandBuffer;
+	VkCommandBufferAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1 };
+	if (vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, &commandBuffer) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate a command buffer for the draw measurement!\n");
+		return false;
+	}
+
+	VkViewport viewport = { 0.0f, 0.0f, (float)renderingInfo->renderArea.extent.width, (float)renderingInfo->renderArea.extent.height, 0.0f, 1.0f };
+	VkRect2D scissor = renderingInfo->renderArea;
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr };
+
+	for (u32 run = 0; run < 2; ++run)
+	{
+		vkResetCommandBuffer(commandBuffer, 0);
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		double startTime = GetTimeInSeconds();
+		if (run == 0)
+		{
+			vkCmdBeginRenderPass(commandBuffer, renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+			for (u32 i = 0; i < drawCount; ++i)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, materials[i % materialCount].Pipeline);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			}
+			vkCmdEndRenderPass(commandBuffer);
+			timings->PipelineSeconds = GetTimeInSeconds() - startTime;
+		}
+		else
+		{
+			ShaderObjectRecorder recorder;
+			functions->CmdBeginRendering(commandBuffer, renderingInfo);
+			BeginShaderObjectRecording(&recorder, functions, commandBuffer, &viewport, &scissor);
+			for (u32 i = 0; i < drawCount; ++i)
+			{
+				BindShaderObjectState(&recorder, materials[i % materialCount].Shaders, &materials[i % materialCount].State);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			}
+			functions->CmdEndRendering(commandBuffer);
+			timings->ShaderObjectSeconds = GetTimeInSeconds() - startTime;
+			timings->ShaderObjectStateCommands = recorder.StateCommands;
+		}
+
+		vkEndCommandBuffer(commandBuffer);
+	}
+
+	vkFreeCommandBuffers(*logicalDevice, commandPool, 1, &commandBuffer);
+
+	printf("INFO: %u draws over %u materials: %.3f us per draw with pipelines, %.3f us per draw with shader objects (%llu state commands)\n",
+		drawCount, materialCount, timings->PipelineSeconds * 1000000.0 / drawCount, timings->ShaderObjectSeconds * 1000000.0 / drawCount,
+		(unsigned long long)timings->ShaderObjectStateCommands);
+	return true;
+}
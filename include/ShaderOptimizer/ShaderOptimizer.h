@@ -0,0 +1,117 @@
+#pragma once
+#include <stdlib.h>
+#include <VkHelper/VkHelper.h>
+#include <spirv-tools/libspirv.h>
+
+/* The optimization presets, picked per shader or for the whole build */
+typedef enum {
+	SHADER_OPTIMIZATION_NONE,	/* Keep the SPIR-V as it comes out of the compiler, for debugging */
+	SHADER_OPTIMIZATION_SPEED,	/* Inlining, dead code elimination, constant folding, scalar replacement and the rest of spirv-opt -O */
+	SHADER_OPTIMIZATION_SIZE	/* spirv-opt -Os, for shaders that are rarely hot but many */
+} ShaderOptimizationPreset;
+
+/* The preset new shader descriptions get, a build can define it to pick another one */
+#ifndef SHADER_OPTIMIZATION_DEFAULT
+#ifdef NDEBUG
+#define SHADER_OPTIMIZATION_DEFAULT SHADER_OPTIMIZATION_SPEED
+#else
+#define SHADER_OPTIMIZATION_DEFAULT SHADER_OPTIMIZATION_NONE
+#endif
+#endif
+
+/* A structure for what an optimization did */
+typedef struct {
+	ShaderOptimizationPreset Preset;	/* The preset that ran */
+	u32 InstructionsBefore;				/* The instructions going in, 0 if the SPIR-V came from the cache */
+	u32 InstructionsAfter;				/* The instructions coming out */
+	u64 SizeBefore;						/* The size going in in bytes, 0 if the SPIR-V came from the cache */
+	u64 SizeAfter;						/* The size coming out in bytes */
+	double Seconds;						/* The time the optimizer took */
+} ShaderOptimizationStats;
+
+/* A function for counting the instructions of a SPIR-V module */
+/* @param A Pointer to the SPIR-V words */
+/* @param The size of the SPIR-V in bytes */
+u32 CountSpirvInstructions(const u32* spirv, u64 size)
+{
+	/* After the 5 word header every instruction starts with its word count in the high 16 bits */
+	u64 wordCount = size / sizeof(u32);
+	u32 instructions = 0;
+	for (u64 i = 5; i < wordCount; ++instructions)
+	{
+		u32 length = spirv[i] >> 16;
+		if (length == 0)
+			break;
+		i += length;
+	}
+	return instructions;
+}
+
+/* The function spirv-tools reports problems with */
+void PrintSpirvOptimizerMessage(spv_message_level_t level, const char* source, const spv_position_t* position, const char* message)
+{
+	if (level <= SPV_MSG_ERROR)
+		printf("ERROR: SPIR-V optimizer: %s\n", message);
+	else if (level == SPV_MSG_WARNING)
+		printf("WARNING: SPIR-V optimizer: %s\n", message);
+}
+
+/* A function to run a preset of spirv-opt passes on SPIR-V, safe to call from many threads at once */
+/* @param The preset to run */
+/* @param A Pointer to the SPIR-V words */
+/* @param The size of the SPIR-V in bytes */
+/* @param A Pointer to the optimized SPIR-V to be filled, it must be freed with free() */
+/* @param A Pointer to the size of the optimized SPIR-V in bytes to be filled */
+/* @param A Pointer to the ShaderOptimizationStats to be filled, can be null */
+bool OptimizeSpirv(ShaderOptimizationPreset preset, const u32* spirv, u64 size, u32** optimized, u64* optimizedSize, ShaderOptimizationStats* stats)
+{
+	double startTime = GetTimeInSeconds();
+	*optimized = nullptr;
+	*optimizedSize = 0;
+
+	if (preset == SHADER_OPTIMIZATION_NONE)
+		return false;
+
+	/* An optimizer per call, they are cheap to create next to running the passes and this keeps the workers independent */
+	spv_optimizer_t* optimizer = spvOptimizerCreate(SPV_ENV_VULKAN_1_2);
+	spvOptimizerSetMessageConsumer(optimizer, PrintSpirvOptimizerMessage);
+	if (preset == SHADER_OPTIMIZATION_SIZE)
+		spvOptimizerRegisterSizePasses(optimizer);
+	else
+		spvOptimizerRegisterPerformancePasses(optimizer);
+
+	/* The input is validated first, so a compiler bug fails here and not in the driver */
+	spv_optimizer_options options = spvOptimizerOptionsCreate();
+	spvOptimizerOptionsSetRunValidator(options, true);
+
+	spv_binary binary = nullptr;
+	spv_result_t result = spvOptimizerRun(optimizer, spirv, (size_t)(size / sizeof(u32)), &binary, options);
+
+	spvOptimizerOptionsDestroy(options);
+	spvOptimizerDestroy(optimizer);
+
+	if ((result != SPV_SUCCESS) || (binary == nullptr))
+	{
+		printf("WARNING: Could not optimize SPIR-V, using it as it is\n");
+		if (binary)
+			spvBinaryDestroy(binary);
+		return false;
+	}
+
+	*optimizedSize = binary->wordCount * sizeof(u32);
+	*optimized = (u32*)malloc((size_t)*optimizedSize);
+	memcpy(*optimized, binary->code, (size_t)*optimizedSize);
+	spvBinaryDestroy(binary);
+
+	if (stats)
+	{
+		stats->Preset = preset;
+		stats->InstructionsBefore = CountSpirvInstructions(spirv, size);
+		stats->InstructionsAfter = CountSpirvInstructions(*optimized, *optimizedSize);
+		stats->SizeBefore = size;
+		stats->SizeAfter = *optimizedSize;
+		stats->Seconds = GetTimeInSeconds() - startTime;
+	}
+
+	return true;
+}
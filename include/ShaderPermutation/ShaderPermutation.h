@@ -0,0 +1,170 @@
+#pragma once
+#include <ShaderCompiler/ShaderCompiler.h>
+#include <PipelineState/PipelineState.h>
+
+#define SHADER_MAX_FEATURES PIPELINE_STATE_MAX_SPECIALIZATION_CONSTANTS	/* Every feature is a specialization constant of the pipeline state */
+#define SHADER_PERMUTATION_MACRO "SHADER_PERMUTATION_MACROS"
+#define SHADER_PERMUTATION_MAX_MEASURED_FEATURES 8	/* 2^8 macro variants is already minutes of compiling on big shaders */
+
+/* A structure for a feature toggle of a shader. The shader declares it as a boolean specialization constant, and
+   only when SHADER_PERMUTATION_MACROS is defined does it expect a macro instead, which is how the old way is measured:
+	#ifndef SHADER_PERMUTATION_MACROS
+	layout(constant_id = 0) const bool USE_FOG = false;
+	#endif */
+typedef struct {
+	char Name[SHADER_NAME_LENGTH];	/* The name of the constant, and of the macro when measuring */
+	u32 ConstantId;					/* The constant_id in the shader */
+} ShaderFeature;
+
+/* A structure for the feature toggles a set of shaders share */
+typedef struct {
+	ShaderFeature Features[SHADER_MAX_FEATURES];	/* The features, bit i of a permutation toggles feature i */
+	u32 FeatureCount;								/* The number of features */
+} ShaderFeatureSet;
+
+/* A permutation of a ShaderFeatureSet, a bit per feature */
+typedef u32 ShaderPermutation;
+
+/* A structure for the results of comparing one specialized module against a module per permutation */
+typedef struct {
+	u32 FeatureCount;			/* The features measured */
+	u32 MacroVariantCount;		/* The modules the macro way needs, 2^FeatureCount */
+	double SpecializedSeconds;	/* Time to compile the one module */
+	double MacroSeconds;		/* Time to compile every macro variant */
+	u64 SpecializedSize;		/* The size of the one module in bytes */
+	u64 MacroSize;				/* The size of every macro variant together in bytes */
+} ShaderPermutationTimings;
+
+/* A function to add a feature toggle to a set */
+/* @param A Pointer to the feature set */
+/* @param The name of the constant in the shaders */
+/* @param The constant_id in the shaders */
+bool AddShaderFeature(ShaderFeatureSet* set, const char* name, u32 constantId)
+{
+	if (set->FeatureCount == SHADER_MAX_FEATURES)
+	{
+		printf("ERROR: A shader can not have more than %d features!\n", SHADER_MAX_FEATURES);
+		return false;
+	}
+
+	ShaderFeature* feature = &set->Features[set->FeatureCount++];
+	snprintf(feature->Name, SHADER_NAME_LENGTH, "%s", name);
+	feature->ConstantId = constantId;
+	return true;
+}
+
+/* A function to turn a feature of a permutation on or off by name */
+/* @param A Pointer to the feature set */
+/* @param A Pointer to the permutation */
+/* @param The name of the feature */
+/* @param If the feature is on */
+bool SetShaderFeature(ShaderFeatureSet* set, ShaderPermutation* permutation, const char* name, bool enabled)
+{
+	for (u32 i = 0; i < set->FeatureCount; ++i)
+		if (strcmp(set->Features[i].Name, name) == 0)
+		{
+			if (enabled)
+				*permutation |= 1u << i;
+			else
+				*permutation &= ~(1u << i);
+			return true;
+		}
+
+	printf("ERROR: The shader feature %s does not exist!\n", name);
+	return false;
+}
+
+/* A function to write a permutation into a pipeline state. Every feature of the set is written, off ones too, so the
+   state and its hash always hold the full permutation */
+/* @param A Pointer to the feature set */
+/* @param The permutation */
+/* @param A Pointer to the pipeline state */
+bool ApplyShaderPermutation(ShaderFeatureSet* set, ShaderPermutation permutation, PipelineState* state)
+{
+	for (u32 i = 0; i < set->FeatureCount; ++i)
+		if (!SetPipelineStateSpecialization(state, set->Features[i].ConstantId, (permutation >> i) & 1))
+			return false;
+	return true;
+}
+
+/* A function to measure compiling a shader once with its features as specialization constants against compiling
+   it once per permutation with the features as macros, neither run uses the SPIR-V cache */
+/* @param The number of compile threads, 0 uses one per processor */
+/* @param An array of include directories, can be null */
+/* @param The number of include directories */
+/* @param A Pointer to the description of the shader */
+/* @param A Pointer to the feature set, only the first SHADER_PERMUTATION_MAX_MEASURED_FEATURES are measured */
+/* @param A Pointer to the ShaderPermutationTimings to be filled */
+bool MeasureShaderPermutationCost(u32 threadCount, const char** includeDirectories, u32 includeDirectoryCount,
+	ShaderDescription* description, ShaderFeatureSet* set, ShaderPermutationTimings* timings)
+{
+	memset(timings, 0, sizeof(ShaderPermutationTimings));
+	timings->FeatureCount = set->FeatureCount < SHADER_PERMUTATION_MAX_MEASURED_FEATURES ? set->FeatureCount : SHADER_PERMUTATION_MAX_MEASURED_FEATURES;
+	timings->MacroVariantCount = 1u << timings->FeatureCount;
+
+	for (u32 run = 0; run < 2; ++run)
+	{
+		ShaderCompiler compiler;
+		if (!CreateShaderCompiler(threadCount, includeDirectories, includeDirectoryCount, nullptr, &compiler))
+			return false;
+
+		u32 count = run == 0 ? 1 : timings->MacroVariantCount;
+		double startTime = GetTimeInSeconds();
+		for (u32 permutation = 0; permutation < count; ++permutation)
+		{
+			ShaderDescription variant = *description;
+			bool added = true;
+			if (run == 1)
+			{
+				added = AddShaderMacro(&variant, SHADER_PERMUTATION_MACRO, "1");
+				for (u32 i = 0; added && (i < timings->FeatureCount); ++i)
+					added = AddShaderMacro(&variant, set->Features[i].Name, ((permutation >> i) & 1) ? "true" : "false");
+			}
+
+			/* A variant left out would make the macro way look cheaper than it is */
+			if (!added)
+			{
+				printf("ERROR: Could not add the permutation macros of %s!\n", description->Path);
+				WaitForShaderCompiler(&compiler);
+				DestroyShaderCompiler(&compiler);
+				return false;
+			}
+
+			ShaderHandle handle;
+			AddShader(&compiler, &variant, &handle);
+		}
+		WaitForShaderCompiler(&compiler);
+		double seconds = GetTimeInSeconds() - startTime;
+
+		u64 size = 0;
+		bool failed = false;
+		for (u32 i = 0; i < (u32)vec_length(compiler.Shaders); ++i)
+		{
+			failed |= GetShaderState(&compiler, i) != SHADER_STATE_READY;
+			size += GetShader(&compiler, i)->SpirvSize;
+		}
+		DestroyShaderCompiler(&compiler);
+
+		if (failed)
+		{
+			printf("ERROR: Could not compile every permutation of %s!\n", description->Path);
+			return false;
+		}
+
+		if (run == 0)
+		{
+			timings->SpecializedSeconds = seconds;
+			timings->SpecializedSize = size;
+		}
+		else
+		{
+			timings->MacroSeconds = seconds;
+			timings->MacroSize = size;
+		}
+	}
+
+	printf("INFO: %s with %u features: 1 specialized module in %.2f ms and %llu bytes, %u macro variants in %.2f ms and %llu bytes\n",
+		description->Path, timings->FeatureCount, timings->SpecializedSeconds * 1000.0, (unsigned long long)timings->SpecializedSize,
+		timings->MacroVariantCount, timings->MacroSeconds * 1000.0, (unsigned long long)timings->MacroSize);
+	return true;
+}
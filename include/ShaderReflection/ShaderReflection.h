@@ -0,0 +1,560 @@
+#pragma once
+#include <VkHelper/VkHelper.h>
+#include <Threading/Threading.h>
+#include <Hash/Hash.h>
+#include <spirv_cross/spirv_cross_c.h>
+
+#define REFLECTION_MAX_SETS 4					/* The maxBoundDescriptorSets every device has */
+#define REFLECTION_MAX_BINDINGS 32				/* The most bindings in one set */
+#define REFLECTION_MAX_VERTEX_ATTRIBUTES 16		/* The maxVertexInputAttributes every device has */
+#define REFLECTION_RUNTIME_ARRAY_SIZE 1024		/* The descriptor count of unsized arrays, they need descriptor indexing */
+#define REFLECTION_PUSH_CONSTANT_SIZE 128		/* The maxPushConstantsSize every device has */
+
+/* A structure for the bindings of one descriptor set */
+typedef struct {
+	VkDescriptorSetLayoutBinding Bindings[REFLECTION_MAX_BINDINGS];	/* The bindings, sorted by binding number */
+	u32 BindingCount;												/* The number of bindings */
+} DescriptorSetLayoutDescription;
+
+/* A structure for everything a pipeline layout and the vertex input state need from the shaders */
+typedef struct {
+	VkShaderStageFlags Stages;											/* The stages that were reflected */
+	DescriptorSetLayoutDescription Sets[REFLECTION_MAX_SETS];			/* The descriptor sets */
+	u32 SetCount;														/* The highest used set + 1 */
+	VkPushConstantRange PushConstants;									/* The push constants of all stages, size 0 if there are none */
+	VkVertexInputAttributeDescription Attributes[REFLECTION_MAX_VERTEX_ATTRIBUTES];	/* The vertex inputs, sorted by location */
+	u32 AttributeCount;													/* The number of vertex inputs */
+	VkVertexInputBindingDescription VertexBinding;						/* One interleaved vertex buffer with every input */
+} ShaderReflection;
+
+/* A function for getting the format of a vertex input */
+/* @param The spirv-cross base type */
+/* @param The number of components */
+VkFormat GetReflectedVertexFormat(spvc_basetype baseType, u32 components)
+{
+	static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+	static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+	if ((components == 0) || (components > 4))
+		return VK_FORMAT_UNDEFINED;
+
+	switch (baseType)
+	{
+	case SPVC_BASETYPE_FP32:	return floatFormats[components - 1];
+	case SPVC_BASETYPE_INT32:	return intFormats[components - 1];
+	case SPVC_BASETYPE_UINT32:	return uintFormats[components - 1];
+	default:					return VK_FORMAT_UNDEFINED;
+	}
+}
+
+/* A function to add a binding to a reflection, a binding that is already there gets the stage added */
+/* @param A Pointer to the reflection */
+/* @param The set of the binding */
+/* @param The binding */
+bool AddReflectedBinding(ShaderReflection* reflection, u32 set, VkDescriptorSetLayoutBinding* binding)
+{
+	if (set >= REFLECTION_MAX_SETS)
+	{
+		printf("ERROR: The descriptor set %u is higher than the %d sets every device supports!\n", set, REFLECTION_MAX_SETS);
+		return false;
+	}
+
+	DescriptorSetLayoutDescription* description = &reflection->Sets[set];
+	u32 index = 0;
+	while ((index < description->BindingCount) && (description->Bindings[index].binding < binding->binding))
+		++index;
+
+	if ((index < description->BindingCount) && (description->Bindings[index].binding == binding->binding))
+	{
+		VkDescriptorSetLayoutBinding* existing = &description->Bindings[index];
+		if ((existing->descriptorType != binding->descriptorType) || (existing->descriptorCount != binding->descriptorCount))
+		{
+			printf("ERROR: The shaders disagree on set %u binding %u!\n", set, binding->binding);
+			return false;
+		}
+		existing->stageFlags |= binding->stageFlags;
+		return true;
+	}
+
+	if (description->BindingCount == REFLECTION_MAX_BINDINGS)
+	{
+		printf("ERROR: A descriptor set can not have more than %d bindings!\n", REFLECTION_MAX_BINDINGS);
+		return false;
+	}
+
+	/* Kept sorted, so equal sets are equal in memory too */
+	memmove(&description->Bindings[index + 1], &description->Bindings[index], (description->BindingCount - index) * sizeof(VkDescriptorSetLayoutBinding));
+	description->Bindings[index] = *binding;
+	++description->BindingCount;
+
+	if (set + 1 > reflection->SetCount)
+		reflection->SetCount = set + 1;
+	return true;
+}
+
+/* A function to reflect the descriptor bindings of one resource type */
+/* @param The spirv-cross compiler */
+/* @param The spirv-cross resources */
+/* @param The spirv-cross resource type */
+/* @param The descriptor type it turns into */
+/* @param The stage of the shader */
+/* @param A Pointer to the reflection */
+bool ReflectDescriptorBindings(spvc_compiler compiler, spvc_resources resources, spvc_resource_type resourceType, VkDescriptorType descriptorType,
+	VkShaderStageFlagBits stage, ShaderReflection* reflection)
+{
+	const spvc_reflected_resource* list = nullptr;
+	size_t count = 0;
+	spvc_resources_get_resource_list_for_type(resources, resourceType, &list, &count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		spvc_type type = spvc_compiler_get_type_handle(compiler, list[i].type_id);
+		VkDescriptorSetLayoutBinding binding = { 0 };
+		binding.binding = spvc_compiler_get_decoration(compiler, list[i].id, SpvDecorationBinding);
+		binding.descriptorType = descriptorType;
+		binding.descriptorCount = 1;
+		binding.stageFlags = stage;
+
+		/* Texel buffers show up as images with a buffer dimension */
+		if ((resourceType == SPVC_RESOURCE_TYPE_SAMPLED_IMAGE || resourceType == SPVC_RESOURCE_TYPE_SEPARATE_IMAGE) &&
+			(spvc_type_get_image_dimension(type) == SpvDimBuffer))
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+		else if ((resourceType == SPVC_RESOURCE_TYPE_STORAGE_IMAGE) && (spvc_type_get_image_dimension(type) == SpvDimBuffer))
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+
+		for (u32 dimension = 0; dimension < spvc_type_get_num_array_dimensions(type); ++dimension)
+		{
+			u32 size = spvc_type_get_array_dimension(type, dimension);
+			if (!spvc_type_array_dimension_is_literal(type, dimension))
+				printf("WARNING: The size of %s comes from a specialization constant, reflecting its default\n", list[i].name);
+			binding.descriptorCount *= size ? size : REFLECTION_RUNTIME_ARRAY_SIZE;
+		}
+
+		if (!AddReflectedBinding(reflection, spvc_compiler_get_decoration(compiler, list[i].id, SpvDecorationDescriptorSet), &binding))
+			return false;
+	}
+
+	return true;
+}
+
+/* A function to reflect the vertex inputs of a vertex shader into one interleaved vertex buffer */
+/* @param The spirv-cross compiler */
+/* @param The spirv-cross resources */
+/* @param A Pointer to the reflection */
+bool ReflectVertexInputs(spvc_compiler compiler, spvc_resources resources, ShaderReflection* reflection)
+{
+	const spvc_reflected_resource* list = nullptr;
+	size_t count = 0;
+	spvc_resources_get_resource_list_for_type(resources, SPVC_RESOURCE_TYPE_STAGE_INPUT, &list, &count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		spvc_type type = spvc_compiler_get_type_handle(compiler, list[i].type_id);
+		u32 location = spvc_compiler_get_decoration(compiler, list[i].id, SpvDecorationLocation);
+		VkFormat format = GetReflectedVertexFormat(spvc_type_get_basetype(type), spvc_type_get_vector_size(type));
+		if (format == VK_FORMAT_UNDEFINED)
+		{
+			printf("ERROR: The vertex input %s has a type that can not be reflected!\n", list[i].name);
+			return false;
+		}
+
+		/* A matrix takes one location per column */
+		for (u32 column = 0; column < spvc_type_get_columns(type); ++column)
+		{
+			if (reflection->AttributeCount == REFLECTION_MAX_VERTEX_ATTRIBUTES)
+			{
+				printf("ERROR: A vertex shader can not have more than %d inputs!\n", REFLECTION_MAX_VERTEX_ATTRIBUTES);
+				return false;
+			}
+
+			VkVertexInputAttributeDescription attribute = { location + column, 0, format, 0 };
+			u32 index = reflection->AttributeCount++;
+			while ((index > 0) && (reflection->Attributes[index - 1].location > attribute.location))
+			{
+				reflection->Attributes[index] = reflection->Attributes[index - 1];
+				--index;
+			}
+			reflection->Attributes[index] = attribute;
+		}
+	}
+
+	/* Offsets follow the locations, every component is 4 bytes */
+	u32 offset = 0;
+	for (u32 i = 0; i < reflection->AttributeCount; ++i)
+	{
+		reflection->Attributes[i].offset = offset;
+		switch (reflection->Attributes[i].format)
+		{
+		case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32_SINT: case VK_FORMAT_R32_UINT:										offset += 4; break;
+		case VK_FORMAT_R32G32_SFLOAT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32_UINT:								offset += 8; break;
+		case VK_FORMAT_R32G32B32_SFLOAT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32_UINT:						offset += 12; break;
+		default:																											offset += 16; break;
+		}
+	}
+	reflection->VertexBinding.binding = 0;
+	reflection->VertexBinding.stride = offset;
+	reflection->VertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return true;
+}
+
+/* The function spirv-cross reports errors with */
+void PrintSpirvCrossError(void* userData, const char* error)
+{
+	printf("ERROR: SPIR-V reflection: %s\n", error);
+}
+
+/* A function to reflect the descriptor sets, push constants and vertex inputs of a SPIR-V module */
+/* @param A Pointer to the SPIR-V words */
+/* @param The size of the SPIR-V in bytes */
+/* @param A Pointer to the ShaderReflection to be filled */
+bool ReflectSpirv(const u32* spirv, u64 size, ShaderReflection* reflection)
+{
+	memset(reflection, 0, sizeof(ShaderReflection));
+
+	spvc_context context = nullptr;
+	spvc_parsed_ir ir = nullptr;
+	spvc_compiler compiler = nullptr;
+	spvc_resources resources = nullptr;
+
+	if (spvc_context_create(&context) != SPVC_SUCCESS)
+	{
+		printf("ERROR: Could not create a spirv-cross context!\n");
+		return false;
+	}
+	spvc_context_set_error_callback(context, PrintSpirvCrossError, nullptr);
+
+	bool result = (spvc_context_parse_spirv(context, spirv, (size_t)(size / sizeof(u32)), &ir) == SPVC_SUCCESS) &&
+		(spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, &compiler) == SPVC_SUCCESS) &&
+		(spvc_compiler_create_shader_resources(compiler, &resources) == SPVC_SUCCESS);
+
+	if (result)
+	{
+		VkShaderStageFlagBits stage;
+		switch (spvc_compiler_get_execution_model(compiler))
+		{
+		case SpvExecutionModelVertex:					stage = VK_SHADER_STAGE_VERTEX_BIT; break;
+		case SpvExecutionModelTessellationControl:		stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; break;
+		case SpvExecutionModelTessellationEvaluation:	stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; break;
+		case SpvExecutionModelGeometry:					stage = VK_SHADER_STAGE_GEOMETRY_BIT; break;
+		case SpvExecutionModelFragment:					stage = VK_SHADER_STAGE_FRAGMENT_BIT; break;
+		case SpvExecutionModelGLCompute:				stage = VK_SHADER_STAGE_COMPUTE_BIT; break;
+		case SpvExecutionModelTaskEXT:					stage = VK_SHADER_STAGE_TASK_BIT_EXT; break;
+		case SpvExecutionModelMeshEXT:					stage = VK_SHADER_STAGE_MESH_BIT_EXT; break;
+		default:										stage = VK_SHADER_STAGE_ALL; break;
+		}
+		reflection->Stages = stage;
+
+		result = ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_SEPARATE_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS, VK_DESCRIPTOR_TYPE_SAMPLER, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_SUBPASS_INPUT, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, stage, reflection) &&
+			ReflectDescriptorBindings(compiler, resources, SPVC_RESOURCE_TYPE_ACCELERATION_STRUCTURE, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, stage, reflection);
+
+		/* There is at most one push constant block per stage */
+		const spvc_reflected_resource* list = nullptr;
+		size_t count = 0;
+		spvc_resources_get_resource_list_for_type(resources, SPVC_RESOURCE_TYPE_PUSH_CONSTANT, &list, &count);
+		if (result && (count > 0))
+		{
+			const spvc_buffer_range* ranges = nullptr;
+			size_t rangeCount = 0;
+			spvc_compiler_get_active_buffer_ranges(compiler, list[0].id, &ranges, &rangeCount);
+
+			u32 begin = ~0u, end = 0;
+			for (size_t i = 0; i < rangeCount; ++i)
+			{
+				if (ranges[i].offset < begin) begin = (u32)ranges[i].offset;
+				if (ranges[i].offset + ranges[i].range > end) end = (u32)(ranges[i].offset + ranges[i].range);
+			}
+			if (rangeCount > 0)
+			{
+				reflection->PushConstants.stageFlags = stage;
+				reflection->PushConstants.offset = begin;
+				reflection->PushConstants.size = end - begin;
+			}
+		}
+
+		if (result && (stage == VK_SHADER_STAGE_VERTEX_BIT))
+			result = ReflectVertexInputs(compiler, resources, reflection);
+	}
+	else
+		printf("ERROR: Could not parse SPIR-V for reflection!\n");
+
+	spvc_context_destroy(context);
+	return result;
+}
+
+/* A function to merge the reflection of another stage into a reflection, the vertex inputs of the vertex stage are kept */
+/* @param A Pointer to the reflection to merge into */
+/* @param A Pointer to the reflection of the other stage */
+bool MergeShaderReflections(ShaderReflection* reflection, const ShaderReflection* other)
+{
+	for (u32 set = 0; set < other->SetCount; ++set)
+		for (u32 i = 0; i < other->Sets[set].BindingCount; ++i)
+		{
+			VkDescriptorSetLayoutBinding binding = other->Sets[set].Bindings[i];
+			if (!AddReflectedBinding(reflection, set, &binding))
+				return false;
+		}
+
+	if (other->PushConstants.size > 0)
+	{
+		if (reflection->PushConstants.size == 0)
+			reflection->PushConstants = other->PushConstants;
+		else
+		{
+			u32 begin = other->PushConstants.offset < reflection->PushConstants.offset ? other->PushConstants.offset : reflection->PushConstants.offset;
+			u32 end = reflection->PushConstants.offset + reflection->PushConstants.size;
+			if (other->PushConstants.offset + other->PushConstants.size > end)
+				end = other->PushConstants.offset + other->PushConstants.size;
+			reflection->PushConstants.stageFlags |= other->PushConstants.stageFlags;
+			reflection->PushConstants.offset = begin;
+			reflection->PushConstants.size = end - begin;
+		}
+	}
+
+	if (other->Stages & VK_SHADER_STAGE_VERTEX_BIT)
+	{
+		memcpy(reflection->Attributes, other->Attributes, sizeof(reflection->Attributes));
+		reflection->AttributeCount = other->AttributeCount;
+		reflection->VertexBinding = other->VertexBinding;
+	}
+
+	reflection->Stages |= other->Stages;
+	return true;
+}
+
+/* A function to fill a vertex input state from a reflection, it points into the reflection */
+/* @param A Pointer to the reflection */
+/* @param A Pointer to the VkPipelineVertexInputStateCreateInfo to be filled */
+void GetReflectedVertexInputState(const ShaderReflection* reflection, VkPipelineVertexInputStateCreateInfo* vertexInputState)
+{
+	vertexInputState->sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputState->pNext = nullptr;
+	vertexInputState->flags = 0;
+	vertexInputState->vertexBindingDescriptionCount = reflection->AttributeCount ? 1 : 0;
+	vertexInputState->pVertexBindingDescriptions = &reflection->VertexBinding;
+	vertexInputState->vertexAttributeDescriptionCount = reflection->AttributeCount;
+	vertexInputState->pVertexAttributeDescriptions = reflection->Attributes;
+}
+
+/* ---- Layout deduplication ---- */
+
+/* A structure for a created descriptor set layout */
+typedef struct {
+	u64 Hash;								/* The hash of the description */
+	DescriptorSetLayoutDescription Description;	/* What the layout was created from */
+	VkDescriptorSetLayout Layout;			/* The layout */
+} CachedDescriptorSetLayout;
+
+/* A structure for a created pipeline layout */
+typedef struct {
+	u64 Hash;											/* The hash of the set layouts and push constants */
+	VkDescriptorSetLayout SetLayouts[REFLECTION_MAX_SETS];	/* The set layouts */
+	u32 SetCount;										/* The number of set layouts */
+	VkPushConstantRange PushConstants;					/* The push constants, size 0 if there are none */
+	VkPipelineLayout Layout;							/* The layout */
+} CachedPipelineLayout;
+
+/* A structure for the cache that makes pipelines with the same interface share layouts */
+typedef struct {
+	VkDevice* LogicalDevice;	/* The logical device */
+	bool Normalize;				/* Widen stages and push constants, so more pipelines end up compatible */
+	Vec SetLayouts;				/* A Vector of CachedDescriptorSetLayout */
+	Vec PipelineLayouts;		/* A Vector of CachedPipelineLayout */
+	Mutex Lock;					/* Guards the vectors and the counters */
+	u32 Hits;					/* Layouts that were already there */
+	u32 Misses;					/* Layouts that had to be created */
+} PipelineLayoutCache;
+
+/* A function to hash a descriptor set layout description, field by field so padding does not matter */
+/* @param A Pointer to the description */
+u64 HashDescriptorSetLayoutDescription(const DescriptorSetLayoutDescription* description)
+{
+	u64 hash = HashU64(description->BindingCount, HASH_SEED);
+	for (u32 i = 0; i < description->BindingCount; ++i)
+	{
+		const VkDescriptorSetLayoutBinding* binding = &description->Bindings[i];
+		hash = HashU64(binding->binding, hash);
+		hash = HashU64(binding->descriptorType, hash);
+		hash = HashU64(binding->descriptorCount, hash);
+		hash = HashU64(binding->stageFlags, hash);
+	}
+	return hash;
+}
+
+/* A function to check if two descriptor set layout descriptions are the same */
+/* @param A Pointer to the first description */
+/* @param A Pointer to the second description */
+bool IsSameDescriptorSetLayoutDescription(const DescriptorSetLayoutDescription* a, const DescriptorSetLayoutDescription* b)
+{
+	if (a->BindingCount != b->BindingCount)
+		return false;
+
+	for (u32 i = 0; i < a->BindingCount; ++i)
+		if ((a->Bindings[i].binding != b->Bindings[i].binding) || (a->Bindings[i].descriptorType != b->Bindings[i].descriptorType) ||
+			(a->Bindings[i].descriptorCount != b->Bindings[i].descriptorCount) || (a->Bindings[i].stageFlags != b->Bindings[i].stageFlags))
+			return false;
+
+	return true;
+}
+
+/* A function to create a pipeline layout cache */
+/* @param A Pointer to a logical device */
+/* @param True to give every binding and the push constants all graphics stages, or the compute stage, and a fixed push constant size */
+/* @param A Pointer to the PipelineLayoutCache to be filled */
+void CreatePipelineLayoutCache(VkDevice* logicalDevice, bool normalize, PipelineLayoutCache* cache)
+{
+	memset(cache, 0, sizeof(PipelineLayoutCache));
+	cache->LogicalDevice = logicalDevice;
+	cache->Normalize = normalize;
+	cache->SetLayouts = vec_create(CachedDescriptorSetLayout);
+	cache->PipelineLayouts = vec_create(CachedPipelineLayout);
+	InitializeMutex(&cache->Lock);
+}
+
+/* A function for getting the descriptor set layout of a description, it is created the first time, the lock must be held */
+/* @param A Pointer to the cache */
+/* @param A Pointer to the description */
+/* @param A Pointer to a VkDescriptorSetLayout to be filled */
+bool GetCachedDescriptorSetLayout(PipelineLayoutCache* cache, const DescriptorSetLayoutDescription* description, VkDescriptorSetLayout* layout)
+{
+	u64 hash = HashDescriptorSetLayoutDescription(description);
+	for (u64 i = 0; i < vec_length(cache->SetLayouts); ++i)
+	{
+		CachedDescriptorSetLayout* cached = &((CachedDescriptorSetLayout*)cache->SetLayouts)[i];
+		if ((cached->Hash == hash) && IsSameDescriptorSetLayoutDescription(&cached->Description, description))
+		{
+			*layout = cached->Layout;
+			++cache->Hits;
+			return true;
+		}
+	}
+
+	CachedDescriptorSetLayout cached;
+	cached.Hash = hash;
+	cached.Description = *description;
+	if (!CreateDescriptorSetLayout(cache->LogicalDevice, description->Bindings, description->BindingCount, &cached.Layout))
+		return false;
+
+	vec_pushback(cache->SetLayouts, cached, CachedDescriptorSetLayout);
+	*layout = cached.Layout;
+	++cache->Misses;
+	return true;
+}
+
+/* A function for getting the pipeline layout of a reflection, equal interfaces get the same VkPipelineLayout and VkDescriptorSetLayouts */
+/* @param A Pointer to the cache */
+/* @param A Pointer to the reflection of all stages of the pipeline */
+/* @param A Pointer to a VkPipelineLayout to be filled */
+/* @param A Pointer to an array of REFLECTION_MAX_SETS VkDescriptorSetLayout to be filled, can be null */
+bool GetPipelineLayoutFromReflection(PipelineLayoutCache* cache, const ShaderReflection* reflection, VkPipelineLayout* pipelineLayout, VkDescriptorSetLayout* setLayouts)
+{
+	CachedPipelineLayout cached;
+	memset(&cached, 0, sizeof(CachedPipelineLayout));
+	cached.SetCount = reflection->SetCount;
+	cached.PushConstants = reflection->PushConstants;
+
+	/* Vulkan calls layouts compatible for set N if sets 0 to N and the push constants are identical, so unused stages
+	   and bytes are declared anyway, and binding a new pipeline keeps the sets that are already bound. ALL_GRAPHICS has no mesh or task bits */
+	VkShaderStageFlags allStages = (reflection->Stages & VK_SHADER_STAGE_COMPUTE_BIT) ? VK_SHADER_STAGE_COMPUTE_BIT :
+		VK_SHADER_STAGE_ALL_GRAPHICS | (reflection->Stages & (VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_TASK_BIT_EXT));
+	if (cache->Normalize && (cached.PushConstants.offset + cached.PushConstants.size <= REFLECTION_PUSH_CONSTANT_SIZE))
+	{
+		cached.PushConstants.stageFlags = allStages;
+		cached.PushConstants.offset = 0;
+		cached.PushConstants.size = REFLECTION_PUSH_CONSTANT_SIZE;
+	}
+
+	LockMutex(&cache->Lock);
+
+	/* Sets without bindings in between still get an empty layout, so the set numbers stay the same */
+	for (u32 set = 0; set < reflection->SetCount; ++set)
+	{
+		DescriptorSetLayoutDescription description = reflection->Sets[set];
+		for (u32 i = 0; cache->Normalize && (i < description.BindingCount); ++i)
+			description.Bindings[i].stageFlags = allStages;
+
+		if (!GetCachedDescriptorSetLayout(cache, &description, &cached.SetLayouts[set]))
+		{
+			UnlockMutex(&cache->Lock);
+			return false;
+		}
+	}
+
+	cached.Hash = HashU64(cached.SetCount, HASH_SEED);
+	for (u32 set = 0; set < cached.SetCount; ++set)
+		cached.Hash = HashU64((u64)cached.SetLayouts[set], cached.Hash);
+	cached.Hash = HashU64(cached.PushConstants.stageFlags, cached.Hash);
+	cached.Hash = HashU64(cached.PushConstants.offset, cached.Hash);
+	cached.Hash = HashU64(cached.PushConstants.size, cached.Hash);
+
+	if (setLayouts)
+		memcpy(setLayouts, cached.SetLayouts, sizeof(cached.SetLayouts));
+
+	for (u64 i = 0; i < vec_length(cache->PipelineLayouts); ++i)
+	{
+		CachedPipelineLayout* existing = &((CachedPipelineLayout*)cache->PipelineLayouts)[i];
+		if ((existing->Hash == cached.Hash) && (existing->SetCount == cached.SetCount) &&
+			(memcmp(existing->SetLayouts, cached.SetLayouts, sizeof(cached.SetLayouts)) == 0) &&
+			(existing->PushConstants.stageFlags == cached.PushConstants.stageFlags) &&
+			(existing->PushConstants.offset == cached.PushConstants.offset) && (existing->PushConstants.size == cached.PushConstants.size))
+		{
+			*pipelineLayout = existing->Layout;
+			++cache->Hits;
+			UnlockMutex(&cache->Lock);
+			return true;
+		}
+	}
+
+	bool result = CreatePipelineLayout(cache->LogicalDevice, cached.SetLayouts, cached.SetCount, &cached.PushConstants,
+		cached.PushConstants.size ? 1 : 0, &cached.Layout);
+	if (result)
+	{
+		vec_pushback(cache->PipelineLayouts, cached, CachedPipelineLayout);
+		*pipelineLayout = cached.Layout;
+		++cache->Misses;
+	}
+
+	UnlockMutex(&cache->Lock);
+	return result;
+}
+
+/* A function to reflect the SPIR-V of every stage of a pipeline and get its shared pipeline layout */
+/* @param A Pointer to the cache */
+/* @param An array of pointers to the SPIR-V of each stage */
+/* @param An array of the SPIR-V sizes in bytes */
+/* @param The number of stages */
+/* @param A Pointer to the ShaderReflection to be filled */
+/* @param A Pointer to a VkPipelineLayout to be filled */
+bool ReflectPipelineLayout(PipelineLayoutCache* cache, const u32** spirv, const u64* sizes, u32 stageCount, ShaderReflection* reflection, VkPipelineLayout* pipelineLayout)
+{
+	memset(reflection, 0, sizeof(ShaderReflection));
+	for (u32 i = 0; i < stageCount; ++i)
+	{
+		ShaderReflection stage;
+		if (!ReflectSpirv(spirv[i], sizes[i], &stage) || !MergeShaderReflections(reflection, &stage))
+			return false;
+	}
+
+	return GetPipelineLayoutFromReflection(cache, reflection, pipelineLayout, nullptr);
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A pointer to the resource to cleanup */
+void DestroyPipelineLayoutCache(PipelineLayoutCache* cache)
+{
+	for (u64 i = 0; i < vec_length(cache->PipelineLayouts); ++i)
+		vkDestroyPipelineLayout(*cache->LogicalDevice, ((CachedPipelineLayout*)cache->PipelineLayouts)[i].Layout, nullptr);
+	for (u64 i = 0; i < vec_length(cache->SetLayouts); ++i)
+		vkDestroyDescriptorSetLayout(*cache->LogicalDevice, ((CachedDescriptorSetLayout*)cache->SetLayouts)[i].Layout, nullptr);
+
+	vec_destroy(cache->PipelineLayouts);
+	vec_destroy(cache->SetLayouts);
+	DestroyMutex(&cache->Lock);
+	memset(cache, 0, sizeof(PipelineLayoutCache));
+}
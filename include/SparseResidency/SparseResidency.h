@@ -0,0 +1,532 @@
+#pragma once
+#include <defines.h>
+#include <vector/vector.h>
+#include <VkHelper/VkHelper.h>
+
+/* The page table entry of a page that is not resident */
+#define SPARSE_PAGE_NOT_RESIDENT 0xFFFFFFFF
+
+/* The size of a page when sparse residency is not available and pages live in a texture array */
+#define SPARSE_FALLBACK_PAGE_SIZE 128
+
+/* A structure for the location of a virtual page */
+typedef struct {
+	u32 MipLevel;	/* The mip level of the page */
+	u32 X;			/* The column of the page inside the mip level */
+	u32 Y;			/* The row of the page inside the mip level */
+} SparsePage;
+
+/* A structure for a page that became resident and needs its texels uploaded */
+typedef struct {
+	SparsePage Page;	/* The virtual page */
+	u32 Slot;			/* The slot of the page pool, in the fallback path this is the layer of the texture array */
+} SparsePageUpload;
+
+/* A structure for the statistics of a residency manager */
+typedef struct {
+	u32 ResidentPages;	/* The number of pages that are resident right now */
+	u64 PagesBound;		/* The total number of pages that were made resident */
+	u64 PagesEvicted;	/* The total number of pages that got evicted to stay in the budget */
+	u64 Commits;		/* The total number of vkQueueBindSparse calls */
+} SparseResidencyStats;
+
+/* A structure for a texture whose pages are made resident on demand within a fixed budget */
+typedef struct {
+	bool Sparse;				/* True if the texture is a real sparse image, false if the fallback texture array is used */
+	VkImage Image;				/* The sparse image, or the texture array that holds the pages in the fallback path */
+	VkDeviceMemory PagePool;	/* The memory that pages get bound from, one slot per page of the budget */
+	VkDeviceMemory MipTail;		/* The memory of the mip tail, which always stays resident */
+	VkFormat Format;			/* The format of the texture */
+	VkExtent2D Extent;			/* The size of the top mip level */
+	u32 MipLevels;				/* The number of mip levels */
+	u32 FirstMipTailLevel;		/* The first mip level that lives in the mip tail, pages only exist below it */
+	VkExtent3D PageExtent;		/* The size of a page in texels */
+	VkDeviceSize PageSize;		/* The size of a page in bytes */
+	u32 PageBudget;				/* The number of pages that can be resident at the same time */
+	Vec MipPageOffsets;			/* A Vector of u32, the index of the first virtual page of every mip level */
+	Vec MipPageColumns;			/* A Vector of u32, the number of page columns of every mip level */
+	Vec PageTable;				/* A Vector of u32, the slot of every virtual page or SPARSE_PAGE_NOT_RESIDENT */
+	Vec SlotOwners;				/* A Vector of u32, the virtual page in every slot or SPARSE_PAGE_NOT_RESIDENT */
+	Vec SlotLastUsed;			/* A Vector of u64, the frame a slot was last requested in */
+	Vec PendingBinds;			/* A Vector of VkSparseImageMemoryBind waiting for the next commit */
+	Vec PendingUploads;			/* A Vector of SparsePageUpload for the pages that became resident since the last commit */
+	u64 Frame;					/* The current frame, used to find the least recently used page */
+	SparseResidencyStats Stats;	/* The statistics of the manager */
+} SparseResidencyManager;
+
+/* A function for getting the index of a virtual page */
+/* @param A Pointer to the residency manager */
+/* @param The virtual page */
+u32 GetSparseVirtualPageIndex(SparseResidencyManager* manager, SparsePage page)
+{
+	u32 offset = ((u32*)manager->MipPageOffsets)[page.MipLevel];
+	u32 columns = ((u32*)manager->MipPageColumns)[page.MipLevel];
+	return offset + page.Y * columns + page.X;
+}
+
+/* A function for getting the virtual page of an index */
+/* @param A Pointer to the residency manager */
+/* @param The index of the virtual page */
+SparsePage GetSparseVirtualPage(SparseResidencyManager* manager, u32 index)
+{
+	SparsePage page = { 0 };
+	u32* offsets = (u32*)manager->MipPageOffsets;
+	while ((page.MipLevel + 1 < manager->FirstMipTailLevel) && (offsets[page.MipLevel + 1] <= index))
+		++page.MipLevel;
+
+	u32 columns = ((u32*)manager->MipPageColumns)[page.MipLevel];
+	page.X = (index - offsets[page.MipLevel]) % columns;
+	page.Y = (index - offsets[page.MipLevel]) / columns;
+	return page;
+}
+
+/* A function for getting the size of a page in texels, pages on the right and bottom edge of a mip level that is not
+   a multiple of the page size stop at the edge */
+/* @param A Pointer to the residency manager */
+/* @param The virtual page */
+VkExtent3D GetSparsePageExtent(SparseResidencyManager* manager, SparsePage page)
+{
+	u32 width = manager->Extent.width >> page.MipLevel ? manager->Extent.width >> page.MipLevel : 1;
+	u32 height = manager->Extent.height >> page.MipLevel ? manager->Extent.height >> page.MipLevel : 1;
+	u32 x = page.X * manager->PageExtent.width;
+	u32 y = page.Y * manager->PageExtent.height;
+
+	VkExtent3D extent = manager->PageExtent;
+	extent.width = width - x < extent.width ? width - x : extent.width;
+	extent.height = height - y < extent.height ? height - y : extent.height;
+	return extent;
+}
+
+/* A function for building the page grid of every mip level that is not in the mip tail */
+/* @param A Pointer to the residency manager */
+void BuildSparsePageTable(SparseResidencyManager* manager)
+{
+	manager->MipPageOffsets = vec_reserve(u32, manager->FirstMipTailLevel + 1);
+	manager->MipPageColumns = vec_reserve(u32, manager->FirstMipTailLevel + 1);
+
+	u32 pageCount = 0;
+	for (u32 mip = 0; mip < manager->FirstMipTailLevel; ++mip)
+	{
+		u32 width = manager->Extent.width >> mip ? manager->Extent.width >> mip : 1;
+		u32 height = manager->Extent.height >> mip ? manager->Extent.height >> mip : 1;
+		u32 columns = (width + manager->PageExtent.width - 1) / manager->PageExtent.width;
+		u32 rows = (height + manager->PageExtent.height - 1) / manager->PageExtent.height;
+		vec_pushback(manager->MipPageOffsets, pageCount, u32);
+		vec_pushback(manager->MipPageColumns, columns, u32);
+		pageCount += columns * rows;
+	}
+	vec_pushback(manager->MipPageOffsets, pageCount, u32);
+
+	manager->PageTable = nullptr;
+	vec_resize(manager->PageTable, pageCount ? pageCount : 1, u32);
+	memset(manager->PageTable, 0xFF, vec_length(manager->PageTable) * sizeof(u32));
+
+	manager->SlotOwners = nullptr;
+	vec_resize(manager->SlotOwners, manager->PageBudget, u32);
+	memset(manager->SlotOwners, 0xFF, manager->PageBudget * sizeof(u32));
+
+	manager->SlotLastUsed = nullptr;
+	vec_resize(manager->SlotLastUsed, manager->PageBudget, u64);
+
+	manager->PendingBinds = vec_create(VkSparseImageMemoryBind);
+	manager->PendingUploads = vec_create(SparsePageUpload);
+}
+
+/* A function for creating the sparse image, its page pool and the always resident mip tail */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the sparse binding queue */
+/* @param A Pointer to the residency manager to fill in */
+bool CreateSparseResidencyImage(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkQueue* sparseQueue, SparseResidencyManager* manager)
+{
+	VkImageCreateInfo imageCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		nullptr,
+		VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
+		VK_IMAGE_TYPE_2D,
+		manager->Format,
+		{ manager->Extent.width, manager->Extent.height, 1 },
+		manager->MipLevels,
+		1,
+		VK_SAMPLE_COUNT_1_BIT,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_SHARING_MODE_EXCLUSIVE,
+		0,
+		nullptr,
+		VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	if (vkCreateImage(*logicalDevice, &imageCreateInfo, nullptr, &manager->Image) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a sparse image!\n");
+		return false;
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(*logicalDevice, manager->Image, &memoryRequirements);
+
+	u32 requirementsCount = 0;
+	vkGetImageSparseMemoryRequirements(*logicalDevice, manager->Image, &requirementsCount, nullptr);
+	Vec sparseRequirements = nullptr;
+	vec_resize(sparseRequirements, requirementsCount ? requirementsCount : 1, VkSparseImageMemoryRequirements);
+	vkGetImageSparseMemoryRequirements(*logicalDevice, manager->Image, &requirementsCount, (VkSparseImageMemoryRequirements*)sparseRequirements);
+
+	VkSparseImageMemoryRequirements* colorRequirements = nullptr;
+	for (u32 i = 0; i < requirementsCount; ++i)
+	{
+		VkSparseImageMemoryRequirements* requirements = (VkSparseImageMemoryRequirements*)vec_get_at(sparseRequirements, i);
+		if (requirements->formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+			colorRequirements = requirements;
+	}
+
+	if (colorRequirements == nullptr)
+	{
+		printf("ERROR: Sparse image has no color aspect requirements!\n");
+		vec_destroy(sparseRequirements);
+		return false;
+	}
+
+	manager->PageExtent = colorRequirements->formatProperties.imageGranularity;
+	manager->PageSize = memoryRequirements.alignment;
+	manager->FirstMipTailLevel = colorRequirements->imageMipTailFirstLod < manager->MipLevels ? colorRequirements->imageMipTailFirstLod : manager->MipLevels;
+
+	u32 memoryTypeIndex = 0;
+	if (!SelectMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memoryTypeIndex))
+	{
+		vec_destroy(sparseRequirements);
+		return false;
+	}
+
+	/* One allocation for the whole budget, pages are bound at slot * PageSize */
+	VkMemoryAllocateInfo memoryAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		nullptr,
+		manager->PageSize * manager->PageBudget,
+		memoryTypeIndex
+	};
+
+	if (vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &manager->PagePool) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate the sparse page pool!\n");
+		vec_destroy(sparseRequirements);
+		return false;
+	}
+
+	/* The mip tail is small and can not be bound per page, so it stays resident */
+	if ((colorRequirements->imageMipTailFirstLod < manager->MipLevels) && (colorRequirements->imageMipTailSize > 0))
+	{
+		memoryAllocateInfo.allocationSize = colorRequirements->imageMipTailSize;
+		if (vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &manager->MipTail) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not allocate the sparse mip tail!\n");
+			vec_destroy(sparseRequirements);
+			return false;
+		}
+
+		VkSparseMemoryBind mipTailBind =
+		{
+			colorRequirements->imageMipTailOffset,
+			colorRequirements->imageMipTailSize,
+			manager->MipTail,
+			0,
+			0
+		};
+
+		VkSparseImageOpaqueMemoryBindInfo opaqueBindInfo =
+		{
+			manager->Image,
+			1,
+			&mipTailBind
+		};
+
+		VkBindSparseInfo bindSparseInfo = { 0 };
+		bindSparseInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+		bindSparseInfo.imageOpaqueBindCount = 1;
+		bindSparseInfo.pImageOpaqueBinds = &opaqueBindInfo;
+
+		if (vkQueueBindSparse(*sparseQueue, 1, &bindSparseInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			printf("ERROR: Could not bind the sparse mip tail!\n");
+			vec_destroy(sparseRequirements);
+			return false;
+		}
+	}
+
+	vec_destroy(sparseRequirements);
+	return true;
+}
+
+/* A function for creating the texture array that holds the pages when sparse residency is not available */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the residency manager to fill in */
+bool CreateSparseFallbackPageArray(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, SparseResidencyManager* manager)
+{
+	manager->PageExtent.width = SPARSE_FALLBACK_PAGE_SIZE;
+	manager->PageExtent.height = SPARSE_FALLBACK_PAGE_SIZE;
+	manager->PageExtent.depth = 1;
+	manager->FirstMipTailLevel = manager->MipLevels;
+
+	/* Every layer of the array is one physical page, the shader goes through the page table to find it */
+	VkImageCreateInfo imageCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		nullptr,
+		0,
+		VK_IMAGE_TYPE_2D,
+		manager->Format,
+		manager->PageExtent,
+		1,
+		manager->PageBudget,
+		VK_SAMPLE_COUNT_1_BIT,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_SHARING_MODE_EXCLUSIVE,
+		0,
+		nullptr,
+		VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	if (vkCreateImage(*logicalDevice, &imageCreateInfo, nullptr, &manager->Image) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create the fallback page array!\n");
+		return false;
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(*logicalDevice, manager->Image, &memoryRequirements);
+	manager->PageSize = memoryRequirements.size / manager->PageBudget;
+
+	u32 memoryTypeIndex = 0;
+	if (!SelectMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memoryTypeIndex))
+		return false;
+
+	VkMemoryAllocateInfo memoryAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		nullptr,
+		memoryRequirements.size,
+		memoryTypeIndex
+	};
+
+	if (vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &manager->PagePool) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate the fallback page array!\n");
+		return false;
+	}
+
+	if (vkBindImageMemory(*logicalDevice, manager->Image, manager->PagePool, 0) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not bind memory to the fallback page array!\n");
+		return false;
+	}
+
+	return true;
+}
+
+void DestroySparseResidencyManager(VkDevice* logicalDevice, SparseResidencyManager* manager);
+
+/* A function for creating a residency manager, it uses sparse residency when the device supports it and falls back on a texture array with a software page table */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to a queue from a family with VK_QUEUE_SPARSE_BINDING_BIT, can be null if sparse residency is not used */
+/* @param If sparseBinding and sparseResidencyImage2D were enabled when the logical device was created */
+/* @param The format of the texture */
+/* @param The size of the top mip level */
+/* @param The number of mip levels */
+/* @param The number of pages that can be resident at the same time */
+/* @param A Pointer to the residency manager to be filled */
+bool CreateSparseResidencyManager(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkQueue* sparseQueue, bool sparseEnabled, VkFormat format,
+	VkExtent2D extent, u32 mipLevels, u32 pageBudget, SparseResidencyManager* manager)
+{
+	memset(manager, 0, sizeof(SparseResidencyManager));
+	manager->Format = format;
+	manager->Extent = extent;
+	manager->MipLevels = mipLevels;
+	manager->PageBudget = pageBudget;
+	manager->Sparse = (sparseQueue != nullptr) && sparseEnabled && IsSparseImageFormatSupported(physicalDevice, format);
+
+	bool created = false;
+	if (manager->Sparse)
+		created = CreateSparseResidencyImage(physicalDevice, logicalDevice, sparseQueue, manager);
+	else
+	{
+		printf("WARNING: Sparse residency not available, falling back on a software page table!\n");
+		created = CreateSparseFallbackPageArray(physicalDevice, logicalDevice, manager);
+	}
+
+	/* The image and memory that did get made are freed again */
+	if (!created)
+	{
+		DestroySparseResidencyManager(logicalDevice, manager);
+		return false;
+	}
+
+	BuildSparsePageTable(manager);
+	return true;
+}
+
+/* A function for finding a slot for a new page, it takes a free slot or evicts the least recently used page */
+/* @param A Pointer to the residency manager */
+/* @param A Pointer to a u32 for the output slot */
+bool AcquireSparsePageSlot(SparseResidencyManager* manager, u32* slot)
+{
+	u32* owners = (u32*)manager->SlotOwners;
+	u64* lastUsed = (u64*)manager->SlotLastUsed;
+
+	u32 oldest = SPARSE_PAGE_NOT_RESIDENT;
+	for (u32 i = 0; i < manager->PageBudget; ++i)
+	{
+		if (owners[i] == SPARSE_PAGE_NOT_RESIDENT)
+		{
+			*slot = i;
+			return true;
+		}
+
+		/* Pages requested this frame are in use and can not be evicted */
+		if ((lastUsed[i] < manager->Frame) && ((oldest == SPARSE_PAGE_NOT_RESIDENT) || (lastUsed[i] < lastUsed[oldest])))
+			oldest = i;
+	}
+
+	if (oldest == SPARSE_PAGE_NOT_RESIDENT)
+		return false;
+
+	/* Evicting in the sparse path means binding the page back to no memory */
+	SparsePage evicted = GetSparseVirtualPage(manager, owners[oldest]);
+	if (manager->Sparse)
+	{
+		VkSparseImageMemoryBind unbind = { 0 };
+		unbind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		unbind.subresource.mipLevel = evicted.MipLevel;
+		unbind.offset.x = (i32)(evicted.X * manager->PageExtent.width);
+		unbind.offset.y = (i32)(evicted.Y * manager->PageExtent.height);
+		unbind.extent = GetSparsePageExtent(manager, evicted);
+		unbind.memory = VK_NULL_HANDLE;
+		vec_pushback(manager->PendingBinds, unbind, VkSparseImageMemoryBind);
+	}
+
+	((u32*)manager->PageTable)[owners[oldest]] = SPARSE_PAGE_NOT_RESIDENT;
+	owners[oldest] = SPARSE_PAGE_NOT_RESIDENT;
+	--manager->Stats.ResidentPages;
+	++manager->Stats.PagesEvicted;
+
+	*slot = oldest;
+	return true;
+}
+
+/* A function for requesting the pages that the feedback pass found visible this frame */
+/* @param A Pointer to the residency manager */
+/* @param A Vector (MUST BE VALID) of SparsePages that were requested by the feedback */
+void RequestSparsePages(SparseResidencyManager* manager, Vec requestedPages)
+{
+	++manager->Frame;
+	u32* pageTable = (u32*)manager->PageTable;
+
+	for (u32 i = 0; i < vec_length(requestedPages); ++i)
+	{
+		SparsePage* page = (SparsePage*)vec_get_at(requestedPages, i);
+		if (page->MipLevel >= manager->FirstMipTailLevel)
+			continue;
+
+		u32 index = GetSparseVirtualPageIndex(manager, *page);
+		if (index >= vec_length(manager->PageTable))
+			continue;
+
+		if (pageTable[index] != SPARSE_PAGE_NOT_RESIDENT)
+		{
+			((u64*)manager->SlotLastUsed)[pageTable[index]] = manager->Frame;
+			continue;
+		}
+
+		u32 slot = 0;
+		if (!AcquireSparsePageSlot(manager, &slot))
+		{
+			printf("WARNING: Sparse page budget exhausted, page request dropped!\n");
+			break;
+		}
+
+		if (manager->Sparse)
+		{
+			VkSparseImageMemoryBind bind = { 0 };
+			bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bind.subresource.mipLevel = page->MipLevel;
+			bind.offset.x = (i32)(page->X * manager->PageExtent.width);
+			bind.offset.y = (i32)(page->Y * manager->PageExtent.height);
+			bind.extent = GetSparsePageExtent(manager, *page);
+			bind.memory = manager->PagePool;
+			bind.memoryOffset = slot * manager->PageSize;
+			vec_pushback(manager->PendingBinds, bind, VkSparseImageMemoryBind);
+		}
+
+		pageTable[index] = slot;
+		((u32*)manager->SlotOwners)[slot] = index;
+		((u64*)manager->SlotLastUsed)[slot] = manager->Frame;
+		++manager->Stats.ResidentPages;
+		++manager->Stats.PagesBound;
+
+		SparsePageUpload upload = { *page, slot };
+		vec_pushback(manager->PendingUploads, upload, SparsePageUpload);
+	}
+}
+
+/* A function for binding and unbinding all the pages that changed since the last commit */
+/* The texels of the new pages in PendingUploads have to be uploaded after this and the list cleared */
+/* @param A Pointer to the residency manager */
+/* @param A Pointer to the sparse binding queue, can be null in the fallback path */
+/* @param A Pointer to a semaphore to signal when the binds are done, can be null */
+/* @param A Pointer to a fence to signal when the binds are done, can be null */
+bool CommitSparsePages(SparseResidencyManager* manager, VkQueue* sparseQueue, VkSemaphore* signalSemaphore, VkFence* fence)
+{
+	if (!manager->Sparse || (vec_length(manager->PendingBinds) == 0))
+		return true;
+
+	VkSparseImageMemoryBindInfo imageBindInfo =
+	{
+		manager->Image,
+		(u32)vec_length(manager->PendingBinds),
+		(const VkSparseImageMemoryBind*)manager->PendingBinds
+	};
+
+	VkBindSparseInfo bindSparseInfo = { 0 };
+	bindSparseInfo.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+	bindSparseInfo.imageBindCount = 1;
+	bindSparseInfo.pImageBinds = &imageBindInfo;
+	bindSparseInfo.signalSemaphoreCount = signalSemaphore != nullptr ? 1 : 0;
+	bindSparseInfo.pSignalSemaphores = signalSemaphore;
+
+	VkResult result = vkQueueBindSparse(*sparseQueue, 1, &bindSparseInfo, fence != nullptr ? *fence : VK_NULL_HANDLE);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not bind sparse pages!\n");
+		return false;
+	}
+
+	vec_clear(manager->PendingBinds);
+	++manager->Stats.Commits;
+	return true;
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A Pointer to a logical device */
+/* @param A pointer to the resource to cleanup */
+void DestroySparseResidencyManager(VkDevice* logicalDevice, SparseResidencyManager* manager)
+{
+	if (manager->Image != VK_NULL_HANDLE)
+		vkDestroyImage(*logicalDevice, manager->Image, nullptr);
+	if (manager->PagePool != VK_NULL_HANDLE)
+		vkFreeMemory(*logicalDevice, manager->PagePool, nullptr);
+	if (manager->MipTail != VK_NULL_HANDLE)
+		vkFreeMemory(*logicalDevice, manager->MipTail, nullptr);
+
+	vec_destroy(manager->MipPageOffsets);
+	vec_destroy(manager->MipPageColumns);
+	vec_destroy(manager->PageTable);
+	vec_destroy(manager->SlotOwners);
+	vec_destroy(manager->SlotLastUsed);
+	vec_destroy(manager->PendingBinds);
+	vec_destroy(manager->PendingUploads);
+	memset(manager, 0, sizeof(SparseResidencyManager));
+}
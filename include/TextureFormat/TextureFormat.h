@@ -0,0 +1,640 @@
+#pragma once
+#include <stdlib.h>
+#include <defines.h>
+#include <vector/vector.h>
+#include <VkHelper/VkHelper.h>
+#include <TextureStreaming/TextureStreaming.h>
+#include <Timer/Timer.h>
+#include <JobSystem/JobSystem.h>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_FORMAT_SSE2
+#endif
+
+/* A function for checking if the device can sample a format with optimal tiling */
+/* @param A Pointer to a physical device */
+/* @param The format to check */
+bool IsFormatSupportedForSampling(VkPhysicalDevice* physicalDevice, VkFormat format)
+{
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(*physicalDevice, format, &formatProperties);
+	return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
+		(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+}
+
+/* A function for getting the block size of a format, uncompressed formats are 1x1 blocks */
+/* @param The format */
+/* @param A Pointer to a u32 for the width of a block in texels */
+/* @param A Pointer to a u32 for the height of a block in texels */
+/* @param A Pointer to a u32 for the size of a block in bytes */
+bool GetFormatBlockInfo(VkFormat format, u32* blockWidth, u32* blockHeight, u32* blockBytes)
+{
+	*blockWidth = 4;
+	*blockHeight = 4;
+
+	switch (format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+			*blockBytes = 8;
+			return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+		case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+			*blockBytes = 16;
+			return true;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			*blockWidth = 1;
+			*blockHeight = 1;
+			*blockBytes = 4;
+			return true;
+		default:
+			printf("ERROR: Unknown block size of format %d!\n", (int)format);
+			return false;
+	}
+}
+
+/* A function for getting the size in bytes of one mip of a format */
+/* @param The format */
+/* @param The width of the mip */
+/* @param The height of the mip */
+VkDeviceSize GetFormatMipSize(VkFormat format, u32 width, u32 height)
+{
+	u32 blockWidth, blockHeight, blockBytes;
+	if (!GetFormatBlockInfo(format, &blockWidth, &blockHeight, &blockBytes))
+		return 0;
+
+	return (VkDeviceSize)((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * blockBytes;
+}
+
+/* A function for selecting the best block compressed format the device can sample, falls back on RGBA8 */
+/* @param A Pointer to a physical device */
+/* @param An option for textures with alpha */
+/* @param An option for sRGB textures */
+VkFormat SelectBestBlockFormat(VkPhysicalDevice* physicalDevice, bool alpha, bool srgb)
+{
+	/* Best quality first, desktop GPUs have BC, mobile GPUs have ASTC and ETC2 */
+	VkFormat candidates[][2] =
+	{
+		{ VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK },
+		{ alpha ? VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK : VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, alpha ? VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK : VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK },
+		{ alpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK, alpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK }
+	};
+
+	for (u32 i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i)
+	{
+		if (IsFormatSupportedForSampling(physicalDevice, candidates[i][srgb ? 1 : 0]))
+			return candidates[i][srgb ? 1 : 0];
+	}
+
+	printf("WARNING: No block compressed format supported, falling back on uncompressed RGBA8!\n");
+	return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+/* A function for selecting the format the CPU transcoder should produce for this device */
+/* @param A Pointer to a physical device */
+/* @param An option for textures with alpha */
+/* @param An option for sRGB textures */
+VkFormat SelectTranscodeTargetFormat(VkPhysicalDevice* physicalDevice, bool alpha, bool srgb)
+{
+	VkFormat target = alpha ? (srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK) : (srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+	if (IsFormatSupportedForSampling(physicalDevice, target))
+		return target;
+
+	return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+/* A structure for a texture loaded from a container file, the mips point into the file data */
+typedef struct {
+	VkFormat Format;	/* The format of the texels */
+	VkExtent3D Extent;	/* The size of the largest mip */
+	Vec Mips;			/* A Vector of TextureMipData, ready for AddStreamingTexture */
+} LoadedTexture;
+
+/* A function for mapping a DXGI format from a DDS DX10 header to a Vulkan format */
+/* @param The DXGI format number */
+VkFormat GetFormatFromDxgiFormat(u32 dxgiFormat)
+{
+	switch (dxgiFormat)
+	{
+		case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+		case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+		case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+		case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+		case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+		case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+		case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+		case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+		case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+	}
+}
+
+/* A function for building the mip list of a texture whose mips are tightly packed one after the other */
+/* @param A Pointer to the texture with Format and Extent filled in */
+/* @param The number of mips */
+/* @param A Pointer to the first mip */
+/* @param The number of bytes after the first mip */
+bool BuildPackedTextureMips(LoadedTexture* texture, u32 mipCount, const u8* data, u64 dataSize)
+{
+	texture->Mips = vec_reserve(TextureMipData, mipCount ? mipCount : 1);
+	u64 offset = 0;
+
+	for (u32 mip = 0; mip < (mipCount ? mipCount : 1); ++mip)
+	{
+		TextureMipData mipData = { 0 };
+		mipData.Extent.width = texture->Extent.width >> mip ? texture->Extent.width >> mip : 1;
+		mipData.Extent.height = texture->Extent.height >> mip ? texture->Extent.height >> mip : 1;
+		mipData.Extent.depth = 1;
+		mipData.Size = GetFormatMipSize(texture->Format, mipData.Extent.width, mipData.Extent.height);
+		mipData.Data = data + offset;
+
+		if ((mipData.Size == 0) || (offset + mipData.Size > dataSize))
+		{
+			printf("ERROR: Texture data is smaller than its mips!\n");
+			vec_destroy(texture->Mips);
+			texture->Mips = nullptr;
+			return false;
+		}
+
+		offset += mipData.Size;
+		vec_pushback(texture->Mips, mipData, TextureMipData);
+	}
+
+	return true;
+}
+
+/* A function for loading a DDS file that is already in memory, the texels are not copied */
+/* @param A Pointer to the file data */
+/* @param The size of the file data */
+/* @param A Pointer to a LoadedTexture to be filled */
+bool LoadDDSTexture(const u8* data, u64 dataSize, LoadedTexture* texture)
+{
+	memset(texture, 0, sizeof(LoadedTexture));
+
+	/* "DDS " magic followed by the 124 byte header */
+	if ((dataSize < 128) || (memcmp(data, "DDS ", 4) != 0))
+	{
+		printf("ERROR: Data is not a DDS file!\n");
+		return false;
+	}
+
+	const u32* header = (const u32*)(data + 4);
+	u32 height = header[2];
+	u32 width = header[3];
+	u32 mipCount = header[6];
+	u32 fourCC = header[20];
+	u64 dataOffset = 128;
+
+	if (fourCC == *(const u32*)"DXT1")
+		texture->Format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	else if (fourCC == *(const u32*)"DXT3")
+		texture->Format = VK_FORMAT_BC2_UNORM_BLOCK;
+	else if (fourCC == *(const u32*)"DXT5")
+		texture->Format = VK_FORMAT_BC3_UNORM_BLOCK;
+	else if ((fourCC == *(const u32*)"ATI1") || (fourCC == *(const u32*)"BC4U"))
+		texture->Format = VK_FORMAT_BC4_UNORM_BLOCK;
+	else if ((fourCC == *(const u32*)"ATI2") || (fourCC == *(const u32*)"BC5U"))
+		texture->Format = VK_FORMAT_BC5_UNORM_BLOCK;
+	else if (fourCC == *(const u32*)"DX10")
+	{
+		if (dataSize < 148)
+		{
+			printf("ERROR: DDS file is missing its DX10 header!\n");
+			return false;
+		}
+		texture->Format = GetFormatFromDxgiFormat(*(const u32*)(data + 128));
+		dataOffset = 148;
+	}
+
+	if (texture->Format == VK_FORMAT_UNDEFINED)
+	{
+		printf("ERROR: DDS file has a format that is not supported!\n");
+		return false;
+	}
+
+	texture->Extent.width = width;
+	texture->Extent.height = height;
+	texture->Extent.depth = 1;
+	return BuildPackedTextureMips(texture, mipCount, data + dataOffset, dataSize - dataOffset);
+}
+
+/* A function for loading a KTX2 file that is already in memory, the texels are not copied */
+/* Only files without supercompression can be loaded, their vkFormat is used as is */
+/* @param A Pointer to the file data */
+/* @param The size of the file data */
+/* @param A Pointer to a LoadedTexture to be filled */
+bool LoadKTX2Texture(const u8* data, u64 dataSize, LoadedTexture* texture)
+{
+	static const u8 identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	memset(texture, 0, sizeof(LoadedTexture));
+
+	/* The identifier, 9 u32 header fields and the 4 index fields come before the level index */
+	if ((dataSize < 80) || (memcmp(data, identifier, sizeof(identifier)) != 0))
+	{
+		printf("ERROR: Data is not a KTX2 file!\n");
+		return false;
+	}
+
+	const u32* header = (const u32*)(data + 12);
+	u32 levelCount = header[7] ? header[7] : 1;
+	u32 supercompressionScheme = header[8];
+
+	if (supercompressionScheme != 0)
+	{
+		printf("ERROR: Supercompressed KTX2 files have to be transcoded first!\n");
+		return false;
+	}
+
+	/* Only plain 2D textures are loaded, the depth, layer and face counts have to be 0, 0 and 1 */
+	if ((header[4] > 0) || (header[5] > 0) || (header[6] > 1))
+	{
+		printf("ERROR: KTX2 file is a 3D, array or cube texture, only 2D textures can be loaded!\n");
+		return false;
+	}
+
+	/* The extent of level 32 or later would need a shift by the whole width of a u32 */
+	if (levelCount >= 32)
+	{
+		printf("ERROR: KTX2 file has too many levels!\n");
+		return false;
+	}
+
+	if (80 + (u64)levelCount * 24 > dataSize)
+	{
+		printf("ERROR: KTX2 file is smaller than its level index!\n");
+		return false;
+	}
+
+	texture->Format = (VkFormat)header[0];
+	texture->Extent.width = header[2];
+	texture->Extent.height = header[3] ? header[3] : 1;
+	texture->Extent.depth = 1;
+	texture->Mips = vec_reserve(TextureMipData, levelCount);
+
+	/* Every level has a byte offset, byte length and uncompressed byte length */
+	const u64* levelIndex = (const u64*)(data + 80);
+	for (u32 level = 0; level < levelCount; ++level)
+	{
+		TextureMipData mipData = { 0 };
+		mipData.Extent.width = texture->Extent.width >> level ? texture->Extent.width >> level : 1;
+		mipData.Extent.height = texture->Extent.height >> level ? texture->Extent.height >> level : 1;
+		mipData.Extent.depth = 1;
+		u64 offset = levelIndex[level * 3];
+		mipData.Size = levelIndex[level * 3 + 1];
+
+		/* Checked without adding so a huge offset or length can not wrap around */
+		if ((offset > dataSize) || (mipData.Size > dataSize - offset))
+		{
+			printf("ERROR: KTX2 level %u is outside of the file!\n", level);
+			vec_destroy(texture->Mips);
+			texture->Mips = nullptr;
+			return false;
+		}
+
+		mipData.Data = data + offset;
+		vec_pushback(texture->Mips, mipData, TextureMipData);
+	}
+
+	return true;
+}
+
+/* A function for packing an 8 bit color to 5:6:5 */
+/* @param The red channel */
+/* @param The green channel */
+/* @param The blue channel */
+u16 PackColor565(u32 r, u32 g, u32 b)
+{
+	return (u16)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+/* A function for unpacking a 5:6:5 color to 8 bits per channel */
+/* @param The packed color */
+/* @param A Pointer to 3 ints for the output channels */
+void UnpackColor565(u16 color, i32* rgb)
+{
+	rgb[0] = ((color >> 11) & 31) * 255 / 31;
+	rgb[1] = ((color >> 5) & 63) * 255 / 63;
+	rgb[2] = (color & 31) * 255 / 31;
+}
+
+/* A function for finding the smallest and largest channels of a 4x4 block of RGBA8 texels */
+/* @param A Pointer to the 64 bytes of the block */
+/* @param A Pointer to 4 bytes for the minimum of every channel */
+/* @param A Pointer to 4 bytes for the maximum of every channel */
+void GetBlockColorBounds(const u8* block, u8* minimum, u8* maximum)
+{
+#ifdef TEXTURE_FORMAT_SSE2
+	__m128i row0 = _mm_loadu_si128((const __m128i*)(block));
+	__m128i row1 = _mm_loadu_si128((const __m128i*)(block + 16));
+	__m128i row2 = _mm_loadu_si128((const __m128i*)(block + 32));
+	__m128i row3 = _mm_loadu_si128((const __m128i*)(block + 48));
+	__m128i low = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+	__m128i high = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+
+	/* Fold the four texels of the register down to one */
+	low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+	low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+	high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(1, 0, 3, 2)));
+	high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	u32 packedLow = (u32)_mm_cvtsi128_si32(low);
+	u32 packedHigh = (u32)_mm_cvtsi128_si32(high);
+	memcpy(minimum, &packedLow, 4);
+	memcpy(maximum, &packedHigh, 4);
+#else
+	memset(minimum, 255, 4);
+	memset(maximum, 0, 4);
+	for (u32 texel = 0; texel < 16; ++texel)
+	{
+		for (u32 channel = 0; channel < 4; ++channel)
+		{
+			u8 value = block[texel * 4 + channel];
+			minimum[channel] = value < minimum[channel] ? value : minimum[channel];
+			maximum[channel] = value > maximum[channel] ? value : maximum[channel];
+		}
+	}
+#endif
+}
+
+/* A function for encoding the color of a 4x4 block of RGBA8 texels as a BC1 block */
+/* @param A Pointer to the 64 bytes of the block */
+/* @param A Pointer to the 4 bytes of the bounds from GetBlockColorBounds */
+/* @param A Pointer to the 4 bytes of the bounds from GetBlockColorBounds */
+/* @param A Pointer to 8 bytes for the output block */
+void EncodeBC1ColorBlock(const u8* block, const u8* minimum, const u8* maximum, u8* output)
+{
+	/* Pull the end points in a little, the extremes are rarely hit and this lowers the average error */
+	i32 low[3], high[3];
+	for (u32 channel = 0; channel < 3; ++channel)
+	{
+		i32 inset = (maximum[channel] - minimum[channel]) >> 4;
+		low[channel] = minimum[channel] + inset;
+		high[channel] = maximum[channel] - inset;
+	}
+
+	u16 color0 = PackColor565(high[0], high[1], high[2]);
+	u16 color1 = PackColor565(low[0], low[1], low[2]);
+	u32 indices = 0;
+
+	if (color0 != color1)
+	{
+		/* color0 has to be the larger value for the 4 color mode */
+		bool swapped = color0 < color1;
+		if (swapped)
+		{
+			u16 temp = color0;
+			color0 = color1;
+			color1 = temp;
+		}
+
+		i32 end0[3], end1[3];
+		UnpackColor565(color0, end0);
+		UnpackColor565(color1, end1);
+		i32 axis[3] = { end1[0] - end0[0], end1[1] - end0[1], end1[2] - end0[2] };
+		i32 length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+		/* Project every texel on the line between the end points, palette order is 0, 2, 3, 1 along the line */
+		static const u32 paletteOrder[4] = { 0, 2, 3, 1 };
+		for (u32 texel = 0; texel < 16; ++texel)
+		{
+			const u8* color = block + texel * 4;
+			i32 projection = (color[0] - end0[0]) * axis[0] + (color[1] - end0[1]) * axis[1] + (color[2] - end0[2]) * axis[2];
+			i32 step = length > 0 ? (projection * 3 + length / 2) / length : 0;
+			step = step < 0 ? 0 : (step > 3 ? 3 : step);
+			indices |= paletteOrder[step] << (texel * 2);
+		}
+	}
+
+	output[0] = (u8)(color0 & 0xFF);
+	output[1] = (u8)(color0 >> 8);
+	output[2] = (u8)(color1 & 0xFF);
+	output[3] = (u8)(color1 >> 8);
+	memcpy(output + 4, &indices, 4);
+}
+
+/* A function for encoding the alpha of a 4x4 block of RGBA8 texels as a BC4 block */
+/* @param A Pointer to the 64 bytes of the block */
+/* @param The smallest alpha of the block */
+/* @param The largest alpha of the block */
+/* @param A Pointer to 8 bytes for the output block */
+void EncodeBC4AlphaBlock(const u8* block, u8 minimum, u8 maximum, u8* output)
+{
+	output[0] = maximum;
+	output[1] = minimum;
+	u64 indices = 0;
+
+	if (maximum != minimum)
+	{
+		/* Palette order is 0, 2, 3, 4, 5, 6, 7, 1 from the largest to the smallest value */
+		static const u64 paletteOrder[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+		i32 range = maximum - minimum;
+		for (u32 texel = 0; texel < 16; ++texel)
+		{
+			i32 step = ((maximum - block[texel * 4 + 3]) * 7 + range / 2) / range;
+			indices |= paletteOrder[step] << (texel * 3);
+		}
+	}
+
+	for (u32 i = 0; i < 6; ++i)
+		output[2 + i] = (u8)(indices >> (i * 8));
+}
+
+/* A function for block compressing rows of 4 by 4 blocks of RGBA8 texels into BC1, or BC3 with alpha */
+/* @param A Pointer to the RGBA8 texels */
+/* @param The width of the texels */
+/* @param The height of the texels */
+/* @param If the target has alpha, BC3 instead of BC1 */
+/* @param The first row of blocks */
+/* @param The number of rows of blocks */
+/* @param A Pointer to the output of the whole texture, the rows land at their own offset */
+void TranscodeRGBA8BlockRows(const u8* texels, u32 width, u32 height, bool alpha, u32 firstRow, u32 rowCount, u8* output)
+{
+	u32 blockBytes = alpha ? 16 : 8;
+	output += (size_t)firstRow * ((width + 3) / 4) * blockBytes;
+
+	u8 block[64];
+	for (u32 blockY = firstRow * 4; (blockY < height) && (blockY < (firstRow + rowCount) * 4); blockY += 4)
+	{
+		for (u32 blockX = 0; blockX < width; blockX += 4)
+		{
+			/* Gather the block, edges repeat the last texel */
+			for (u32 y = 0; y < 4; ++y)
+			{
+				u32 sourceY = blockY + y < height ? blockY + y : height - 1;
+				for (u32 x = 0; x < 4; ++x)
+				{
+					u32 sourceX = blockX + x < width ? blockX + x : width - 1;
+					memcpy(block + (y * 4 + x) * 4, texels + ((size_t)sourceY * width + sourceX) * 4, 4);
+				}
+			}
+
+			u8 minimum[4], maximum[4];
+			GetBlockColorBounds(block, minimum, maximum);
+
+			if (alpha)
+			{
+				EncodeBC4AlphaBlock(block, minimum[3], maximum[3], output);
+				output += 8;
+			}
+
+			EncodeBC1ColorBlock(block, minimum, maximum, output);
+			output += 8;
+		}
+	}
+}
+
+/* A function for checking a transcode target, and if it is block compressed with alpha */
+/* @param The target format */
+/* @param A Pointer to a bool for if the target is BC3 */
+/* @param A Pointer to a bool for if the target is RGBA8 and only needs a copy */
+bool GetTranscodeTarget(VkFormat target, bool* alpha, bool* copy)
+{
+	*alpha = (target == VK_FORMAT_BC3_UNORM_BLOCK) || (target == VK_FORMAT_BC3_SRGB_BLOCK);
+	*copy = (target == VK_FORMAT_R8G8B8A8_UNORM) || (target == VK_FORMAT_R8G8B8A8_SRGB);
+	bool color = *alpha || (target == VK_FORMAT_BC1_RGB_UNORM_BLOCK) || (target == VK_FORMAT_BC1_RGB_SRGB_BLOCK) ||
+		(target == VK_FORMAT_BC1_RGBA_UNORM_BLOCK) || (target == VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+
+	if (!color && !*copy)
+	{
+		printf("ERROR: Can not transcode to format %d on the CPU!\n", (int)target);
+		return false;
+	}
+
+	return true;
+}
+
+/* A function for transcoding RGBA8 texels to a format the device supports, on the CPU */
+/* BC1 and BC3 targets are block compressed, RGBA8 targets are copied */
+/* @param A Pointer to the RGBA8 texels */
+/* @param The width of the texels */
+/* @param The height of the texels */
+/* @param The target format from SelectTranscodeTargetFormat */
+/* @param A Pointer to GetFormatMipSize bytes for the output */
+bool TranscodeRGBA8Texels(const u8* texels, u32 width, u32 height, VkFormat target, u8* output)
+{
+	bool alpha = false;
+	bool copy = false;
+	if (!GetTranscodeTarget(target, &alpha, &copy))
+		return false;
+
+	if (copy)
+	{
+		memcpy(output, texels, (size_t)width * height * 4);
+		return true;
+	}
+
+	TranscodeRGBA8BlockRows(texels, width, height, alpha, 0, (height + 3) / 4, output);
+	return true;
+}
+
+/* A structure for the texture a parallel transcode works on */
+typedef struct {
+	const u8* Texels;	/* The RGBA8 texels */
+	u32 Width;			/* The width of the texels */
+	u32 Height;			/* The height of the texels */
+	bool Alpha;			/* If the target is BC3 */
+	u8* Output;			/* The output of the whole texture */
+} TranscodeJob;
+
+/* The function transcoding a range of block rows of a parallel transcode */
+void TranscodeBlockRowsJob(u32 first, u32 count, void* userData)
+{
+	TranscodeJob* job = (TranscodeJob*)userData;
+	TranscodeRGBA8BlockRows(job->Texels, job->Width, job->Height, job->Alpha, first, count, job->Output);
+}
+
+/* A function for transcoding RGBA8 texels like TranscodeRGBA8Texels, with the rows of blocks spread over the job system */
+/* @param A Pointer to the job system */
+/* @param A Pointer to the RGBA8 texels */
+/* @param The width of the texels */
+/* @param The height of the texels */
+/* @param The target format from SelectTranscodeTargetFormat */
+/* @param A Pointer to GetFormatMipSize bytes for the output */
+bool TranscodeRGBA8TexelsParallel(JobSystem* jobs, const u8* texels, u32 width, u32 height, VkFormat target, u8* output)
+{
+	bool alpha = false;
+	bool copy = false;
+	if (!GetTranscodeTarget(target, &alpha, &copy))
+		return false;
+
+	if (copy)
+	{
+		memcpy(output, texels, (size_t)width * height * 4);
+		return true;
+	}
+
+	/* About 16K texels per job, small mips end up as one job */
+	TranscodeJob job = { texels, width, height, alpha, output };
+	u32 rowsPerJob = 4096 / ((width + 3) / 4) + 1;
+	ParallelFor(jobs, (height + 3) / 4, rowsPerJob, TranscodeBlockRowsJob, &job);
+	return true;
+}
+
+/* A function for measuring how many megabytes of RGBA8 texels one core transcodes per second, no GPU is needed */
+/* @param The target format */
+/* @param The width and height of the test texture */
+/* @param The number of times to transcode the texture */
+double MeasureTranscodeThroughput(VkFormat target, u32 size, u32 iterations)
+{
+	u64 sourceSize = (u64)size * size * 4;
+	u8* texels = (u8*)malloc((size_t)sourceSize);
+	u8* output = (u8*)malloc((size_t)sourceSize);
+	if ((texels == nullptr) || (output == nullptr))
+	{
+		free(texels);
+		free(output);
+		return 0.0;
+	}
+
+	/* Gradients with some noise so the blocks are not all flat */
+	u32 seed = 12345;
+	for (u64 i = 0; i < sourceSize; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		texels[i] = (u8)(((i / 4) % size) + ((seed >> 24) & 15));
+	}
+
+	double start = GetTimeInSeconds();
+	for (u32 i = 0; i < iterations; ++i)
+		TranscodeRGBA8Texels(texels, size, size, target, output);
+	double seconds = GetTimeInSeconds() - start;
+
+	free(texels);
+	free(output);
+
+	double megabytesPerSecond = seconds > 0.0 ? ((double)sourceSize * iterations / (1024.0 * 1024.0)) / seconds : 0.0;
+	printf("INFO: Transcoded %u %ux%u textures to format %d at %.1f MB/s on one core\n", iterations, size, size, (int)target, megabytesPerSecond);
+	return megabytesPerSecond;
+}
@@ -0,0 +1,533 @@
+#pragma once
+#include <float.h>
+#include <defines.h>
+#include <vector/vector.h>
+#include <VkHelper/VkHelper.h>
+#include <ImageHelper/ImageHelper.h>
+#include <JobSystem/JobSystem.h>
+
+/* The number of frames the streamer can have uploads in flight for */
+#define TEXTURE_STREAMING_FRAMES 2
+
+/* Mips up to this many bytes get uploaded together as soon as a texture is added, so it shows up right away */
+#define TEXTURE_STREAMING_TAIL_SIZE (64 * 1024)
+
+/* A structure for the CPU side data of one mip level */
+typedef struct {
+	const void* Data;	/* The texels of the mip, must stay valid until the mip is resident */
+	VkDeviceSize Size;	/* The size of the texels in bytes */
+	VkExtent3D Extent;	/* The size of the mip in texels */
+} TextureMipData;
+
+/* A structure for a texture that gets streamed in from its smallest mip to its largest */
+typedef struct {
+	TrackedImage Image;		/* The image with all of its mip levels */
+	Vec Mips;				/* A Vector of TextureMipData, index 0 is the largest mip, owned by the caller */
+	u32 ResidentMip;		/* The largest mip whose upload has finished, MipLevels if nothing is resident. Use it as the minLod of the sampler */
+	u32 UploadedMip;		/* The largest mip with an upload recorded, finished or still in flight */
+	u32 WantedMip;			/* The largest mip worth having for the current screen size */
+	float ScreenSize;		/* The size of the texture on screen in pixels, larger is more important */
+} StreamingTexture;
+
+/* A structure for a mip whose upload is in flight, it becomes resident once the fence of its frame was waited on */
+typedef struct {
+	u32 TextureIndex;	/* The index of the texture in the streamer */
+	u32 Mip;			/* The mip that was uploaded */
+} TextureStreamingUpload;
+
+/* A structure for a copy of mip texels into the staging buffer, done on the job system before the uploads are submitted */
+typedef struct {
+	const void* Source;		/* The texels of the mip */
+	u8* Destination;		/* The mapped staging memory of the mip */
+	size_t Size;			/* The size of the texels in bytes */
+} TextureStagingCopy;
+
+/* A structure for an entry of the upload priority queue */
+typedef struct {
+	float Priority;		/* The priority of the next upload of the texture */
+	u32 TextureIndex;	/* The index of the texture in the streamer */
+} TextureStreamingRequest;
+
+/* A structure for the residency statistics of the streamer */
+typedef struct {
+	u32 Textures;					/* The number of textures in the streamer */
+	u32 TexturesFullyResident;		/* The number of textures that have every mip they want */
+	u32 MipsResident;				/* The number of mips that are resident */
+	u32 MipsTotal;					/* The number of mips of all the textures */
+	u64 BytesResident;				/* The number of texel bytes that are resident */
+	u64 BytesPending;				/* The number of texel bytes that are wanted but not resident yet */
+	u64 BytesUploadedThisFrame;		/* The number of bytes uploaded by the last update */
+	u64 BytesUploadedTotal;			/* The number of bytes uploaded since the streamer was created */
+} TextureStreamingStats;
+
+/* A structure for streaming textures within an upload budget per frame */
+typedef struct {
+	VkPhysicalDevice* PhysicalDevice;	/* The physical device */
+	VkDevice* LogicalDevice;			/* The logical device */
+	VkQueue* Queue;						/* The queue that does the uploads */
+	u32 QueueFamily;					/* The family of the upload queue */
+	u32 GraphicsQueueFamily;			/* The family of the queue that samples the textures */
+	VkDeviceSize FrameBudget;			/* The number of bytes that can be uploaded per frame */
+	VkBuffer StagingBuffer;				/* A host visible buffer with FrameBudget bytes for every frame in flight */
+	VkDeviceMemory StagingMemory;		/* The memory of the staging buffer */
+	u8* StagingData;					/* The mapped staging memory */
+	VkCommandPool CommandPools[TEXTURE_STREAMING_FRAMES];	/* A command pool per frame, reset as a whole */
+	Vec CommandBuffers[TEXTURE_STREAMING_FRAMES];			/* A Vector with the one command buffer of every frame */
+	VkFence Fences[TEXTURE_STREAMING_FRAMES];				/* Signaled when the uploads of a frame are done */
+	VkSemaphore Semaphores[TEXTURE_STREAMING_FRAMES];		/* Signaled when the uploads of a frame are done, the graphics queue waits on it */
+	Vec PendingMips[TEXTURE_STREAMING_FRAMES];				/* A Vector of TextureStreamingUpload per frame, committed after its fence */
+	Vec Acquires;						/* A Vector of VkImageMemoryBarrier the graphics queue records to take the uploaded mips over */
+	Vec EmptySemaphores;				/* An empty Vector for the submit helpers */
+	JobSystem* Jobs;					/* The job system the staging copies run on, nullptr to copy on the calling thread */
+	Vec StagingCopies;					/* A Vector of TextureStagingCopy for the uploads of the current frame */
+	u32 Frame;							/* The index of the current frame in flight */
+	Vec Textures;						/* A Vector of StreamingTexture */
+	Vec Requests;						/* A Vector of TextureStreamingRequest used as a max heap */
+	TextureStreamingStats Stats;		/* The statistics of the streamer */
+} TextureStreamer;
+
+/* A function for pushing a request into the priority queue */
+/* @param A Pointer to the streamer */
+/* @param The request */
+void PushTextureStreamingRequest(TextureStreamer* streamer, TextureStreamingRequest request)
+{
+	vec_pushback(streamer->Requests, request, TextureStreamingRequest);
+	TextureStreamingRequest* heap = (TextureStreamingRequest*)streamer->Requests;
+
+	u32 child = (u32)vec_length(streamer->Requests) - 1;
+	while (child > 0)
+	{
+		u32 parent = (child - 1) / 2;
+		if (heap[parent].Priority >= heap[child].Priority)
+			break;
+		TextureStreamingRequest temp = heap[parent];
+		heap[parent] = heap[child];
+		heap[child] = temp;
+		child = parent;
+	}
+}
+
+/* A function for taking the most important request out of the priority queue */
+/* @param A Pointer to the streamer */
+/* @param A Pointer to a request for output */
+bool PopTextureStreamingRequest(TextureStreamer* streamer, TextureStreamingRequest* request)
+{
+	u32 length = (u32)vec_length(streamer->Requests);
+	if (length == 0)
+		return false;
+
+	TextureStreamingRequest* heap = (TextureStreamingRequest*)streamer->Requests;
+	*request = heap[0];
+	heap[0] = heap[length - 1];
+	vec_length_set(streamer->Requests, --length);
+
+	u32 parent = 0;
+	while (true)
+	{
+		u32 largest = parent;
+		u32 left = parent * 2 + 1;
+		u32 right = parent * 2 + 2;
+		if ((left < length) && (heap[left].Priority > heap[largest].Priority))
+			largest = left;
+		if ((right < length) && (heap[right].Priority > heap[largest].Priority))
+			largest = right;
+		if (largest == parent)
+			break;
+		TextureStreamingRequest temp = heap[parent];
+		heap[parent] = heap[largest];
+		heap[largest] = temp;
+		parent = largest;
+	}
+
+	return true;
+}
+
+/* A function to create a texture streamer */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the queue that does the uploads */
+/* @param The index of the family of the queue */
+/* @param The index of the family of the queue that samples the textures */
+/* @param The number of bytes that can be uploaded per frame */
+/* @param A Pointer to the job system for the staging copies, may be nullptr */
+/* @param A Pointer to the streamer to be filled */
+bool CreateTextureStreamer(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkQueue* queue, u32 queueFamily, u32 graphicsQueueFamily, VkDeviceSize frameBudget,
+	JobSystem* jobs, TextureStreamer* streamer)
+{
+	memset(streamer, 0, sizeof(TextureStreamer));
+	streamer->PhysicalDevice = physicalDevice;
+	streamer->LogicalDevice = logicalDevice;
+	streamer->Queue = queue;
+	streamer->QueueFamily = queueFamily;
+	streamer->GraphicsQueueFamily = graphicsQueueFamily;
+	streamer->Acquires = vec_create(VkImageMemoryBarrier);
+	/* Every frame starts its staging copies 16 byte aligned, like the copies inside a frame */
+	streamer->FrameBudget = (frameBudget + 15) & ~(VkDeviceSize)15;
+	streamer->Textures = vec_create(StreamingTexture);
+	streamer->Requests = vec_create(TextureStreamingRequest);
+	streamer->EmptySemaphores = vec_create(VkSemaphore);
+	streamer->Jobs = jobs;
+	streamer->StagingCopies = vec_create(TextureStagingCopy);
+
+	if (!CreateBuffer(logicalDevice, frameBudget * TEXTURE_STREAMING_FRAMES, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &streamer->StagingBuffer))
+		return false;
+
+	if (!AllocateAndBindMemoryObjectToBuffer(physicalDevice, logicalDevice, &streamer->StagingBuffer,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false, &streamer->StagingMemory))
+		return false;
+
+	if (vkMapMemory(*logicalDevice, streamer->StagingMemory, 0, VK_WHOLE_SIZE, 0, (void**)&streamer->StagingData) != VK_SUCCESS)
+	{
+		printf("ERROR: Could not map the texture streaming staging buffer!\n");
+		return false;
+	}
+
+	for (u32 frame = 0; frame < TEXTURE_STREAMING_FRAMES; ++frame)
+	{
+		if (!CreateCommandPool(logicalDevice, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queueFamily, &streamer->CommandPools[frame]))
+			return false;
+
+		streamer->CommandBuffers[frame] = AllocateCommandBuffers(logicalDevice, &streamer->CommandPools[frame], VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+		if (streamer->CommandBuffers[frame] == nullptr)
+			return false;
+
+		if (!CreateFence(logicalDevice, true, &streamer->Fences[frame]) || !CreateVkSemaphore(logicalDevice, &streamer->Semaphores[frame]))
+			return false;
+
+		streamer->PendingMips[frame] = vec_create(TextureStreamingUpload);
+	}
+
+	return true;
+}
+
+/* A function for adding a texture to the streamer, nothing is uploaded until the next update */
+/* The mips are not copied, the caller keeps the Vector and the texels it points to alive until the streamer is destroyed and frees them after */
+/* @param A Pointer to the streamer */
+/* @param The format of the texture */
+/* @param A Vector (MUST BE VALID) of TextureMipData, index 0 is the largest mip */
+/* @param A Pointer to a u32 for the output index of the texture */
+bool AddStreamingTexture(TextureStreamer* streamer, VkFormat format, Vec mips, u32* textureIndex)
+{
+	StreamingTexture texture = { 0 };
+	TextureMipData* largest = (TextureMipData*)vec_get_at(mips, 0);
+	if (largest == nullptr)
+		return false;
+
+	if (!CreateTrackedImage(streamer->PhysicalDevice, streamer->LogicalDevice, format, largest->Extent, (u32)vec_length(mips), 1,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture.Image))
+		return false;
+
+	texture.Mips = mips;
+	texture.ResidentMip = (u32)vec_length(mips);
+	texture.UploadedMip = (u32)vec_length(mips);
+	texture.WantedMip = 0;
+	texture.ScreenSize = (float)largest->Extent.width;
+
+	*textureIndex = (u32)vec_length(streamer->Textures);
+	vec_pushback(streamer->Textures, texture, StreamingTexture);
+	return true;
+}
+
+/* A function for telling the streamer how large a texture is on screen, this drives its priority and the largest mip it wants */
+/* @param A Pointer to the streamer */
+/* @param The index of the texture */
+/* @param The size of the texture on screen in pixels */
+void SetStreamingTextureScreenSize(TextureStreamer* streamer, u32 textureIndex, float screenSize)
+{
+	StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, textureIndex);
+	if (texture == nullptr)
+		return;
+
+	texture->ScreenSize = screenSize;
+
+	/* Every mip is half the size, so skip the mips that would be minified anyway */
+	u32 largestDimension = texture->Image.Extent.width > texture->Image.Extent.height ? texture->Image.Extent.width : texture->Image.Extent.height;
+	texture->WantedMip = 0;
+	while ((texture->WantedMip + 1 < texture->Image.MipLevels) && ((float)(largestDimension >> (texture->WantedMip + 1)) >= screenSize))
+		++texture->WantedMip;
+}
+
+/* The function doing a range of the staging copies of a frame */
+void TextureStagingCopyJob(u32 first, u32 count, void* userData)
+{
+	TextureStagingCopy* copies = (TextureStagingCopy*)userData;
+	for (u32 i = first; i < first + count; ++i)
+		memcpy(copies[i].Destination, copies[i].Source, copies[i].Size);
+}
+
+/* A function for recording the upload of one mip through the staging buffer, the texels are copied later by the update */
+/* @param A Pointer to the streamer */
+/* @param A Pointer to the recording command buffer */
+/* @param A Pointer to the texture */
+/* @param The mip to upload */
+/* @param The offset into the staging buffer */
+void RecordStreamingMipUpload(TextureStreamer* streamer, VkCommandBuffer* commandBuffer, StreamingTexture* texture, u32 mip, VkDeviceSize stagingOffset)
+{
+	TextureMipData* mipData = (TextureMipData*)vec_get_at(texture->Mips, mip);
+	TextureStagingCopy copy = { mipData->Data, streamer->StagingData + stagingOffset, (size_t)mipData->Size };
+	vec_pushback(streamer->StagingCopies, copy, TextureStagingCopy);
+
+	Vec barriers = vec_create(VkImageMemoryBarrier);
+	VkPipelineStageFlags sourceStages = 0;
+	VkPipelineStageFlags destinationStages = 0;
+	GetTrackedImageTransitionBarriers(&texture->Image, mip, 1, 0, 1, IMAGE_USAGE_TRANSFER_DESTINATION, &barriers, &sourceStages, &destinationStages);
+	if (vec_length(barriers) > 0)
+		vkCmdPipelineBarrier(*commandBuffer, sourceStages, destinationStages, 0, 0, nullptr, 0, nullptr, (u32)vec_length(barriers), (const VkImageMemoryBarrier*)barriers);
+
+	VkBufferImageCopy region = { 0 };
+	region.bufferOffset = stagingOffset;
+	region.imageSubresource.aspectMask = texture->Image.Aspect;
+	region.imageSubresource.mipLevel = mip;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = mipData->Extent;
+	vkCmdCopyBufferToImage(*commandBuffer, streamer->StagingBuffer, texture->Image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	vec_clear(barriers);
+	sourceStages = 0;
+	destinationStages = 0;
+	GetTrackedImageTransitionBarriers(&texture->Image, mip, 1, 0, 1, IMAGE_USAGE_SAMPLED_FRAGMENT, &barriers, &sourceStages, &destinationStages);
+
+	/* Across families the upload queue releases the mip and the graphics queue acquires it, with the same layout change in both */
+	if (streamer->QueueFamily != streamer->GraphicsQueueFamily)
+	{
+		for (u32 i = 0; i < vec_length(barriers); ++i)
+		{
+			VkImageMemoryBarrier* release = (VkImageMemoryBarrier*)vec_get_at(barriers, i);
+			release->srcQueueFamilyIndex = streamer->QueueFamily;
+			release->dstQueueFamilyIndex = streamer->GraphicsQueueFamily;
+
+			VkImageMemoryBarrier acquire = *release;
+			acquire.srcAccessMask = 0;
+			vec_pushback(streamer->Acquires, acquire, VkImageMemoryBarrier);
+			release->dstAccessMask = 0;
+		}
+		destinationStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+
+	if (vec_length(barriers) > 0)
+		vkCmdPipelineBarrier(*commandBuffer, sourceStages, destinationStages, 0, 0, nullptr, 0, nullptr, (u32)vec_length(barriers), (const VkImageMemoryBarrier*)barriers);
+
+	vec_destroy(barriers);
+}
+
+/* A function for doing one frame of uploads, call it once per frame */
+/* Textures with nothing resident get their small mips first, then the largest on screen textures get refined one mip at a time.
+   When a semaphore comes back the next graphics submit has to wait on it, and record RecordTextureStreamingAcquires first */
+/* @param A Pointer to the streamer */
+/* @param A Pointer to a VkSemaphore for the output semaphore of the uploads, VK_NULL_HANDLE if nothing was uploaded */
+bool UpdateTextureStreamer(TextureStreamer* streamer, VkSemaphore* uploadSemaphore)
+{
+	u32 frame = streamer->Frame;
+	streamer->Frame = (streamer->Frame + 1) % TEXTURE_STREAMING_FRAMES;
+	streamer->Stats.BytesUploadedThisFrame = 0;
+	*uploadSemaphore = VK_NULL_HANDLE;
+	vec_clear(streamer->Acquires);
+	vec_clear(streamer->StagingCopies);
+
+	/* The staging memory and command buffer of this frame are free again once its last uploads finished */
+	Vec fences = vec_create(VkFence);
+	vec_pushback(fences, streamer->Fences[frame], VkFence);
+	if (!WaitForFences(streamer->LogicalDevice, fences, VK_TRUE, UINT64_MAX))
+	{
+		vec_destroy(fences);
+		return false;
+	}
+
+	/* Only now that the GPU is done with them can samplers see the mips of this frame */
+	for (u32 i = 0; i < vec_length(streamer->PendingMips[frame]); ++i)
+	{
+		TextureStreamingUpload* upload = (TextureStreamingUpload*)vec_get_at(streamer->PendingMips[frame], i);
+		StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, upload->TextureIndex);
+		if (upload->Mip < texture->ResidentMip)
+			texture->ResidentMip = upload->Mip;
+	}
+	vec_clear(streamer->PendingMips[frame]);
+
+	vec_clear(streamer->Requests);
+	for (u32 i = 0; i < vec_length(streamer->Textures); ++i)
+	{
+		StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, i);
+		if (texture->UploadedMip <= texture->WantedMip)
+			continue;
+
+		TextureStreamingRequest request = { texture->UploadedMip == texture->Image.MipLevels ? FLT_MAX : texture->ScreenSize, i };
+		PushTextureStreamingRequest(streamer, request);
+	}
+
+	if (vec_length(streamer->Requests) == 0)
+	{
+		vec_destroy(fences);
+		return true;
+	}
+
+	VkCommandBuffer* commandBuffer = (VkCommandBuffer*)vec_get_at(streamer->CommandBuffers[frame], 0);
+	if (!ResetCommandPool(streamer->LogicalDevice, &streamer->CommandPools[frame], false) ||
+		!BeginCommandBufferRecordingOperation(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr))
+	{
+		vec_destroy(fences);
+		return false;
+	}
+
+	VkDeviceSize frameStart = frame * streamer->FrameBudget;
+	VkDeviceSize used = 0;
+	TextureStreamingRequest request;
+	while (PopTextureStreamingRequest(streamer, &request))
+	{
+		StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, request.TextureIndex);
+		bool empty = texture->UploadedMip == texture->Image.MipLevels;
+
+		/* The tail goes up in one piece, after that one mip per request so the budget is shared fairly */
+		u32 uploaded = 0;
+		while (texture->UploadedMip > texture->WantedMip)
+		{
+			u32 mip = texture->UploadedMip - 1;
+			TextureMipData* mipData = (TextureMipData*)vec_get_at(texture->Mips, mip);
+			if (uploaded > 0 && (!empty || mipData->Size > TEXTURE_STREAMING_TAIL_SIZE))
+				break;
+
+			/* A mip larger than the whole budget can never be staged, so the texture stops one mip short of it */
+			if (mipData->Size > streamer->FrameBudget)
+			{
+				printf("WARNING: Mip %u of a streaming texture is larger than the upload budget and will not be streamed!\n", mip);
+				texture->WantedMip = mip + 1;
+				break;
+			}
+
+			if (used + mipData->Size > streamer->FrameBudget)
+				break;
+
+			RecordStreamingMipUpload(streamer, commandBuffer, texture, mip, frameStart + used);
+			used += (mipData->Size + 15) & ~(VkDeviceSize)15;
+			--texture->UploadedMip;
+			++uploaded;
+
+			TextureStreamingUpload upload = { request.TextureIndex, mip };
+			vec_pushback(streamer->PendingMips[frame], upload, TextureStreamingUpload);
+		}
+
+		if (uploaded == 0)
+		{
+			if (texture->UploadedMip > texture->WantedMip)
+				break;
+			continue;
+		}
+
+		if (texture->UploadedMip > texture->WantedMip)
+		{
+			TextureStreamingRequest next = { texture->ScreenSize, request.TextureIndex };
+			PushTextureStreamingRequest(streamer, next);
+		}
+
+		if (used >= streamer->FrameBudget)
+			break;
+	}
+
+	/* The staging memory is coherent, so the texels only have to be there before the submit */
+	u32 copyCount = (u32)vec_length(streamer->StagingCopies);
+	if ((streamer->Jobs != nullptr) && (copyCount > 1))
+		ParallelFor(streamer->Jobs, copyCount, 1, TextureStagingCopyJob, streamer->StagingCopies);
+	else if (copyCount > 0)
+		TextureStagingCopyJob(0, copyCount, streamer->StagingCopies);
+
+	if (!EndCommandBufferRecordingOperation(commandBuffer) || !ResetFences(streamer->LogicalDevice, fences))
+	{
+		vec_destroy(fences);
+		return false;
+	}
+
+	Vec signalSemaphores = vec_create(VkSemaphore);
+	vec_pushback(signalSemaphores, streamer->Semaphores[frame], VkSemaphore);
+	bool submitted = SubmitCommandBuffersToQueue(streamer->Queue, streamer->EmptySemaphores, streamer->CommandBuffers[frame], signalSemaphores, &streamer->Fences[frame]);
+	vec_destroy(signalSemaphores);
+	if (!submitted)
+	{
+		vec_destroy(fences);
+		return false;
+	}
+
+	*uploadSemaphore = streamer->Semaphores[frame];
+
+	streamer->Stats.BytesUploadedThisFrame = used;
+	streamer->Stats.BytesUploadedTotal += used;
+	vec_destroy(fences);
+	return true;
+}
+
+/* A function for recording the barriers that hand the mips of the last update over to the graphics queue family, in
+   the first graphics command buffer that waits on the semaphore of that update. Does nothing when both are one family */
+/* @param A Pointer to the streamer */
+/* @param A Pointer to a command buffer of the graphics queue that is recording */
+void RecordTextureStreamingAcquires(TextureStreamer* streamer, VkCommandBuffer* commandBuffer)
+{
+	if (vec_length(streamer->Acquires) == 0)
+		return;
+
+	vkCmdPipelineBarrier(*commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+		(u32)vec_length(streamer->Acquires), (const VkImageMemoryBarrier*)streamer->Acquires);
+	vec_clear(streamer->Acquires);
+}
+
+/* A function for getting the residency statistics of the streamer */
+/* @param A Pointer to the streamer */
+TextureStreamingStats GetTextureStreamingStats(TextureStreamer* streamer)
+{
+	TextureStreamingStats stats = streamer->Stats;
+	stats.Textures = (u32)vec_length(streamer->Textures);
+	stats.TexturesFullyResident = 0;
+	stats.MipsResident = 0;
+	stats.MipsTotal = 0;
+	stats.BytesResident = 0;
+	stats.BytesPending = 0;
+
+	for (u32 i = 0; i < stats.Textures; ++i)
+	{
+		StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, i);
+		stats.MipsTotal += texture->Image.MipLevels;
+		stats.MipsResident += texture->Image.MipLevels - texture->ResidentMip;
+		if (texture->ResidentMip <= texture->WantedMip)
+			++stats.TexturesFullyResident;
+
+		for (u32 mip = 0; mip < texture->Image.MipLevels; ++mip)
+		{
+			TextureMipData* mipData = (TextureMipData*)vec_get_at(texture->Mips, mip);
+			if (mip >= texture->ResidentMip)
+				stats.BytesResident += mipData->Size;
+			else if (mip >= texture->WantedMip)
+				stats.BytesPending += mipData->Size;
+		}
+	}
+
+	return stats;
+}
+
+/* A function to clean up created vulkan resources, waits for the uploads in flight first */
+/* @param A pointer to the resource to cleanup */
+void DestroyTextureStreamer(TextureStreamer* streamer)
+{
+	VkDevice* logicalDevice = streamer->LogicalDevice;
+	vkWaitForFences(*logicalDevice, TEXTURE_STREAMING_FRAMES, streamer->Fences, VK_TRUE, UINT64_MAX);
+
+	for (u32 i = 0; i < vec_length(streamer->Textures); ++i)
+	{
+		StreamingTexture* texture = (StreamingTexture*)vec_get_at(streamer->Textures, i);
+		DestroyTrackedImage(logicalDevice, &texture->Image);
+	}
+
+	for (u32 frame = 0; frame < TEXTURE_STREAMING_FRAMES; ++frame)
+	{
+		vkDestroyFence(*logicalDevice, streamer->Fences[frame], nullptr);
+		vkDestroySemaphore(*logicalDevice, streamer->Semaphores[frame], nullptr);
+		vec_destroy(streamer->PendingMips[frame]);
+		vkDestroyCommandPool(*logicalDevice, streamer->CommandPools[frame], nullptr);
+		vec_destroy(streamer->CommandBuffers[frame]);
+	}
+
+	vkDestroyBuffer(*logicalDevice, streamer->StagingBuffer, nullptr);
+	vkFreeMemory(*logicalDevice, streamer->StagingMemory, nullptr);
+	vec_destroy(streamer->Textures);
+	vec_destroy(streamer->Requests);
+	vec_destroy(streamer->EmptySemaphores);
+	vec_destroy(streamer->StagingCopies);
+	vec_destroy(streamer->Acquires);
+	memset(streamer, 0, sizeof(TextureStreamer));
+}
@@ -0,0 +1,466 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <defines.h>
+#include <vector/vector.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* ---- Small wrappers so the rest of the code does not care if it runs on Win32 threads or pthreads ---- */
+
+/* A function that runs on a thread */
+typedef void (*ThreadFunction)(void* argument);
+
+/* A structure for a thread */
+typedef struct {
+#ifdef _WIN32
+	HANDLE Handle;			/* The Win32 thread */
+#else
+	pthread_t Handle;		/* The pthread */
+#endif
+	ThreadFunction Function;	/* The function the thread runs */
+	void* Argument;			/* The argument of the function */
+} Thread;
+
+/* A structure for a mutex */
+typedef struct {
+#ifdef _WIN32
+	SRWLOCK Lock;
+#else
+	pthread_mutex_t Lock;
+#endif
+} Mutex;
+
+/* A structure for a condition variable */
+typedef struct {
+#ifdef _WIN32
+	CONDITION_VARIABLE Variable;
+#else
+	pthread_cond_t Variable;
+#endif
+} ConditionVariable;
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadEntryPoint(LPVOID parameter)
+{
+	Thread* thread = (Thread*)parameter;
+	thread->Function(thread->Argument);
+	return 0;
+}
+#else
+static void* ThreadEntryPoint(void* parameter)
+{
+	Thread* thread = (Thread*)parameter;
+	thread->Function(thread->Argument);
+	return nullptr;
+}
+#endif
+
+/* A function to start a thread, the Thread must stay at the same address until it is joined */
+/* @param The function to run */
+/* @param The argument of the function */
+/* @param A Pointer to the Thread to be filled */
+bool StartThread(ThreadFunction function, void* argument, Thread* thread)
+{
+	thread->Function = function;
+	thread->Argument = argument;
+
+#ifdef _WIN32
+	thread->Handle = CreateThread(nullptr, 0, ThreadEntryPoint, thread, 0, nullptr);
+	if (thread->Handle == nullptr)
+#else
+	if (pthread_create(&thread->Handle, nullptr, ThreadEntryPoint, thread) != 0)
+#endif
+	{
+		printf("ERROR: Could not start a thread!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to wait for a thread to finish */
+/* @param A Pointer to the thread */
+void JoinThread(Thread* thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->Handle, INFINITE);
+	CloseHandle(thread->Handle);
+#else
+	pthread_join(thread->Handle, nullptr);
+#endif
+}
+
+/* A function for getting the number of logical processors */
+u32 GetProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return (u32)systemInfo.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+#endif
+}
+
+/* A function for giving the rest of the time slice of this thread to another one */
+void YieldThread()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+/* A function to sleep the calling thread */
+/* @param The time to sleep in milliseconds */
+void SleepMilliseconds(u32 milliseconds)
+{
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	/* thrd_sleep is plain C11, nanosleep is hidden by a strict -std=c11 */
+	struct timespec time = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000 };
+	thrd_sleep(&time, nullptr);
+#endif
+}
+
+/* A function to set up a mutex */
+/* @param A Pointer to the mutex */
+void InitializeMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	InitializeSRWLock(&mutex->Lock);
+#else
+	pthread_mutex_init(&mutex->Lock, nullptr);
+#endif
+}
+
+/* A function to lock a mutex */
+/* @param A Pointer to the mutex */
+void LockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&mutex->Lock);
+#else
+	pthread_mutex_lock(&mutex->Lock);
+#endif
+}
+
+/* A function to lock a mutex if nobody else holds it, returns false instead of waiting */
+/* @param A Pointer to the mutex */
+bool TryLockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	return TryAcquireSRWLockExclusive(&mutex->Lock) != 0;
+#else
+	return pthread_mutex_trylock(&mutex->Lock) == 0;
+#endif
+}
+
+/* A function to unlock a mutex */
+/* @param A Pointer to the mutex */
+void UnlockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&mutex->Lock);
+#else
+	pthread_mutex_unlock(&mutex->Lock);
+#endif
+}
+
+/* A function to clean up a mutex */
+/* @param A Pointer to the mutex */
+void DestroyMutex(Mutex* mutex)
+{
+#ifndef _WIN32
+	pthread_mutex_destroy(&mutex->Lock);
+#endif
+}
+
+/* A function to set up a condition variable */
+/* @param A Pointer to the condition variable */
+void InitializeConditionVariable_(ConditionVariable* variable)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(&variable->Variable);
+#else
+	pthread_cond_init(&variable->Variable, nullptr);
+#endif
+}
+
+/* A function to wait on a condition variable, the mutex must be locked and is locked again when this returns */
+/* @param A Pointer to the condition variable */
+/* @param A Pointer to the mutex */
+void WaitConditionVariable(ConditionVariable* variable, Mutex* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableSRW(&variable->Variable, &mutex->Lock, INFINITE, 0);
+#else
+	pthread_cond_wait(&variable->Variable, &mutex->Lock);
+#endif
+}
+
+/* A function to wake one thread that waits on a condition variable */
+/* @param A Pointer to the condition variable */
+void SignalConditionVariable(ConditionVariable* variable)
+{
+#ifdef _WIN32
+	WakeConditionVariable(&variable->Variable);
+#else
+	pthread_cond_signal(&variable->Variable);
+#endif
+}
+
+/* A function to wake every thread that waits on a condition variable */
+/* @param A Pointer to the condition variable */
+void BroadcastConditionVariable(ConditionVariable* variable)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(&variable->Variable);
+#else
+	pthread_cond_broadcast(&variable->Variable);
+#endif
+}
+
+/* A function to clean up a condition variable */
+/* @param A Pointer to the condition variable */
+void DestroyConditionVariable(ConditionVariable* variable)
+{
+#ifndef _WIN32
+	pthread_cond_destroy(&variable->Variable);
+#endif
+}
+
+/* ---- Atomics, all of them are sequentially consistent ---- */
+
+/* A function to atomically read a value */
+/* @param A Pointer to the value */
+i32 AtomicLoad32(volatile i32* value)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+#else
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically write a value */
+/* @param A Pointer to the value */
+/* @param The new value */
+void AtomicStore32(volatile i32* value, i32 newValue)
+{
+#ifdef _WIN32
+	InterlockedExchange((volatile LONG*)value, newValue);
+#else
+	__atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically add to a value, returns the new value */
+/* @param A Pointer to the value */
+/* @param The amount to add */
+i32 AtomicAdd32(volatile i32* value, i32 amount)
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd((volatile LONG*)value, amount) + amount;
+#else
+	return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically replace a value if it still has the expected value, returns true if it was replaced */
+/* @param A Pointer to the value */
+/* @param The value it should have */
+/* @param The new value */
+bool AtomicCompareExchange32(volatile i32* value, i32 expected, i32 newValue)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange((volatile LONG*)value, newValue, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically read a value */
+/* @param A Pointer to the value */
+i64 AtomicLoad64(volatile i64* value)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange64((volatile LONG64*)value, 0, 0);
+#else
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically write a value */
+/* @param A Pointer to the value */
+/* @param The new value */
+void AtomicStore64(volatile i64* value, i64 newValue)
+{
+#ifdef _WIN32
+	InterlockedExchange64((volatile LONG64*)value, newValue);
+#else
+	__atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically add to a value, returns the new value */
+/* @param A Pointer to the value */
+/* @param The amount to add */
+i64 AtomicAdd64(volatile i64* value, i64 amount)
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd64((volatile LONG64*)value, amount) + amount;
+#else
+	return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* A function to atomically replace a value if it still has the expected value, returns true if it was replaced */
+/* @param A Pointer to the value */
+/* @param The value it should have */
+/* @param The new value */
+bool AtomicCompareExchange64(volatile i64* value, i64 expected, i64 newValue)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange64((volatile LONG64*)value, newValue, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* ---- A simple thread pool with one shared FIFO queue ---- */
+
+/* A structure for a task of the thread pool */
+typedef struct {
+	ThreadFunction Function;	/* The function to run */
+	void* Argument;				/* The argument of the function */
+} ThreadPoolTask;
+
+/* A structure for a pool of worker threads */
+typedef struct {
+	Thread* Workers;			/* The worker threads */
+	u32 WorkerCount;			/* The number of worker threads */
+	Vec Tasks;					/* A Vector of ThreadPoolTask, tasks before Head are done */
+	u64 Head;					/* The index of the next task to run */
+	u32 Busy;					/* The number of workers running a task */
+	bool Stop;					/* Set when the workers should exit */
+	Mutex Lock;					/* Guards everything above */
+	ConditionVariable Wake;		/* Signaled when a task is added or the pool stops */
+	ConditionVariable Idle;		/* Signaled when the pool runs out of work */
+} ThreadPool;
+
+/* The loop of every worker of a thread pool */
+/* @param A Pointer to the thread pool */
+void ThreadPoolWorker(void* argument)
+{
+	ThreadPool* pool = (ThreadPool*)argument;
+	LockMutex(&pool->Lock);
+
+	while (true)
+	{
+		while (!pool->Stop && (pool->Head == vec_length(pool->Tasks)))
+			WaitConditionVariable(&pool->Wake, &pool->Lock);
+
+		if (pool->Head == vec_length(pool->Tasks))
+			break;
+
+		ThreadPoolTask task = ((ThreadPoolTask*)pool->Tasks)[pool->Head++];
+		if (pool->Head == vec_length(pool->Tasks))
+		{
+			pool->Head = 0;
+			vec_clear(pool->Tasks);
+		}
+		++pool->Busy;
+
+		UnlockMutex(&pool->Lock);
+		task.Function(task.Argument);
+		LockMutex(&pool->Lock);
+
+		--pool->Busy;
+		if ((pool->Busy == 0) && (pool->Head == vec_length(pool->Tasks)))
+			BroadcastConditionVariable(&pool->Idle);
+	}
+
+	UnlockMutex(&pool->Lock);
+}
+
+/* A function to create a thread pool */
+/* @param The number of worker threads, 0 uses one per processor */
+/* @param A Pointer to the thread pool to be filled */
+bool CreateThreadPool(u32 workerCount, ThreadPool* pool)
+{
+	memset(pool, 0, sizeof(ThreadPool));
+	pool->WorkerCount = workerCount ? workerCount : GetProcessorCount();
+	pool->Tasks = vec_create(ThreadPoolTask);
+	InitializeMutex(&pool->Lock);
+	InitializeConditionVariable_(&pool->Wake);
+	InitializeConditionVariable_(&pool->Idle);
+
+	pool->Workers = (Thread*)calloc(pool->WorkerCount, sizeof(Thread));
+	for (u32 i = 0; i < pool->WorkerCount; ++i)
+	{
+		if (!StartThread(ThreadPoolWorker, pool, &pool->Workers[i]))
+		{
+			pool->WorkerCount = i;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* A function to queue a task on a thread pool */
+/* @param A Pointer to the thread pool */
+/* @param The function to run */
+/* @param The argument of the function */
+void SubmitThreadPoolTask(ThreadPool* pool, ThreadFunction function, void* argument)
+{
+	ThreadPoolTask task = { function, argument };
+	LockMutex(&pool->Lock);
+	vec_pushback(pool->Tasks, task, ThreadPoolTask);
+	SignalConditionVariable(&pool->Wake);
+	UnlockMutex(&pool->Lock);
+}
+
+/* A function to wait until every queued task of a thread pool is done */
+/* @param A Pointer to the thread pool */
+void WaitForThreadPool(ThreadPool* pool)
+{
+	LockMutex(&pool->Lock);
+	while ((pool->Busy > 0) || (pool->Head != vec_length(pool->Tasks)))
+		WaitConditionVariable(&pool->Idle, &pool->Lock);
+	UnlockMutex(&pool->Lock);
+}
+
+/* A function to clean up a thread pool, the queued tasks are finished first */
+/* @param A pointer to the thread pool to cleanup */
+void DestroyThreadPool(ThreadPool* pool)
+{
+	LockMutex(&pool->Lock);
+	pool->Stop = true;
+	BroadcastConditionVariable(&pool->Wake);
+	UnlockMutex(&pool->Lock);
+
+	for (u32 i = 0; i < pool->WorkerCount; ++i)
+		JoinThread(&pool->Workers[i]);
+
+	free(pool->Workers);
+	vec_destroy(pool->Tasks);
+	DestroyConditionVariable(&pool->Wake);
+	DestroyConditionVariable(&pool->Idle);
+	DestroyMutex(&pool->Lock);
+	memset(pool, 0, sizeof(ThreadPool));
+}
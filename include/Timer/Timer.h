@@ -0,0 +1,29 @@
+#pragma once
+#include <defines.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* A function for getting a high resolution time stamp in seconds, only useful for measuring differences */
+double GetTimeInSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec time;
+#ifdef CLOCK_MONOTONIC
+	clock_gettime(CLOCK_MONOTONIC, &time);
+#else
+	/* A strict -std=c11 build has no POSIX clocks, the C11 one is the wall clock */
+	timespec_get(&time, TIME_UTC);
+#endif
+	return (double)time.tv_sec + (double)time.tv_nsec / 1000000000.0;
+#endif
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <vector/vector.h>
 #include <WindowHelper/WindowHelper.h>
+#include <Timer/Timer.h>
 
 /* A function for checking the available instance extensions */
 Vec CheckAvailableInstanceExtensions()
@@ -47,6 +48,25 @@ bool IsExtensionSupported(Vec VkExtensionProperties_available_extensions, const
 	return false;
 }
 
+/* A function for checking if an instance layer is installed */
+/* @param The name of the layer */
+bool IsInstanceLayerSupported(const char* layer)
+{
+	u32 layerCount = 0;
+	if ((vkEnumerateInstanceLayerProperties(&layerCount, nullptr) != VK_SUCCESS) || (layerCount == 0))
+		return false;
+
+	Vec layers = vec_create(VkLayerProperties);
+	vec_resize(layers, layerCount, VkLayerProperties);
+	bool found = false;
+	if (vkEnumerateInstanceLayerProperties(&layerCount, (VkLayerProperties*)layers) == VK_SUCCESS)
+		for (u32 i = 0; !found && (i < layerCount); ++i)
+			found = strcmp(((VkLayerProperties*)layers)[i].layerName, layer) == 0;
+
+	vec_destroy(layers);
+	return found;
+}
+
 /* A function that creates a Vulkan Instance */
 /* @param Pass in a Vector that has the Desired Extensions, pass in null if you don't need extra extensions */
 /* @param A string for the application name */
@@ -83,9 +103,16 @@ bool CreateVulkanInstance(Vec ConstCharPointer_desired_extensions, const char* a
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "Nullpointer Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.apiVersion = VK_API_VERSION_1_2; /* 1.2 is needed for buffer device addresses */
 
-	const char* layers[] = { "VK_LAYER_KHRONOS_validation" };
+	/* The shader object and synchronization2 layers only do something on drivers without VK_EXT_shader_object or
+	   VK_KHR_synchronization2, there they emulate them */
+	const char* layers[3] = { "VK_LAYER_KHRONOS_validation" };
+	u32 layerCount = 1;
+	if (IsInstanceLayerSupported("VK_LAYER_KHRONOS_shader_object"))
+		layers[layerCount++] = "VK_LAYER_KHRONOS_shader_object";
+	if (IsInstanceLayerSupported("VK_LAYER_KHRONOS_synchronization2"))
+		layers[layerCount++] = "VK_LAYER_KHRONOS_synchronization2";
 
 	VkInstanceCreateInfo createInfo;
 	memset(&createInfo, 0, sizeof(VkInstanceCreateInfo));
@@ -93,7 +120,7 @@ bool CreateVulkanInstance(Vec ConstCharPointer_desired_extensions, const char* a
 	createInfo.pApplicationInfo = &appInfo;
 	createInfo.enabledExtensionCount = desiredExtensionsLength;
 	createInfo.ppEnabledExtensionNames = (const char *const*)ConstCharPointer_desired_extensions;
-	createInfo.enabledLayerCount = 1;
+	createInfo.enabledLayerCount = layerCount;
 	createInfo.ppEnabledLayerNames = layers;
 	if (vkCreateInstance(&createInfo, nullptr, Inst) != VK_SUCCESS) {
 		// Handle instance creation failure
@@ -164,6 +191,20 @@ Vec CheckAvailableDeviceExtensions(VkPhysicalDevice* physical_device)
 	return tempVecExtensionProperties;
 }
 
+/* A function to check if a physical device supports an extension */
+/* @param A Pointer to the physical device */
+/* @param The name of the extension */
+bool IsDeviceExtensionSupported(VkPhysicalDevice* physicalDevice, const char* extension)
+{
+	Vec availableExtensions = CheckAvailableDeviceExtensions(physicalDevice);
+	if (availableExtensions == nullptr)
+		return false;
+
+	bool supported = IsExtensionSupported(availableExtensions, extension);
+	vec_destroy(availableExtensions);
+	return supported;
+}
+
 /* A function to get the features and properties of a physical device */
 /* @param The physical device to be screened */
 /* @param A pointer to a VkPhysicalDeviceFeatures to be filled in */
@@ -174,6 +215,149 @@ void GetFeaturesAndPropertiesOfPhysicalDevice(VkPhysicalDevice* physicalDevice,
 	vkGetPhysicalDeviceProperties(*physicalDevice, deviceProperties);
 }
 
+/* A structure holding the extended feature structures that get chained onto device creation */
+typedef struct {
+	VkPhysicalDeviceFeatures2 Features;					/* The core features, this is the head of the chain */
+	VkPhysicalDeviceVulkan12Features Vulkan12Features;	/* The Vulkan 1.2 features (buffer device address, descriptor indexing...) */
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR DynamicRenderingFeatures;	/* Not linked, device creation adds it when the device can render without render passes */
+	VkPhysicalDeviceSynchronization2FeaturesKHR Synchronization2Features;	/* Not linked, device creation adds it when the device has vkCmdPipelineBarrier2KHR */
+} DeviceFeatureChain;
+
+/* A function for linking the structures of a feature chain together, call this again if the chain gets copied */
+/* @param A Pointer to the physical device the chain is for, the Vulkan 1.2 features are only linked if it has Vulkan 1.2 */
+/* @param A Pointer to the feature chain to link */
+void LinkDeviceFeatureChain(VkPhysicalDevice* physicalDevice, DeviceFeatureChain* chain)
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(*physicalDevice, &deviceProperties);
+
+	chain->Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	chain->Features.pNext = deviceProperties.apiVersion >= VK_API_VERSION_1_2 ? &chain->Vulkan12Features : nullptr;
+	chain->Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	chain->Vulkan12Features.pNext = nullptr;
+	chain->DynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	chain->DynamicRenderingFeatures.pNext = nullptr;
+	chain->Synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	chain->Synchronization2Features.pNext = nullptr;
+}
+
+/* A function to add an extension feature structure to the end of a feature chain, the structure must outlive the chain */
+/* @param A Pointer to the feature chain */
+/* @param A Pointer to the feature structure, with its sType set */
+void AppendToDeviceFeatureChain(DeviceFeatureChain* chain, void* feature)
+{
+	VkBaseOutStructure* last = (VkBaseOutStructure*)&chain->Features;
+	while (last->pNext)
+		last = last->pNext;
+	last->pNext = (VkBaseOutStructure*)feature;
+	((VkBaseOutStructure*)feature)->pNext = nullptr;
+}
+
+/* A function to get the extended features of a physical device */
+/* @param The physical device to be screened */
+/* @param A Pointer to a DeviceFeatureChain to be filled in */
+void GetExtendedFeaturesOfPhysicalDevice(VkPhysicalDevice* physicalDevice, DeviceFeatureChain* supportedFeatures)
+{
+	memset(supportedFeatures, 0, sizeof(DeviceFeatureChain));
+	LinkDeviceFeatureChain(physicalDevice, supportedFeatures);
+	vkGetPhysicalDeviceFeatures2(*physicalDevice, &supportedFeatures->Features);
+}
+
+/* A function to check if a physical device can give buffers raw GPU addresses */
+/* @param The physical device to be screened */
+bool IsBufferDeviceAddressSupported(VkPhysicalDevice* physicalDevice)
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(*physicalDevice, &deviceProperties);
+	if (deviceProperties.apiVersion < VK_API_VERSION_1_2)
+		return false;
+
+	DeviceFeatureChain supportedFeatures;
+	GetExtendedFeaturesOfPhysicalDevice(physicalDevice, &supportedFeatures);
+	return supportedFeatures.Vulkan12Features.bufferDeviceAddress == VK_TRUE;
+}
+
+/* A function to check if a physical device can render with vkCmdBeginRenderingKHR instead of render pass objects */
+/* @param The physical device to be screened */
+bool IsDynamicRenderingSupported(VkPhysicalDevice* physicalDevice)
+{
+	if (!IsDeviceExtensionSupported(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR };
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &dynamicRenderingFeatures };
+	vkGetPhysicalDeviceFeatures2(*physicalDevice, &features);
+	return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
+/* A function to check if a physical device has vkCmdPipelineBarrier2KHR, natively or through the synchronization2 layer */
+/* @param The physical device to be screened */
+bool IsSynchronization2Supported(VkPhysicalDevice* physicalDevice)
+{
+	if (!IsDeviceExtensionSupported(physicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+		return false;
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR };
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &synchronization2Features };
+	vkGetPhysicalDeviceFeatures2(*physicalDevice, &features);
+	return synchronization2Features.synchronization2 == VK_TRUE;
+}
+
+/* A function to check if a physical device can draw from buffers a compute shader filled, with the count read from a buffer too */
+/* @param The physical device to be screened */
+bool IsGpuDrivenRenderingSupported(VkPhysicalDevice* physicalDevice)
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(*physicalDevice, &deviceProperties);
+	if (deviceProperties.apiVersion < VK_API_VERSION_1_2)
+		return false;
+
+	DeviceFeatureChain supportedFeatures;
+	GetExtendedFeaturesOfPhysicalDevice(physicalDevice, &supportedFeatures);
+	return (supportedFeatures.Features.features.multiDrawIndirect == VK_TRUE) &&
+		(supportedFeatures.Features.features.drawIndirectFirstInstance == VK_TRUE) &&
+		(supportedFeatures.Vulkan12Features.drawIndirectCount == VK_TRUE) &&
+		(supportedFeatures.Vulkan12Features.bufferDeviceAddress == VK_TRUE) &&
+		(supportedFeatures.Vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE);
+}
+
+/* A function to check if a physical device can stream textures through sparse residency, the features still have to be enabled on the logical device */
+/* @param The physical device to be screened */
+bool IsSparseResidencySupported(VkPhysicalDevice* physicalDevice)
+{
+	VkPhysicalDeviceFeatures deviceFeatures;
+	VkPhysicalDeviceProperties deviceProperties;
+	GetFeaturesAndPropertiesOfPhysicalDevice(physicalDevice, &deviceFeatures, &deviceProperties);
+
+	if (!deviceFeatures.sparseBinding || !deviceFeatures.sparseResidencyImage2D)
+	{
+		printf("INFO: Device \"%s\" does NOT support sparse residency for 2D images!\n", deviceProperties.deviceName);
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to check if a format has a sparse page layout, otherwise there is nothing to bind pages with */
+/* @param The physical device to be screened */
+/* @param The format of the sparse textures */
+bool IsSparseImageFormatSupported(VkPhysicalDevice* physicalDevice, VkFormat format)
+{
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(*physicalDevice, &deviceProperties);
+
+	u32 propertyCount = 0;
+	vkGetPhysicalDeviceSparseImageFormatProperties(*physicalDevice, format, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_TILING_OPTIMAL, &propertyCount, nullptr);
+	if (propertyCount == 0)
+	{
+		printf("INFO: Device \"%s\" does NOT support sparse residency for the requested format!\n", deviceProperties.deviceName);
+		return false;
+	}
+
+	return true;
+}
+
 /* A function to check the available Queue Families and their properties */
 /* @param The physical device to be screened */
 /* @param A Vector of VkQueueFamilyProperties to be filled in with properties */
@@ -229,6 +413,32 @@ bool SelectIndexOfQueueFamilyWithDesiredCapabilities(VkPhysicalDevice* physicalD
 	return false;
 }
 
+/* A function to select a queue family for async compute, one with compute but without graphics runs next to the
+   graphics queue instead of taking turns with it. Falls back to any family with compute */
+/* @param The physical device to be screened */
+/* @param An unsigned 32 bit integer for the output index */
+bool SelectIndexOfDedicatedComputeQueueFamily(VkPhysicalDevice* physicalDevice, u32* queueFamilyIndex)
+{
+	Vec queueFamilies = CheckAvailableQueueFamiliesAndTheirProperties(physicalDevice);
+	if (queueFamilies == nullptr)
+		return false;
+
+	for (u32 index = 0; index < vec_length(queueFamilies); ++index)
+	{
+		VkQueueFamilyProperties* indexProperties = (VkQueueFamilyProperties*)vec_get_at(queueFamilies, index);
+		if ((indexProperties->queueCount > 0) && (indexProperties->queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+			!(indexProperties->queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			*queueFamilyIndex = index;
+			vec_destroy(queueFamilies);
+			return true;
+		}
+	}
+
+	vec_destroy(queueFamilies);
+	return SelectIndexOfQueueFamilyWithDesiredCapabilities(physicalDevice, VK_QUEUE_COMPUTE_BIT, queueFamilyIndex);
+}
+
 /* A structure of data to hold data about a queue */
 typedef struct {
 	u32 FamilyIndex;		/* The index of the Queue Family*/
@@ -247,13 +457,15 @@ void PrintAvailableExtensionsFromVector(Vec extensionsVector)
 	}
 }
 
-/* A function to create a logical device */
+/* A function to create a logical device with extended features enabled through a feature chain */
 /* @param The physical devaice */
 /* @param A Vector of Queue Infos */
 /* @param A Vector of strings (const char*) of the desired extensions, pass in null if you don't need extra extensions */
 /* @param Some VkPhysicalDeviceFeatures for the features of the physical device */
+/* @param A Pointer to a DeviceFeatureChain for the extended features, pass in null to only use the VkPhysicalDeviceFeatures */
 /* @param The logical device to be filled */
-bool CreateLogicalDevice(VkPhysicalDevice* physicalDevice, Vec QueueInfo_queue_infos, Vec ConstCharPointer_desired_extensions, VkPhysicalDeviceFeatures* desired_features, VkDevice* logicalDevice)
+bool CreateLogicalDeviceWithFeatureChain(VkPhysicalDevice* physicalDevice, Vec QueueInfo_queue_infos, Vec ConstCharPointer_desired_extensions, VkPhysicalDeviceFeatures* desired_features,
+	DeviceFeatureChain* desired_feature_chain, VkDevice* logicalDevice)
 {
 	Vec VkExtensionProperties_available_extensions = vec_create(VkExtensionProperties);
 	VkExtensionProperties_available_extensions = CheckAvailableDeviceExtensions(physicalDevice);
@@ -305,7 +517,15 @@ bool CreateLogicalDevice(VkPhysicalDevice* physicalDevice, Vec QueueInfo_queue_i
 	deviceCreateInfo.enabledExtensionCount = desiredExtensionsLength;
 	deviceCreateInfo.ppEnabledExtensionNames = desiredExtensionsLength > 0 ? (const char* const*)vec_get_at(ConstCharPointer_desired_extensions, 0) : nullptr,
 	deviceCreateInfo.pEnabledFeatures = desired_features;
-	
+
+	/* The core features have to go through VkPhysicalDeviceFeatures2 when a chain is used */
+	if (desired_feature_chain != nullptr)
+	{
+		if (desired_features != nullptr)
+			desired_feature_chain->Features.features = *desired_features;
+		deviceCreateInfo.pNext = &desired_feature_chain->Features;
+		deviceCreateInfo.pEnabledFeatures = nullptr;
+	}
 
 	VkResult result = vkCreateDevice(*physicalDevice, &deviceCreateInfo, nullptr, logicalDevice);
 	if ((result != VK_SUCCESS) || (logicalDevice == VK_NULL_HANDLE))
@@ -323,6 +543,17 @@ bool CreateLogicalDevice(VkPhysicalDevice* physicalDevice, Vec QueueInfo_queue_i
 	return true;
 }
 
+/* A function to create a logical device */
+/* @param The physical devaice */
+/* @param A Vector of Queue Infos */
+/* @param A Vector of strings (const char*) of the desired extensions, pass in null if you don't need extra extensions */
+/* @param Some VkPhysicalDeviceFeatures for the features of the physical device */
+/* @param The logical device to be filled */
+bool CreateLogicalDevice(VkPhysicalDevice* physicalDevice, Vec QueueInfo_queue_infos, Vec ConstCharPointer_desired_extensions, VkPhysicalDeviceFeatures* desired_features, VkDevice* logicalDevice)
+{
+	return CreateLogicalDeviceWithFeatureChain(physicalDevice, QueueInfo_queue_infos, ConstCharPointer_desired_extensions, desired_features, nullptr, logicalDevice);
+}
+
 /* A function for obtaining a device queue from a logical device */
 /* @param The logical device to get the queue from */
 /* @param The index of the queue family */
@@ -370,7 +601,7 @@ bool CreateLogicalDeviceWithGeometryShaderAndGraphicsAndComputeQueues(VkInstance
 		}
 
 		u32 computeQueueFamilyIndex;
-		if (!SelectIndexOfQueueFamilyWithDesiredCapabilities(physicalDevice, VK_QUEUE_COMPUTE_BIT, &computeQueueFamilyIndex))
+		if (!SelectIndexOfDedicatedComputeQueueFamily(physicalDevice, &computeQueueFamilyIndex))
 		{
 			printf("Device \"%s\", does NOT support queue compute!\n", deviceProperties.deviceName);
 			continue;
@@ -433,17 +664,63 @@ bool CreateVulkanInstanceWithWsiExtensionsEnabled(Vec extraExtensions, const cha
 	return CreateVulkanInstance(extraExtensions, applicationName, instance);
 }
 
+/* A function to turn on an optional device feature when the physical device has it, its extension and feature structure
+   are added once, a chain that already has the structure keeps the caller's choice */
+/* @param A Pointer to the feature chain */
+/* @param A Pointer to a Vector of strings (const char*) of the extensions, the extension is added if it is not in it */
+/* @param The name of the extension */
+/* @param A Pointer to the feature structure, a member of the chain with its sType set */
+/* @param A Pointer to the VkBool32 of the feature in the structure */
+/* @param If the physical device has the feature */
+void EnableOptionalDeviceFeature(DeviceFeatureChain* chain, Vec* extensions, const char* extension, void* feature, VkBool32* enable, bool supported)
+{
+	VkStructureType type = ((VkBaseOutStructure*)feature)->sType;
+	for (VkBaseOutStructure* chained = (VkBaseOutStructure*)&chain->Features; chained != nullptr; chained = chained->pNext)
+		if ((chained == feature) || (chained->sType == type))
+			return;
+
+	*enable = supported ? VK_TRUE : VK_FALSE;
+	if (!supported)
+		return;
+
+	bool requested = false;
+	for (u64 i = 0; i < vec_length(*extensions); ++i)
+		requested |= strcmp(((const char**)*extensions)[i], extension) == 0;
+	if (!requested)
+		vec_pushback(*extensions, extension, const char*);
+
+	AppendToDeviceFeatureChain(chain, feature);
+}
+
 /* A function to create a Vulkan Logical Device with the required Windows / Linux windowing extensions */
 /* @param The physical device to create the logical one with */
 /* @param A Vector of queue infos */
 /* @param A Vector of extra extensions besides the default ones, please pass in a VALID vector not nullptr if no extra are required */
 /* @param The desired features name */
+/* @param A Pointer to a DeviceFeatureChain for the extended features, dynamic rendering is negotiated into it, pass in null if none are needed */
 /* @param The device to be output to */
-bool CreateLogicalDeviceWithWsiExtensionsEnabled(VkPhysicalDevice* physicalDevice, Vec queueInfos, Vec desiredExtensions, VkPhysicalDeviceFeatures* desiredFeatures, VkDevice* logicalDevice) 
+bool CreateLogicalDeviceWithWsiExtensionsEnabled(VkPhysicalDevice* physicalDevice, Vec queueInfos, Vec desiredExtensions, VkPhysicalDeviceFeatures* desiredFeatures,
+	DeviceFeatureChain* desiredFeatureChain, VkDevice* logicalDevice) 
 {
-	desiredExtensions = vec_reserve(const char*, sizeof(desiredExtensions) + sizeof(VK_KHR_SWAPCHAIN_EXTENSION_NAME));
-	vec_pushback(desiredExtensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME, const char*);
-	return CreateLogicalDevice(physicalDevice, queueInfos, desiredExtensions, desiredFeatures, logicalDevice);
+	/* The extra extensions are kept, the swapchain one is added after them */
+	Vec extensions = vec_create(const char*);
+	for (u64 i = 0; (desiredExtensions != nullptr) && (i < vec_length(desiredExtensions)); ++i)
+		vec_pushback(extensions, ((const char**)desiredExtensions)[i], const char*);
+	vec_pushback(extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME, const char*);
+
+	/* Dynamic rendering and synchronization2 are turned on whenever the device has them, the feature structures in
+	   the chain tell the caller what it got. Synchronization2 may come from the synchronization2 layer */
+	if (desiredFeatureChain != nullptr)
+	{
+		EnableOptionalDeviceFeature(desiredFeatureChain, &extensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, &desiredFeatureChain->DynamicRenderingFeatures,
+			&desiredFeatureChain->DynamicRenderingFeatures.dynamicRendering, IsDynamicRenderingSupported(physicalDevice));
+		EnableOptionalDeviceFeature(desiredFeatureChain, &extensions, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, &desiredFeatureChain->Synchronization2Features,
+			&desiredFeatureChain->Synchronization2Features.synchronization2, IsSynchronization2Supported(physicalDevice));
+	}
+
+	bool result = CreateLogicalDeviceWithFeatureChain(physicalDevice, queueInfos, extensions, desiredFeatures, desiredFeatureChain, logicalDevice);
+	vec_destroy(extensions);
+	return result;
 }
 
 /* A function to create a presentation surface to display on */
@@ -833,7 +1110,7 @@ bool CreateSwapchain(VkDevice* logicalDevice, VkSurfaceKHR* presentationSurface,
 /* @param A Pointer to the swapchain */
 Vec GetSwapchainImageHandles(VkDevice* logicalDevice, VkSwapchainKHR* swapchain)
 {
-	Vec tempVec = vec_create(VkImage);
+	Vec tempVec = nullptr;
 
 	u32 imageCount = 0;
 	VkResult result = VK_SUCCESS;
@@ -850,6 +1127,7 @@ Vec GetSwapchainImageHandles(VkDevice* logicalDevice, VkSwapchainKHR* swapchain)
 	if ((result != VK_SUCCESS) || (imageCount == 0))
 	{
 		printf("ERROR: Could not enumerate swapchain images!\n");
+		vec_destroy(tempVec);
 		return nullptr;
 	}
 
@@ -865,8 +1143,9 @@ Vec GetSwapchainImageHandles(VkDevice* logicalDevice, VkSwapchainKHR* swapchain)
 /* @param A Pointer to the image format */
 /* @param A Pointer to the old swapchain (null if none) */
 /* @param A Pointer to a new swapchain for output */
+/* @param A Pointer to a Vector of VkImage for output, an old Vector is destroyed */
 bool CreateSwapchainWithR8G8B8A8FormatAndMailboxPresentMode(VkPhysicalDevice* physicalDevice, VkSurfaceKHR* presentationSurface, VkDevice* logicalDevice, VkImageUsageFlags swapchainImageUsage,
-	VkExtent2D* imageSize, VkFormat* imageFormat, VkSwapchainKHR* oldSwapchain, VkSwapchainKHR* swapchain, Vec swapchainImages)
+	VkExtent2D* imageSize, VkFormat* imageFormat, VkSwapchainKHR* oldSwapchain, VkSwapchainKHR* swapchain, Vec* swapchainImages)
 {
 	VkPresentModeKHR desiredPresentMode;
 	if (!SelectDesiredPresentationMode(physicalDevice, presentationSurface, VK_PRESENT_MODE_MAILBOX_KHR, &desiredPresentMode))
@@ -919,14 +1198,17 @@ bool CreateSwapchainWithR8G8B8A8FormatAndMailboxPresentMode(VkPhysicalDevice* ph
 		return false;
 	}
 
-	swapchainImages = GetSwapchainImageHandles(logicalDevice, swapchain);
+	Vec images = GetSwapchainImageHandles(logicalDevice, swapchain);
 
-	if (swapchainImages == nullptr)
+	if (images == nullptr)
 	{
 		printf("ERROR: Could not get swapchain image handles!\n");
 		return false;
 	}
 
+	vec_destroy(*swapchainImages);
+	*swapchainImages = images;
+
 	printf("INFO: Created Swapchain successfully!\n");
 	return true;
 }
@@ -1356,4 +1638,472 @@ bool WaitForAllSubmittedCommandsToBeFinished(VkDevice* logicalDevice)
 		return false;
 	}
 	return true;
-}
\ No newline at end of file
+}
+
+/* A function for selecting a memory type that fits the requirements of a resource */
+/* @param A Pointer to a physical device */
+/* @param The memoryTypeBits from the VkMemoryRequirements of the resource */
+/* @param The memory properties that are wanted */
+/* @param A Pointer to a u32 for the output memory type index */
+bool SelectMemoryTypeIndex(VkPhysicalDevice* physicalDevice, u32 memoryTypeBits, VkMemoryPropertyFlags memoryProperties, u32* memoryTypeIndex)
+{
+	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(*physicalDevice, &physicalDeviceMemoryProperties);
+
+	for (u32 type = 0; type < physicalDeviceMemoryProperties.memoryTypeCount; ++type)
+	{
+		if ((memoryTypeBits & (1 << type)) &&
+			((physicalDeviceMemoryProperties.memoryTypes[type].propertyFlags & memoryProperties) == memoryProperties))
+		{
+			*memoryTypeIndex = type;
+			return true;
+		}
+	}
+
+	printf("ERROR: Could not find a memory type with the desired properties!\n");
+	return false;
+}
+
+/* A function to create a buffer */
+/* @param A Pointer to a logical device */
+/* @param The size of the buffer in bytes */
+/* @param The usage flags of the buffer */
+/* @param A Pointer to a VkBuffer to be filled */
+bool CreateBuffer(VkDevice* logicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer* buffer)
+{
+	VkBufferCreateInfo bufferCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		nullptr,
+		0,
+		size,
+		usage,
+		VK_SHARING_MODE_EXCLUSIVE,
+		0,
+		nullptr
+	};
+
+	VkResult result = vkCreateBuffer(*logicalDevice, &bufferCreateInfo, nullptr, buffer);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a buffer!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to allocate a memory object and bind it to a buffer */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the buffer */
+/* @param The memory properties wanted */
+/* @param An option for allocating memory that can be used with buffer device addresses */
+/* @param A Pointer to a VkDeviceMemory to be filled */
+bool AllocateAndBindMemoryObjectToBuffer(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkBuffer* buffer, VkMemoryPropertyFlags memoryProperties,
+	bool deviceAddress, VkDeviceMemory* memoryObject)
+{
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(*logicalDevice, *buffer, &memoryRequirements);
+
+	u32 memoryTypeIndex = 0;
+	if (!SelectMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, memoryProperties, &memoryTypeIndex))
+		return false;
+
+	/* Memory behind a buffer with a device address has to be allocated with the device address flag */
+	VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+		nullptr,
+		VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+		0
+	};
+
+	VkMemoryAllocateInfo memoryAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		deviceAddress ? &memoryAllocateFlagsInfo : nullptr,
+		memoryRequirements.size,
+		memoryTypeIndex
+	};
+
+	VkResult result = vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, memoryObject);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate memory for a buffer!\n");
+		return false;
+	}
+
+	result = vkBindBufferMemory(*logicalDevice, *buffer, *memoryObject, 0);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not bind memory object to a buffer!\n");
+		vkFreeMemory(*logicalDevice, *memoryObject, nullptr);
+		*memoryObject = VK_NULL_HANDLE;
+		return false;
+	}
+
+	return true;
+}
+
+/* A function for getting the raw GPU address of a buffer, the buffer must have been created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the buffer */
+VkDeviceAddress GetBufferDeviceAddress(VkDevice* logicalDevice, VkBuffer* buffer)
+{
+	VkBufferDeviceAddressInfo bufferDeviceAddressInfo =
+	{
+		VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+		nullptr,
+		*buffer
+	};
+
+	return vkGetBufferDeviceAddress(*logicalDevice, &bufferDeviceAddressInfo);
+}
+
+/* A structure for a buffer that shaders can read through a raw GPU pointer */
+typedef struct {
+	VkBuffer Buffer;			/* The buffer handle */
+	VkDeviceMemory Memory;		/* The memory bound to the buffer */
+	VkDeviceSize Size;			/* The size of the buffer in bytes */
+	VkDeviceAddress Address;	/* The GPU address of the start of the buffer */
+} AddressableBuffer;
+
+void DestroyAddressableBuffer(VkDevice* logicalDevice, AddressableBuffer* addressableBuffer);
+
+/* A function to create a buffer that can be read by shaders through its device address */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param The size of the buffer in bytes */
+/* @param The usage flags of the buffer, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT is always added */
+/* @param The memory properties wanted */
+/* @param A Pointer to an AddressableBuffer to be filled */
+bool CreateAddressableBuffer(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties,
+	AddressableBuffer* addressableBuffer)
+{
+	memset(addressableBuffer, 0, sizeof(AddressableBuffer));
+
+	if (!CreateBuffer(logicalDevice, size, usage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, &addressableBuffer->Buffer))
+		return false;
+
+	if (!AllocateAndBindMemoryObjectToBuffer(physicalDevice, logicalDevice, &addressableBuffer->Buffer, memoryProperties, true, &addressableBuffer->Memory))
+	{
+		vkDestroyBuffer(*logicalDevice, addressableBuffer->Buffer, nullptr);
+		addressableBuffer->Buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	addressableBuffer->Size = size;
+	addressableBuffer->Address = GetBufferDeviceAddress(logicalDevice, &addressableBuffer->Buffer);
+	if (addressableBuffer->Address == 0)
+	{
+		printf("ERROR: Could not get the device address of a buffer!\n");
+		DestroyAddressableBuffer(logicalDevice, addressableBuffer);
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to clean up created vulkan resources */
+/* @param A Pointer to a logical device */
+/* @param A pointer to the resource to cleanup */
+void DestroyAddressableBuffer(VkDevice* logicalDevice, AddressableBuffer* addressableBuffer)
+{
+	if (addressableBuffer->Buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(*logicalDevice, addressableBuffer->Buffer, nullptr);
+	if (addressableBuffer->Memory != VK_NULL_HANDLE)
+		vkFreeMemory(*logicalDevice, addressableBuffer->Memory, nullptr);
+	memset(addressableBuffer, 0, sizeof(AddressableBuffer));
+}
+
+/* A structure of buffer addresses that gets pushed as push constants, matches this GLSL block: */
+/* layout(push_constant) uniform Addresses { VertexBuffer vertices; MaterialBuffer materials; InstanceBuffer instances; uint baseInstance; }; */
+/* where each member is declared with layout(buffer_reference) and GL_EXT_buffer_reference is enabled */
+typedef struct {
+	VkDeviceAddress VertexData;		/* The address of the vertex data */
+	VkDeviceAddress MaterialData;	/* The address of the material data */
+	VkDeviceAddress InstanceData;	/* The address of the per instance data */
+	u32 BaseInstance;				/* The first instance to read from the instance data */
+	u32 Padding;					/* Keeps the structure a multiple of 8 bytes */
+} BufferAddressPushConstants;
+
+/* A function for getting the push constant range used by BufferAddressPushConstants */
+/* @param The shader stages that read the addresses */
+VkPushConstantRange GetBufferAddressPushConstantRange(VkShaderStageFlags stages)
+{
+	VkPushConstantRange pushConstantRange =
+	{
+		stages,
+		0,
+		sizeof(BufferAddressPushConstants)
+	};
+	return pushConstantRange;
+}
+
+/* A function for pushing buffer addresses to the shaders, this replaces binding descriptor sets per draw */
+/* @param A Pointer to a command buffer that is recording */
+/* @param A Pointer to a pipeline layout that has the range from GetBufferAddressPushConstantRange */
+/* @param The shader stages that read the addresses */
+/* @param A Pointer to the addresses */
+void PushBufferAddresses(VkCommandBuffer* commandBuffer, VkPipelineLayout* pipelineLayout, VkShaderStageFlags stages, BufferAddressPushConstants* addresses)
+{
+	vkCmdPushConstants(*commandBuffer, *pipelineLayout, stages, 0, sizeof(BufferAddressPushConstants), addresses);
+}
+
+/* A structure for the results of comparing draw submission costs */
+typedef struct {
+	u32 DrawCount;					/* The number of draws recorded per path */
+	double DescriptorSetSeconds;	/* CPU time for recording the draws with a descriptor set bind each */
+	double BufferAddressSeconds;	/* CPU time for recording the draws with buffer addresses pushed each */
+} DrawSubmissionCost;
+
+/* A function for comparing the CPU cost of recording draws with descriptor sets against buffer addresses */
+/* Both command buffers must be recording inside a render pass with a pipeline bound that uses the given layout */
+/* @param A Pointer to the command buffer for the descriptor set path */
+/* @param A Pointer to the command buffer for the buffer address path */
+/* @param A Pointer to the pipeline layout */
+/* @param A Vector (MUST BE VALID) of VkDescriptorSets for set 0 that get cycled through */
+/* @param A Vector (MUST BE VALID) of BufferAddressPushConstants that get cycled through */
+/* @param The number of draws to record per path */
+/* @param A Pointer to a DrawSubmissionCost for output */
+void MeasureDrawSubmissionCost(VkCommandBuffer* descriptorSetCommandBuffer, VkCommandBuffer* bufferAddressCommandBuffer, VkPipelineLayout* pipelineLayout,
+	Vec descriptorSets, Vec addresses, u32 drawCount, DrawSubmissionCost* cost)
+{
+	u32 descriptorSetCount = (u32)vec_length(descriptorSets);
+	u32 addressCount = (u32)vec_length(addresses);
+	VkDescriptorSet* sets = (VkDescriptorSet*)descriptorSets;
+	BufferAddressPushConstants* pushConstants = (BufferAddressPushConstants*)addresses;
+
+	cost->DrawCount = drawCount;
+
+	double start = GetTimeInSeconds();
+	for (u32 i = 0; i < drawCount; ++i)
+	{
+		vkCmdBindDescriptorSets(*descriptorSetCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipelineLayout, 0, 1, &sets[i % descriptorSetCount], 0, nullptr);
+		vkCmdDraw(*descriptorSetCommandBuffer, 3, 1, 0, 0);
+	}
+	cost->DescriptorSetSeconds = GetTimeInSeconds() - start;
+
+	start = GetTimeInSeconds();
+	for (u32 i = 0; i < drawCount; ++i)
+	{
+		PushBufferAddresses(bufferAddressCommandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, &pushConstants[i % addressCount]);
+		vkCmdDraw(*bufferAddressCommandBuffer, 3, 1, 0, 0);
+	}
+	cost->BufferAddressSeconds = GetTimeInSeconds() - start;
+
+	printf("INFO: %u draws, descriptor sets: %.3f ms (%.1f ns per draw), buffer addresses: %.3f ms (%.1f ns per draw)\n", drawCount,
+		cost->DescriptorSetSeconds * 1000.0, cost->DescriptorSetSeconds * 1000000000.0 / drawCount,
+		cost->BufferAddressSeconds * 1000.0, cost->BufferAddressSeconds * 1000000000.0 / drawCount);
+}
+
+/* A function to create an image */
+/* @param A Pointer to a logical device */
+/* @param The type of the image */
+/* @param The format of the image */
+/* @param The size of the image */
+/* @param The number of mip levels */
+/* @param The number of array layers */
+/* @param The number of samples */
+/* @param The usage flags of the image */
+/* @param An option for making a cubemap */
+/* @param A Pointer to a VkImage to be filled */
+bool CreateImage(VkDevice* logicalDevice, VkImageType type, VkFormat format, VkExtent3D size, u32 mipLevels, u32 arrayLayers, VkSampleCountFlagBits samples,
+	VkImageUsageFlags usage, bool cubemap, VkImage* image)
+{
+	VkImageCreateInfo imageCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		nullptr,
+		cubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0u,
+		type,
+		format,
+		size,
+		mipLevels,
+		cubemap ? 6 * arrayLayers : arrayLayers,
+		samples,
+		VK_IMAGE_TILING_OPTIMAL,
+		usage,
+		VK_SHARING_MODE_EXCLUSIVE,
+		0,
+		nullptr,
+		VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	VkResult result = vkCreateImage(*logicalDevice, &imageCreateInfo, nullptr, image);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create an image!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to allocate a memory object and bind it to an image */
+/* @param A Pointer to a physical device */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the image */
+/* @param The memory properties wanted */
+/* @param A Pointer to a VkDeviceMemory to be filled */
+bool AllocateAndBindMemoryObjectToImage(VkPhysicalDevice* physicalDevice, VkDevice* logicalDevice, VkImage* image, VkMemoryPropertyFlags memoryProperties, VkDeviceMemory* memoryObject)
+{
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(*logicalDevice, *image, &memoryRequirements);
+
+	u32 memoryTypeIndex = 0;
+	if (!SelectMemoryTypeIndex(physicalDevice, memoryRequirements.memoryTypeBits, memoryProperties, &memoryTypeIndex))
+		return false;
+
+	VkMemoryAllocateInfo memoryAllocateInfo =
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		nullptr,
+		memoryRequirements.size,
+		memoryTypeIndex
+	};
+
+	VkResult result = vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, memoryObject);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not allocate memory for an image!\n");
+		return false;
+	}
+
+	result = vkBindImageMemory(*logicalDevice, *image, *memoryObject, 0);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not bind memory object to an image!\n");
+		vkFreeMemory(*logicalDevice, *memoryObject, nullptr);
+		*memoryObject = VK_NULL_HANDLE;
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create an image view */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the image */
+/* @param The type of the view */
+/* @param The format of the view */
+/* @param The aspect of the image the view sees */
+/* @param A Pointer to a VkImageView to be filled */
+bool CreateImageView(VkDevice* logicalDevice, VkImage* image, VkImageViewType viewType, VkFormat format, VkImageAspectFlags aspect, VkImageView* imageView)
+{
+	VkImageViewCreateInfo imageViewCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		nullptr,
+		0,
+		*image,
+		viewType,
+		format,
+		{
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY,
+			VK_COMPONENT_SWIZZLE_IDENTITY
+		},
+		{
+			aspect,
+			0,
+			VK_REMAINING_MIP_LEVELS,
+			0,
+			VK_REMAINING_ARRAY_LAYERS
+		}
+	};
+
+	VkResult result = vkCreateImageView(*logicalDevice, &imageViewCreateInfo, nullptr, imageView);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create an image view!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create a shader module from SPIR-V */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the SPIR-V words */
+/* @param The size of the SPIR-V in bytes */
+/* @param A Pointer to a VkShaderModule to be filled */
+bool CreateShaderModule(VkDevice* logicalDevice, const u32* code, u64 size, VkShaderModule* shaderModule)
+{
+	VkShaderModuleCreateInfo shaderModuleCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+		nullptr,
+		0,
+		(size_t)size,
+		code
+	};
+
+	VkResult result = vkCreateShaderModule(*logicalDevice, &shaderModuleCreateInfo, nullptr, shaderModule);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a shader module!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create a descriptor set layout */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the bindings */
+/* @param The number of bindings */
+/* @param A Pointer to a VkDescriptorSetLayout to be filled */
+bool CreateDescriptorSetLayout(VkDevice* logicalDevice, const VkDescriptorSetLayoutBinding* bindings, u32 bindingCount, VkDescriptorSetLayout* descriptorSetLayout)
+{
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		nullptr,
+		0,
+		bindingCount,
+		bindings
+	};
+
+	VkResult result = vkCreateDescriptorSetLayout(*logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, descriptorSetLayout);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a layout for descriptor sets!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* A function to create a pipeline layout */
+/* @param A Pointer to a logical device */
+/* @param A Pointer to the descriptor set layouts */
+/* @param The number of descriptor set layouts */
+/* @param A Pointer to the push constant ranges */
+/* @param The number of push constant ranges */
+/* @param A Pointer to a VkPipelineLayout to be filled */
+bool CreatePipelineLayout(VkDevice* logicalDevice, const VkDescriptorSetLayout* descriptorSetLayouts, u32 descriptorSetLayoutCount,
+	const VkPushConstantRange* pushConstantRanges, u32 pushConstantRangeCount, VkPipelineLayout* pipelineLayout)
+{
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		nullptr,
+		0,
+		descriptorSetLayoutCount,
+		descriptorSetLayouts,
+		pushConstantRangeCount,
+		pushConstantRanges
+	};
+
+	VkResult result = vkCreatePipelineLayout(*logicalDevice, &pipelineLayoutCreateInfo, nullptr, pipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		printf("ERROR: Could not create a pipeline layout!\n");
+		return false;
+	}
+
+	return true;
+}
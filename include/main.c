@@ -2,6 +2,13 @@
 #include <windows.h>
 #include <vector/vector.h>
 #include <VkHelper/VkHelper.h>
+#include <PipelineCache/PipelineCache.h>
+#include <PipelineManager/PipelineManager.h>
+#include <ShaderObject/ShaderObject.h>
+#include <JobSystem/JobSystem.h>
+#include <EventQueue/EventQueue.h>
+#include <DynamicRendering/DynamicRendering.h>
+#include <BarrierBatcher/BarrierBatcher.h>
 
 /* Global variables */
 HINSTANCE hInstance;
@@ -11,12 +18,27 @@ VkInstance Inst = { 0 };
 VkDevice logicalDevice = { 0 };
 VkQueue GraphicsQueue = { 0 };
 VkQueue ComputeQueue = { 0 };
+u32 ComputeQueueFamilyIndex = 0;
 WindowPerameters window_parameters = { 0 };
 VkSwapchainKHR swapchain = { 0 };
 VkSemaphore imageAcquiredSemaphore = { 0 };
 VkSemaphore readyToPresentSemaphore = { 0 };
 Vec swapchainImages = nullptr;
 Vec physicalDevices = nullptr;
+PipelineCache pipelineCache = { 0 };
+PipelineManager pipelineManager = { 0 };
+bool shaderObjects = false;
+ShaderObjectFunctions shaderObjectFunctions = { 0 };
+bool gpuDrivenRendering = false;
+bool sparseResidency = false;
+JobSystem jobSystem = { 0 };
+VkPhysicalDevice* selectedPhysicalDevice = nullptr;
+VkExtent2D swapchainSize = { 0 };
+EventQueue platformEvents = { 0 };
+Thread renderThread = { 0 };
+volatile i32 renderThreadRunning = 0;
+RenderTargetCache renderTargets = { 0 };
+BarrierBatcher barrierBatcher = { 0 };
 
 bool CreateAppInstance()
 {
@@ -42,11 +64,13 @@ bool CreateAppSwapchain(VkPhysicalDevice* PhysicalDevice)
 
 	VkFormat swapchainImageFormat = { 0 };
 	VkExtent2D swapchainImageSize = { 0 };
-	Vec swapchainImages = vec_create(VkImage);
 
-	if (!CreateSwapchainWithR8G8B8A8FormatAndMailboxPresentMode(PhysicalDevice, &PresentationSurface, &logicalDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &swapchainImageSize, &swapchainImageFormat, nullptr, &swapchain, swapchainImages))
+	if (!CreateSwapchainWithR8G8B8A8FormatAndMailboxPresentMode(PhysicalDevice, &PresentationSurface, &logicalDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &swapchainImageSize, &swapchainImageFormat, nullptr, &swapchain, &swapchainImages))
 		return false;
 
+	selectedPhysicalDevice = PhysicalDevice;
+	swapchainSize = swapchainImageSize;
+
 	if (swapchain)
 		Ready = true;
 
@@ -95,19 +119,204 @@ bool CreateAppDeviceAndPhysicalDeviceAndSwapchain()
 		if (GraphicsQueueFamilyIndex != PresentQueueFamilyIndex) {
 			vec_pushback(requested_queues, infoPresent, QueueInfo);
 		}
-		Vec device_extensions = vec_create(VkExtensionProperties);
-		if (!CreateLogicalDeviceWithWsiExtensionsEnabled(physicalDevice, requested_queues, device_extensions, nullptr, &logicalDevice))
+
+		/* Async compute passes get a queue of a family without graphics when there is one, so they overlap rendering */
+		ComputeQueueFamilyIndex = GraphicsQueueFamilyIndex;
+		SelectIndexOfDedicatedComputeQueueFamily(physicalDevice, &ComputeQueueFamilyIndex);
+		bool computeRequested = false;
+		for (u32 q = 0; q < vec_length(requested_queues); ++q)
+			computeRequested |= ((QueueInfo*)requested_queues)[q].FamilyIndex == ComputeQueueFamilyIndex;
+		if (!computeRequested)
+		{
+			QueueInfo infoCompute = { ComputeQueueFamilyIndex, priorities };
+			vec_pushback(requested_queues, infoCompute, QueueInfo);
+		}
+		/* Let shaders read buffers through raw GPU pointers when the device can do it */
+		DeviceFeatureChain featureChain = { 0 };
+		LinkDeviceFeatureChain(physicalDevice, &featureChain);
+		featureChain.Vulkan12Features.bufferDeviceAddress = IsBufferDeviceAddressSupported(physicalDevice) ? VK_TRUE : VK_FALSE;
+
+		/* Lets a compute pass cull the instances and write their draws, so a frame records the same few commands however big the scene is */
+		gpuDrivenRendering = IsGpuDrivenRenderingSupported(physicalDevice);
+		if (gpuDrivenRendering)
+		{
+			featureChain.Features.features.multiDrawIndirect = VK_TRUE;
+			featureChain.Features.features.drawIndirectFirstInstance = VK_TRUE;
+			featureChain.Vulkan12Features.drawIndirectCount = VK_TRUE;
+			featureChain.Vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		}
+
+		/* Lets textures bigger than the memory budget keep only the pages that get sampled resident, pass this on to the residency managers */
+		sparseResidency = IsSparseResidencySupported(physicalDevice);
+		if (sparseResidency)
+		{
+			featureChain.Features.features.sparseBinding = VK_TRUE;
+			featureChain.Features.features.sparseResidencyImage2D = VK_TRUE;
+		}
+
+		/* Lets the pipeline cache tell hits from misses */
+		Vec device_extensions = vec_create(const char*);
+		bool creationFeedback = IsDeviceExtensionSupported(physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+		if (creationFeedback)
+			vec_pushback(device_extensions, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, const char*);
+
+		/* Lets pipelines be linked from precompiled parts instead of compiled whole on first use */
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+		bool pipelineLibraries = IsGraphicsPipelineLibrarySupported(physicalDevice);
+		if (pipelineLibraries)
+		{
+			vec_pushback(device_extensions, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, const char*);
+			vec_pushback(device_extensions, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, const char*);
+			pipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+			AppendToDeviceFeatureChain(&featureChain, &pipelineLibraryFeatures);
+		}
+
+		/* Lets materials bind shaders and set state at draw time instead of baking a pipeline per combination,
+		   drivers without it get it from the shader object layer. The dynamic rendering it needs is added by device creation */
+		VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT };
+		shaderObjects = IsShaderObjectSupported(physicalDevice);
+		if (shaderObjects)
+		{
+			vec_pushback(device_extensions, VK_EXT_SHADER_OBJECT_EXTENSION_NAME, const char*);
+			shaderObjectFeatures.shaderObject = VK_TRUE;
+			AppendToDeviceFeatureChain(&featureChain, &shaderObjectFeatures);
+		}
+
+		if (!CreateLogicalDeviceWithWsiExtensionsEnabled(physicalDevice, requested_queues, device_extensions, nullptr, &featureChain, &logicalDevice))
 			return false;
-		else
-			return CreateAppSwapchain(physicalDevice);
+		GetDeviceQueue(&logicalDevice, ComputeQueueFamilyIndex, 0, &ComputeQueue);
+
+		/* Without dynamic rendering, render passes and framebuffers are made once per set of attachments and reused */
+		if (!CreateRenderTargetCache(&logicalDevice, featureChain.DynamicRenderingFeatures.dynamicRendering == VK_TRUE, &renderTargets))
+			return false;
+
+		/* The barriers recorded between two commands go out as one, through vkCmdPipelineBarrier2KHR when there is synchronization2 */
+		if (!CreateBarrierBatcher(&logicalDevice, featureChain.Synchronization2Features.synchronization2 == VK_TRUE, &barrierBatcher))
+			return false;
+
+		if (shaderObjects && !LoadShaderObjectFunctions(&logicalDevice, &shaderObjectFunctions))
+			shaderObjects = false;
+
+		if (!CreatePersistentPipelineCache(physicalDevice, &logicalDevice, "pipeline_cache.bin", creationFeedback, &pipelineCache))
+			return false;
+
+		if (!CreatePipelineManager(&logicalDevice, &pipelineCache, 0, "pipeline_states.bin", pipelineLibraries,
+			featureChain.DynamicRenderingFeatures.dynamicRendering == VK_TRUE, &pipelineManager))
+			return false;
+
+		return CreateAppSwapchain(physicalDevice);
 	}
 
 	return true;
 }
 
+bool RecreateAppSwapchain(u32 width, u32 height)
+{
+	if ((width == swapchainSize.width) && (height == swapchainSize.height))
+		return true;
+
+	WaitForAllSubmittedCommandsToBeFinished(&logicalDevice);
+
+	VkFormat swapchainImageFormat = { 0 };
+	VkSwapchainKHR oldSwapchain = swapchain;
+	if (!CreateSwapchainWithR8G8B8A8FormatAndMailboxPresentMode(selectedPhysicalDevice, &PresentationSurface, &logicalDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &swapchainSize, &swapchainImageFormat, &oldSwapchain, &swapchain, &swapchainImages))
+		return false;
+
+	VulkanSwapchainCleanup(&logicalDevice, &oldSwapchain);
+	return true;
+}
+
+bool Draw();
+
+/* The render thread owns the frame loop, it only hears about the window through platformEvents so a message loop
+   stuck in a drag or resize never holds up a frame */
+void RenderThreadMain(void* argument)
+{
+	bool running = true;
+	bool minimized = false;
+	while (running)
+	{
+		/* Resizes are collapsed so a drag that sends hundreds of them recreates the swapchain once per frame */
+		bool resized = false;
+		u32 width = 0;
+		u32 height = 0;
+		PlatformEvent event;
+		while (PopEvent(&platformEvents, &event))
+		{
+			switch (event.Type)
+			{
+			case PLATFORM_EVENT_RESIZE:
+				resized = true;
+				width = event.Width;
+				height = event.Height;
+				break;
+			case PLATFORM_EVENT_QUIT:
+				running = false;
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (!running)
+			break;
+
+		if (resized)
+		{
+			minimized = (width == 0) || (height == 0);
+			if (!minimized && !RecreateAppSwapchain(width, height))
+				break;
+		}
+
+		if (minimized)
+		{
+			SleepMilliseconds(1);
+			continue;
+		}
+
+		if (!Draw())
+			break;
+
+		/* Draw does not acquire or present yet, so no swapchain holds the loop to the display. Sleep about
+		   a 60 Hz frame instead of pinning a core until it does */
+		SleepMilliseconds(16);
+	}
+
+	/* A frame that failed closes the window, so the platform thread leaves its loop too */
+	AtomicStore32(&renderThreadRunning, 0);
+	if (running)
+		PostMessage(hWnd, WM_CLOSE, 0, 0);
+}
+
+void PushWindowEvent(PlatformEventType type, u32 width, u32 height, u32 key)
+{
+	PlatformEvent event = { type, width, height, key };
+	if (PushEvent(&platformEvents, &event))
+		return;
+
+	/* Only quitting may not be lost, a dropped resize is replaced by the next one. A render thread that already
+	   left its loop never empties the queue, and has nothing left to hear */
+	while ((type == PLATFORM_EVENT_QUIT) && AtomicLoad32(&renderThreadRunning) && !PushEvent(&platformEvents, &event))
+		YieldThread();
+}
+
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 	switch (uMsg) {
+	case WM_SIZE:
+		PushWindowEvent(PLATFORM_EVENT_RESIZE, LOWORD(lParam), HIWORD(lParam), 0);
+		return 0;
+	case WM_KEYDOWN:
+		PushWindowEvent(PLATFORM_EVENT_KEY_DOWN, 0, 0, (u32)wParam);
+		return 0;
+	case WM_KEYUP:
+		PushWindowEvent(PLATFORM_EVENT_KEY_UP, 0, 0, (u32)wParam);
+		return 0;
+	case WM_SETFOCUS:
+	case WM_KILLFOCUS:
+		PushWindowEvent(PLATFORM_EVENT_FOCUS, 0, 0, uMsg == WM_SETFOCUS);
+		return 0;
 	case WM_DESTROY:
+		PushWindowEvent(PLATFORM_EVENT_QUIT, 0, 0, 0);
 		PostQuitMessage(0);
 		return 0;
 	default:
@@ -172,6 +381,9 @@ bool CreateSemaphores()
 
 bool Start()
 {
+	if (!CreateJobSystem(0, &jobSystem))
+		return false;
+
 	if (!CreateWin())
 		return false;
 
@@ -187,9 +399,29 @@ bool Start()
 	if (!CreateSemaphores())
 		return false;
 
+	/* This thread only pumps messages from here on, every frame is made on the render thread */
+	AtomicStore32(&renderThreadRunning, 1);
+	if (!StartThread(RenderThreadMain, nullptr, &renderThread))
+	{
+		AtomicStore32(&renderThreadRunning, 0);
+		printf("ERROR: Could not start the render thread!\n");
+		return false;
+	}
+
 	RunWindow();
+	JoinThread(&renderThread);
 
+	WaitForAllSubmittedCommandsToBeFinished(&logicalDevice);
+	DestroyPipelineManager(&pipelineManager);
+	PrintRenderTargetStats(&renderTargets);
+	DestroyRenderTargetCache(&renderTargets);
+	PrintBarrierBatcherStats(&barrierBatcher);
+	DestroyBarrierBatcher(&barrierBatcher);
+	DestroyJobSystem(&jobSystem);
+	PrintPipelineCreationTimings(&pipelineCache);
+	DestroyPersistentPipelineCache(&pipelineCache);
 	VulkanSwapchainCleanup(&logicalDevice, &swapchain);
+	vec_destroy(swapchainImages);
 	VulkanDeviceCleanup(&logicalDevice);
 	VulkanSurfaceCleanup(&Inst, &PresentationSurface);
 	VulkanInstanceCleanup(&Inst);
@@ -201,10 +433,6 @@ bool Draw()
 {
 	WaitForAllSubmittedCommandsToBeFinished(&logicalDevice);
 
-	u32 imageIndex = 0;
-	//if (!AcquireSwapchainImage(&logicalDevice, &swapchain, &imageAcquiredSemaphore, ))
-		//return false;
-
 	return true;
 }
 